@@ -17,6 +17,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 #include "button_subroutines.h"
+#include "display_subroutines.h"
+#include "record_subroutines.h"
 #include "gstreamer_subroutines.h"
 #include "sound_effects_player.h"
 #include "sound_subroutines.h"
@@ -71,10 +73,6 @@ button_master_volume_changed (GtkButton *button, gpointer user_data)
   GtkLabel *volume_label;
   gdouble new_value;
   gchar *value_string;
-  GtkWidget *parent_container;
-  GList *children_list = NULL;
-  GList *l;
-  const gchar *child_name = NULL;
 
   app = sep_get_application_from_widget (user_data);
   pipeline_element = sep_get_pipeline_from_app (app);
@@ -95,24 +93,8 @@ button_master_volume_changed (GtkButton *button, gpointer user_data)
   if (volume_element == NULL)
     return;
 
-  /* Find the volume label associated with this volume widget.
-   * It will be a child of this widget's parent. */
-  parent_container = gtk_widget_get_parent (GTK_WIDGET (button));
-  children_list =
-    gtk_container_get_children (GTK_CONTAINER (parent_container));
-  l = children_list;
-  volume_label = NULL;
-  while (l != NULL)
-    {
-      child_name = gtk_widget_get_name (l->data);
-      if (g_strcmp0 (child_name, "volume_label") == 0)
-        {
-          volume_label = l->data;
-          break;
-        }
-      l = l->next;
-    }
-  g_list_free (children_list);
+  /* Find the volume label associated with this volume widget.  */
+  volume_label = display_get_master_volume_label (app);
 
   /* If there is no volume label, do nothing.  */
   if (volume_label == NULL)
@@ -130,6 +112,19 @@ button_master_volume_changed (GtkButton *button, gpointer user_data)
   return;
 }
 
+/* Record the pushing of a cluster's button.  */
+static void
+button_record (const gchar *button_name, guint cluster_number,
+               GApplication *app)
+{
+  gchar *argument;
+
+  argument = g_strdup_printf ("%s %u", button_name, cluster_number);
+  record_event ("button", argument, app);
+  g_free (argument);
+  return;
+}
+
 /* The Pause button has been pushed.  */
 void
 button_pause_clicked (GtkButton *button, gpointer user_data)
@@ -137,6 +132,7 @@ button_pause_clicked (GtkButton *button, gpointer user_data)
   GApplication *app;
 
   app = sep_get_application_from_widget (user_data);
+  record_event ("button", "pause", app);
   sound_button_pause (app);
 
   return;
@@ -149,6 +145,7 @@ button_continue_clicked (GtkButton *button, gpointer user_data)
   GApplication *app;
 
   app = sep_get_application_from_widget (user_data);
+  record_event ("button", "continue", app);
   sound_button_continue (app);
 
   return;
@@ -162,6 +159,7 @@ button_play_clicked (GtkButton *button, gpointer user_data)
 
   /* Let the internal sequencer handle it.  */
   app = sep_get_application_from_widget (user_data);
+  record_event ("button", "go", app);
   sequence_button_play (app);
 
   return;
@@ -179,6 +177,7 @@ button_start_clicked (GtkButton *button, gpointer user_data)
   app = sep_get_application_from_widget (user_data);
   cluster_widget = sep_get_cluster_from_widget (user_data);
   cluster_number = sep_get_cluster_number (cluster_widget);
+  button_record ("start", cluster_number, app);
   sequence_cluster_start (cluster_number, app);
 
   return;
@@ -196,6 +195,7 @@ button_stop_clicked (GtkButton *button, gpointer user_data)
   app = sep_get_application_from_widget (user_data);
   cluster_widget = sep_get_cluster_from_widget (user_data);
   cluster_number = sep_get_cluster_number (cluster_widget);
+  button_record ("stop", cluster_number, app);
   sequence_cluster_stop (cluster_number, app);
 
   return;
@@ -205,109 +205,44 @@ button_stop_clicked (GtkButton *button, gpointer user_data)
 void
 button_set_cluster_playing (struct sound_info *sound_data, GApplication *app)
 {
-  GtkButton *start_button;
-  GtkLabel *volume_label, *pan_label;
+  struct display_cluster_info *cluster_info;
   GstElement *volume_element, *pan_element;
   gdouble volume_level_value, pan_value;
   GstBin *bin_element;
-  GtkScaleButton *volume_button, *pan_button;
-  GtkWidget *parent_container;
-  GList *children_list, *grandchildren_list;
-  GList *l, *ll;
-  const gchar *child_name, *grandchild_name;
 
   if (BUTTON_TRACE)
     {
       g_print ("Set sound %s to playing.\n", sound_data->name);
     }
 
-  /* Find the start button and set its text to "Playing...". 
-   * The start button will be a child of the cluster, and will be named
-   * "start_button".  */
-  parent_container = sound_data->cluster_widget;
-
   /* It is possible, though unlikely, that the sound will no longer
    * be in a cluster.  */
-  if (parent_container == NULL)
+  cluster_info = display_get_cluster_from_widget (sound_data->cluster_widget);
+  if (cluster_info == NULL)
     return;
-    
-  start_button = NULL;
-  pan_label = NULL;
-  volume_label = NULL;
-  pan_button = NULL;
-  volume_button = NULL;
-  children_list = gtk_container_get_children (GTK_CONTAINER (parent_container));
-  l = children_list;
-  while (l != NULL)
-    {
-      child_name = gtk_widget_get_name (l->data);
-      if (BUTTON_TRACE)
-	g_print (" child name is %s\n", child_name);
-      if (GTK_IS_CONTAINER (l->data))
-	{
-	  if (BUTTON_TRACE)
-	    g_print (" container\n");
-	  grandchildren_list = gtk_container_get_children (l->data);
-	  ll = grandchildren_list;
-	  while (ll != NULL)
-	    {
-	      grandchild_name = gtk_widget_get_name (ll->data);
-	      if (BUTTON_TRACE)
-		g_print (" grandchild name is %s\n", grandchild_name);
-	      if (g_strcmp0 (grandchild_name, "pan_label") == 0)
-		pan_label = ll->data;
-	      if (g_strcmp0 (grandchild_name, "pan_button") == 0)
-		pan_button = ll->data;
-	      if (g_strcmp0 (grandchild_name, "volume_label") == 0)
-		volume_label = ll->data;
-	      if (g_strcmp0 (grandchild_name, "volume") == 0)
-		volume_button = ll->data;
-	      ll = ll->next;
-	    }
-	  g_list_free (grandchildren_list);
-	  grandchildren_list = NULL;
-	}
-      if (g_strcmp0 (child_name, "start_button") == 0)
-	  start_button = l->data;
-      l = l->next;
-    }
-  g_list_free (children_list);
-  children_list = NULL;
-    
-  if (BUTTON_TRACE)
-    {
-      if (start_button != NULL)
-	g_print (" found start button\n");
-      if (pan_label != NULL)
-	g_print (" found pan label\n");
-      if (pan_button != NULL)
-	g_print (" found pan button\n");
-      if (volume_label != NULL)
-	g_print (" found volume label\n");
-      if (volume_button != NULL)
-	g_print (" found volume button\n");
-    }
-  
-  if (start_button != NULL)
-    gtk_button_set_label (start_button, "Playing...");
+
+  /* Set the text of the start button to "Playing...".  */
+  if (cluster_info->start_button != NULL)
+    gtk_button_set_label (cluster_info->start_button, "Playing...");
   
   /* The sound_effect structure records where the Gstreamer bin is
    * for this sound effect.  That bin contains the volume and pan
    * controls. */
   bin_element = sound_data->sound_control;
   volume_element = gstreamer_get_volume (bin_element);
-  if ((volume_element != NULL) && (volume_button != NULL))
+  if ((volume_element != NULL) && (cluster_info->volume_button != NULL))
     {
       volume_level_value = sound_data->default_volume_level;
       if (BUTTON_TRACE)
 	{
 	  g_print (" set volume to %4.3f.\n", volume_level_value);
 	}
-      gtk_scale_button_set_value (volume_button, volume_level_value);
+      gtk_scale_button_set_value (cluster_info->volume_button,
+                                  volume_level_value);
     }
   
   pan_element = gstreamer_get_pan (bin_element);
-  if ((pan_element != NULL) && (pan_button != NULL))
+  if ((pan_element != NULL) && (cluster_info->pan_button != NULL))
     {
       pan_value = sound_data->designer_pan;
       /* -1.0 is full left, 0.0 is center, 1.0 is full right.
@@ -318,7 +253,7 @@ button_set_cluster_playing (struct sound_info *sound_data, GApplication *app)
 	{
 	  g_print (" set pan to %4.0f.\n", pan_value);
 	}
-      gtk_scale_button_set_value (pan_button, pan_value);
+      gtk_scale_button_set_value (cluster_info->pan_button, pan_value);
     }
 
   return;
@@ -329,43 +264,18 @@ void
 button_set_cluster_releasing (struct sound_info *sound_data,
                               GApplication *app)
 {
-  GtkButton *start_button;
-  GtkWidget *parent_container;
-  GList *children_list;
-  GList *l;
-  const gchar *child_name;
+  struct display_cluster_info *cluster_info;
 
     if (BUTTON_TRACE)
     {
       g_print ("Set sound %s to releasing.\n", sound_data->name);
     }
 
-  /* Find the start button and set its text to "Releasing...". 
-   * The start button will be a child of the cluster, and will be named
-   * "start_button".  */
-  parent_container = sound_data->cluster_widget;
-
-  /* It is possible that the sound will no longer be in a cluster.  */
-  if (parent_container != NULL)
-    {
-      start_button = NULL;
-      children_list =
-        gtk_container_get_children (GTK_CONTAINER (parent_container));
-      l = children_list;
-      while (l != NULL)
-        {
-          child_name = gtk_widget_get_name (l->data);
-          if (g_strcmp0 (child_name, "start_button") == 0)
-            {
-              start_button = l->data;
-              break;
-            }
-          l = l->next;
-        }
-      g_list_free (children_list);
-      if (start_button != NULL)
-	gtk_button_set_label (start_button, "Releasing...");
-    }
+  /* Set the text of the start button to "Releasing...".
+   * It is possible that the sound will no longer be in a cluster.  */
+  cluster_info = display_get_cluster_from_widget (sound_data->cluster_widget);
+  if ((cluster_info != NULL) && (cluster_info->start_button != NULL))
+    gtk_button_set_label (cluster_info->start_button, "Releasing...");
 
   return;
 }
@@ -374,16 +284,9 @@ button_set_cluster_releasing (struct sound_info *sound_data,
 void
 button_reset_cluster (struct sound_info *sound_data, GApplication *app)
 {
-
-  GtkButton *start_button;
-  GtkLabel *volume_label, *pan_label;
+  struct display_cluster_info *cluster_info;
   GstElement *volume_element, *pan_element;
   GstBin *bin_element;
-  GtkScaleButton *volume_button, *pan_button;
-  GtkWidget *parent_container;
-  GList *children_list, *grandchildren_list;
-  GList *l, *ll;
-  const gchar *child_name, *grandchild_name;
 
   if (BUTTON_TRACE)
     {
@@ -391,94 +294,35 @@ button_reset_cluster (struct sound_info *sound_data, GApplication *app)
     }
 
   /* Set the start, volume and pan displays to their initial values.  */
-  parent_container = sound_data->cluster_widget;
-  if (parent_container == NULL)
+  cluster_info = display_get_cluster_from_widget (sound_data->cluster_widget);
+  if (cluster_info == NULL)
     return;
 
-  start_button = NULL;
-  pan_label = NULL;
-  volume_label = NULL;
-  pan_button = NULL;
-  volume_button = NULL;
-
-  /* Find the needed items.  */
-  children_list = gtk_container_get_children (GTK_CONTAINER (parent_container));
-  l = children_list;
-  while (l != NULL)
-    {
-      child_name = gtk_widget_get_name (l->data);
-      if (BUTTON_TRACE)
-	g_print (" child name is %s\n", child_name);
-      if (GTK_IS_CONTAINER (l->data))
-	{
-	  if (BUTTON_TRACE)
-	    g_print (" container\n");
-	  grandchildren_list = gtk_container_get_children (l->data);
-	  ll = grandchildren_list;
-	  while (ll != NULL)
-	    {
-	      grandchild_name = gtk_widget_get_name (ll->data);
-	      if (BUTTON_TRACE)
-		g_print (" grandchild name is %s\n", grandchild_name);
-	      if (g_strcmp0 (grandchild_name, "pan_label") == 0)
-		pan_label = ll->data;
-	      if (g_strcmp0 (grandchild_name, "pan_button") == 0)
-		pan_button = ll->data;
-	      if (g_strcmp0 (grandchild_name, "volume_label") == 0)
-		volume_label = ll->data;
-	      if (g_strcmp0 (grandchild_name, "volume") == 0)
-		volume_button = ll->data;
-	      ll = ll->next;
-	    }
-	  g_list_free (grandchildren_list);
-	  grandchildren_list = NULL;
-	}
-      if (g_strcmp0 (child_name, "start_button") == 0)
-	  start_button = l->data;
-      l = l->next;
-    }
-  g_list_free (children_list);
-  children_list = NULL;
-    
-  if (BUTTON_TRACE)
-    {
-      if (start_button != NULL)
-	g_print (" found start button\n");
-      if (pan_label != NULL)
-	g_print (" found pan label\n");
-      if (pan_button != NULL)
-	g_print (" found pan button\n");
-      if (volume_label != NULL)
-	g_print (" found volume label\n");
-      if (volume_button != NULL)
-	g_print (" found volume button\n");
-    }
-  
-  if (start_button != NULL)
-    gtk_button_set_label (start_button, "Start");
+  if (cluster_info->start_button != NULL)
+    gtk_button_set_label (cluster_info->start_button, "Start");
   
   /* The sound_effect structure records where the Gstreamer bin is
    * for this sound effect.  That bin contains the volume and pan
    * controls. */
   bin_element = sound_data->sound_control;
   volume_element = gstreamer_get_volume (bin_element);
-  if ((volume_element != NULL) && (volume_button != NULL))
+  if ((volume_element != NULL) && (cluster_info->volume_button != NULL))
     {
       if (BUTTON_TRACE)
 	{
 	  g_print (" set volume to 0.\n");
 	}
-      gtk_scale_button_set_value (volume_button, 0.0);
+      gtk_scale_button_set_value (cluster_info->volume_button, 0.0);
     }
   
   pan_element = gstreamer_get_pan (bin_element);
-  if ((pan_element != NULL) && (pan_button != NULL))
+  if ((pan_element != NULL) && (cluster_info->pan_button != NULL))
     {  
       if (BUTTON_TRACE)
 	{
 	  g_print (" set pan to center.\n");
 	}
-      gtk_scale_button_set_value (pan_button, 50.0);
+      gtk_scale_button_set_value (cluster_info->pan_button, 50.0);
     }
 
   return;
@@ -490,13 +334,12 @@ void
 button_volume_changed (GtkButton *button, gpointer user_data)
 {
   GtkLabel *volume_label = NULL;
-  GtkWidget *parent_container;
-  GList *children_list = NULL;
-  GList *l;
-  const gchar *child_name = NULL;
+  struct display_cluster_info *cluster_info;
   struct sound_info *sound_data;
   GstBin *bin_element;
   GstElement *volume_element;
+  struct voice_info *voice_data;
+  GList *l;
   gdouble old_value, new_value;
   gchar *value_string;
 
@@ -506,23 +349,11 @@ button_volume_changed (GtkButton *button, gpointer user_data)
     }
 
   /* Find the volume label associated with this volume widget.
-   * It will be a child of this widget's parent. */
+   * The user data is the cluster.  */
   volume_label = NULL;
-  parent_container = gtk_widget_get_parent (GTK_WIDGET (button));
-  children_list =
-    gtk_container_get_children (GTK_CONTAINER (parent_container));
-  l = children_list;
-  while (l != NULL)
-    {
-      child_name = gtk_widget_get_name (l->data);
-      if (g_strcmp0 (child_name, "volume_label") == 0)
-        {
-          volume_label = l->data;
-          break;
-        }
-      l = l->next;
-    }
-  g_list_free (children_list);
+  cluster_info = display_get_cluster_from_widget (user_data);
+  if (cluster_info != NULL)
+    volume_label = cluster_info->volume_label;
 
   if (volume_label != NULL)
     {
@@ -549,6 +380,22 @@ button_volume_changed (GtkButton *button, gpointer user_data)
       /* Set the volume of the sound. */
       g_object_set (volume_element, "volume", new_value, NULL);
 
+      /* While the sound is playing, its other voices follow the slider.
+       * When it finishes the slider returns to zero, which must not
+       * silence voices that are still playing.  */
+      if (sound_data->running)
+        {
+          for (l = sound_data->voices; l != NULL; l = l->next)
+            {
+              voice_data = l->data;
+              if (voice_data->sound_control == NULL)
+                continue;
+              volume_element = gstreamer_get_volume (voice_data->sound_control);
+              if (volume_element != NULL)
+                g_object_set (volume_element, "volume", new_value, NULL);
+            }
+        }
+
       /* Update the text in the volume label. */
       value_string = g_strdup_printf ("Vol %4.0f%%", new_value * 100.0);
       gtk_label_set_text (volume_label, value_string);
@@ -569,13 +416,12 @@ void
 button_pan_changed (GtkButton *button, gpointer user_data)
 {
   GtkLabel *pan_label;
-  GtkWidget *parent_container;
-  GList *children_list;
-  GList *l;
-  const gchar *child_name;
+  struct display_cluster_info *cluster_info;
   struct sound_info *sound_data;
   GstBin *bin_element;
   GstElement *pan_element;
+  struct voice_info *voice_data;
+  GList *l;
   gdouble old_value, new_value;
   gchar *value_string;
 
@@ -585,23 +431,11 @@ button_pan_changed (GtkButton *button, gpointer user_data)
     }
 
   /* Find the pan label associated with this pan widget.
-   * It will be a child of this widget's parent. */
-  parent_container = gtk_widget_get_parent (GTK_WIDGET (button));
+   * The user data is the cluster.  */
   pan_label = NULL;
-  children_list =
-    gtk_container_get_children (GTK_CONTAINER (parent_container));
-  l = children_list;
-  while (l != NULL)
-    {
-      child_name = gtk_widget_get_name (l->data);
-      if (g_strcmp0 (child_name, "pan_label") == 0)
-        {
-          pan_label = l->data;
-          break;
-        }
-      l = l->next;
-    }
-  g_list_free (children_list);
+  cluster_info = display_get_cluster_from_widget (user_data);
+  if (cluster_info != NULL)
+    pan_label = cluster_info->pan_label;
 
   if (pan_label != NULL)
     {
@@ -630,6 +464,20 @@ button_pan_changed (GtkButton *button, gpointer user_data)
       /* Set the panorama position of the sound. */
       g_object_set (pan_element, "panorama", new_value, NULL);
 
+      /* While the sound is playing, its other voices follow the slider.  */
+      if (sound_data->running)
+        {
+          for (l = sound_data->voices; l != NULL; l = l->next)
+            {
+              voice_data = l->data;
+              if (voice_data->sound_control == NULL)
+                continue;
+              pan_element = gstreamer_get_pan (voice_data->sound_control);
+              if (pan_element != NULL)
+                g_object_set (pan_element, "panorama", new_value, NULL);
+            }
+        }
+
       /* Update the text of the pan label.  0.0 corresponds to Center, 
        * negative numbers to left, and positive numbers to right. */
       if (new_value == 0.0)
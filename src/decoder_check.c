@@ -0,0 +1,126 @@
+/*
+ * decoder_check.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Check that the decoder reads the format of compressed sound files
+ * correctly, using the headers of real files.  Build it with
+ * "make decoder_check" and run it; it prints "Decoder headers OK."
+ * or stops at the first header it reads wrongly.  */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "decoder_subroutines.h"
+
+/* The start of a FLAC file written by the reference encoder: 44,100
+ * frames per second, 2 channels, 16 bits per sample, with a block
+ * size of 4096.  */
+static const guchar flac_header[] = {
+  'f', 'L', 'a', 'C',
+  0x00, 0x00, 0x00, 0x22,       /* STREAMINFO, not last, 34 bytes */
+  0x10, 0x00, 0x10, 0x00,       /* minimum and maximum block size */
+  0x00, 0x00, 0x0e, 0x00, 0x3d, 0x1f,   /* minimum and maximum frame size */
+  0x0a, 0xc4, 0x42, 0xf0,       /* rate, channels, bits, samples */
+  0x00, 0x00, 0xac, 0x44,
+  0xd4, 0x1d, 0x8c, 0xd9, 0x8f, 0x00, 0xb2, 0x04,       /* MD5 */
+  0xe9, 0x80, 0x09, 0x98, 0xec, 0xf8, 0x42, 0x7e,
+  0x84, 0x00, 0x00, 0x28        /* the last block: padding */
+};
+
+/* The same, but 24 bits per sample, 6 channels at 96,000 frames per
+ * second.  */
+static const guchar flac_24_header[] = {
+  'f', 'L', 'a', 'C',
+  0x00, 0x00, 0x00, 0x22,
+  0x10, 0x00, 0x10, 0x00,
+  0x00, 0x00, 0x10, 0x00, 0x9c, 0x40,
+  0x17, 0x70, 0x0b, 0x70,
+  0x00, 0x01, 0x77, 0x00,
+  0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* The first page of an Ogg Opus file: 2 channels.  */
+static const guchar opus_header[] = {
+  'O', 'g', 'g', 'S', 0x00, 0x02,
+  0, 0, 0, 0, 0, 0, 0, 0,       /* granule position */
+  0x2a, 0x00, 0x00, 0x00,       /* serial number */
+  0, 0, 0, 0,                   /* page sequence */
+  0x5b, 0x6a, 0x17, 0x3c,       /* checksum */
+  0x01, 0x13,                   /* one segment of 19 bytes */
+  'O', 'p', 'u', 's', 'H', 'e', 'a', 'd',
+  0x01, 0x02, 0x38, 0x01, 0x80, 0xbb, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/* Write a header to a file and read it back.  */
+static void
+check_header (const gchar *directory, const gchar *name,
+              const guchar *header, gsize size, const gchar *format_name,
+              gint channel_count, gint sample_rate)
+{
+  struct sound_info sound_data;
+  gchar *file_name;
+  GError *error = NULL;
+
+  file_name = g_build_filename (directory, name, NULL);
+  if (!g_file_set_contents (file_name, (const gchar *) header, size, &error))
+    {
+      g_printerr ("Unable to write %s: %s.\n", file_name, error->message);
+      exit (EXIT_FAILURE);
+    }
+
+  memset (&sound_data, 0, sizeof (sound_data));
+  g_assert (decoder_is_compressed ((const gchar *) header));
+  g_assert (decoder_parse_header (file_name, &sound_data) == 1);
+  g_assert_cmpstr (sound_data.format_name, ==, format_name);
+  g_assert_cmpint (sound_data.channel_count, ==, channel_count);
+  g_assert_cmpint (sound_data.sample_rate, ==, sample_rate);
+
+  g_remove (file_name);
+  g_free (file_name);
+  return;
+}
+
+int
+main (int argc, char *argv[])
+{
+  gchar *directory;
+  GError *error = NULL;
+
+  directory = g_dir_make_tmp ("decoder_check_XXXXXX", &error);
+  if (directory == NULL)
+    {
+      g_printerr ("Unable to make a directory: %s.\n", error->message);
+      return (EXIT_FAILURE);
+    }
+
+  check_header (directory, "stereo.flac", flac_header, sizeof (flac_header),
+                "S16LE", 2, 44100);
+  check_header (directory, "surround.flac", flac_24_header,
+                sizeof (flac_24_header), "S24LE", 6, 96000);
+  check_header (directory, "stereo.opus", opus_header, sizeof (opus_header),
+                "F32LE", 2, 48000);
+
+  g_rmdir (directory);
+  g_free (directory);
+  g_print ("Decoder headers OK.\n");
+  return (EXIT_SUCCESS);
+}
+
+/* End of file decoder_check.c */
@@ -0,0 +1,529 @@
+/*
+ * decoder_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include "decoder_subroutines.h"
+
+/* A sound file may be compressed with FLAC, or with Opus in an Ogg
+ * container, rather than being a WAV file.  The looper plays only
+ * uncompressed samples, so the loader decodes such a file on one of
+ * its threads, using a small Gstreamer pipeline of its own, and gives
+ * the looper the result just as if it had been read from a WAV file.
+ * Playing the sound costs no more than if it had not been compressed.
+ *
+ * Decoding takes much longer than reading, so we save the decoded
+ * samples as a WAV file in the user's cache directory, and read that
+ * instead the next time, unless the sound file has changed since.
+ * Beside it we keep the size and modification time the sound file had
+ * when it was decoded; both must match exactly, since a file may be
+ * replaced by an older one.  */
+
+#define TRACE_DECODER FALSE
+
+/* How long to wait for the decoding pipeline before checking it for
+ * errors.  */
+#define DECODER_POLL_INTERVAL (100 * GST_MSECOND)
+
+/* Return the number of bytes in a sample of the given format.  */
+static gint
+decoder_sample_size (const gchar *format_name)
+{
+  if (g_strcmp0 (format_name, "U8") == 0)
+    return 1;
+  if (g_strcmp0 (format_name, "S16LE") == 0)
+    return 2;
+  if (g_strcmp0 (format_name, "S24LE") == 0)
+    return 3;
+  if (g_strcmp0 (format_name, "F64LE") == 0)
+    return 8;
+  return 4;
+}
+
+/* Return TRUE if the first four bytes of a sound file show that it is
+ * compressed.  */
+gboolean
+decoder_is_compressed (const gchar *magic)
+{
+  return ((memcmp (magic, "fLaC", 4) == 0)
+          || (memcmp (magic, "OggS", 4) == 0));
+}
+
+/* Learn about a FLAC file from its STREAMINFO block, which must be
+ * the first metadata block.  The file has been read just past its
+ * "fLaC" marker, so the next four bytes are the header of that block:
+ * a last-block flag and 7 bits of block type, which is 0 for
+ * STREAMINFO, then 24 bits of length.  The samples are decoded into
+ * the smallest of our formats that holds them without loss.  */
+static gint
+decoder_parse_flac_header (FILE *file_stream, const gchar *file_name,
+                           struct sound_info *sound_effect)
+{
+  guchar header[4];
+  guchar stream_info[34];
+  gint sample_rate, channel_count, bits_per_sample;
+
+  if ((fread (header, 1, 4, file_stream) != 4)
+      || ((header[0] & 0x7F) != 0)
+      || (fread (stream_info, 1, 34, file_stream) != 34))
+    {
+      g_printerr ("File \"%s\" has no FLAC stream information.\n",
+                  file_name);
+      return 0;
+    }
+
+  /* After the block and frame sizes, in the first 10 bytes, the
+   * sample rate is 20 bits, then the channel count less one is 3 bits
+   * and the bits per sample less one is 5 bits.  */
+  sample_rate = (stream_info[10] << 12) | (stream_info[11] << 4)
+    | (stream_info[12] >> 4);
+  channel_count = ((stream_info[12] >> 1) & 0x07) + 1;
+  bits_per_sample = (((stream_info[12] & 0x01) << 4)
+                     | (stream_info[13] >> 4)) + 1;
+
+  if (sample_rate == 0)
+    {
+      g_printerr ("FLAC file \"%s\" has no sample rate.\n", file_name);
+      return 0;
+    }
+
+  if (bits_per_sample <= 16)
+    sound_effect->format_name = "S16LE";
+  else if (bits_per_sample <= 24)
+    sound_effect->format_name = "S24LE";
+  else
+    sound_effect->format_name = "S32LE";
+  sound_effect->channel_count = channel_count;
+  sound_effect->sample_rate = sample_rate;
+  return 1;
+}
+
+/* Learn about an Ogg file from the identification header of the
+ * stream on its first page, which must be Opus.  Opus always decodes
+ * at 48,000 frames per second, and into floating point.  */
+static gint
+decoder_parse_ogg_header (FILE *file_stream, const gchar *file_name,
+                          struct sound_info *sound_effect)
+{
+  guchar page_header[27];
+  guchar segment_table[255];
+  guchar opus_header[19];
+  gint segment_count;
+
+  if (fread (page_header, 1, 27, file_stream) != 27)
+    {
+      g_printerr ("File \"%s\" has no Ogg page header.\n", file_name);
+      return 0;
+    }
+  segment_count = page_header[26];
+  if ((fread (segment_table, 1, segment_count, file_stream)
+       != (gsize) segment_count)
+      || (fread (opus_header, 1, 19, file_stream) != 19)
+      || (memcmp (opus_header, "OpusHead", 8) != 0))
+    {
+      g_printerr ("Ogg file \"%s\" does not hold an Opus stream.\n",
+                  file_name);
+      return 0;
+    }
+
+  sound_effect->format_name = "F32LE";
+  sound_effect->channel_count = opus_header[9];
+  sound_effect->sample_rate = 48000;
+  return 1;
+}
+
+/* Learn the format, channel count and sample rate of a compressed sound
+ * file.  This runs on a loader thread.  */
+gint
+decoder_parse_header (const gchar *file_name, struct sound_info *sound_effect)
+{
+  FILE *file_stream;
+  gchar magic[4];
+  gint return_value;
+
+  file_stream = fopen (file_name, "rb");
+  if (file_stream == NULL)
+    {
+      g_printerr ("Failed to open file \"%s\": %s.\n",
+                  file_name, strerror (errno));
+      return 0;
+    }
+
+  return_value = 0;
+  if (fread (magic, 1, 4, file_stream) == 4)
+    {
+      if (memcmp (magic, "fLaC", 4) == 0)
+        return_value =
+          decoder_parse_flac_header (file_stream, file_name, sound_effect);
+      else if (memcmp (magic, "OggS", 4) == 0)
+        {
+          rewind (file_stream);
+          return_value =
+            decoder_parse_ogg_header (file_stream, file_name, sound_effect);
+        }
+    }
+  fclose (file_stream);
+
+  if (TRACE_DECODER && (return_value == 1))
+    {
+      g_print ("File %s decodes to %s with %d channels at %d frames "
+               "per second.\n", file_name, sound_effect->format_name,
+               sound_effect->channel_count, sound_effect->sample_rate);
+    }
+  return return_value;
+}
+
+/* Decode a compressed sound file.  This runs on a loader thread, and
+ * the pipeline it builds is not part of the application's pipeline.  */
+GstBuffer *
+decoder_decode_file (const gchar *file_name, const gchar *format_name,
+                     gint channel_count, gint sample_rate,
+                     guint64 max_duration_time)
+{
+  GstElement *pipeline_element, *source_element, *filter_element;
+  GstElement *sink_element;
+  GstCaps *caps;
+  GstSample *sample;
+  GstBus *bus;
+  GstMessage *message;
+  GError *error = NULL;
+  gchar *debug_info = NULL;
+  guint64 max_size, fill_level, capacity, needed_size;
+  gsize block_size;
+  guchar *data;
+  gboolean failed;
+  GstBuffer *buffer;
+
+  pipeline_element =
+    gst_parse_launch ("filesrc name=source ! decodebin ! audioconvert "
+                      "! audioresample ! capsfilter name=filter "
+                      "! appsink name=sink sync=false", &error);
+  if (pipeline_element == NULL)
+    {
+      g_printerr ("Unable to create the decoder for \"%s\": %s.\n",
+                  file_name, error->message);
+      g_error_free (error);
+      return (NULL);
+    }
+  if (error != NULL)
+    {
+      /* A recoverable error, such as a missing decoder.  We will find
+       * out when we try to decode.  */
+      g_error_free (error);
+      error = NULL;
+    }
+
+  /* Tell the decoder where to find the file, and to produce the same
+   * samples the looper expects.  */
+  source_element =
+    gst_bin_get_by_name (GST_BIN (pipeline_element), (gchar *) "source");
+  filter_element =
+    gst_bin_get_by_name (GST_BIN (pipeline_element), (gchar *) "filter");
+  sink_element =
+    gst_bin_get_by_name (GST_BIN (pipeline_element), (gchar *) "sink");
+  g_object_set (source_element, "location", file_name, NULL);
+  caps =
+    gst_caps_new_simple ("audio/x-raw", "format", G_TYPE_STRING, format_name,
+                         "rate", G_TYPE_INT, sample_rate, "channels",
+                         G_TYPE_INT, channel_count, "layout", G_TYPE_STRING,
+                         "interleaved", NULL);
+  g_object_set (filter_element, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  gst_object_unref (source_element);
+  gst_object_unref (filter_element);
+
+  max_size = 0;
+  if (max_duration_time > 0)
+    {
+      max_size =
+        gst_util_uint64_scale_ceil (max_duration_time,
+                                    (guint64) sample_rate * channel_count
+                                    * decoder_sample_size (format_name),
+                                    GST_SECOND);
+    }
+
+  /* Collect the samples into one block, which grows geometrically.  */
+  fill_level = 0;
+  capacity = 0;
+  data = NULL;
+  failed = FALSE;
+  bus = gst_element_get_bus (pipeline_element);
+  gst_element_set_state (pipeline_element, GST_STATE_PLAYING);
+  for (;;)
+    {
+      if ((max_size > 0) && (fill_level >= max_size))
+        break;
+
+      sample =
+        gst_app_sink_try_pull_sample (GST_APP_SINK (sink_element),
+                                      DECODER_POLL_INTERVAL);
+      if (sample != NULL)
+        {
+          block_size = gst_buffer_get_size (gst_sample_get_buffer (sample));
+          needed_size = fill_level + block_size;
+          if (needed_size > capacity)
+            {
+              capacity = MAX (needed_size, capacity * 2);
+              data = g_realloc (data, capacity);
+            }
+          gst_buffer_extract (gst_sample_get_buffer (sample), 0,
+                              data + fill_level, block_size);
+          fill_level = needed_size;
+          gst_sample_unref (sample);
+          continue;
+        }
+
+      if (gst_app_sink_is_eos (GST_APP_SINK (sink_element)))
+        break;
+
+      /* Nothing arrived.  Perhaps the decoder has failed.  */
+      message = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+      if (message != NULL)
+        {
+          gst_message_parse_error (message, &error, &debug_info);
+          g_printerr ("Failed to decode \"%s\": %s.\n", file_name,
+                      error->message);
+          if (TRACE_DECODER)
+            {
+              g_print ("Debugging information: %s.\n",
+                       debug_info ? debug_info : "none");
+            }
+          g_clear_error (&error);
+          g_free (debug_info);
+          debug_info = NULL;
+          gst_message_unref (message);
+          failed = TRUE;
+          break;
+        }
+    }
+
+  gst_element_set_state (pipeline_element, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (sink_element);
+  gst_object_unref (pipeline_element);
+
+  if (failed)
+    {
+      g_free (data);
+      return (NULL);
+    }
+
+  if (TRACE_DECODER)
+    {
+      g_print ("Decoded %" G_GUINT64_FORMAT " bytes from %s.\n",
+               fill_level, file_name);
+    }
+  if (data == NULL)
+    return (gst_buffer_new ());
+  buffer = gst_buffer_new_wrapped (g_realloc (data, fill_level), fill_level);
+  return (buffer);
+}
+
+/* Construct the name of the cache file for a compressed sound file.
+ * Sound files are distinguished by a hash of their names.  */
+static gchar *
+decoder_cache_file_name (const gchar *file_name)
+{
+  gchar *checksum;
+  gchar *base_name;
+  gchar *cache_name;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, file_name, -1);
+  base_name = g_strconcat (checksum, ".wav", NULL);
+  cache_name = g_build_filename (g_get_user_cache_dir (),
+                                 (gchar *) "sound_effects_player",
+                                 (gchar *) "decoded", base_name, NULL);
+  g_free (base_name);
+  g_free (checksum);
+  return (cache_name);
+}
+
+/* Describe the size and modification time of a sound file, as it is
+ * recorded beside its decoded samples.  Returns NULL if the file
+ * cannot be examined.  */
+static gchar *
+decoder_source_stamp (const gchar *file_name)
+{
+  GStatBuf file_stat;
+
+  if (g_stat (file_name, &file_stat) != 0)
+    return (NULL);
+  return (g_strdup_printf ("%" G_GINT64_FORMAT " %" G_GINT64_FORMAT "\n",
+                           (gint64) file_stat.st_size,
+                           ((gint64) file_stat.st_mtim.tv_sec
+                            * G_GINT64_CONSTANT (1000000000))
+                           + file_stat.st_mtim.tv_nsec));
+}
+
+/* The name of the file beside the decoded samples which records the
+ * sound file they were decoded from.  */
+static gchar *
+decoder_stamp_file_name (const gchar *cache_name)
+{
+  return (g_strconcat (cache_name, ".source", NULL));
+}
+
+/* Find the cached decoded samples of a compressed sound file.  They are
+ * not used unless the sound file has the same size and modification
+ * time as when they were written.  */
+gchar *
+decoder_find_cached_file (const gchar *file_name)
+{
+  gchar *cache_name, *stamp_name;
+  gchar *current_stamp, *cached_stamp;
+  gboolean valid;
+
+  cache_name = decoder_cache_file_name (file_name);
+  stamp_name = decoder_stamp_file_name (cache_name);
+  current_stamp = decoder_source_stamp (file_name);
+  cached_stamp = NULL;
+  valid = ((current_stamp != NULL)
+           && g_file_get_contents (stamp_name, &cached_stamp, NULL, NULL)
+           && (g_strcmp0 (current_stamp, cached_stamp) == 0)
+           && g_file_test (cache_name, G_FILE_TEST_IS_REGULAR));
+  g_free (cached_stamp);
+  g_free (current_stamp);
+  g_free (stamp_name);
+  if (!valid)
+    {
+      g_free (cache_name);
+      return (NULL);
+    }
+
+  if (TRACE_DECODER)
+    {
+      g_print ("Using %s for %s.\n", cache_name, file_name);
+    }
+  return (cache_name);
+}
+
+/* Store a 32-bit or 16-bit integer in little-endian order.  */
+static void
+decoder_put_uint32 (guchar *place, guint32 value)
+{
+  value = GUINT32_TO_LE (value);
+  memcpy (place, &value, 4);
+  return;
+}
+
+static void
+decoder_put_uint16 (guchar *place, guint16 value)
+{
+  value = GUINT16_TO_LE (value);
+  memcpy (place, &value, 2);
+  return;
+}
+
+/* Save the decoded samples of a compressed sound file.  The file is
+ * written under a temporary name and then renamed, so that another
+ * copy of the program never reads a partly written file.  The record
+ * of the sound file is removed first and written last, so it never
+ * vouches for samples it does not describe.  Failure is not serious:
+ * we will just decode the sound again next time.  */
+void
+decoder_write_cached_file (const gchar *file_name, GstBuffer *data,
+                           const gchar *format_name, gint channel_count,
+                           gint sample_rate)
+{
+  gchar *cache_name, *directory_name, *temporary_name;
+  gchar *stamp_name, *stamp;
+  guchar header[44];
+  GstMapInfo info;
+  FILE *file_stream;
+  gint block_align;
+  gboolean written;
+
+  /* The WAV size fields are 32 bits.  */
+  if (gst_buffer_get_size (data) > G_MAXUINT32 - 36)
+    return;
+
+  stamp = decoder_source_stamp (file_name);
+  if (stamp == NULL)
+    return;
+
+  cache_name = decoder_cache_file_name (file_name);
+  stamp_name = decoder_stamp_file_name (cache_name);
+  directory_name = g_path_get_dirname (cache_name);
+  g_mkdir_with_parents (directory_name, 0700);
+  g_free (directory_name);
+  g_unlink (stamp_name);
+  /* Two sounds may use the same file, and be decoded at once on
+   * different threads.  */
+  temporary_name =
+    g_strdup_printf ("%s.%p.new", cache_name, (void *) g_thread_self ());
+
+  /* The header holds a format chunk of 16 bytes, which is all that
+   * sound_parse_wav_file_header and the loader read, and a data
+   * chunk.  Floating point samples have format code 3.  */
+  block_align = channel_count * decoder_sample_size (format_name);
+  memcpy (&header[0], "RIFF", 4);
+  decoder_put_uint32 (&header[4], 36 + gst_buffer_get_size (data));
+  memcpy (&header[8], "WAVEfmt ", 8);
+  decoder_put_uint32 (&header[16], 16);
+  decoder_put_uint16 (&header[20], (format_name[0] == 'F') ? 3 : 1);
+  decoder_put_uint16 (&header[22], channel_count);
+  decoder_put_uint32 (&header[24], sample_rate);
+  decoder_put_uint32 (&header[28], sample_rate * block_align);
+  decoder_put_uint16 (&header[32], block_align);
+  decoder_put_uint16 (&header[34],
+                      8 * decoder_sample_size (format_name));
+  memcpy (&header[36], "data", 4);
+  decoder_put_uint32 (&header[40], gst_buffer_get_size (data));
+
+  written = FALSE;
+  file_stream = g_fopen (temporary_name, "wb");
+  if (file_stream != NULL)
+    {
+      gst_buffer_map (data, &info, GST_MAP_READ);
+      written = ((fwrite (header, 1, 44, file_stream) == 44)
+                 && (fwrite (info.data, 1, info.size, file_stream)
+                     == info.size));
+      gst_buffer_unmap (data, &info);
+      if (fclose (file_stream) != 0)
+        written = FALSE;
+    }
+
+  if (written && (g_rename (temporary_name, cache_name) == 0)
+      && g_file_set_contents (stamp_name, stamp, -1, NULL))
+    {
+      if (TRACE_DECODER)
+        {
+          g_print ("Saved the decoded samples of %s in %s.\n", file_name,
+                   cache_name);
+        }
+    }
+  else
+    {
+      g_printerr ("Unable to save the decoded samples of \"%s\" "
+                  "in \"%s\".\n", file_name, cache_name);
+      g_unlink (temporary_name);
+    }
+
+  g_free (temporary_name);
+  g_free (stamp_name);
+  g_free (stamp);
+  g_free (cache_name);
+  return;
+}
+
+/* End of file decoder_subroutines.c */
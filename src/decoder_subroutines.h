@@ -0,0 +1,55 @@
+/*
+ * decoder_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include "sound_structure.h"
+
+/* Subroutines defined in decoder_subroutines.c.  They do not use the
+ * application, so they may be called on the loader's threads.  */
+
+/* Return TRUE if the first four bytes of a sound file show that it is
+ * compressed, and so must be decoded rather than read.  */
+gboolean decoder_is_compressed (const gchar *magic);
+
+/* Learn the format, channel count and sample rate of a compressed sound
+ * file.  The format is the one the file will be decoded into.
+ * Return 1 on success, 0 on failure.  */
+gint decoder_parse_header (const gchar *file_name,
+                           struct sound_info *sound_effect);
+
+/* Decode a compressed sound file into samples of the given format.
+ * If max_duration_time is not zero we need decode only that much.
+ * Returns NULL if the file cannot be decoded.  */
+GstBuffer *decoder_decode_file (const gchar *file_name,
+                                const gchar *format_name, gint channel_count,
+                                gint sample_rate, guint64 max_duration_time);
+
+/* Return the name of the WAV file which holds the decoded samples of a
+ * compressed sound file, if the sound file has not changed since they
+ * were decoded, or NULL.  */
+gchar *decoder_find_cached_file (const gchar *file_name);
+
+/* Save the decoded samples of a compressed sound file as a WAV file in
+ * the user's cache directory, so that they need not be decoded again.  */
+void decoder_write_cached_file (const gchar *file_name, GstBuffer *data,
+                                const gchar *format_name, gint channel_count,
+                                gint sample_rate);
+
+/* End of file decoder_subroutines.h */
@@ -21,25 +21,167 @@
 #include "display_subroutines.h"
 #include "sound_subroutines.h"
 #include "sound_effects_player.h"
+#include "main.h"
 
 #define TRACE_DISPLAY FALSE
 
-/* The persistent data used by the display subroutines.  */
+/* The most output channels the VU meter can show.  */
+#define DISPLAY_MAX_CHANNELS 64
+
+/* The persistent data used by the display subroutines.  The widgets
+ * we update are found once, when the display subroutines are
+ * initialized, rather than by searching the window each time.
+ * Frequent updates, the VU meter levels and the activity text, are
+ * held until the window is next drawn, so only the latest value is
+ * shown and we do the work at most once per frame.  */
 struct display_info
 {
   GtkWidget *VU_meter;
-  gint initialized;
+  gint initialized;             /* the channel names have been set */
+  gboolean headless;            /* There is no window.  Messages go to
+                                 * standard output and everything else
+                                 * is ignored.  */
+  guint message_count;          /* message IDs issued when headless */
+  gint channel_count;           /* the number of channels in the meter */
+  GtkLabel *channel_label[DISPLAY_MAX_CHANNELS];
+  GtkLevelBar *channel_level_bar[DISPLAY_MAX_CHANNELS];
+  gdouble channel_value[DISPLAY_MAX_CHANNELS];
+  gboolean channel_changed[DISPLAY_MAX_CHANNELS];
+  gboolean levels_changed;
+  GtkLabel *activity_label;
+  gchar *activity_text;         /* waiting to be shown, or NULL */
+  GtkLabel *master_volume_label;
+  struct display_cluster_info clusters[DISPLAY_CLUSTER_COUNT];
+  guint tick_id;                /* the frame clock callback, or 0 */
 };
 
+/* Find a widget with the specified name within a container.  */
+static GtkWidget *
+find_named_widget (GtkWidget *container, const gchar *name)
+{
+  GList *children_list, *l;
+  GtkWidget *found_widget;
+
+  if (container == NULL)
+    return NULL;
+  found_widget = NULL;
+  children_list = gtk_container_get_children (GTK_CONTAINER (container));
+  for (l = children_list; l != NULL; l = l->next)
+    {
+      if (g_strcmp0 (gtk_widget_get_name (l->data), name) == 0)
+        {
+          found_widget = l->data;
+          break;
+        }
+      if (GTK_IS_CONTAINER (l->data))
+        {
+          found_widget = find_named_widget (l->data, name);
+          if (found_widget != NULL)
+            break;
+        }
+    }
+  g_list_free (children_list);
+  return found_widget;
+}
+
+/* Find the widgets in the VU meter: a box for each channel, named by
+ * its channel number, holding a label and a level bar.  */
+static void
+find_VU_meter_widgets (struct display_info *display_data)
+{
+  GList *children_list, *l;
+  GtkWidget *child_widget;
+  gint64 channel_number;
+
+  children_list =
+    gtk_container_get_children (GTK_CONTAINER (display_data->VU_meter));
+  for (l = children_list; l != NULL; l = l->next)
+    {
+      child_widget = l->data;
+      channel_number =
+        g_ascii_strtoll (gtk_widget_get_name (child_widget), NULL, 10);
+      if ((channel_number < 0) || (channel_number >= DISPLAY_MAX_CHANNELS))
+        continue;
+      display_data->channel_label[channel_number] =
+        GTK_LABEL (find_named_widget (child_widget, "label"));
+      display_data->channel_level_bar[channel_number] =
+        GTK_LEVEL_BAR (find_named_widget (child_widget, "LEVEL_BAR"));
+      if (channel_number >= display_data->channel_count)
+        display_data->channel_count = channel_number + 1;
+    }
+  g_list_free (children_list);
+  return;
+}
+
+/* Find the widgets in a cluster.  */
+static void
+find_cluster_widgets (GtkWidget *cluster_widget, guint cluster_number,
+                      struct display_cluster_info *cluster_info)
+{
+  cluster_info->cluster_widget = cluster_widget;
+  cluster_info->cluster_number = cluster_number;
+  cluster_info->title_label =
+    GTK_LABEL (find_named_widget (cluster_widget, "title"));
+  cluster_info->start_button =
+    GTK_BUTTON (find_named_widget (cluster_widget, "start_button"));
+  cluster_info->volume_label =
+    GTK_LABEL (find_named_widget (cluster_widget, "volume_label"));
+  cluster_info->volume_button =
+    GTK_SCALE_BUTTON (find_named_widget (cluster_widget, "volume"));
+  cluster_info->pan_label =
+    GTK_LABEL (find_named_widget (cluster_widget, "pan_label"));
+  cluster_info->pan_button =
+    GTK_SCALE_BUTTON (find_named_widget (cluster_widget, "pan_button"));
+
+  /* Let the button callbacks, which are given the cluster widget,
+   * find the other widgets in the cluster.  */
+  g_object_set_data (G_OBJECT (cluster_widget), "cluster_info",
+                     cluster_info);
+  return;
+}
+
 /* Subroutines for display progessing.  */
 void *
 display_init (GApplication *app)
 {
   struct display_info *display_data;
+  GtkWidget *common_area;
+  GtkWidget *master_volume;
+  GtkWidget *cluster_widget;
+  guint cluster_number;
 
-  display_data = g_malloc (sizeof (struct display_info));
+  display_data = g_malloc0 (sizeof (struct display_info));
   display_data->VU_meter = NULL;
   display_data->initialized = 0;
+  display_data->headless = main_get_headless ();
+  display_data->message_count = 0;
+  display_data->activity_text = NULL;
+  display_data->tick_id = 0;
+  if (display_data->headless)
+    return (display_data);
+
+  /* Find the VU meter, the activity label and the master volume label
+   * in the common area.  */
+  common_area = sep_get_common_area (app);
+  display_data->VU_meter = find_named_widget (common_area, "VU_meter");
+  if (display_data->VU_meter != NULL)
+    find_VU_meter_widgets (display_data);
+  display_data->activity_label =
+    GTK_LABEL (find_named_widget (common_area, "activity"));
+  master_volume = find_named_widget (common_area, "master_volume");
+  display_data->master_volume_label =
+    GTK_LABEL (find_named_widget (master_volume, "volume_label"));
+
+  /* Find the widgets in each cluster.  */
+  for (cluster_number = 0; cluster_number < DISPLAY_CLUSTER_COUNT;
+       cluster_number++)
+    {
+      cluster_widget = sep_get_cluster_from_number (cluster_number, app);
+      if (cluster_widget != NULL)
+        find_cluster_widgets (cluster_widget, cluster_number,
+                              &display_data->clusters[cluster_number]);
+    }
+
   return (display_data);
 }
 
@@ -48,115 +190,140 @@ display_finish (GApplication *app)
 {
   struct display_info *display_data;
 
+  /* The main loop has stopped, so any pending frame clock callback
+   * will not run.  */
   display_data = sep_get_display_data (app);
+  g_free (display_data->activity_text);
   g_free (display_data);
   display_data = NULL;
   return;
 }
 
-/* Initialize the display data.  We need the sound data to be complete,
- * so we defer this until the first time we update the VU meter.  */
-void
-initialize_display_data (GApplication *app)
+/* Find the widgets in a cluster, given its number.  Return NULL if
+ * there is no such cluster.  */
+struct display_cluster_info *
+display_get_cluster (guint cluster_number, GApplication *app)
 {
   struct display_info *display_data;
-  GtkWidget *common_area;
-  GList *children_list, *l1;
-  GList *grandchildren_list, *l2;
-  GtkWidget *child_widget;
-  GtkWidget *grandchild_widget;
-  const gchar *child_name;
-  const gchar *grandchild_name;
-  GtkWidget *VU_meter = NULL;
-  GtkLabel *text_label;
-  gint64 channel_number;
+  struct display_cluster_info *cluster_info;
+
+  display_data = sep_get_display_data (app);
+  if (cluster_number >= DISPLAY_CLUSTER_COUNT)
+    return NULL;
+  cluster_info = &display_data->clusters[cluster_number];
+  if (cluster_info->cluster_widget == NULL)
+    return NULL;
+  return cluster_info;
+}
+
+/* Find the widgets in a cluster, given the cluster widget.  */
+struct display_cluster_info *
+display_get_cluster_from_widget (GtkWidget *cluster_widget)
+{
+  if (cluster_widget == NULL)
+    return NULL;
+  return g_object_get_data (G_OBJECT (cluster_widget), "cluster_info");
+}
+
+/* Find the label which shows the master volume.  */
+GtkLabel *
+display_get_master_volume_label (GApplication *app)
+{
+  struct display_info *display_data;
+
+  display_data = sep_get_display_data (app);
+  return display_data->master_volume_label;
+}
+
+/* Set the name of each output channel on the VU meter.  We need the
+ * sound data to be complete, so we defer this until the first time
+ * we update the VU meter.  */
+static void
+name_channels (struct display_info *display_data, GApplication *app)
+{
+  gint channel_number;
   gchar *speaker_abbreviation;
 
+  for (channel_number = 0; channel_number < display_data->channel_count;
+       channel_number++)
+    {
+      if (display_data->channel_label[channel_number] == NULL)
+        continue;
+      speaker_abbreviation = sound_output_channel_name (channel_number, app);
+      if (TRACE_DISPLAY)
+        {
+          g_print ("Setting the name of channel %d to \"%s\".\n",
+                   channel_number, speaker_abbreviation);
+        }
+      gtk_label_set_text (display_data->channel_label[channel_number],
+                          speaker_abbreviation);
+    }
+
+  /* We don't need to do this again.  */
+  display_data->initialized = 1;
+  return;
+}
+
+/* The window is about to be drawn.  Show the latest VU meter levels and
+ * activity text.  */
+static gboolean
+display_tick (GtkWidget *widget, GdkFrameClock *frame_clock,
+              gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct display_info *display_data;
+  gint channel;
+
   display_data = sep_get_display_data (app);
-  
-  /* Find the VU meter in the common area. */
-  common_area = sep_get_common_area (app);
-  children_list = gtk_container_get_children (GTK_CONTAINER (common_area));
-  l1 = children_list;
-  while (l1 != NULL)
+  if (display_data->levels_changed)
     {
-      child_widget = l1->data;
-      child_name = gtk_widget_get_name (child_widget);
-      if (g_ascii_strcasecmp (child_name, "global display") == 0)
+      for (channel = 0; channel < display_data->channel_count; channel++)
         {
-          grandchildren_list =
-	    gtk_container_get_children (GTK_CONTAINER (child_widget));
-	  l2 = grandchildren_list;
-	  
-          while (l2 != NULL)
+          if (!display_data->channel_changed[channel])
+            continue;
+          display_data->channel_changed[channel] = FALSE;
+          if (display_data->channel_level_bar[channel] == NULL)
+            continue;
+          if (TRACE_DISPLAY)
             {
-	      grandchild_widget = l2->data;
-              grandchild_name = gtk_widget_get_name (grandchild_widget);
-              if (g_ascii_strcasecmp (grandchild_name, "VU_meter") == 0)
-                {
-                  VU_meter = l2->data;
-                  break;
-                }
-              l2 = l2->next;
+              g_print ("VU meter %d set to %f.\n", channel,
+                       display_data->channel_value[channel]);
             }
-          g_list_free (grandchildren_list);
-	  grandchildren_list = NULL;
+          gtk_level_bar_set_value (display_data->channel_level_bar[channel],
+                                   display_data->channel_value[channel]);
         }
-
-      if (VU_meter != NULL)
-        break;
-      l1 = l1->next;
+      display_data->levels_changed = FALSE;
     }
-  g_list_free (children_list);
-  children_list = NULL;
-
-  /* If we didn't find the VU meter, do nothing.  */
-  if (VU_meter == NULL)
-    return;
-
-  /* Within the VU_meter box is a label and a level bar for each channel.  
-   * Set the name of each output channel.  */
-  children_list = gtk_container_get_children (GTK_CONTAINER (VU_meter));
-  l1 = children_list;
 
-  while (l1 != NULL)
+  if (display_data->activity_text != NULL)
     {
-      child_widget = l1->data;
-      child_name = gtk_widget_get_name (child_widget);
-      channel_number = g_ascii_strtoll (child_name, NULL, 10);
-      speaker_abbreviation = sound_output_channel_name (channel_number, app);
-      grandchildren_list =
-	gtk_container_get_children (GTK_CONTAINER (child_widget));
-      l2 = grandchildren_list;
-      while (l2 != NULL)
-	{
-	  grandchild_widget = l2->data;
-	  grandchild_name = gtk_widget_get_name (grandchild_widget);
-	  if (g_ascii_strcasecmp (grandchild_name, "label") == 0)
-	    {
-	      if (TRACE_DISPLAY)
-		{
-		  g_print ("Setting the name of channel %" G_GINT64_FORMAT
-			   " to \"%s\".\n",
-			   channel_number, speaker_abbreviation);
-		}
-	      text_label = GTK_LABEL (grandchild_widget);
-	      gtk_label_set_text (text_label, speaker_abbreviation);
-	    }
-	  l2 = l2->next;
-	}
-      g_list_free (grandchildren_list);
-      grandchildren_list = NULL;
-      l1 = l1->next;
+      if (display_data->activity_label != NULL)
+        gtk_label_set_text (display_data->activity_label,
+                            display_data->activity_text);
+      g_free (display_data->activity_text);
+      display_data->activity_text = NULL;
     }
-  g_list_free (children_list);
-  children_list = NULL;
 
-  /* Remember where the VU meter is.  */
-  display_data->VU_meter = VU_meter;
-  
-  /* We don't need to do this again.  */
-  display_data->initialized = 1;
+  /* We will be called again when there is something new to show.  */
+  display_data->tick_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+/* Arrange to update the display when the window is next drawn.  */
+static void
+schedule_tick (struct display_info *display_data, GApplication *app)
+{
+  GtkWindow *top_window;
+
+  if (display_data->tick_id != 0)
+    return;
+  top_window = sep_get_top_window (app);
+  if (top_window == NULL)
+    return;
+  display_data->tick_id =
+    gtk_widget_add_tick_callback (GTK_WIDGET (top_window), display_tick, app,
+                                  NULL);
+  return;
 }
 
 /* Update the VU meter. */
@@ -165,72 +332,24 @@ display_update_vu_meter (gpointer *user_data, gint channel,
                          gdouble new_value, gdouble peak_dB, gdouble decay_dB)
 {
   struct display_info *display_data;
-  GList *children_list, *l1;
-  GtkWidget *child_widget;
-  const gchar *child_name;
-  GtkWidget *VU_meter = NULL;
-  GtkWidget *this_meter = NULL;
-  GtkLevelBar *channel_level_bar = NULL;
-  gint64 channel_number;
   gdouble channel_value;
   GApplication *app;
 
   app = G_APPLICATION (user_data);
   display_data = sep_get_display_data (app);
+  if (display_data->headless)
+    return;
 
-  /* If we haven't done so already, find the VU meter and set the names
-   * of the output channels.  */
+  /* If we haven't done so already, set the names of the output
+   * channels.  */
   if (display_data->initialized == 0)
     {
-      initialize_display_data (app);
+      name_channels (display_data, app);
     }
-  VU_meter = display_data->VU_meter;
-  
-  /* Find the box for this channel. */
-  children_list = gtk_container_get_children (GTK_CONTAINER (VU_meter));
-  this_meter = NULL;
-  l1 = children_list;
-  
-  while (l1 != NULL)
-    {
-      child_widget = l1->data;
-      child_name = gtk_widget_get_name (child_widget);
-      channel_number = g_ascii_strtoll (child_name, NULL, 10);
-      if (channel_number == channel)
-	{
-	  this_meter = child_widget;
-	  break;
-	}
-      l1 = l1->next;
-    }
-  g_list_free (children_list);
-  children_list = NULL;
-  
-  if (this_meter == NULL)
-    return;
 
-  /* Now find the level bar within the box for this output channel.  */
-  children_list = gtk_container_get_children (GTK_CONTAINER (this_meter));
-  channel_level_bar = NULL;
-  l1 = children_list;
-  
-  while (l1 != NULL)
-    {
-      child_widget = l1->data;
-      child_name = gtk_widget_get_name (child_widget);
-      if (g_ascii_strcasecmp (child_name, "LEVEL_BAR") == 0)
-	{
-	  channel_level_bar = GTK_LEVEL_BAR (child_widget);
-	  break;
-	}
-      l1 = l1->next;
-    }
-  g_list_free (children_list);
-  children_list = NULL;
-  
-  if (channel_level_bar == NULL)
+  if ((channel < 0) || (channel >= display_data->channel_count))
     return;
-  	  
+
   /* Set the value of the level bar, between 0 and 1.  
    * Due to what appears to be a bug in level_bar, do not set it very small.  
    */
@@ -238,11 +357,11 @@ display_update_vu_meter (gpointer *user_data, gint channel,
   if (channel_value < 0.01)
     channel_value = 0.01;
 
-  if (TRACE_DISPLAY)
-    {
-      g_print ("VU meter %d set to %f.\n", channel, channel_value);
-    }
-  gtk_level_bar_set_value (channel_level_bar, channel_value);
+  /* Only the latest value is shown.  */
+  display_data->channel_value[channel] = channel_value;
+  display_data->channel_changed[channel] = TRUE;
+  display_data->levels_changed = TRUE;
+  schedule_tick (display_data, app);
 
   return;
 }
@@ -252,10 +371,20 @@ display_update_vu_meter (gpointer *user_data, gint channel,
 guint
 display_show_message (gchar * message_text, GApplication *app)
 {
+  struct display_info *display_data;
   GtkStatusbar *status_bar;
   guint context_id;
   guint message_id;
 
+  /* Without a status bar, the operator messages are a log.  */
+  display_data = sep_get_display_data (app);
+  if (display_data->headless)
+    {
+      g_print ("%s\n", message_text);
+      display_data->message_count = display_data->message_count + 1;
+      return display_data->message_count;
+    }
+
   /* Find the GUI's status display area.  */
   status_bar = sep_get_status_bar (app);
 
@@ -272,9 +401,14 @@ display_show_message (gchar * message_text, GApplication *app)
 void
 display_remove_message (guint message_id, GApplication *app)
 {
+  struct display_info *display_data;
   GtkStatusbar *status_bar;
   guint context_id;
 
+  display_data = sep_get_display_data (app);
+  if (display_data->headless)
+    return;
+
   /* Find the GUI's status display area.  */
   status_bar = sep_get_status_bar (app);
 
@@ -291,8 +425,13 @@ display_remove_message (guint message_id, GApplication *app)
 void
 display_set_operator_text (gchar *text_to_display, GApplication *app)
 {
+  struct display_info *display_data;
   GtkLabel *text_label;
 
+  display_data = sep_get_display_data (app);
+  if (display_data->headless)
+    return;
+
   /* Find the GUI's operator text area.  */
   text_label = sep_get_operator_text (app);
 
@@ -306,8 +445,13 @@ display_set_operator_text (gchar *text_to_display, GApplication *app)
 void
 display_clear_operator_text (GApplication *app)
 {
+  struct display_info *display_data;
   GtkLabel *text_label;
 
+  display_data = sep_get_display_data (app);
+  if (display_data->headless)
+    return;
+
   /*Find the GUI's operator text area.  */
   text_label = sep_get_operator_text (app);
 
@@ -317,62 +461,22 @@ display_clear_operator_text (GApplication *app)
   return;
 }
 
-/* Update the current activity information.  */
+/* Update the current activity information.  This is called up to ten
+ * times a second while a sound is playing, so the text is shown when the
+ * window is next drawn.  */
 void
 display_current_activity (gchar * activity_text, GApplication *app)
 {
-  GtkLabel *activity_label;
-  GtkWidget *common_area;
-  GtkWidget *child_widget;
-  GtkWidget *grandchild_widget;
-  GList *children_list, *l1;
-  GList *grandchildren_list, *l2;
-  const gchar *child_name;
-  const gchar *grandchild_name;
-
-  common_area = sep_get_common_area (app);
-
-  /* Find the activity information in the common area. */
-  activity_label = NULL;
-  children_list = gtk_container_get_children (GTK_CONTAINER (common_area));
-  l1 = children_list;
-  while (l1 != NULL)
-    {
-      child_widget = l1->data;
-      child_name = gtk_widget_get_name (child_widget);
-      if (g_ascii_strcasecmp (child_name, "global display") == 0)
-        {
-          grandchildren_list =
-            gtk_container_get_children (GTK_CONTAINER (child_widget));
-	  l2 = grandchildren_list;
-	  
-          while (l2 != NULL)
-            {
-	      grandchild_widget = l2->data;
-              grandchild_name =
-                gtk_widget_get_name (grandchild_widget);
-              if (g_ascii_strcasecmp (grandchild_name, "activity") == 0)
-                {
-                  activity_label = GTK_LABEL (grandchild_widget);
-                  break;
-                }
-              l2 = l2->next;
-            }
-          g_list_free (grandchildren_list);
-        }
-
-      if (activity_label != NULL)
-        break;
-      l1 = l1->next;
-    }
-  g_list_free (children_list);
+  struct display_info *display_data;
 
-  if (activity_label == NULL)
+  display_data = sep_get_display_data (app);
+  if (display_data->headless)
     return;
 
-  gtk_label_set_text (activity_label, activity_text);
+  g_free (display_data->activity_text);
+  display_data->activity_text = g_strdup (activity_text);
+  schedule_tick (display_data, app);
   return;
-
 }
 
 /* End of file display_subroutines.c  */
@@ -22,11 +22,37 @@
 
 #include <gtk/gtk.h>
 
+/* The number of clusters in the window.  */
+#define DISPLAY_CLUSTER_COUNT 16
+
+/* The widgets in a cluster, found when the display subroutines are
+ * initialized.  Any of them may be NULL if it is not in the
+ * user interface file.  */
+struct display_cluster_info
+{
+  GtkWidget *cluster_widget;
+  guint cluster_number;
+  GtkLabel *title_label;
+  GtkButton *start_button;
+  GtkLabel *volume_label;
+  GtkScaleButton *volume_button;
+  GtkLabel *pan_label;
+  GtkScaleButton *pan_button;
+};
+
 /* Subroutines defined in display_subroutines.c */
 void *display_init (GApplication *app);
 
 void display_finish (GApplication *app);
 
+struct display_cluster_info *display_get_cluster (guint cluster_number,
+                                                  GApplication *app);
+
+struct display_cluster_info *display_get_cluster_from_widget (GtkWidget
+                                                              *cluster_widget);
+
+GtkLabel *display_get_master_volume_label (GApplication *app);
+
 void display_update_vu_meter (gpointer *user_data, gint channel,
                               gdouble new_value, gdouble peak_dB,
                               gdouble decay_dB);
@@ -70,9 +70,15 @@
  * push mode if necessary.  An even faster alternative to getting the data in 
  * pull mode is to specify the file-location parameter.  Gstlooper will read 
  * the data segements from that file rather than wait for the data to come from 
- * upstream.  The metadata will still come from upstream.  The specified file 
- * must be a WAV file.  Default is that file-location is not specified, so
- * no file is read.
+ * upstream.  The metadata will still come from upstream, unless the
+ * caps property is specified.  The specified file must be a WAV file.
+ * Default is that file-location is not specified, so no file is read.
+ *
+ * #GstLooper:caps.  If specified, the format of the sound data, and this
+ * element is a source: it needs nothing upstream of it, and leaves its
+ * sink pad unlinked.  The data must come from the preloaded-data or
+ * file-location property.  Default is that caps is not specified, so the
+ * format comes from upstream.
  *
  * #GstLooper:release-duration-time.  The number of nanoseconds that the
  * sound will play after it is released.  G_MAXUINT64 means no limit.
@@ -85,6 +91,22 @@
  * sound.  If the sound will run forever, the value is G_MAXUINT64.
  * This is a read-only parameter.
  *
+ * #GstLooper:local-buffer-bytes.  The number of bytes of memory this
+ * element holds for the sound data, whether it read them itself or
+ * they were supplied through preloaded-data.  This is a read-only
+ * parameter.
+ *
+ * #GstLooper:pull-block-size.  When the sound data is pulled from
+ * upstream, the number of bytes to ask for in each pull.  Default is
+ * 1,048,576.
+ *
+ * #GstLooper:progress-interval.  If not zero, while the sound is playing
+ * this element posts a "progress" element message at most once per this
+ * many nanoseconds of sound, with the elapsed-time and remaining-time
+ * as unsigned 64-bit fields of the same names, so the application need
+ * not poll those properties.  One is also posted as soon as the sound
+ * starts and after it is released.  Default is 0: no messages.
+ *
  * Receipt of a Release message causes looping to terminate, which means 
  * reaching the end of the loop no longer causes sound to be sent from the 
  * beginning of the loop.  The amount of sound sent after a Release message can 
@@ -153,7 +175,13 @@ enum
   PROP_FILE_LOCATION,
   PROP_RELEASE_DURATION_TIME,
   PROP_ELAPSED_TIME,
-  PROP_REMAINING_TIME
+  PROP_REMAINING_TIME,
+  PROP_PRELOAD,
+  PROP_PRELOADED_DATA,
+  PROP_PROGRESS_INTERVAL,
+  PROP_PULL_BLOCK_SIZE,
+  PROP_CAPS,
+  PROP_LOCAL_BUFFER_BYTES
 };
 
 #define DEBUG_INIT \
@@ -173,6 +201,9 @@ static void gst_looper_set_property (GObject *object, guint prop_id,
                                      GParamSpec *pspec);
 /* Compute the remaining running time of the sound.  */
 static guint64 compute_remaining_time (GstLooper *object);
+
+/* Tell the application how far the sound has progressed.  */
+static void post_progress (GstLooper *self);
 /* fetch the value of a property */
 static void gst_looper_get_property (GObject *object, guint prop_id,
                                      GValue *value, GParamSpec *pspec);
@@ -227,6 +258,19 @@ static guint64 round_down_to_position (GstLooper *self,
 /* Read the data chunks from a WAV file into the local buffer.  */
 static gboolean read_wav_file_data (GstLooper *self, guint64 max_position);
 
+/* Fill the local buffer, once we know the format of the data.  */
+static void load_local_buffer (GstLooper *self);
+
+/* Learn the format of the sound data from its caps.  */
+static void set_format (GstLooper *self, GstCaps *in_caps);
+
+/* Begin sending sound without anything upstream.  */
+static void start_as_source (GstLooper *self);
+
+/* Make room in the local buffer, and add data to it.  */
+static gboolean reserve_local_buffer (GstLooper *self, guint64 size);
+static gboolean append_to_local_buffer (GstLooper *self, GstBuffer *buffer);
+
 /* GObject vmethod implementations */
 
 /* initialize the looper's class */
@@ -316,6 +360,51 @@ gst_looper_class_init (GstLooperClass *klass)
   g_object_class_install_property (gobject_class, PROP_REMAINING_TIME,
                                    param_spec);
 
+  param_spec =
+    g_param_spec_boolean ("preload", "Preload",
+                          "The sound data will be supplied through "
+                          "the preloaded-data property", FALSE,
+                          G_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_PRELOAD, param_spec);
+
+  param_spec =
+    g_param_spec_boxed ("preloaded-data", "Preloaded_data",
+                        "The data chunks of the WAV file, "
+                        "read by the application", GST_TYPE_BUFFER,
+                        G_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_PRELOADED_DATA,
+                                   param_spec);
+
+  param_spec =
+    g_param_spec_uint64 ("progress-interval", "Progress_interval",
+                         "Nanoseconds of sound between progress messages; "
+                         "0 means none", 0, G_MAXUINT64, 0,
+                         G_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_PROGRESS_INTERVAL,
+                                   param_spec);
+
+  param_spec =
+    g_param_spec_uint ("pull-block-size", "Pull_block_size",
+                       "Bytes of sound data to request from upstream "
+                       "in each pull", 4096, G_MAXINT,
+                       DEFAULT_PULL_BLOCK_SIZE, G_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_PULL_BLOCK_SIZE,
+                                   param_spec);
+
+  param_spec =
+    g_param_spec_boxed ("caps", "Caps",
+                        "The format of the sound data, if this element "
+                        "is to be the source of the sound", GST_TYPE_CAPS,
+                        G_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_CAPS, param_spec);
+
+  param_spec =
+    g_param_spec_uint64 ("local-buffer-bytes", "local_buffer_bytes",
+                         "Bytes of memory held for the sound data", 0,
+                         G_MAXUINT64, 0, G_PARAM_READABLE);
+  g_object_class_install_property (gobject_class, PROP_LOCAL_BUFFER_BYTES,
+                                   param_spec);
+
   g_free (string_default);
   string_default = NULL;
 
@@ -365,6 +454,8 @@ gst_looper_init (GstLooper *self)
   self->local_buffer_drain_level = 0;
   self->pull_level = 0;
   self->local_buffer_size = 0;
+  self->local_buffer_capacity = 0;
+  self->pull_block_size = DEFAULT_PULL_BLOCK_SIZE;
   self->bytes_per_ns = 0.0;
   self->local_clock = 0;
   self->elapsed_time = 0;
@@ -379,6 +470,11 @@ gst_looper_init (GstLooper *self)
   self->file_location = NULL;
   self->file_location_specified = FALSE;
   self->seen_incoming_data = FALSE;
+  self->preload_pending = FALSE;
+  self->preloaded_data = NULL;
+  self->source_caps = NULL;
+  self->progress_interval = 0;
+  self->progress_posted_time = G_MAXUINT64;
   g_rec_mutex_init (&self->interlock);
   self->silence_byte = 0;
   self->gap_time = G_MAXUINT64; /* Disable gaps: some sort of bug.  */
@@ -446,6 +542,16 @@ gst_looper_finalize (GObject *object)
       self->file_location = NULL;
       self->file_location_specified = FALSE;
     }
+  if (self->preloaded_data != NULL)
+    {
+      gst_buffer_unref (self->preloaded_data);
+      self->preloaded_data = NULL;
+    }
+  if (self->source_caps != NULL)
+    {
+      gst_caps_unref (self->source_caps);
+      self->source_caps = NULL;
+    }
   g_rec_mutex_clear (&self->interlock);
   G_OBJECT_CLASS (parent_class)->finalize (object);
   return;
@@ -518,6 +624,16 @@ gst_looper_change_state (GstElement *element, GstStateChange transition)
 
   switch (transition)
     {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      /* If we are the source of the sound, our source pad is now
+       * active, so we can tell downstream about the sound and start
+       * sending it.  */
+      if (self->source_caps != NULL)
+        {
+          start_as_source (self);
+        }
+      break;
+
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       g_rec_mutex_lock (&self->interlock);
 
@@ -738,7 +854,7 @@ gst_looper_push_data_downstream (GstPad *pad)
   /* If requested, or if we are autostarted and have reached the end of
    * the buffer, send an end-of-stream message and stop.  */
   if ((self->send_EOS)
-      || (self->autostart
+      || (self->autostart && self->data_buffered
           && (self->local_buffer_drain_level >= self->local_buffer_size)))
     {
       GST_INFO_OBJECT (self, "pushing an EOS event");
@@ -799,12 +915,12 @@ gst_looper_push_data_downstream (GstPad *pad)
       self->continued = FALSE;
     }
 
-  /* If we have not received a start event, or if we have completely
-   * drained the buffer, or we are paused, remember to send silence 
-   * downstream.  */
+  /* If we have not received a start event, or our data has not yet
+   * been loaded, or if we have completely drained the buffer, or we are
+   * paused, remember to send silence downstream.  */
   send_silence = FALSE;
   buffer_complete = FALSE;
-  if (!self->started)
+  if ((!self->started) || (!self->data_buffered))
     {
       send_silence = TRUE;
     }
@@ -1002,6 +1118,7 @@ gst_looper_push_data_downstream (GstPad *pad)
     self->elapsed_time + (memory_out_info.size / self->bytes_per_ns);
   GST_DEBUG_OBJECT (self, "elapsed time is %" G_GUINT64_FORMAT ".",
                     self->elapsed_time);
+  post_progress (self);
   /* Note the byte offsets in the source.  */
   GST_BUFFER_OFFSET (buffer) = self->local_buffer_drain_level;
   GST_BUFFER_OFFSET_END (buffer) =
@@ -1123,10 +1240,6 @@ static void
 gst_looper_pull_data_from_upstream (GstPad *pad)
 {
   GstLooper *self = GST_LOOPER (GST_PAD_PARENT (pad));
-  GstMemory *memory_allocated;
-  GstMapInfo memory_in_info, buffer_memory_info;
-  guint64 byte_offset;
-  char *byte_data_in_pointer, *byte_data_out_pointer;
   gboolean result, pull_result;
   guint64 max_position, start_position;
   gboolean max_duration_reached;
@@ -1148,7 +1261,8 @@ gst_looper_pull_data_from_upstream (GstPad *pad)
 
   /* If the local buffer has been filled, and we have already seen some data,
    * we don't need to run any more.  */
-  if ((self->data_buffered) && (self->seen_incoming_data))
+  if ((self->data_buffered || self->preload_pending)
+      && (self->seen_incoming_data))
     {
       GST_DEBUG_OBJECT (self, "pausing sink pad task");
       result = gst_pad_pause_task (self->sinkpad);
@@ -1163,7 +1277,8 @@ gst_looper_pull_data_from_upstream (GstPad *pad)
 
   /* Ask our upstream peer to give us some data.  */
   pull_result =
-    gst_pad_pull_range (pad, self->pull_level, BUFFER_SIZE, &pull_buffer);
+    gst_pad_pull_range (pad, self->pull_level, self->pull_block_size,
+                        &pull_buffer);
   if (pull_result == GST_FLOW_OK)
     {
       GST_DEBUG_OBJECT (self,
@@ -1172,8 +1287,10 @@ gst_looper_pull_data_from_upstream (GstPad *pad)
 
       /* If this is the first time we have seen any data from upstream, but
        * we already have all our data, which can only be true if we read
-       * the data directly from the WAV file, start pushing data downstream.  */
-      if ((self->data_buffered) && (!self->seen_incoming_data))
+       * the data directly from the WAV file, or the application is reading
+       * it for us, start pushing data downstream.  */
+      if ((self->data_buffered || self->preload_pending)
+          && (!self->seen_incoming_data))
         {
           /* Begin pushing data from our local buffer downstream using the
            * source pad.  Unless we are autostarted, that task will send 
@@ -1193,7 +1310,7 @@ gst_looper_pull_data_from_upstream (GstPad *pad)
       /* If our local buffer has already been filled, we have no need for
        * this additional data.  The next time around we will pause this task. 
        */
-      if (self->data_buffered)
+      if (self->data_buffered || self->preload_pending)
         {
           gst_buffer_unref (pull_buffer);
           g_rec_mutex_unlock (&self->interlock);
@@ -1267,55 +1384,21 @@ gst_looper_pull_data_from_upstream (GstPad *pad)
                                 NULL);
           self->src_pad_task_running = TRUE;
         }
+
+      /* We are done.  The next time around we will detect that the
+       * buffer has been filled and stop this task.  */
+      g_rec_mutex_unlock (&self->interlock);
+      return;
     }
-  /* We are done.  The next time around we will detect that the buffer has
-   * been filled and stop this task.  */
-  g_rec_mutex_unlock (&self->interlock);
-  return;
 
   /* We have a buffer from upstream and we have not already reached 
-   * max duration.  Accept the buffer.  */
-
-  /* Allocate more memory at the end of our local buffer, then copy
-   * the data in the received buffer to it.  */
-  GST_DEBUG_OBJECT (self, "map pulled buffer for reading");
-  result = gst_buffer_map (pull_buffer, &memory_in_info, GST_MAP_READ);
-  if (!result)
+   * max duration.  Accept the buffer, and ask for the data after it
+   * next time.  */
+  self->pull_level = self->pull_level + gst_buffer_get_size (pull_buffer);
+  if (!append_to_local_buffer (self, pull_buffer))
     {
-      GST_DEBUG_OBJECT (self, "unable to map pulled buffer for reading");
+      GST_DEBUG_OBJECT (self, "unable to add pulled data to local buffer");
     }
-  memory_allocated = gst_allocator_alloc (NULL, memory_in_info.size, NULL);
-  gst_buffer_append_memory (self->local_buffer, memory_allocated);
-  result =
-    gst_buffer_map (self->local_buffer, &buffer_memory_info, GST_MAP_WRITE);
-  if (!result)
-    {
-      GST_DEBUG_OBJECT (self, "unable to map local buffer for writing");
-    }
-  GST_DEBUG_OBJECT (self,
-                    "copy data from pulled buffer to local buffer"
-                    " at %p, memory at %p, offset %" G_GUINT64_FORMAT
-                    ", from %p, size %" G_GSIZE_FORMAT ".",
-                    self->local_buffer, buffer_memory_info.data,
-                    self->local_buffer_fill_level, memory_in_info.data,
-                    memory_in_info.size);
-  for (byte_offset = 0; byte_offset < memory_in_info.size;
-       byte_offset = byte_offset + 1)
-    {
-      byte_data_in_pointer = (void *) memory_in_info.data + byte_offset;
-      byte_data_out_pointer =
-        (void *) buffer_memory_info.data + self->local_buffer_fill_level +
-        byte_offset;
-      *byte_data_out_pointer = *byte_data_in_pointer;
-    }
-  gst_buffer_unmap (self->local_buffer, &buffer_memory_info);
-
-  /* Update our offset into the local buffer.  */
-  self->local_buffer_fill_level =
-    self->local_buffer_fill_level + memory_in_info.size;
-
-  /* We are done with the pulled buffer.  */
-  gst_buffer_unmap (pull_buffer, &memory_in_info);
   gst_buffer_unref (pull_buffer);
 
   g_rec_mutex_unlock (&self->interlock);
@@ -1328,10 +1411,6 @@ static GstFlowReturn
 gst_looper_chain (GstPad * pad, GstObject *parent, GstBuffer *buffer)
 {
   GstLooper *self = GST_LOOPER (parent);
-  GstMemory *memory_allocated;
-  GstMapInfo memory_in_info, buffer_memory_info;
-  guint64 byte_offset;
-  char *byte_data_in_pointer, *byte_data_out_pointer;
   gboolean result;
   guint64 max_position, start_position;
   gboolean max_duration_reached;
@@ -1347,7 +1426,8 @@ gst_looper_chain (GstPad * pad, GstObject *parent, GstBuffer *buffer)
   /* If we have already filled our local buffer, either because we have
    * received max-duration data or we loaded the data directly from the file, 
    * and we have already seen some data, discard any more.  */
-  if ((self->data_buffered) && (self->seen_incoming_data))
+  if ((self->data_buffered || self->preload_pending)
+      && (self->seen_incoming_data))
     {
       /* Discard the buffer from upstream.  */
       gst_buffer_unref (buffer);
@@ -1361,8 +1441,11 @@ gst_looper_chain (GstPad * pad, GstObject *parent, GstBuffer *buffer)
   /* If we have already filled our local buffer, but we are seeing data from
    * upstream for the first time, which can only happen if we filled the
    * buffer by reading sound data directly from the WAV file, start sending
-   * sound data from our local buffer downstream.  */
-  if ((self->data_buffered) && (!self->seen_incoming_data))
+   * sound data from our local buffer downstream.  If the application is
+   * still reading the WAV file for us, that task will send silence until
+   * the data arrives.  */
+  if ((self->data_buffered || self->preload_pending)
+      && (!self->seen_incoming_data))
     {
       self->seen_incoming_data = TRUE;
       /* Begin pushing data from our local buffer downstream using the 
@@ -1435,47 +1518,15 @@ gst_looper_chain (GstPad * pad, GstObject *parent, GstBuffer *buffer)
       return GST_FLOW_OK;
     }
 
-  /* Our local buffer has not been filled, and we have not reached max-duration.
-   * Allocate more memory at the end of our local buffer, then copy the data in
-   * the received buffer to it.  */
-  GST_DEBUG_OBJECT (self, "map received buffer for reading");
-  result = gst_buffer_map (buffer, &memory_in_info, GST_MAP_READ);
-  if (!result)
+  /* Our local buffer has not been filled, and we have not reached
+   * max-duration.  Copy the data in the received buffer to the end of
+   * our local buffer.  */
+  if (!append_to_local_buffer (self, buffer))
     {
-      GST_DEBUG_OBJECT (self, "unable to map received buffer for reading");
+      GST_DEBUG_OBJECT (self, "unable to add received data to local buffer");
     }
-  memory_allocated = gst_allocator_alloc (NULL, memory_in_info.size, NULL);
-  gst_buffer_append_memory (self->local_buffer, memory_allocated);
-  result =
-    gst_buffer_map (self->local_buffer, &buffer_memory_info, GST_MAP_WRITE);
-  if (!result)
-    {
-      GST_DEBUG_OBJECT (self, "unable to map local buffer for writing");
-    }
-  GST_DEBUG_OBJECT (self,
-                    "copy data from received buffer to local buffer"
-                    " at %p, memory at %p, offset %" G_GUINT64_FORMAT
-                    ", from %p, size %" G_GSIZE_FORMAT ".",
-                    self->local_buffer, buffer_memory_info.data,
-                    self->local_buffer_fill_level, memory_in_info.data,
-                    memory_in_info.size);
-  for (byte_offset = 0; byte_offset < memory_in_info.size;
-       byte_offset = byte_offset + 1)
-    {
-      byte_data_in_pointer = (void *) memory_in_info.data + byte_offset;
-      byte_data_out_pointer =
-        (void *) buffer_memory_info.data + self->local_buffer_fill_level +
-        byte_offset;
-      *byte_data_out_pointer = *byte_data_in_pointer;
-    }
-  gst_buffer_unmap (self->local_buffer, &buffer_memory_info);
-
-  /* Update our offset into the local buffer.  */
-  self->local_buffer_fill_level =
-    self->local_buffer_fill_level + memory_in_info.size;
 
   /* We are done with the received buffer.  */
-  gst_buffer_unmap (buffer, &memory_in_info);
   gst_buffer_unref (buffer);
 
   g_rec_mutex_unlock (&self->interlock);
@@ -1552,14 +1603,7 @@ gst_looper_handle_sink_event (GstPad *pad, GstObject *parent,
   gboolean result = TRUE;
   GstLooper *self = GST_LOOPER (parent);
   GstCaps *in_caps, *out_caps;
-  GstStructure *caps_structure;
-  gchar *format_code_pointer;
-  gchar format_code_0, format_code_1;
-  gdouble bits_per_second, bits_per_nanosecond;
   guint64 start_position;
-  gint data_rate, channel_count;
-  guint64 max_position;
-  gboolean wav_file_read;
 
   GST_DEBUG_OBJECT (self, "received an event on the sink pad");
 
@@ -1628,34 +1672,7 @@ gst_looper_handle_sink_event (GstPad *pad, GstObject *parent,
       g_rec_mutex_lock (&self->interlock);
       gst_event_parse_caps (event, &in_caps);
       GST_DEBUG_OBJECT (self, "input caps are %" GST_PTR_FORMAT ".", in_caps);
-      caps_structure = gst_caps_get_structure (in_caps, 0);
-      /* Fill in local information about the format, and values based on it.  
-       */
-      result = gst_structure_get_int (caps_structure, "rate", &data_rate);
-      if (!result)
-        {
-          GST_DEBUG_OBJECT (self, "no rate in caps");
-          data_rate = 48000;
-        }
-      self->data_rate = data_rate;
-
-      result =
-        gst_structure_get_int (caps_structure, "channels", &channel_count);
-      if (!result)
-        {
-          GST_DEBUG_OBJECT (self, "no channel count in caps");
-          channel_count = 2;
-        }
-      self->channel_count = channel_count;
-
-      g_free (self->format);
-      self->format =
-        g_strdup (gst_structure_get_string (caps_structure, "format"));
-      if (self->format == NULL)
-        {
-          GST_DEBUG_OBJECT (self, "no format in caps");
-          self->format = g_strdup (GST_AUDIO_NE (F64));
-        }
+      set_format (self, in_caps);
 
       out_caps =
         gst_caps_new_simple ("audio/x-raw", "format", G_TYPE_STRING,
@@ -1667,121 +1684,12 @@ gst_looper_handle_sink_event (GstPad *pad, GstObject *parent,
                         out_caps);
       gst_caps_unref (out_caps);
 
-      /* Compute the size of a frame from the format string.  
-       * The possible formats start with a letter, then the width of
-       * sample in bits, for example, F32LE.  The second character of
-       * the format can be used to determine the width.  */
-      format_code_pointer = self->format;
-      format_code_0 = format_code_pointer[0];
-      GST_LOG_OBJECT (self, "first character of format is %c.",
-                      format_code_0);
-      format_code_1 = format_code_pointer[1];
-      GST_LOG_OBJECT (self, "second character of format is %c.",
-                      format_code_1);
-      switch (format_code_1)
-        {
-        case '8':
-          self->width = 8;
-          break;
-        case '1':
-          self->width = 16;
-          break;
-        case '2':
-          self->width = 24;
-          break;
-        case '3':
-          self->width = 32;
-          break;
-        case '6':
-          self->width = 64;
-          break;
-        default:
-          self->width = 32;
-          break;
-        }
-      GST_DEBUG_OBJECT (self, "each sample has %" G_GUINT64_FORMAT " bits.",
-                        self->width);
-
-      /* Compute the silence value.  For signed and floating formats, it is 0.
-       * for unsigned it is 128 for U8, the only unsigned format we support.  */
-      switch (format_code_0)
+      /* Now that we have the format and data rate, fill the local buffer,
+       * unless the application is still reading the WAV file for us.
+       * In that case the buffer is filled when the data arrives.  */
+      if (!self->preload_pending)
         {
-        case 'S':
-        case 'F':
-          self->silence_byte = 0;
-          break;
-        case 'U':
-          self->silence_byte = 128;
-          break;
-        default:
-          self->silence_byte = 0;
-          break;
-        }
-      GST_DEBUG_OBJECT (self, "silence value is %hhd.", self->silence_byte);
-
-      /* Compute the data rate in bytes per nanosecond.
-       * data_rate times width times channel_count is bits per second.
-       * that divided by 1E9 is bits per nanosecond.
-       * that divided by 8 is bytes per nanosecond.  */
-      bits_per_second = self->data_rate * self->width * self->channel_count;
-      bits_per_nanosecond = (gdouble) bits_per_second / (gdouble) 1E9;
-      self->bytes_per_ns = bits_per_nanosecond / 8.0;
-      GST_DEBUG_OBJECT (self, "data rate is %f bytes per nanosecond.",
-                        self->bytes_per_ns);
-
-      /* If a WAV file was specified, this is a good time to read it.  We have
-       * the format and data rate, so we can convert max duration 
-       * to the maximum size of the local buffer.  */
-      if (self->file_location_specified)
-        {
-          max_position = 0;
-          if (self->max_duration > 0)
-            {
-              max_position = round_up_to_position (self, self->max_duration);
-            }
-
-          /* Read the data from the WAV file, up to the most we will need.  */
-          wav_file_read = read_wav_file_data (self, max_position);
-          if (wav_file_read)
-            {
-              /* We now have all our data.  */
-              self->data_buffered = TRUE;
-              GST_DEBUG_OBJECT (self, "read %" G_GUINT64_FORMAT
-				" bytes from WAV file.",
-                                self->local_buffer_fill_level);
-              /* We now know the size of our local buffer.  We may have filled 
-                 it beyond max-duration, but if so we will use only the data
-                 * up to max-duration.  */
-              if (self->max_duration > 0
-                  && max_position < self->local_buffer_fill_level)
-                {
-                  self->local_buffer_size = max_position;
-                }
-              else
-                {
-                  self->local_buffer_size = self->local_buffer_fill_level;
-                }
-
-              /* Set the position from which to start draining the buffer.  */
-              start_position =
-                round_down_to_position (self, self->start_time);
-              self->local_buffer_drain_level = start_position;
-
-              /* If the Autostart parameter has been set to TRUE, don't wait
-               * for a Start event.  */
-              if (self->autostart)
-                {
-                  self->started = TRUE;
-                  self->local_clock = 0;
-                  self->elapsed_time = 0;
-                }
-              /* It is too early to start pushing data downstream.  Wait until
-               * we get some data from upstream.  */
-            }
-          else
-            {
-              GST_DEBUG_OBJECT (self, "read from WAV file failed.");
-            }
+          load_local_buffer (self);
         }
 
       g_rec_mutex_unlock (&self->interlock);
@@ -1796,8 +1704,9 @@ gst_looper_handle_sink_event (GstPad *pad, GstObject *parent,
                        ".", self->local_buffer_fill_level);
 
       /* If we have already filled the buffer due to reaching max-duration, 
-       * we don't need to do anything here.  */
-      if (!self->data_buffered)
+       * or the application is supplying our data, we don't need to do
+       * anything here.  */
+      if ((!self->data_buffered) && (!self->preload_pending))
         {
           self->data_buffered = TRUE;
           /* We now know the size of our local buffer.  */
@@ -1938,6 +1847,7 @@ gst_looper_handle_src_event (GstPad *pad, GstObject *parent,
           start_position = round_down_to_position (self, self->start_time);
           self->local_buffer_drain_level = start_position;
           self->elapsed_time = 0;
+          self->progress_posted_time = G_MAXUINT64;
         }
 
       if (g_strcmp0 (structure_name, (gchar *) "pause") == 0)
@@ -1968,6 +1878,8 @@ gst_looper_handle_src_event (GstPad *pad, GstObject *parent,
 	    (gdouble) self->local_buffer_drain_level / self->bytes_per_ns;
 	  current_time_int = (guint64) current_time;
 	  self->release_start_time = current_time_int;
+          /* The remaining time has changed.  */
+          self->progress_posted_time = G_MAXUINT64;
         }
 
       if (g_strcmp0 (structure_name, (gchar *) "shutdown") == 0)
@@ -2015,11 +1927,46 @@ gst_looper_handle_src_query (GstPad *pad, GstObject *parent,
   gboolean seekable, peer_success;
   gint64 peer_pos;
   GstSchedulingFlags scheduling_flags = 0;
+  GstCaps *filter_caps, *result_caps;
   gboolean result;
 
   GST_DEBUG_OBJECT (self, "query on source pad or element");
   g_rec_mutex_lock (&self->interlock);
 
+  /* If we are the source of the sound there is nothing upstream to ask
+   * about its format or latency, so answer those queries here.  */
+  if (self->source_caps != NULL)
+    {
+      switch (GST_QUERY_TYPE (query))
+        {
+        case GST_QUERY_CAPS:
+          gst_query_parse_caps (query, &filter_caps);
+          if (filter_caps != NULL)
+            {
+              result_caps =
+                gst_caps_intersect_full (filter_caps, self->source_caps,
+                                         GST_CAPS_INTERSECT_FIRST);
+            }
+          else
+            {
+              result_caps = gst_caps_ref (self->source_caps);
+            }
+          gst_query_set_caps_result (query, result_caps);
+          gst_caps_unref (result_caps);
+          g_rec_mutex_unlock (&self->interlock);
+          return TRUE;
+
+        case GST_QUERY_LATENCY:
+          /* All of our data is in memory before we send it.  */
+          gst_query_set_latency (query, FALSE, 0, GST_CLOCK_TIME_NONE);
+          g_rec_mutex_unlock (&self->interlock);
+          return TRUE;
+
+        default:
+          break;
+        }
+    }
+
   switch (GST_QUERY_TYPE (query))
     {
     case GST_QUERY_POSITION:
@@ -2223,6 +2170,374 @@ round_down_to_position (GstLooper *self, guint64 specified_time)
   return byte_position;
 }
 
+/* Fill the local buffer, either from data the application has read
+ * for us or by reading the WAV file here.  We must know the format and
+ * data rate, so we can convert max duration to the maximum size
+ * of the local buffer.  The caller holds the interlock, since the
+ * caps handler, a property being set by the application and the
+ * data pusher may each get here or look at the local buffer.  */
+static void
+load_local_buffer (GstLooper *self)
+{
+  guint64 max_position;
+  guint64 start_position;
+  gboolean wav_file_read;
+  gint64 upstream_duration;
+  guint64 upstream_position;
+
+  /* The buffer may already have been filled by one of the others.  */
+  if (self->data_buffered)
+    return;
+
+  max_position = 0;
+  if (self->max_duration > 0)
+    {
+      max_position = round_up_to_position (self, self->max_duration);
+    }
+
+  if (self->preloaded_data != NULL)
+    {
+      /* The application has already read the data chunks of the WAV file
+       * on one of its own threads.  Use them as our local buffer.  */
+      gst_buffer_unref (self->local_buffer);
+      self->local_buffer = gst_buffer_ref (self->preloaded_data);
+      self->local_buffer_fill_level =
+        gst_buffer_get_size (self->preloaded_data);
+      self->local_buffer_capacity = self->local_buffer_fill_level;
+      wav_file_read = TRUE;
+    }
+  else if (self->file_location_specified)
+    {
+      /* Read the data from the WAV file, up to the most we will need.  */
+      wav_file_read = read_wav_file_data (self, max_position);
+    }
+  else
+    {
+      /* The data will come from upstream.  If upstream knows how long
+       * the sound is, make room for all of it now, so the local buffer
+       * need not be moved as it fills.  */
+      if (gst_pad_peer_query_duration (self->sinkpad, GST_FORMAT_TIME,
+                                       &upstream_duration)
+          && (upstream_duration > 0))
+        {
+          upstream_position = round_up_to_position (self, upstream_duration);
+          if ((max_position != 0) && (upstream_position > max_position))
+            {
+              upstream_position = max_position;
+            }
+          reserve_local_buffer (self, upstream_position);
+        }
+      return;
+    }
+
+  if (!wav_file_read)
+    {
+      GST_DEBUG_OBJECT (self, "read from WAV file failed.");
+      return;
+    }
+
+  GST_DEBUG_OBJECT (self, "read %" G_GUINT64_FORMAT " bytes from WAV file.",
+                    self->local_buffer_fill_level);
+
+  /* We now know the size of our local buffer.  We may have filled 
+   * it beyond max-duration, but if so we will use only the data
+   * up to max-duration.  */
+  if (self->max_duration > 0 && max_position < self->local_buffer_fill_level)
+    {
+      self->local_buffer_size = max_position;
+    }
+  else
+    {
+      self->local_buffer_size = self->local_buffer_fill_level;
+    }
+
+  /* Set the position from which to start draining the buffer.  If we
+   * received a Start event while we were waiting for the data, this is
+   * the same position it chose.  */
+  start_position = round_down_to_position (self, self->start_time);
+  self->local_buffer_drain_level = start_position;
+
+  /* If the Autostart parameter has been set to TRUE, don't wait
+   * for a Start event.  */
+  if (self->autostart)
+    {
+      self->started = TRUE;
+      self->local_clock = 0;
+      self->elapsed_time = 0;
+    }
+
+  /* We now have all our data.  This is set only once the size and
+   * position above are, since it tells the data pusher it may use
+   * them.  */
+  self->data_buffered = TRUE;
+
+  /* If we have not yet seen any data from upstream it is too early
+   * to start pushing data downstream; the task will be started then.
+   * If we have, and the task was stopped while we waited for the data,
+   * start it again.  */
+  if ((self->seen_incoming_data) && (!self->src_pad_task_running)
+      && (!self->src_pad_flushing))
+    {
+      gst_pad_start_task (self->srcpad,
+                          (GstTaskFunction) gst_looper_push_data_downstream,
+                          self->srcpad, NULL);
+      self->src_pad_task_running = TRUE;
+    }
+
+  return;
+}
+
+/* Fill in local information about the format of the sound data, and
+ * values based on it, from its caps.  */
+static void
+set_format (GstLooper *self, GstCaps *in_caps)
+{
+  GstStructure *caps_structure;
+  gchar *format_code_pointer;
+  gchar format_code_0, format_code_1;
+  gdouble bits_per_second, bits_per_nanosecond;
+  gint data_rate, channel_count;
+  gboolean result;
+
+  caps_structure = gst_caps_get_structure (in_caps, 0);
+  result = gst_structure_get_int (caps_structure, "rate", &data_rate);
+  if (!result)
+    {
+      GST_DEBUG_OBJECT (self, "no rate in caps");
+      data_rate = 48000;
+    }
+  self->data_rate = data_rate;
+
+  result = gst_structure_get_int (caps_structure, "channels", &channel_count);
+  if (!result)
+    {
+      GST_DEBUG_OBJECT (self, "no channel count in caps");
+      channel_count = 2;
+    }
+  self->channel_count = channel_count;
+
+  g_free (self->format);
+  self->format =
+    g_strdup (gst_structure_get_string (caps_structure, "format"));
+  if (self->format == NULL)
+    {
+      GST_DEBUG_OBJECT (self, "no format in caps");
+      self->format = g_strdup (GST_AUDIO_NE (F64));
+    }
+
+  /* Compute the size of a frame from the format string.  
+   * The possible formats start with a letter, then the width of
+   * sample in bits, for example, F32LE.  The second character of
+   * the format can be used to determine the width.  */
+  format_code_pointer = self->format;
+  format_code_0 = format_code_pointer[0];
+  GST_LOG_OBJECT (self, "first character of format is %c.",
+                  format_code_0);
+  format_code_1 = format_code_pointer[1];
+  GST_LOG_OBJECT (self, "second character of format is %c.",
+                  format_code_1);
+  switch (format_code_1)
+    {
+    case '8':
+      self->width = 8;
+      break;
+    case '1':
+      self->width = 16;
+      break;
+    case '2':
+      self->width = 24;
+      break;
+    case '3':
+      self->width = 32;
+      break;
+    case '6':
+      self->width = 64;
+      break;
+    default:
+      self->width = 32;
+      break;
+    }
+  GST_DEBUG_OBJECT (self, "each sample has %" G_GUINT64_FORMAT " bits.",
+                    self->width);
+
+  /* Compute the silence value.  For signed and floating formats, it is 0.
+   * for unsigned it is 128 for U8, the only unsigned format we support.  */
+  switch (format_code_0)
+    {
+    case 'S':
+    case 'F':
+      self->silence_byte = 0;
+      break;
+    case 'U':
+      self->silence_byte = 128;
+      break;
+    default:
+      self->silence_byte = 0;
+      break;
+    }
+  GST_DEBUG_OBJECT (self, "silence value is %hhd.", self->silence_byte);
+
+  /* Compute the data rate in bytes per nanosecond.
+   * data_rate times width times channel_count is bits per second.
+   * that divided by 1E9 is bits per nanosecond.
+   * that divided by 8 is bytes per nanosecond.  */
+  bits_per_second = self->data_rate * self->width * self->channel_count;
+  bits_per_nanosecond = (gdouble) bits_per_second / (gdouble) 1E9;
+  self->bytes_per_ns = bits_per_nanosecond / 8.0;
+  GST_DEBUG_OBJECT (self, "data rate is %f bytes per nanosecond.",
+                    self->bytes_per_ns);
+
+  return;
+}
+
+/* Begin sending sound downstream without anything upstream.  Tell
+ * downstream about the stream, its format and its timeline, which a
+ * demultiplexer would otherwise have done for us, then start the task
+ * that sends the sound.  That task sends silence until the data has
+ * been loaded and a Start event has been received.  */
+static void
+start_as_source (GstLooper *self)
+{
+  GstCaps *out_caps;
+  GstSegment segment;
+  gchar *stream_id;
+  gboolean result;
+
+  GST_DEBUG_OBJECT (self, "starting as a source with caps %" GST_PTR_FORMAT
+                    ".", self->source_caps);
+
+  stream_id =
+    gst_pad_create_stream_id (self->srcpad, GST_ELEMENT (self), NULL);
+  gst_pad_push_event (self->srcpad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+
+  g_rec_mutex_lock (&self->interlock);
+  set_format (self, self->source_caps);
+  out_caps = gst_caps_copy (self->source_caps);
+  g_rec_mutex_unlock (&self->interlock);
+
+  result = gst_pad_set_caps (self->srcpad, out_caps);
+  if (!result)
+    {
+      GST_DEBUG_OBJECT (self, "downstream refused caps %" GST_PTR_FORMAT ".",
+                        out_caps);
+    }
+  gst_caps_unref (out_caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (self->srcpad, gst_event_new_segment (&segment));
+
+  g_rec_mutex_lock (&self->interlock);
+  self->seen_incoming_data = TRUE;
+  if (!self->preload_pending)
+    {
+      load_local_buffer (self);
+    }
+  if ((!self->src_pad_task_running) && (!self->src_pad_flushing))
+    {
+      result =
+        gst_pad_start_task (self->srcpad,
+                            (GstTaskFunction) gst_looper_push_data_downstream,
+                            self->srcpad, NULL);
+      if (!result)
+        {
+          GST_DEBUG_OBJECT (self, "failed to start push task as a source");
+        }
+      self->src_pad_task_running = TRUE;
+    }
+  g_rec_mutex_unlock (&self->interlock);
+  return;
+}
+
+/* Make sure the local buffer can hold at least size bytes.  The local
+ * buffer is kept as a single block of memory which grows geometrically,
+ * so the cost of filling it is proportional to its final size rather
+ * than to the square of the number of pieces it arrived in.  Only the
+ * bytes up to the fill level are preserved when the block is moved.
+ * The return value is TRUE if the space is available.  */
+static gboolean
+reserve_local_buffer (GstLooper *self, guint64 size)
+{
+  guint64 new_capacity;
+  GstMemory *memory_allocated;
+  GstMapInfo old_memory_info, new_memory_info;
+
+  if (size <= self->local_buffer_capacity)
+    {
+      return TRUE;
+    }
+
+  new_capacity = MAX (size, self->local_buffer_capacity * 2);
+  new_capacity = MAX (new_capacity, MIN_LOCAL_BUFFER_CAPACITY);
+  GST_DEBUG_OBJECT (self, "growing local buffer from %" G_GUINT64_FORMAT
+                    " to %" G_GUINT64_FORMAT " bytes.",
+                    self->local_buffer_capacity, new_capacity);
+
+  memory_allocated = gst_allocator_alloc (NULL, new_capacity, NULL);
+  if (memory_allocated == NULL)
+    {
+      GST_DEBUG_OBJECT (self, "unable to allocate %" G_GUINT64_FORMAT
+                        " bytes for the local buffer.", new_capacity);
+      return FALSE;
+    }
+
+  if (self->local_buffer_fill_level > 0)
+    {
+      if (!gst_memory_map (memory_allocated, &new_memory_info, GST_MAP_WRITE))
+        {
+          gst_memory_unref (memory_allocated);
+          return FALSE;
+        }
+      if (!gst_buffer_map (self->local_buffer, &old_memory_info,
+                           GST_MAP_READ))
+        {
+          gst_memory_unmap (memory_allocated, &new_memory_info);
+          gst_memory_unref (memory_allocated);
+          return FALSE;
+        }
+      memcpy (new_memory_info.data, old_memory_info.data,
+              self->local_buffer_fill_level);
+      gst_buffer_unmap (self->local_buffer, &old_memory_info);
+      gst_memory_unmap (memory_allocated, &new_memory_info);
+    }
+
+  gst_buffer_replace_all_memory (self->local_buffer, memory_allocated);
+  self->local_buffer_capacity = new_capacity;
+  return TRUE;
+}
+
+/* Copy the contents of a buffer to the end of the local buffer.  */
+static gboolean
+append_to_local_buffer (GstLooper *self, GstBuffer *buffer)
+{
+  gsize buffer_size, amount_copied;
+  GstMapInfo buffer_memory_info;
+
+  buffer_size = gst_buffer_get_size (buffer);
+  if (!reserve_local_buffer (self,
+                             self->local_buffer_fill_level + buffer_size))
+    {
+      return FALSE;
+    }
+
+  if (!gst_buffer_map (self->local_buffer, &buffer_memory_info,
+                       GST_MAP_WRITE))
+    {
+      GST_DEBUG_OBJECT (self, "unable to map local buffer for writing");
+      return FALSE;
+    }
+  amount_copied =
+    gst_buffer_extract (buffer, 0,
+                        buffer_memory_info.data +
+                        self->local_buffer_fill_level, buffer_size);
+  gst_buffer_unmap (self->local_buffer, &buffer_memory_info);
+
+  /* Update our offset into the local buffer.  */
+  self->local_buffer_fill_level =
+    self->local_buffer_fill_level + amount_copied;
+  return TRUE;
+}
+
 /* Subroutine to read the data chunks from a WAV file into the local buffer.
  * This is a faster way to load the buffer than waiting for the data to
  * be provided in real time by upstream.  We read only the data; parsing of
@@ -2234,16 +2549,13 @@ read_wav_file_data (GstLooper *self, guint64 max_position)
   FILE *file_stream;
   gint stream_status;
   gsize amount_read;
-  GstMemory *memory_allocated;
   GstMapInfo buffer_memory_info;
   gint result, seek_success;
   gboolean return_value = FALSE;
   guint32 header[2];
   guint32 chunk_size;
-  unsigned int byte_offset;
   guint64 local_buffer_fill_level;
   gchar data_byte;
-  gchar *byte_data_out_pointer;
 
   /* This subroutine exits through some common cleanup code at common_exit.
    * The following flags control the extent of its cleanup.  */
@@ -2343,11 +2655,15 @@ read_wav_file_data (GstLooper *self, guint64 max_position)
           continue;
         }
 
-      /* Copy the data chunk into our local buffer.  */
+      /* Copy the data chunk into our local buffer, reading it directly
+       * into place with a single call.  */
       GST_DEBUG_OBJECT (self, "reading %d bytes of data from file \"%s\".",
                         chunk_size, self->file_location);
-      memory_allocated = gst_allocator_alloc (NULL, chunk_size, NULL);
-      gst_buffer_append_memory (self->local_buffer, memory_allocated);
+      if (!reserve_local_buffer (self, local_buffer_fill_level + chunk_size))
+        {
+          GST_DEBUG_OBJECT (self, "unable to extend local buffer");
+          goto common_exit;
+        }
       result =
         gst_buffer_map (self->local_buffer, &buffer_memory_info,
                         GST_MAP_WRITE);
@@ -2357,26 +2673,24 @@ read_wav_file_data (GstLooper *self, guint64 max_position)
           goto common_exit;
         }
       buffer_mapped = TRUE;
-      for (byte_offset = 0; byte_offset < chunk_size;
-           byte_offset = byte_offset + 1)
+      amount_read =
+        fread (buffer_memory_info.data + local_buffer_fill_level, 1,
+               chunk_size, file_stream);
+      if (amount_read != chunk_size)
         {
-          byte_data_out_pointer =
-            (void *) buffer_memory_info.data + local_buffer_fill_level +
-            byte_offset;
-          amount_read = fread (&data_byte, 1, 1, file_stream);
-          if (amount_read != 1)
-            {
-              GST_DEBUG_OBJECT (self,
-                                "failed to read a data byte from \"%s\".",
-                                self->file_location);
-              goto common_exit;
-            }
-          *byte_data_out_pointer = data_byte;
+          GST_DEBUG_OBJECT (self,
+                            "read only %" G_GSIZE_FORMAT " of %u data bytes"
+                            " from \"%s\".", amount_read, chunk_size,
+                            self->file_location);
+          goto common_exit;
         }
       gst_buffer_unmap (self->local_buffer, &buffer_memory_info);
       buffer_mapped = FALSE;
 
+      /* Keep the fill level current, so that growing the local buffer
+       * for the next chunk preserves this one.  */
       local_buffer_fill_level = local_buffer_fill_level + chunk_size;
+      self->local_buffer_fill_level = local_buffer_fill_level;
 
       /* If the chunk size is odd, skip the pad byte.  */
       if ((chunk_size & 1) == 1)
@@ -2495,6 +2809,40 @@ gst_looper_set_property (GObject *object, guint prop_id,
       GST_OBJECT_UNLOCK (self);
       break;
 
+    case PROP_PRELOAD:
+      /* The interlock, taken above, keeps the caps handler and the
+       * data pusher away from the local buffer while we fill it.  */
+      GST_OBJECT_LOCK (self);
+      self->preload_pending = g_value_get_boolean (value);
+      GST_INFO_OBJECT (self, "preload: %d", self->preload_pending);
+      GST_OBJECT_UNLOCK (self);
+
+      /* If the application was unable to read the file for us and
+       * we already know the format, read the file ourselves.  */
+      if ((!self->preload_pending) && (!self->data_buffered)
+          && (self->bytes_per_ns > 0))
+        {
+          load_local_buffer (self);
+        }
+      break;
+
+    case PROP_PRELOADED_DATA:
+      GST_OBJECT_LOCK (self);
+      gst_buffer_replace (&self->preloaded_data, g_value_get_boxed (value));
+      self->preload_pending = FALSE;
+      GST_INFO_OBJECT (self, "preloaded-data: %" G_GSIZE_FORMAT " bytes.",
+                       (self->preloaded_data == NULL) ? 0 :
+                       gst_buffer_get_size (self->preloaded_data));
+      GST_OBJECT_UNLOCK (self);
+
+      /* If we already know the format, the sound is ready to play.  
+       * Otherwise we will use the data when we receive the caps.  */
+      if ((!self->data_buffered) && (self->bytes_per_ns > 0))
+        {
+          load_local_buffer (self);
+        }
+      break;
+
     case PROP_RELEASE_DURATION_TIME:
       GST_OBJECT_LOCK (self);
       self->release_duration_time = g_value_get_uint64 (value);
@@ -2503,6 +2851,25 @@ gst_looper_set_property (GObject *object, guint prop_id,
       GST_OBJECT_UNLOCK (self);
       break;
 
+    case PROP_PROGRESS_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      self->progress_interval = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
+    case PROP_PULL_BLOCK_SIZE:
+      GST_OBJECT_LOCK (self);
+      self->pull_block_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
+    case PROP_CAPS:
+      GST_OBJECT_LOCK (self);
+      gst_caps_replace (&self->source_caps, g_value_get_boxed (value));
+      GST_INFO_OBJECT (self, "caps: %" GST_PTR_FORMAT ".", self->source_caps);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2575,6 +2942,35 @@ compute_remaining_time (GstLooper *object)
   return (total_time_int - self->elapsed_time);
 }
 
+/* Post a progress message if the sound has run for another progress
+ * interval since the last one, or has been restarted or released.
+ * The caller holds the interlock.  */
+static void
+post_progress (GstLooper *self)
+{
+  GstStructure *structure;
+  GstMessage *message;
+
+  if (self->progress_interval == 0)
+    return;
+  if ((self->elapsed_time >= self->progress_posted_time)
+      && (self->elapsed_time - self->progress_posted_time <
+          self->progress_interval))
+    return;
+
+  structure =
+    gst_structure_new ("progress", "elapsed-time", G_TYPE_UINT64,
+                       self->elapsed_time, "remaining-time", G_TYPE_UINT64,
+                       compute_remaining_time (self), NULL);
+  message = gst_message_new_element (GST_OBJECT (self), structure);
+  if (!gst_element_post_message (GST_ELEMENT (self), message))
+    {
+      GST_DEBUG_OBJECT (self, "unable to post a progress message");
+    }
+  self->progress_posted_time = self->elapsed_time;
+  return;
+}
+
 /* Return the value of a property.  */
 static void
 gst_looper_get_property (GObject *object, guint prop_id, GValue *value,
@@ -2582,6 +2978,7 @@ gst_looper_get_property (GObject *object, guint prop_id, GValue *value,
 {
   GstLooper *self = GST_LOOPER (object);
   guint64 remaining_time;
+  guint64 local_buffer_bytes;
 
   g_rec_mutex_lock (&self->interlock);
   switch (prop_id)
@@ -2640,6 +3037,18 @@ gst_looper_get_property (GObject *object, guint prop_id, GValue *value,
       GST_OBJECT_UNLOCK (self);
       break;
 
+    case PROP_PRELOAD:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->preload_pending);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
+    case PROP_PRELOADED_DATA:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boxed (value, self->preloaded_data);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
     case PROP_ELAPSED_TIME:
       GST_OBJECT_LOCK (self);
       g_value_set_uint64 (value, self->elapsed_time);
@@ -2653,6 +3062,37 @@ gst_looper_get_property (GObject *object, guint prop_id, GValue *value,
       GST_OBJECT_UNLOCK (self);
       break;
 
+    case PROP_PROGRESS_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->progress_interval);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
+    case PROP_PULL_BLOCK_SIZE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->pull_block_size);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
+    case PROP_CAPS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boxed (value, self->source_caps);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
+    case PROP_LOCAL_BUFFER_BYTES:
+      /* Once loaded, preloaded data is the local buffer, so count it
+       * only if it has not yet been loaded.  */
+      GST_OBJECT_LOCK (self);
+      local_buffer_bytes = self->local_buffer_capacity;
+      if ((self->preloaded_data != NULL)
+          && (self->preloaded_data != self->local_buffer))
+        local_buffer_bytes =
+          local_buffer_bytes + gst_buffer_get_size (self->preloaded_data);
+      g_value_set_uint64 (value, local_buffer_bytes);
+      GST_OBJECT_UNLOCK (self);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
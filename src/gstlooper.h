@@ -67,6 +67,10 @@ struct _GstLooper
   guint64 local_buffer_fill_level;
   guint64 local_buffer_drain_level;
   guint64 local_buffer_size;    /* number of bytes in the local buffer */
+  guint64 local_buffer_capacity;        /* number of bytes allocated for
+                                         * the local buffer while it is
+                                         * being filled */
+  guint pull_block_size;        /* bytes requested from upstream per pull */
   guint64 pull_level;           /* how much data we have pulled from upstream */
   guint64 timestamp_offset;
   guint64 local_clock;          /* The current time, in nanoseconds.  
@@ -121,12 +125,24 @@ struct _GstLooper
                                          */
   gboolean seen_incoming_data;  /* Sound data has been seen on the source pad.  
                                  */
+  gboolean preload_pending;     /* The application is reading the WAV file
+                                 * for us, and will supply its data through
+                                 * the preloaded-data property.  */
+  GstBuffer *preloaded_data;    /* The data it supplied.  */
+  GstCaps *source_caps;         /* If we are the source of the sound,
+                                 * its format.  */
   guint8 silence_byte;          /* The byte value of silence for this
                                  * format.  */
+  guint64 progress_interval;    /* nanoseconds between progress messages */
+  guint64 progress_posted_time; /* The elapsed time in the last progress
+                                 * message, or G_MAXUINT64 to post one
+                                 * as soon as possible.  */
 };
 
-/* The number of bytes of data requested from upstream in each pull */
-#define BUFFER_SIZE 4096
+/* The default number of bytes of data requested from upstream in each
+ * pull */
+#define DEFAULT_PULL_BLOCK_SIZE (1024 * 1024)
+#define MIN_LOCAL_BUFFER_CAPACITY (64 * 1024)
 
 struct _GstLooperClass
 {
@@ -23,9 +23,16 @@
 #include "sound_subroutines.h"
 #include "button_subroutines.h"
 #include "display_subroutines.h"
+#include "loader_subroutines.h"
+#include "realtime_subroutines.h"
+#include "render_subroutines.h"
 #include "main.h"
 #include <math.h>
 
+/* How often, in nanoseconds of sound, a playing sound reports its
+ * elapsed and remaining time.  */
+#define PROGRESS_INTERVAL (100 * GST_MSECOND)
+
 /* If true, print trace information as we proceed.  */
 #define GSTREAMER_TRACE FALSE
 
@@ -55,6 +62,7 @@ gstreamer_init (int sound_count, GApplication *app)
   gchar *device_name_string;
   gchar *client_name_string;
   gchar *server_name_string;
+  gchar *render_file_name;
   gboolean monitor_enabled;
   gboolean output_enabled;
   gboolean link_ok;
@@ -100,6 +108,17 @@ gstreamer_init (int sound_count, GApplication *app)
         }
     }
 
+  /* If --render was specified, the mix goes only to the render file,
+   * as fast as we can make it.  */
+  render_file_name = main_get_render_file_name ();
+  if (render_file_name != NULL)
+    {
+      monitor_file_name = render_file_name;
+      monitor_enabled = TRUE;
+      output_enabled = FALSE;
+      output_type = 0;
+    }
+
   /* Create the top-level pipeline.  */
   pipeline_element = GST_PIPELINE (gst_pipeline_new ("sound_effects"));
   if (pipeline_element == NULL)
@@ -226,8 +245,11 @@ gstreamer_init (int sound_count, GApplication *app)
       gst_bin_add_many (GST_BIN (final_bin_element), sink_element, NULL);
     }
 
-  /* Make sure we will get level messages. */
-  g_object_set (level_element, "post-messages", TRUE, NULL);
+  /* Make sure we will get level messages, unless there is neither
+   * a VU meter nor a telemetry console to show them.  */
+  g_object_set (level_element, "post-messages",
+                (!main_get_headless ())
+                || (main_get_telemetry_address_string () != NULL), NULL);
 
   if (monitor_enabled == TRUE)
     {
@@ -235,6 +257,12 @@ gstreamer_init (int sound_count, GApplication *app)
       g_object_set (filesink_element, "location", monitor_file_name, NULL);
     }
 
+  if (render_file_name != NULL)
+    {
+      /* Do not wait for the clock; write the file as fast as we can.  */
+      g_object_set (filesink_element, "sync", FALSE, NULL);
+    }
+
   /* Use the command-line options to condition the audio output.  */
   if (output_enabled == TRUE)
     {
@@ -270,8 +298,18 @@ gstreamer_init (int sound_count, GApplication *app)
       g_object_set (sink_element, "transport", 2, NULL);
     }
 
-  /* Watch for messages from the pipeline.  */
+  /* Have the audio output tell us when it is given samples too late
+   * to play them, so we can count the dropouts.  */
+  if (output_enabled == TRUE)
+    {
+      g_object_set (sink_element, "qos", TRUE, NULL);
+    }
+
+  /* Watch for messages from the pipeline.  The streaming threads
+   * announce themselves on their own threads, so the real-time
+   * subroutines see those messages before the main thread does.  */
   bus = gst_element_get_bus (GST_ELEMENT (pipeline_element));
+  gst_bus_set_sync_handler (bus, realtime_bus_sync_handler, app, NULL);
   gst_bus_add_watch (bus, message_handler, app);
 
   /* The inputs to the final bin are the inputs to the audio mixer.  
@@ -428,18 +466,22 @@ gstreamer_init (int sound_count, GApplication *app)
 
     }
 
+  /* When rendering, keep the sequencer in step with the mix.  */
+  render_watch_mixer (audiomixer_element, app);
+
   /* Place the final bin in the pipeline. */
   gst_bin_add (GST_BIN (pipeline_element), final_bin_element);
 
   return pipeline_element;
 }
 
-/* Create a Gstreamer bin for a sound effect.  */
+/* Create a Gstreamer bin for a sound effect, or for one of its extra
+ * voices if voice_data is not NULL.  */
 GstBin *
-gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
+gstreamer_create_bin (struct sound_info *sound_data,
+                      struct voice_info *voice_data, gint sound_number,
                       GstPipeline *pipeline_element, GApplication *app)
 {
-  GstElement *source_element, *parse_element, *convert1_element;
   GstElement *resample_element, *looper_element;
   GstElement *envelope_element, *pan_element, *volume_element;
   GstElement *convert2_element, *convert3_element;
@@ -453,73 +495,31 @@ gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
   GValue v2 = G_VALUE_INIT;
   GValue v3 = G_VALUE_INIT;
   gint in_chan, out_chan;
-  GstCaps *caps_filter1, *caps_filter2;
+  GstCaps *source_caps, *caps_filter1, *caps_filter2;
   gfloat volume_level;
   guint64 channel_mask;
   gchar string_buffer[G_ASCII_DTOSTR_BUF_SIZE];
   
-  /* Create the bin, source and various filter elements for this sound effect. 
-   */
-  sound_name = g_strconcat ((gchar *) "sound/", sound_data->name, NULL);
-  bin_element = gst_bin_new (sound_name);
-  if (bin_element == NULL)
-    {
-      g_print ("Unable to create the bin element.\n");
-      return NULL;
-    }
-
-  element_name = g_strconcat (sound_name, (gchar *) "/source", NULL);
-  source_element = gst_element_factory_make ("filesrc", element_name);
-  if (source_element == NULL)
+  /* Create the bin, looper and various filter elements for this sound
+   * effect.  The looper is the source: it gets the sound's samples from
+   * the loader, or reads the WAV file itself, so nothing need be
+   * upstream of it.  */
+  if (voice_data == NULL)
     {
-      g_print ("Unable to create the file source element.\n");
-      return NULL;
+      sound_name = g_strconcat ((gchar *) "sound/", sound_data->name, NULL);
     }
-  g_free (element_name);
-
-  element_name = g_strconcat (sound_name, (gchar *) "/parse", NULL);
-  parse_element = gst_element_factory_make ("wavparse", element_name);
-  if (parse_element == NULL)
+  else
     {
-      g_print ("Unable to create the wave file parse element.\n");
-      return NULL;
+      sound_name =
+        g_strdup_printf ("sound/%s/voice %d", sound_data->name,
+                         voice_data->number);
     }
-  g_free (element_name);
-
-  element_name = g_strconcat (sound_name, (gchar *) "/convert1", NULL);
-  convert1_element = gst_element_factory_make ("audioconvert", element_name);
-  if (convert1_element == NULL)
+  bin_element = gst_bin_new (sound_name);
+  if (bin_element == NULL)
     {
-      g_print ("Unable to create the audio convert1 element.\n");
+      g_print ("Unable to create the bin element.\n");
       return NULL;
     }
-  g_free (element_name);
-
-  /* Create a 1-1 mix matrix from the incoming to the outgoing channels.
-   */
-  g_value_init (&v, GST_TYPE_ARRAY);
-  for (out_chan=0; out_chan < sound_data->channel_count; out_chan++)
-    {
-      g_value_init (&v2, GST_TYPE_ARRAY);
-      for (in_chan=0; in_chan < sound_data->channel_count; in_chan++)
-	{
-	  g_value_init (&v3, G_TYPE_FLOAT);
-	  if (in_chan == out_chan)
-	    {
-	      g_value_set_float (&v3, (gfloat) 1.0);
-	    }
-	  else
-	    {
-	      g_value_set_float (&v3, (gfloat) 0.0);
-	    }
-	  gst_value_array_append_value (&v2, &v3);
-	  g_value_unset (&v3);
-	}
-      gst_value_array_append_value (&v, &v2);
-      g_value_unset (&v2);
-    }
-  g_object_set_property (G_OBJECT (convert1_element), "mix-matrix", &v);
-  g_value_unset (&v);
 
   element_name = g_strconcat (sound_name, (gchar *) "/looper", NULL);
   looper_element = gst_element_factory_make ("looper", element_name);
@@ -625,11 +625,11 @@ gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
   element_name = NULL;
   sound_name = NULL;
 
-  g_object_set (source_element, "location", sound_data->wav_file_name_full,
-                NULL);
-
   g_object_set (looper_element, "file-location",
                 sound_data->wav_file_name_full, NULL);
+  /* The loader reads the samples on a background thread and gives
+   * them to the looper; until then the looper sends silence.  */
+  g_object_set (looper_element, "preload", TRUE, NULL);
   g_object_set (looper_element, "loop-to", sound_data->loop_to_time, NULL);
   g_object_set (looper_element, "loop-from", sound_data->loop_from_time,
                 NULL);
@@ -637,6 +637,35 @@ gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
   g_object_set (looper_element, "max-duration", sound_data->max_duration_time,
                 NULL);
   g_object_set (looper_element, "start-time", sound_data->start_time, NULL);
+
+  /* The operator display and the telemetry show the elapsed and
+   * remaining time to a tenth of a second, so have the looper tell us
+   * that often rather than asking it.  The bus message handler finds
+   * the sound from the looper.  Only the sound's first voice is shown,
+   * so the others need not tell us.  */
+  if ((voice_data == NULL)
+      && ((!main_get_headless ())
+          || (main_get_telemetry_address_string () != NULL)))
+    {
+      g_object_set (looper_element, "progress-interval",
+                    (guint64) PROGRESS_INTERVAL, NULL);
+    }
+  g_object_set_data (G_OBJECT (looper_element), "sound_info", sound_data);
+  if (voice_data == NULL)
+    {
+      sound_data->looper_element = looper_element;
+      sound_data->elapsed_time = 0;
+      sound_data->remaining_time = G_MAXUINT64;
+    }
+  else
+    {
+      /* The bus message handler finds the voice from its envelope,
+       * which reports completion and release.  */
+      voice_data->looper_element = looper_element;
+      g_object_set_data (G_OBJECT (envelope_element), "voice_info",
+                         voice_data);
+    }
+
   if (sound_data->release_duration_infinite)
     {
       g_object_set (looper_element, "release-duration-time",
@@ -720,8 +749,7 @@ gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
   g_value_unset (&v);
 
   /* Place the various elements in the bin. */
-  gst_bin_add_many (GST_BIN (bin_element), source_element, parse_element,
-                    convert1_element, looper_element, convert2_element,
+  gst_bin_add_many (GST_BIN (bin_element), looper_element, convert2_element,
 		    resample_element, envelope_element, volume_element,
 		    convert3_element, NULL);
   if (pan_element != NULL)
@@ -730,22 +758,33 @@ gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
     }
 
   /* Link them together in this order: 
-   * source->parse->convert1->looper->convert2->resample->envelope->pan->
-   * volume->convert3.
-   * Note that because the looper reads the wave file directly, as well
-   * as getting it through the pipeline, the first audio converter must
-   * provide the format that corresponds to the WAV file format, since
-   * otherwise the F32LE format later in the pipeline will be propagated
-   * up to it.  We must have the filter to specify the channel mask,
-   * else we get a warning message from Gstreamer about a missing
-   * channel mask for 4-channel WAV files.
-   * It is for this reason that the looper handles a variety of audio formats.  
-   * Note also that the pan element is optional.  */
+   * looper->convert2->resample->envelope->pan->volume->convert3.
+   * The looper sends the sound in the format its samples are kept in,
+   * which is usually the WAV file's own, and which we give it here
+   * since there is no demultiplexer upstream to tell it.
+   * We must specify the channel mask, else we get a warning message
+   * from Gstreamer about a missing channel mask for 4-channel WAV files.
+   * It is for this reason that the looper handles a variety of audio
+   * formats.  Note also that the pan element is optional.  */
 
   channel_mask = sound_data->channel_mask;
+  source_caps =
+    gst_caps_new_simple ("audio/x-raw",
+			 "format", G_TYPE_STRING,
+			 sound_data->storage_format_name,
+			 "rate", G_TYPE_INT, sound_data->sample_rate,
+			 "channels", G_TYPE_INT, sound_data->channel_count,
+			 "channel-mask", GST_TYPE_BITMASK, channel_mask,
+			 "layout", G_TYPE_STRING, "interleaved",
+			 NULL);
+  g_object_set (looper_element, "caps", source_caps, NULL);
+  gst_caps_unref (source_caps);
+  source_caps = NULL;
+
   caps_filter1 =
     gst_caps_new_simple ("audio/x-raw",
-			 "format", G_TYPE_STRING, sound_data->format_name,
+			 "format", G_TYPE_STRING,
+			 sound_data->storage_format_name,
 			 "channels", G_TYPE_INT, sound_data->channel_count,
 			 "channel-mask", GST_TYPE_BITMASK, channel_mask,
 			 NULL);
@@ -767,9 +806,6 @@ gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
 	       sound_data->name);
     }
   
-  gst_element_link (source_element, parse_element);
-  gst_element_link (parse_element, convert1_element);
-  gst_element_link_filtered (convert1_element, looper_element, caps_filter1);
   gst_element_link_filtered (looper_element, convert2_element, caps_filter1);
   gst_element_link_filtered (convert2_element, resample_element, caps_filter2);
   gst_element_link (resample_element, envelope_element);
@@ -825,6 +861,173 @@ gstreamer_create_bin (struct sound_info *sound_data, gint sound_number,
   return (GST_BIN (bin_element));
 }
 
+/* Add a sound effect's bin, or one of its voices, to the pipeline while
+ * it is running.
+ * Unlike the bins built by sound_start, this one needs a new input
+ * to the final bin, and its timestamps, which start at zero, must be
+ * offset to the pipeline's current running time.  */
+GstBin *
+gstreamer_add_bin (struct sound_info *sound_data,
+                   struct voice_info *voice_data, GApplication *app)
+{
+  GstPipeline *pipeline_element;
+  GstElement *final_bin_element, *audiomixer_element;
+  GstBin *bin_element;
+  GstPad *mixer_pad, *ghost_pad, *source_pad;
+  GstClock *clock;
+  GstClockTime running_time;
+  gchar *pad_name;
+  gint sound_number;
+
+  pipeline_element = sep_get_pipeline_from_app (app);
+  if (pipeline_element == NULL)
+    return NULL;
+  final_bin_element =
+    gst_bin_get_by_name (GST_BIN (pipeline_element), (gchar *) "final");
+  audiomixer_element =
+    gst_bin_get_by_name (GST_BIN (final_bin_element),
+                         (gchar *) "final/audiomixer");
+
+  /* Find an unused input to the final bin.  Removing a bin leaves
+   * a gap, which we fill.  */
+  sound_number = 0;
+  for (;;)
+    {
+      pad_name = g_strdup_printf ("sink %d", sound_number);
+      ghost_pad = gst_element_get_static_pad (final_bin_element, pad_name);
+      g_free (pad_name);
+      if (ghost_pad == NULL)
+        break;
+      gst_object_unref (ghost_pad);
+      sound_number = sound_number + 1;
+    }
+
+  mixer_pad = gst_element_request_pad_simple (audiomixer_element, "sink_%u");
+  pad_name = g_strdup_printf ("sink %d", sound_number);
+  ghost_pad = gst_ghost_pad_new (pad_name, mixer_pad);
+  g_free (pad_name);
+  gst_pad_set_active (ghost_pad, TRUE);
+  gst_element_add_pad (final_bin_element, ghost_pad);
+
+  bin_element =
+    gstreamer_create_bin (sound_data, voice_data, sound_number,
+                          pipeline_element, app);
+  if (bin_element == NULL)
+    {
+      gst_element_remove_pad (final_bin_element, ghost_pad);
+      gst_element_release_request_pad (audiomixer_element, mixer_pad);
+      gst_object_unref (mixer_pad);
+      gst_object_unref (audiomixer_element);
+      gst_object_unref (final_bin_element);
+      return NULL;
+    }
+  gst_object_unref (mixer_pad);
+  gst_object_unref (audiomixer_element);
+  gst_object_unref (final_bin_element);
+
+  clock = gst_element_get_clock (GST_ELEMENT (pipeline_element));
+  if (clock != NULL)
+    {
+      running_time =
+        gst_clock_get_time (clock) -
+        gst_element_get_base_time (GST_ELEMENT (pipeline_element));
+      source_pad = gst_element_get_static_pad (GST_ELEMENT (bin_element),
+                                               "src");
+      gst_pad_set_offset (source_pad, running_time);
+      gst_object_unref (source_pad);
+      gst_object_unref (clock);
+    }
+
+  /* Bring the new bin up to the state of the pipeline.  */
+  gst_element_sync_state_with_parent (GST_ELEMENT (bin_element));
+
+  if (GSTREAMER_TRACE)
+    {
+      g_print ("added gstreamer bin for %s as input %d.\n",
+               sound_data->name, sound_number);
+    }
+  return (bin_element);
+}
+
+/* Finish removing a bin, on the main thread.  */
+static gboolean
+remove_bin_idle (gpointer user_data)
+{
+  GstElement *bin_element = user_data;
+  GstElement *parent_element, *final_bin_element, *audiomixer_element;
+  GstPad *source_pad, *ghost_pad, *mixer_pad;
+
+  source_pad = gst_element_get_static_pad (bin_element, "src");
+  ghost_pad = gst_pad_get_peer (source_pad);
+  if (ghost_pad != NULL)
+    {
+      gst_pad_unlink (source_pad, ghost_pad);
+    }
+  gst_object_unref (source_pad);
+
+  gst_element_set_state (bin_element, GST_STATE_NULL);
+  parent_element = GST_ELEMENT (gst_element_get_parent (bin_element));
+  if (parent_element != NULL)
+    {
+      gst_bin_remove (GST_BIN (parent_element), bin_element);
+      gst_object_unref (parent_element);
+    }
+
+  /* Give back the final bin's input.  */
+  if (ghost_pad != NULL)
+    {
+      final_bin_element = gst_pad_get_parent_element (ghost_pad);
+      mixer_pad = gst_ghost_pad_get_target (GST_GHOST_PAD (ghost_pad));
+      gst_element_remove_pad (final_bin_element, ghost_pad);
+      if (mixer_pad != NULL)
+        {
+          audiomixer_element = gst_pad_get_parent_element (mixer_pad);
+          gst_element_release_request_pad (audiomixer_element, mixer_pad);
+          gst_object_unref (audiomixer_element);
+          gst_object_unref (mixer_pad);
+        }
+      gst_object_unref (final_bin_element);
+      gst_object_unref (ghost_pad);
+    }
+
+  if (GSTREAMER_TRACE)
+    {
+      g_print ("removed gstreamer bin %s.\n", GST_ELEMENT_NAME (bin_element));
+    }
+  gst_object_unref (bin_element);
+  return G_SOURCE_REMOVE;
+}
+
+/* The output of a bin being removed is blocked.  */
+static GstPadProbeReturn
+remove_bin_blocked (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  GstElement *bin_element = user_data;
+
+  /* We are on the bin's streaming thread, which cannot stop itself,
+   * so do the rest on the main thread.  The pad stays blocked until
+   * the bin is shut down.  */
+  g_idle_add (remove_bin_idle, bin_element);
+  return GST_PAD_PROBE_OK;
+}
+
+/* Remove a sound effect's bin from the running pipeline.  We first block
+ * the bin's output, so the final bin does not lose its input in the
+ * middle of a buffer.  */
+void
+gstreamer_remove_bin (GstBin *bin_element, GApplication *app)
+{
+  GstPad *source_pad;
+
+  source_pad = gst_element_get_static_pad (GST_ELEMENT (bin_element), "src");
+  gst_object_ref (bin_element);
+  gst_pad_add_probe (source_pad,
+                     GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM, remove_bin_blocked,
+                     bin_element, NULL);
+  gst_object_unref (source_pad);
+  return;
+}
+
 /* Print a message that appeared on the pipeline's message bus.  */
 static void
 print_message (GstMessage * msg)
@@ -997,6 +1200,30 @@ gstreamer_complete_pipeline (GstPipeline *pipeline_element,
   /* For debugging, write out a graphical representation of the pipeline. */
   gstreamer_dump_pipeline (pipeline_element, "completing-paused");
 
+  /* If the sounds are still being read from their files, leave the
+   * pipeline paused.  The loader will start it playing when enough
+   * of them are ready.  */
+  if (!loader_ready_to_play (app))
+    {
+      if (GSTREAMER_TRACE)
+        {
+          g_print ("waiting for sounds to load.\n");
+        }
+      return (1);
+    }
+
+  return (gstreamer_play_pipeline (pipeline_element, app));
+}
+
+/* Start the completed pipeline playing.  If it cannot be started,
+ * return 0, else return 1.  */
+gint
+gstreamer_play_pipeline (GstPipeline *pipeline_element, GApplication *app)
+{
+  GstStateChangeReturn set_state_val;
+  GstBus *bus;
+  GstMessage *msg;
+
   /* Now that the pipeline is constructed, start it running.  Unless a sound
    * is autostarted, there will be no sound until a sound effect bin receives 
    * a start message.  */
@@ -1127,6 +1354,11 @@ gstreamer_async_done (GApplication *app)
   /* For debugging, write out a graphical representation of the pipeline. */
   gstreamer_dump_pipeline (pipeline_element, "async_done");
 
+  /* If the pipeline is paused waiting for sounds to load, the loader
+   * will tell the core when it starts the pipeline playing.  */
+  if (loader_defer_ready (app))
+    return;
+
   /* Tell the core that we have completed gstreamer initialization.  */
   sep_gstreamer_ready (app);
 
@@ -1188,22 +1420,6 @@ gstreamer_get_pan (GstBin *bin_element)
   return (pan_element);
 }
 
-/* Find the looper element in a bin. */
-GstElement *
-gstreamer_get_looper (GstBin *bin_element)
-{
-  GstElement *looper_element;
-  gchar *element_name, *bin_name;
-
-  bin_name = gst_element_get_name (bin_element);
-  element_name = g_strconcat (bin_name, (gchar *) "/looper", NULL);
-  g_free (bin_name);
-  looper_element = gst_bin_get_by_name (bin_element, element_name);
-  g_free (element_name);
-
-  return (looper_element);
-}
-
 /* For debugging, write out an annotated, graphical representation
  * of the gstreamer pipeline.
  */
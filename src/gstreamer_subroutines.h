@@ -22,18 +22,23 @@
 
 /* Subroutines defined in gstreamer_subroutines.c */
 GstPipeline *gstreamer_init (int sound_count, GApplication *app);
-GstBin *gstreamer_create_bin (struct sound_info *sound_data, int sound_number,
+GstBin *gstreamer_create_bin (struct sound_info *sound_data,
+                              struct voice_info *voice_data, int sound_number,
                               GstPipeline *pipeline_element,
                               GApplication *app);
+GstBin *gstreamer_add_bin (struct sound_info *sound_data,
+                           struct voice_info *voice_data, GApplication *app);
+void gstreamer_remove_bin (GstBin *bin_element, GApplication *app);
 gint gstreamer_complete_pipeline (GstPipeline *pipeline_element,
                                   GApplication *app);
+gint gstreamer_play_pipeline (GstPipeline *pipeline_element,
+                              GApplication *app);
 void gstreamer_shutdown (GApplication *app);
 GstPipeline *gstreamer_dispose (GApplication *app);
 void gstreamer_async_done (GApplication *app);
 void gstreamer_process_eos (GApplication *app);
 GstElement *gstreamer_get_volume (GstBin *bin_element);
 GstElement *gstreamer_get_pan (GstBin *bin_element);
-GstElement *gstreamer_get_looper (GstBin *bin_element);
 void gstreamer_dump_pipeline (GstPipeline *pipeline_element, gchar *filename);
 
 /* End of file gstreamer_subroutines.h */
@@ -0,0 +1,859 @@
+/*
+ * loader_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include "loader_subroutines.h"
+#include "display_subroutines.h"
+#include "decoder_subroutines.h"
+#include "gstreamer_subroutines.h"
+#include "main.h"
+#include "realtime_subroutines.h"
+#include "sound_effects_player.h"
+#include "sound_structure.h"
+#include "sound_subroutines.h"
+#include "warmup_subroutines.h"
+
+/* Loading a project means reading the header of every WAV file and then
+ * all of its samples.  Done one file at a time, the computer is mostly
+ * waiting for the disk.  Instead we hand each file to a pool of threads,
+ * one per processor.
+ *
+ * The headers are read while the project is being parsed, and we wait
+ * for all of them, since the pipeline cannot be built without them.
+ * The samples are read after the pipeline is built.  Each looper sends
+ * silence until its samples arrive, and the pipeline waits in the paused
+ * state until the first few sounds are ready, then starts playing while
+ * the rest load.  The status bar shows how many have been loaded.  */
+
+#define TRACE_LOADER FALSE
+
+/* How often, in milliseconds, we check for sounds that have finished
+ * loading and update the progress message.  */
+#define LOADER_PROGRESS_INTERVAL 50
+
+/* The kinds of work done on the thread pool.  */
+enum loader_job_kind
+{
+  loader_job_probe,             /* read the WAV file header */
+  loader_job_preload            /* read the WAV file samples */
+};
+
+/* One file to be read by the thread pool.  */
+struct loader_job
+{
+  enum loader_job_kind kind;
+  struct sound_info *sound_data;
+  gchar *file_name;             /* our own copy, for the pool thread */
+  guint64 max_duration_time;    /* 0 means the whole file */
+  const gchar *format_name;     /* the format the looper expects */
+  gint channel_count;
+  gint sample_rate;
+  gboolean use_decode_cache;    /* keep the decoded samples on disk */
+  GstBuffer *data;              /* the samples read; NULL if we failed */
+};
+
+/* The persistent data used by the loader subroutines.  */
+struct loader_info
+{
+  GThreadPool *pool;
+  GAsyncQueue *completed;       /* preload jobs which have finished */
+
+  /* Used to wait for the WAV file headers.  */
+  GMutex probe_lock;
+  GCond probe_done;
+  gint probe_remaining;
+
+  /* The following are used only on the main thread.  */
+  gint total_count;             /* sounds we have started to preload */
+  gint done_count;              /* sounds whose preload is finished */
+  gint ready_count;             /* sounds needed before we play */
+  gboolean play_deferred;       /* the pipeline is waiting for sounds */
+  gboolean prerolled;           /* and has reached the paused state */
+  guint progress_source;
+  guint message_id;
+  gint message_count;           /* the count the message shows */
+};
+
+static void loader_run_job (gpointer data, gpointer user_data);
+static GstBuffer *loader_read_wav_data (gchar *file_name,
+                                        guint64 max_duration_time,
+                                        const gchar *format_name);
+static GstBuffer *loader_read_sound_data (struct loader_job *job);
+static gboolean loader_check_progress (gpointer user_data);
+static void loader_free_job (struct loader_job *job);
+
+/* Initialize the loader subroutines.  */
+void *
+loader_init (GApplication *app)
+{
+  struct loader_info *loader_data;
+  GError *error = NULL;
+
+  loader_data = g_malloc0 (sizeof (struct loader_info));
+  g_mutex_init (&loader_data->probe_lock);
+  g_cond_init (&loader_data->probe_done);
+  loader_data->completed = g_async_queue_new ();
+  loader_data->ready_count = main_get_ready_count ();
+
+  /* A render must be the same every time, so it waits for all of the
+   * sounds.  */
+  if (main_get_render_file_name () != NULL)
+    loader_data->ready_count = 0;
+
+  loader_data->message_count = -1;
+
+  /* Reading a file is mostly waiting, so even a small computer benefits
+   * from several threads.  */
+  loader_data->pool =
+    g_thread_pool_new (loader_run_job, loader_data,
+                       MAX (g_get_num_processors (), 2), FALSE, &error);
+  if (loader_data->pool == NULL)
+    {
+      g_printerr ("Unable to create the loader threads: %s.\n",
+                  error->message);
+      g_error_free (error);
+    }
+
+  return (loader_data);
+}
+
+/* Stop loading sounds and deallocate the loader's persistent data.  */
+void
+loader_finish (GApplication *app)
+{
+  struct loader_info *loader_data;
+  struct loader_job *job;
+
+  loader_data = sep_get_loader_data (app);
+  if (loader_data == NULL)
+    return;
+
+  if (loader_data->progress_source != 0)
+    {
+      g_source_remove (loader_data->progress_source);
+      loader_data->progress_source = 0;
+    }
+
+  /* Discard the files not yet started, and wait for the rest.  */
+  if (loader_data->pool != NULL)
+    {
+      g_thread_pool_free (loader_data->pool, TRUE, TRUE);
+      loader_data->pool = NULL;
+    }
+
+  while ((job = g_async_queue_try_pop (loader_data->completed)) != NULL)
+    {
+      loader_free_job (job);
+    }
+  g_async_queue_unref (loader_data->completed);
+  g_mutex_clear (&loader_data->probe_lock);
+  g_cond_clear (&loader_data->probe_done);
+  g_free (loader_data);
+  return;
+}
+
+/* Read the headers of all the sounds' WAV files, in parallel, to learn
+ * their formats and channel counts.  We return once all have been read.  */
+void
+loader_probe_sounds (GApplication *app)
+{
+  struct loader_info *loader_data;
+  struct loader_job *job;
+  struct sound_info *sound_data;
+  GList *l;
+
+  loader_data = sep_get_loader_data (app);
+
+  for (l = sound_get_sounds_list (app); l != NULL; l = l->next)
+    {
+      sound_data = l->data;
+      if (sound_data->disabled)
+        continue;
+
+      job = g_malloc0 (sizeof (struct loader_job));
+      job->kind = loader_job_probe;
+      job->sound_data = sound_data;
+      job->file_name = g_strdup (sound_data->wav_file_name_full);
+
+      if (loader_data->pool == NULL)
+        {
+          /* Without threads, read the header here.  A sound whose
+           * header cannot be read cannot be played.  */
+          if (sound_parse_wav_file_header (job->file_name, sound_data,
+                                           app) == 0)
+            sound_data->disabled = TRUE;
+          loader_free_job (job);
+          continue;
+        }
+
+      g_mutex_lock (&loader_data->probe_lock);
+      loader_data->probe_remaining = loader_data->probe_remaining + 1;
+      g_mutex_unlock (&loader_data->probe_lock);
+      g_thread_pool_push (loader_data->pool, job, NULL);
+    }
+
+  /* Wait for the headers.  */
+  g_mutex_lock (&loader_data->probe_lock);
+  while (loader_data->probe_remaining > 0)
+    {
+      g_cond_wait (&loader_data->probe_done, &loader_data->probe_lock);
+    }
+  g_mutex_unlock (&loader_data->probe_lock);
+
+  /* Now that we know how many channels each sound has, make sure
+   * the project does not refer to channels it does not have.  */
+  for (l = sound_get_sounds_list (app); l != NULL; l = l->next)
+    {
+      sound_data = l->data;
+      if (!sound_data->disabled)
+        sound_check_channels (sound_data, app);
+    }
+
+  return;
+}
+
+/* Start reading the samples of a sound on a background thread.
+ * When they have been read they are given to the sound's looper.  */
+void
+loader_preload_sound (struct sound_info *sound_data, GApplication *app)
+{
+  struct loader_info *loader_data;
+  struct loader_job *job;
+
+  loader_data = sep_get_loader_data (app);
+
+  job = g_malloc0 (sizeof (struct loader_job));
+  job->kind = loader_job_preload;
+  job->sound_data = sound_data;
+  job->file_name = g_strdup (sound_data->wav_file_name_full);
+  job->max_duration_time = sound_data->max_duration_time;
+  job->format_name = sound_data->storage_format_name;
+  job->channel_count = sound_data->channel_count;
+  job->sample_rate = sound_data->sample_rate;
+  job->use_decode_cache = !main_get_no_decode_cache ();
+
+  loader_data->total_count = loader_data->total_count + 1;
+  if (loader_data->pool == NULL)
+    {
+      /* Without threads, read the samples here.  */
+      loader_run_job (job, loader_data);
+    }
+  else
+    {
+      g_thread_pool_push (loader_data->pool, job, NULL);
+    }
+
+  if (loader_data->progress_source == 0)
+    {
+      loader_data->progress_source =
+        g_timeout_add (LOADER_PROGRESS_INTERVAL, loader_check_progress, app);
+    }
+
+  return;
+}
+
+/* Return TRUE if enough sounds are loaded to start the pipeline playing.
+ * If not, remember that the pipeline is waiting; we will start it playing
+ * when they are.  */
+gboolean
+loader_ready_to_play (GApplication *app)
+{
+  struct loader_info *loader_data;
+  gint needed_count;
+
+  loader_data = sep_get_loader_data (app);
+
+  needed_count = loader_data->total_count;
+  if ((loader_data->ready_count > 0)
+      && (loader_data->ready_count < needed_count))
+    needed_count = loader_data->ready_count;
+
+  if (loader_data->done_count >= needed_count)
+    {
+      loader_data->play_deferred = FALSE;
+      return TRUE;
+    }
+
+  loader_data->play_deferred = TRUE;
+  return FALSE;
+}
+
+/* The pipeline has reached the paused state.  If it is waiting for sounds
+ * to load, remember that, and return TRUE.  We will report that the
+ * pipeline is ready when we start it playing.  */
+gboolean
+loader_defer_ready (GApplication *app)
+{
+  struct loader_info *loader_data;
+
+  loader_data = sep_get_loader_data (app);
+  if (!loader_data->play_deferred)
+    return FALSE;
+
+  loader_data->prerolled = TRUE;
+  return TRUE;
+}
+
+/* Deallocate a loader job.  */
+static void
+loader_free_job (struct loader_job *job)
+{
+  if (job->data != NULL)
+    gst_buffer_unref (job->data);
+  g_free (job->file_name);
+  g_free (job);
+  return;
+}
+
+/* Do one job.  This runs on a thread in the pool.  */
+static void
+loader_run_job (gpointer data, gpointer user_data)
+{
+  struct loader_job *job = data;
+  struct loader_info *loader_data = user_data;
+
+  switch (job->kind)
+    {
+    case loader_job_probe:
+      /* Each job writes only into its own sound, and the main thread
+       * does not look at the sounds until all the jobs are done.
+       * A sound whose header cannot be read cannot be played; the
+       * reason has been printed.  */
+      if (sound_parse_wav_file_header (job->file_name, job->sound_data,
+                                       NULL) == 0)
+        job->sound_data->disabled = TRUE;
+      loader_free_job (job);
+
+      g_mutex_lock (&loader_data->probe_lock);
+      loader_data->probe_remaining = loader_data->probe_remaining - 1;
+      if (loader_data->probe_remaining == 0)
+        g_cond_signal (&loader_data->probe_done);
+      g_mutex_unlock (&loader_data->probe_lock);
+      break;
+
+    case loader_job_preload:
+      job->data = loader_read_sound_data (job);
+      if (TRACE_LOADER)
+        {
+          g_print ("Loaded %" G_GSIZE_FORMAT " bytes from %s.\n",
+                   (job->data == NULL) ? 0 : gst_buffer_get_size (job->data),
+                   job->file_name);
+        }
+
+      /* The looper is given the data on the main thread.  */
+      g_async_queue_push (loader_data->completed, job);
+      break;
+
+    default:
+      break;
+    }
+
+  return;
+}
+
+/* Read the samples of a sound.  A compressed sound file is decoded,
+ * unless we have already saved its decoded samples.  */
+static GstBuffer *
+loader_read_sound_data (struct loader_job *job)
+{
+  FILE *file_stream;
+  gchar magic[4];
+  gboolean compressed;
+  gchar *cache_file_name;
+  GstBuffer *buffer;
+
+  compressed = FALSE;
+  file_stream = fopen (job->file_name, "rb");
+  if (file_stream != NULL)
+    {
+      compressed = ((fread (magic, 1, 4, file_stream) == 4)
+                    && decoder_is_compressed (magic));
+      fclose (file_stream);
+    }
+  if (!compressed)
+    return (loader_read_wav_data (job->file_name, job->max_duration_time,
+                                  job->format_name));
+
+  if (job->use_decode_cache)
+    {
+      cache_file_name = decoder_find_cached_file (job->file_name);
+      if (cache_file_name != NULL)
+        {
+          buffer =
+            loader_read_wav_data (cache_file_name, job->max_duration_time,
+                                  job->format_name);
+          g_free (cache_file_name);
+          if (buffer != NULL)
+            return (buffer);
+        }
+    }
+
+  buffer =
+    decoder_decode_file (job->file_name, job->format_name,
+                         job->channel_count, job->sample_rate,
+                         job->max_duration_time);
+
+  /* Save the samples only if we decoded all of them.  */
+  if ((buffer != NULL) && job->use_decode_cache
+      && (job->max_duration_time == 0))
+    {
+      decoder_write_cached_file (job->file_name, buffer, job->format_name,
+                                 job->channel_count, job->sample_rate);
+    }
+  return (buffer);
+}
+
+/* The sample formats we can convert between.  */
+enum loader_sample_format
+{
+  loader_format_U8,
+  loader_format_S16LE,
+  loader_format_S24LE,
+  loader_format_S32LE,
+  loader_format_F32LE,
+  loader_format_F64LE,
+  loader_format_unknown
+};
+
+/* The names and sizes of the sample formats, in the order above.  */
+static const gchar *const loader_format_names[] = {
+  "U8", "S16LE", "S24LE", "S32LE", "F32LE", "F64LE"
+};
+static const gint loader_format_sizes[] = { 1, 2, 3, 4, 4, 8 };
+
+/* Find a sample format from its name.  */
+static enum loader_sample_format
+loader_sample_format (const gchar *format_name)
+{
+  enum loader_sample_format format;
+
+  for (format = loader_format_U8; format < loader_format_unknown; format++)
+    {
+      if (g_strcmp0 (format_name, loader_format_names[format]) == 0)
+        break;
+    }
+  return (format);
+}
+
+/* Fetch a sample, scaled to a 32-bit integer.  */
+static inline gint32
+loader_get_sample (const guchar *place, enum loader_sample_format format)
+{
+  guint32 word;
+  guint64 double_word;
+  gfloat float_value;
+  gdouble double_value;
+
+  switch (format)
+    {
+    case loader_format_U8:
+      return ((gint32) ((guint32) (place[0] ^ 0x80) << 24));
+    case loader_format_S16LE:
+      return ((gint32) (((guint32) place[0] << 16)
+                        | ((guint32) place[1] << 24)));
+    case loader_format_S24LE:
+      return ((gint32) (((guint32) place[0] << 8)
+                        | ((guint32) place[1] << 16)
+                        | ((guint32) place[2] << 24)));
+    case loader_format_S32LE:
+      memcpy (&word, place, 4);
+      return ((gint32) GUINT32_FROM_LE (word));
+    case loader_format_F32LE:
+      memcpy (&word, place, 4);
+      word = GUINT32_FROM_LE (word);
+      memcpy (&float_value, &word, 4);
+      double_value = float_value;
+      break;
+    case loader_format_F64LE:
+      memcpy (&double_word, place, 8);
+      double_word = GUINT64_FROM_LE (double_word);
+      memcpy (&double_value, &double_word, 8);
+      break;
+    default:
+      return (0);
+    }
+
+  /* Floating point samples run from -1.0 to 1.0, but may go beyond.  */
+  double_value = double_value * 2147483648.0;
+  return ((gint32) CLAMP (double_value, (gdouble) G_MININT32,
+                          (gdouble) G_MAXINT32));
+}
+
+/* Store a sample which has been scaled to a 32-bit integer.  */
+static inline void
+loader_put_sample (guchar *place, gint32 value,
+                   enum loader_sample_format format)
+{
+  guint32 word;
+  guint64 double_word;
+  gfloat float_value;
+  gdouble double_value;
+
+  word = (guint32) value;
+  switch (format)
+    {
+    case loader_format_U8:
+      place[0] = (word >> 24) ^ 0x80;
+      break;
+    case loader_format_S16LE:
+      place[0] = word >> 16;
+      place[1] = word >> 24;
+      break;
+    case loader_format_S24LE:
+      place[0] = word >> 8;
+      place[1] = word >> 16;
+      place[2] = word >> 24;
+      break;
+    case loader_format_S32LE:
+      word = GUINT32_TO_LE (word);
+      memcpy (place, &word, 4);
+      break;
+    case loader_format_F32LE:
+      float_value = value / 2147483648.0;
+      memcpy (&word, &float_value, 4);
+      word = GUINT32_TO_LE (word);
+      memcpy (place, &word, 4);
+      break;
+    case loader_format_F64LE:
+      double_value = value / 2147483648.0;
+      memcpy (&double_word, &double_value, 8);
+      double_word = GUINT64_TO_LE (double_word);
+      memcpy (place, &double_word, 8);
+      break;
+    default:
+      break;
+    }
+  return;
+}
+
+/* Convert samples read from a WAV file into the format the looper
+ * expects.  This happens when a sound's samples are kept more compactly
+ * than its file holds them, or when a decoded file was cached in a
+ * different format from the one now wanted.  Conversion to a narrower
+ * format is done in place.  Returns the samples, and their new size
+ * through new_size.  */
+static guchar *
+loader_convert_samples (guchar *data, gsize size,
+                        enum loader_sample_format file_format,
+                        enum loader_sample_format format, gsize *new_size)
+{
+  gint file_sample_size, sample_size;
+  gsize sample_count, index;
+  guchar *new_data;
+
+  file_sample_size = loader_format_sizes[file_format];
+  sample_size = loader_format_sizes[format];
+  sample_count = size / file_sample_size;
+  *new_size = sample_count * sample_size;
+  if (sample_size <= file_sample_size)
+    new_data = data;
+  else
+    new_data = g_malloc (*new_size);
+
+  /* Each sample is stored no later in the data than it was read from,
+   * so working forward converts in place.  */
+  for (index = 0; index < sample_count; index++)
+    {
+      loader_put_sample (new_data + (index * sample_size),
+                         loader_get_sample (data + (index * file_sample_size),
+                                            file_format), format);
+    }
+
+  /* Give back the memory the narrower samples no longer need.  */
+  if (new_data != data)
+    g_free (data);
+  else
+    new_data = g_realloc (new_data, MAX (*new_size, 1));
+  return (new_data);
+}
+
+/* Read the samples from a WAV file; that is, the contents of its data
+ * chunks.  If max_duration_time is not zero we need read only enough
+ * for that much time.  The looper uses only up to max-duration, so it
+ * doesn't hurt to read a little more.  The samples are converted to
+ * format_name if the file holds them in some other format.  Returns
+ * NULL if the file cannot be read.  */
+static GstBuffer *
+loader_read_wav_data (gchar *file_name, guint64 max_duration_time,
+                      const gchar *format_name)
+{
+  FILE *file_stream;
+  guint32 header[2];
+  guint32 chunk_size;
+  guchar format_chunk[16];
+  guint32 byte_rate;
+  guint16 block_align;
+  guint16 format_code, bits_per_sample;
+  enum loader_sample_format file_format, format;
+  guint64 max_size;
+  guint64 read_size;
+  guint64 fill_level;
+  guchar *data;
+  gsize amount_read;
+  gsize converted_size;
+  GstBuffer *buffer = NULL;
+
+  file_stream = fopen (file_name, "rb");
+  if (file_stream == NULL)
+    {
+      g_printerr ("Failed to open file \"%s\": %s.\n",
+                  file_name, strerror (errno));
+      return (NULL);
+    }
+
+  /* Verify the RIFF header.  We ignore its size field, which is
+   * often wrong, and read chunks until end of file.  */
+  amount_read = fread (&header, 1, 8, file_stream);
+  if ((amount_read != 8) || (memcmp (&header[0], "RIFF", 4) != 0))
+    {
+      g_printerr ("File \"%s\" is not a RIFF file.\n", file_name);
+      fclose (file_stream);
+      return (NULL);
+    }
+  amount_read = fread (&header, 1, 4, file_stream);
+  if ((amount_read != 4) || (memcmp (&header[0], "WAVE", 4) != 0))
+    {
+      g_printerr ("File \"%s\" is not a WAVE file.\n", file_name);
+      fclose (file_stream);
+      return (NULL);
+    }
+
+  max_size = 0;
+  fill_level = 0;
+  data = NULL;
+  file_format = loader_format_unknown;
+  for (;;)
+    {
+      /* If we have enough data to reach max duration, we are done.  */
+      if ((max_size > 0) && (fill_level >= max_size))
+        break;
+
+      amount_read = fread (&header, 1, 8, file_stream);
+      if (amount_read != 8)
+        break;
+      chunk_size = GUINT32_FROM_LE (header[1]);
+
+      if ((memcmp (&header[0], "fmt ", 4) == 0) && (chunk_size >= 16))
+        {
+          /* From the format chunk we learn the data rate, which converts
+           * max duration into bytes.  */
+          amount_read = fread (&format_chunk, 1, 16, file_stream);
+          if (amount_read != 16)
+            break;
+          byte_rate = format_chunk[8] | (format_chunk[9] << 8)
+            | (format_chunk[10] << 16) | ((guint32) format_chunk[11] << 24);
+          block_align = format_chunk[12] | (format_chunk[13] << 8);
+          format_code = format_chunk[0] | (format_chunk[1] << 8);
+          bits_per_sample = format_chunk[14] | (format_chunk[15] << 8);
+
+          /* As in sound_parse_wav_file_header, 8-bit samples are
+           * unsigned and format code 3 means floating point.  */
+          switch (bits_per_sample)
+            {
+            case 8:
+              file_format = loader_format_U8;
+              break;
+            case 16:
+              file_format = loader_format_S16LE;
+              break;
+            case 24:
+              file_format = loader_format_S24LE;
+              break;
+            case 32:
+              file_format = (format_code == 3) ? loader_format_F32LE
+                : loader_format_S32LE;
+              break;
+            case 64:
+              file_format = loader_format_F64LE;
+              break;
+            default:
+              file_format = loader_format_unknown;
+              break;
+            }
+          if ((max_duration_time > 0) && (byte_rate > 0))
+            {
+              max_size =
+                gst_util_uint64_scale_ceil (max_duration_time, byte_rate,
+                                            GST_SECOND) + block_align;
+            }
+          chunk_size = chunk_size - 16;
+        }
+      else if (memcmp (&header[0], "data", 4) == 0)
+        {
+          /* Copy the part of the data chunk we need.  */
+          read_size = chunk_size;
+          if ((max_size > 0) && (fill_level + read_size > max_size))
+            read_size = max_size - fill_level;
+          data = g_realloc (data, fill_level + read_size);
+          amount_read = fread (data + fill_level, 1, read_size, file_stream);
+          fill_level = fill_level + amount_read;
+          if (amount_read != read_size)
+            break;
+          chunk_size = chunk_size - read_size;
+        }
+
+      /* Skip the rest of the chunk.  Odd chunk sizes are padded with
+       * a single byte so that chunks always start on 2-byte boundaries.  */
+      if ((GUINT32_FROM_LE (header[1]) & 1) == 1)
+        chunk_size = chunk_size + 1;
+      if ((chunk_size > 0) && (fseek (file_stream, chunk_size, SEEK_CUR) != 0))
+        break;
+    }
+
+  if (ferror (file_stream))
+    {
+      g_printerr ("Failed to read file \"%s\".\n", file_name);
+      g_free (data);
+    }
+  else if (data == NULL)
+    {
+      buffer = gst_buffer_new ();
+    }
+  else
+    {
+      /* Keep the samples in the format the looper was told of.  */
+      format = loader_sample_format (format_name);
+      if ((file_format != format) && (file_format != loader_format_unknown)
+          && (format != loader_format_unknown))
+        {
+          data =
+            loader_convert_samples (data, fill_level, file_format, format,
+                                    &converted_size);
+          fill_level = converted_size;
+        }
+      buffer = gst_buffer_new_wrapped (data, fill_level);
+    }
+
+  fclose (file_stream);
+  return (buffer);
+}
+
+/* Called periodically on the main thread while sounds are loading.
+ * Give the loaded samples to their loopers, start the pipeline playing
+ * once enough are ready, and show the operator our progress.  */
+static gboolean
+loader_check_progress (gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct loader_info *loader_data;
+  struct loader_job *job;
+  GstElement *looper_element;
+  struct voice_info *voice_data;
+  GList *l;
+  GstPipeline *pipeline_element;
+  gchar *message_text;
+
+  loader_data = sep_get_loader_data (app);
+
+  while ((job = g_async_queue_try_pop (loader_data->completed)) != NULL)
+    {
+      /* If we could not read the file the looper will try, but it
+       * reads only the format it was told of.  If the samples were to
+       * be kept in another format, leave the sound silent.  */
+      if ((job->data == NULL)
+          && (g_strcmp0 (job->format_name, job->sound_data->format_name)
+              != 0))
+        job->data = gst_buffer_new ();
+
+      /* If the project was reloaded while we were reading this sound,
+       * its bin might be gone, and with it the looper.  */
+      looper_element = job->sound_data->looper_element;
+      if (looper_element != NULL)
+        {
+          if (job->data != NULL)
+            {
+              g_object_set (looper_element, "preloaded-data", job->data,
+                            NULL);
+            }
+          else
+            {
+              /* We could not read the file, so let the looper try.  */
+              g_object_set (looper_element, "preload", FALSE, NULL);
+            }
+        }
+
+      /* The sound's other voices share the samples.  */
+      for (l = job->sound_data->voices; l != NULL; l = l->next)
+        {
+          voice_data = l->data;
+          if (voice_data->looper_element == NULL)
+            continue;
+          if (job->data != NULL)
+            g_object_set (voice_data->looper_element, "preloaded-data",
+                          job->data, NULL);
+          else
+            g_object_set (voice_data->looper_element, "preload", FALSE,
+                          NULL);
+        }
+      loader_data->done_count = loader_data->done_count + 1;
+      loader_free_job (job);
+    }
+
+  /* If the pipeline is waiting for sounds, see if it can start.  */
+  if (loader_data->play_deferred && loader_ready_to_play (app))
+    {
+      pipeline_element = sep_get_pipeline_from_app (app);
+      if (pipeline_element != NULL)
+        {
+          gstreamer_play_pipeline (pipeline_element, app);
+        }
+      if (loader_data->prerolled)
+        {
+          loader_data->prerolled = FALSE;
+          sep_gstreamer_ready (app);
+        }
+    }
+
+  /* Keep the operator informed.  */
+  if (loader_data->message_count != loader_data->done_count)
+    {
+      if (loader_data->message_id != 0)
+        {
+          display_remove_message (loader_data->message_id, app);
+          loader_data->message_id = 0;
+        }
+      if (loader_data->done_count < loader_data->total_count)
+        {
+          message_text =
+            g_strdup_printf ("Loading sounds: %d of %d.",
+                             loader_data->done_count,
+                             loader_data->total_count);
+          loader_data->message_id = display_show_message (message_text, app);
+          g_free (message_text);
+        }
+      loader_data->message_count = loader_data->done_count;
+    }
+
+  if (loader_data->done_count < loader_data->total_count)
+    return G_SOURCE_CONTINUE;
+
+  /* All of the sounds are in memory; keep them there, and get them
+   * ready to start quickly.  */
+  realtime_lock_memory (app);
+  warmup_start (app);
+
+  loader_data->progress_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+/* End of file loader_subroutines.c */
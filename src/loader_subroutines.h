@@ -0,0 +1,45 @@
+/*
+ * loader_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include "sound_structure.h"
+
+/* Subroutines defined in loader_subroutines.c */
+
+/* Initialize the loader subroutines.  */
+void *loader_init (GApplication *app);
+
+/* Stop loading sounds and deallocate the loader's persistent data.  */
+void loader_finish (GApplication *app);
+
+/* Read the headers of all the sounds' WAV files, in parallel.  */
+void loader_probe_sounds (GApplication *app);
+
+/* Start reading the samples of a sound on a background thread.  */
+void loader_preload_sound (struct sound_info *sound_data, GApplication *app);
+
+/* Return TRUE if enough sounds are loaded to start the pipeline playing.
+ * If not, the loader starts it playing when they are.  */
+gboolean loader_ready_to_play (GApplication *app);
+
+/* The pipeline has prerolled.  Return TRUE if it is waiting for sounds
+ * to load, in which case the loader will report it ready later.  */
+gboolean loader_defer_ready (GApplication *app);
+
+/* End of file loader_subroutines.h */
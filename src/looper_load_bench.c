@@ -0,0 +1,168 @@
+/*
+ * looper_load_bench.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compare the time needed to fill the looper's local buffer the way it
+ * used to be filled, by appending a new piece of memory for each block
+ * received and mapping the whole buffer to copy the block into it, and
+ * the way gstlooper.c now fills it, as a single block of memory which
+ * grows geometrically.  Mapping a buffer made of many pieces merges
+ * them, so the old way copies everything received so far for every
+ * block, and its time grows with the square of the sound's length.
+ * The program does not need the user interface.  Build it with
+ * "make looper_load_bench" and run it with an optional block size in
+ * bytes and largest sound length in seconds.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <gst/gst.h>
+
+/* The data rate of CD-quality stereo sound, in bytes per second.  */
+#define BYTES_PER_SECOND (44100 * 2 * 2)
+
+/* The old way: a new piece of memory for each block.  */
+static gsize
+load_by_appending (GstBuffer *block, guint64 total_size)
+{
+  GstBuffer *local_buffer;
+  GstMemory *memory_allocated;
+  GstMapInfo block_info, local_info;
+  guint64 fill_level;
+  gsize result;
+
+  local_buffer = gst_buffer_new ();
+  fill_level = 0;
+  gst_buffer_map (block, &block_info, GST_MAP_READ);
+  while (fill_level < total_size)
+    {
+      memory_allocated = gst_allocator_alloc (NULL, block_info.size, NULL);
+      gst_buffer_append_memory (local_buffer, memory_allocated);
+      gst_buffer_map (local_buffer, &local_info, GST_MAP_WRITE);
+      memcpy (local_info.data + fill_level, block_info.data,
+              block_info.size);
+      gst_buffer_unmap (local_buffer, &local_info);
+      fill_level = fill_level + block_info.size;
+    }
+  gst_buffer_unmap (block, &block_info);
+  result = gst_buffer_get_size (local_buffer);
+  gst_buffer_unref (local_buffer);
+  return result;
+}
+
+/* The new way: one block of memory, doubled when it fills.  */
+static gsize
+load_into_arena (GstBuffer *block, guint64 total_size)
+{
+  GstBuffer *local_buffer;
+  GstMemory *memory_allocated;
+  GstMapInfo old_info, new_info, local_info;
+  guint64 fill_level, capacity, new_capacity;
+  gsize block_size;
+
+  local_buffer = gst_buffer_new ();
+  fill_level = 0;
+  capacity = 0;
+  block_size = gst_buffer_get_size (block);
+  while (fill_level < total_size)
+    {
+      if (fill_level + block_size > capacity)
+        {
+          new_capacity = MAX (fill_level + block_size, capacity * 2);
+          memory_allocated = gst_allocator_alloc (NULL, new_capacity, NULL);
+          if (fill_level > 0)
+            {
+              gst_memory_map (memory_allocated, &new_info, GST_MAP_WRITE);
+              gst_buffer_map (local_buffer, &old_info, GST_MAP_READ);
+              memcpy (new_info.data, old_info.data, fill_level);
+              gst_buffer_unmap (local_buffer, &old_info);
+              gst_memory_unmap (memory_allocated, &new_info);
+            }
+          gst_buffer_replace_all_memory (local_buffer, memory_allocated);
+          capacity = new_capacity;
+        }
+      gst_buffer_map (local_buffer, &local_info, GST_MAP_WRITE);
+      gst_buffer_extract (block, 0, local_info.data + fill_level,
+                          block_size);
+      gst_buffer_unmap (local_buffer, &local_info);
+      fill_level = fill_level + block_size;
+    }
+  gst_buffer_unref (local_buffer);
+  return fill_level;
+}
+
+/* Run one method and report its time.  */
+static void
+measure (const gchar *method_name,
+         gsize (*method) (GstBuffer *block, guint64 total_size),
+         GstBuffer *block, guint seconds)
+{
+  gint64 start_time, end_time;
+  gsize loaded;
+
+  start_time = g_get_monotonic_time ();
+  loaded = method (block, (guint64) seconds * BYTES_PER_SECOND);
+  end_time = g_get_monotonic_time ();
+  g_print ("%-6s %4u seconds of sound, %10" G_GSIZE_FORMAT
+           " bytes in %8.3f seconds.\n", method_name, seconds, loaded,
+           (gdouble) (end_time - start_time) / 1e6);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GstBuffer *block;
+  GstMapInfo block_info;
+  gsize block_size;
+  guint max_seconds, seconds;
+
+  gst_init (&argc, &argv);
+
+  /* The looper used to pull 4096 bytes at a time from upstream, and
+   * filesrc pushes that much by default.  */
+  block_size = 4096;
+  max_seconds = 120;
+  if (argc > 1)
+    block_size = strtoul (argv[1], NULL, 0);
+  if (argc > 2)
+    max_seconds = strtoul (argv[2], NULL, 0);
+  if (block_size == 0)
+    {
+      g_printerr ("The block size must be at least one byte.\n");
+      return EXIT_FAILURE;
+    }
+
+  block = gst_buffer_new_allocate (NULL, block_size, NULL);
+  gst_buffer_map (block, &block_info, GST_MAP_WRITE);
+  memset (block_info.data, 0x5a, block_size);
+  gst_buffer_unmap (block, &block_info);
+
+  /* Double the length of the sound each time, so the growth of each
+   * method's time is easy to see.  */
+  for (seconds = 1; seconds <= max_seconds; seconds = seconds * 2)
+    {
+      measure ("append", load_by_appending, block, seconds);
+      measure ("arena", load_into_arena, block, seconds);
+    }
+
+  gst_buffer_unref (block);
+  return EXIT_SUCCESS;
+}
+
+/* End of file looper_load_bench.c */
@@ -31,7 +31,28 @@ static gchar *client_name_string = NULL;
 static gchar *server_name_string = NULL;
 static gchar *trace_file_name = NULL;
 static gint trace_sequencer_level = 1;
+static gchar *trace_sync_string = NULL;
+static gint trace_profile_interval = 0;
 static gchar *configuration_file_name = NULL;
+static gchar *telemetry_address_string = NULL;
+static gint telemetry_interval = 100;
+static gboolean no_project_cache = FALSE;
+static gboolean no_decode_cache = FALSE;
+static gint ready_count = 16;
+static gboolean headless = FALSE;
+static gchar *render_file_name = NULL;
+static gchar *render_script_name = NULL;
+static gchar *record_file_name = NULL;
+static gchar *replay_file_name = NULL;
+static gint voice_limit = 0;
+static gchar *voice_stealing_string = NULL;
+static gchar *sample_storage_string = NULL;
+static gint realtime_priority = 0;
+static gchar *realtime_policy_string = NULL;
+static gchar *realtime_cpus_string = NULL;
+static gboolean lock_memory = FALSE;
+static gboolean warm_up = FALSE;
+static gboolean memory_report = FALSE;
 
 /* The entry point for the sound_effects_player application.  
  * This is a GTK application, so much of what is done here is standard 
@@ -65,8 +86,53 @@ main (int argc, char *argv[])
     {"trace-sequencer-level", 'v', 0, G_OPTION_ARG_INT,
      &trace_sequencer_level,
      "The amount of sequencer tracing: 0 = none, 1 = all"},
+    {"trace-sync", 0, 0, G_OPTION_ARG_STRING, &trace_sync_string,
+     "when to force the trace file to disk: none, batch, each"},
+    {"trace-profile", 0, 0, G_OPTION_ARG_INT, &trace_profile_interval,
+     "seconds between summaries of pipeline element times in the trace "
+     "file; 0 means don't profile"},
     {"configuration-file", 'c', G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME,
      &configuration_file_name, "name of the configuration file"},
+    {"telemetry-address", 0, 0, G_OPTION_ARG_STRING,
+     &telemetry_address_string,
+     "host:port to send OSC status reports to; may be multicast"},
+    {"telemetry-interval", 0, 0, G_OPTION_ARG_INT, &telemetry_interval,
+     "milliseconds between OSC status reports, default 100"},
+    {"no-project-cache", 0, 0, G_OPTION_ARG_NONE, &no_project_cache,
+     "always parse the project files; do not use or write the cache"},
+    {"no-decode-cache", 0, 0, G_OPTION_ARG_NONE, &no_decode_cache,
+     "always decode compressed sound files; do not save them decoded"},
+    {"ready-count", 0, 0, G_OPTION_ARG_INT, &ready_count,
+     "start playing once this many sounds are loaded; 0 means all"},
+    {"headless", 0, 0, G_OPTION_ARG_NONE, &headless,
+     "run without a display; no operator window is shown"},
+    {"render", 0, 0, G_OPTION_ARG_FILENAME, &render_file_name,
+     "write the mix to this WAV file as fast as possible, then exit"},
+    {"render-script", 0, 0, G_OPTION_ARG_FILENAME, &render_script_name,
+     "file of timed commands to send while rendering"},
+    {"record-events", 0, 0, G_OPTION_ARG_FILENAME, &record_file_name,
+     "record network, button, signal and completion events in this file"},
+    {"replay-events", 0, 0, G_OPTION_ARG_FILENAME, &replay_file_name,
+     "replay the events recorded in this file"},
+    {"voice-limit", 0, 0, G_OPTION_ARG_INT, &voice_limit,
+     "the most sounds that can play at once; 0 means no limit"},
+    {"voice-stealing", 0, 0, G_OPTION_ARG_STRING, &voice_stealing_string,
+     "which sound to release at the voice limit: "
+     "oldest, quietest, releasing"},
+    {"sample-storage", 0, 0, G_OPTION_ARG_STRING, &sample_storage_string,
+     "keep samples in their file's format (source) or 24-bit (compact)"},
+    {"realtime-priority", 0, 0, G_OPTION_ARG_INT, &realtime_priority,
+     "run the audio threads at this real-time priority; 0 means don't"},
+    {"realtime-policy", 0, 0, G_OPTION_ARG_STRING, &realtime_policy_string,
+     "the real-time scheduling policy: fifo or rr"},
+    {"realtime-cpus", 0, 0, G_OPTION_ARG_STRING, &realtime_cpus_string,
+     "run the audio threads only on these processors, such as 2,3"},
+    {"lock-memory", 0, 0, G_OPTION_ARG_NONE, &lock_memory,
+     "lock the sounds into memory once they are loaded"},
+    {"warm-up", 0, 0, G_OPTION_ARG_NONE, &warm_up,
+     "play each sound silently once it is loaded, so it starts quickly"},
+    {"memory-report", 0, 0, G_OPTION_ARG_NONE, &memory_report,
+     "when exiting, print how much memory the sounds and the rest used"},
     /* add more command line options here */
     {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames,
      "Special option that collects any remaining arguments for us"},
@@ -78,6 +144,7 @@ main (int argc, char *argv[])
   const gchar *check_version_str;
   int fake_argc;
   char *fake_argv[2];
+  int i;
   
 #ifdef ENABLE_NLS
   bindtextdomain (GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR);
@@ -85,12 +152,27 @@ main (int argc, char *argv[])
   textdomain (GETTEXT_PACKAGE);
 #endif
 
+  /* We must know whether we are running headless before GTK is
+   * initialized, since initializing GTK opens the display.
+   * Rendering is always done headless.  */
+  for (i = 1; i < argc; i++)
+    {
+      if (strcmp (argv[i], "--") == 0)
+        break;
+      if ((strcmp (argv[i], "--headless") == 0)
+          || (strcmp (argv[i], "--render") == 0)
+          || (strncmp (argv[i], "--render=", 9) == 0))
+        headless = TRUE;
+    }
+
   /* Initialize gtk and Gstreamer. */
-  gtk_init (&argc, &argv);
+  if (!headless)
+    gtk_init (&argc, &argv);
 
   /* Parse the command line.  */
   ctx = g_option_context_new ("[project_file]");
-  g_option_context_add_group (ctx, gtk_get_option_group (TRUE));
+  if (!headless)
+    g_option_context_add_group (ctx, gtk_get_option_group (TRUE));
   g_option_context_add_group (ctx, gst_init_get_option_group ());
   g_option_context_add_main_entries (ctx, entries, NULL);
   g_option_context_set_summary (ctx, "Play sound effects for ShowControl.");
@@ -168,8 +250,28 @@ main (int argc, char *argv[])
   server_name_string = NULL;
   free (trace_file_name);
   trace_file_name = NULL;
+  free (trace_sync_string);
+  trace_sync_string = NULL;
   free (configuration_file_name);
   configuration_file_name = NULL;
+  free (telemetry_address_string);
+  telemetry_address_string = NULL;
+  free (render_file_name);
+  render_file_name = NULL;
+  free (render_script_name);
+  render_script_name = NULL;
+  free (record_file_name);
+  record_file_name = NULL;
+  free (replay_file_name);
+  replay_file_name = NULL;
+  free (voice_stealing_string);
+  voice_stealing_string = NULL;
+  free (sample_storage_string);
+  sample_storage_string = NULL;
+  free (realtime_policy_string);
+  realtime_policy_string = NULL;
+  free (realtime_cpus_string);
+  realtime_cpus_string = NULL;
   return status;
 }
 
@@ -216,10 +318,136 @@ main_get_trace_sequencer_level ()
   return trace_sequencer_level;
 }
 
+gchar *
+main_get_trace_sync_string ()
+{
+  return trace_sync_string;
+}
+
+gint
+main_get_trace_profile_interval ()
+{
+  return trace_profile_interval;
+}
+
 gchar *
 main_get_configuration_file_name ()
 {
   return configuration_file_name;
 }
 
+gchar *
+main_get_telemetry_address_string ()
+{
+  return telemetry_address_string;
+}
+
+gint
+main_get_telemetry_interval ()
+{
+  return telemetry_interval;
+}
+
+gboolean
+main_get_no_project_cache ()
+{
+  return no_project_cache;
+}
+
+gboolean
+main_get_no_decode_cache ()
+{
+  return no_decode_cache;
+}
+
+gint
+main_get_ready_count ()
+{
+  return ready_count;
+}
+
+gboolean
+main_get_headless ()
+{
+  return headless;
+}
+
+gchar *
+main_get_render_file_name ()
+{
+  return render_file_name;
+}
+
+gchar *
+main_get_render_script_name ()
+{
+  return render_script_name;
+}
+
+gchar *
+main_get_record_file_name ()
+{
+  return record_file_name;
+}
+
+gchar *
+main_get_replay_file_name ()
+{
+  return replay_file_name;
+}
+
+gint
+main_get_voice_limit ()
+{
+  return voice_limit;
+}
+
+gchar *
+main_get_voice_stealing_string ()
+{
+  return voice_stealing_string;
+}
+
+gchar *
+main_get_sample_storage_string ()
+{
+  return sample_storage_string;
+}
+
+gint
+main_get_realtime_priority ()
+{
+  return realtime_priority;
+}
+
+gchar *
+main_get_realtime_policy_string ()
+{
+  return realtime_policy_string;
+}
+
+gchar *
+main_get_realtime_cpus_string ()
+{
+  return realtime_cpus_string;
+}
+
+gboolean
+main_get_lock_memory ()
+{
+  return lock_memory;
+}
+
+gboolean
+main_get_warm_up ()
+{
+  return warm_up;
+}
+
+gboolean
+main_get_memory_report ()
+{
+  return memory_report;
+}
+
 /* End of file main.c */
@@ -29,6 +29,27 @@ gchar *main_get_client_name_string ();
 gchar *main_get_server_name_string ();
 gchar *main_get_trace_file_name ();
 gint main_get_trace_sequencer_level ();
+gchar *main_get_trace_sync_string ();
+gint main_get_trace_profile_interval ();
 gchar *main_get_configuration_file_name ();
+gchar *main_get_telemetry_address_string ();
+gint main_get_telemetry_interval ();
+gboolean main_get_no_project_cache ();
+gboolean main_get_no_decode_cache ();
+gint main_get_ready_count ();
+gboolean main_get_headless ();
+gchar *main_get_render_file_name ();
+gchar *main_get_render_script_name ();
+gchar *main_get_record_file_name ();
+gchar *main_get_replay_file_name ();
+gint main_get_voice_limit ();
+gchar *main_get_voice_stealing_string ();
+gchar *main_get_sample_storage_string ();
+gint main_get_realtime_priority ();
+gchar *main_get_realtime_policy_string ();
+gchar *main_get_realtime_cpus_string ();
+gboolean main_get_lock_memory ();
+gboolean main_get_warm_up ();
+gboolean main_get_memory_report ();
 
 /* End of file main.h */
@@ -0,0 +1,418 @@
+/*
+ * memory_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include <gst/audio/gstaudiobasesink.h>
+#include <libxml/tree.h>
+#include "memory_subroutines.h"
+#include "project_cache_subroutines.h"
+#include "sound_effects_player.h"
+#include "sound_structure.h"
+#include "sound_subroutines.h"
+
+/* Nearly all of our memory holds the sounds' samples, which each
+ * looper keeps so that it can play its sound without reading the
+ * disk.  The voices of a sound share its samples, but two sounds
+ * which use the same file each have their own copy.  This report
+ * shows how much each sound and each file holds, along with the
+ * other things we keep, so that the operator can see where the
+ * memory has gone.  */
+
+/* Warn if one sound holds more than this fraction of the samples.  */
+#define MEMORY_DOMINANT_FRACTION 0.5
+
+/* What one sound holds.  */
+struct memory_sound
+{
+  struct sound_info *sound_data;
+  guint64 bytes;
+  gint voice_count;
+};
+
+/* What the sounds which use one file hold.  */
+struct memory_file
+{
+  const gchar *file_name;
+  guint64 bytes;
+  gint sound_count;
+  gint copy_count;              /* sounds holding samples of this file */
+};
+
+/* The memory held by a looper for its samples.  Samples shared with
+ * a looper already seen are not counted again.  */
+static guint64
+memory_looper_bytes (GstElement *looper_element, GHashTable *seen)
+{
+  GstBuffer *preloaded_data;
+  guint64 bytes;
+  gpointer key;
+
+  if (looper_element == NULL)
+    return (0);
+
+  preloaded_data = NULL;
+  bytes = 0;
+  g_object_get (looper_element, "preloaded-data", &preloaded_data,
+                "local-buffer-bytes", &bytes, NULL);
+
+  /* The key is used only for its identity, so the buffer need not
+   * stay referenced; the looper keeps it.  */
+  key = looper_element;
+  if (preloaded_data != NULL)
+    {
+      key = preloaded_data;
+      gst_buffer_unref (preloaded_data);
+    }
+  if (g_hash_table_contains (seen, key))
+    return (0);
+  g_hash_table_add (seen, key);
+  return (bytes);
+}
+
+/* Sort sounds so the largest comes first.  */
+static gint
+memory_compare_sounds (gconstpointer a, gconstpointer b)
+{
+  const struct memory_sound *sound_a = a;
+  const struct memory_sound *sound_b = b;
+
+  if (sound_a->bytes > sound_b->bytes)
+    return (-1);
+  if (sound_a->bytes < sound_b->bytes)
+    return (1);
+  return (0);
+}
+
+static gint
+memory_compare_files (gconstpointer a, gconstpointer b)
+{
+  const struct memory_file *file_a = *(struct memory_file *const *) a;
+  const struct memory_file *file_b = *(struct memory_file *const *) b;
+
+  if (file_a->bytes > file_b->bytes)
+    return (-1);
+  if (file_a->bytes < file_b->bytes)
+    return (1);
+  return (0);
+}
+
+/* Estimate the memory held by a tree of XML nodes.  libxml2 does not
+ * say, so we add up the nodes and their text.  */
+static gsize
+memory_xml_size (xmlNodePtr node)
+{
+  xmlAttrPtr attribute;
+  gsize size;
+
+  size = 0;
+  for (; node != NULL; node = node->next)
+    {
+      size = size + sizeof (xmlNode);
+      if (node->content != NULL)
+        size = size + xmlStrlen (node->content) + 1;
+      for (attribute = node->properties; attribute != NULL;
+           attribute = attribute->next)
+        size = size + sizeof (xmlAttr) + memory_xml_size (attribute->children);
+      size = size + memory_xml_size (node->children);
+    }
+  return (size);
+}
+
+/* The memory held by the buffers in a queue or an audio output.  */
+static guint64
+memory_element_buffer_bytes (GstElement *element, gint *queue_count)
+{
+  GstElementFactory *factory;
+  GstPad *sink_pad;
+  GstCaps *caps;
+  GstAudioInfo audio_info;
+  guint level_bytes;
+  gint64 buffer_time;
+  guint64 bytes;
+
+  bytes = 0;
+  factory = gst_element_get_factory (element);
+  if ((factory != NULL)
+      && (g_strcmp0 (GST_OBJECT_NAME (factory), "queue") == 0))
+    {
+      g_object_get (element, "current-level-bytes", &level_bytes, NULL);
+      *queue_count = *queue_count + 1;
+      bytes = level_bytes;
+    }
+  else if (GST_IS_AUDIO_BASE_SINK (element))
+    {
+      /* The audio output keeps a ring buffer of buffer-time
+       * microseconds of sound in the format it was given.  */
+      g_object_get (element, "buffer-time", &buffer_time, NULL);
+      sink_pad = gst_element_get_static_pad (element, "sink");
+      caps = NULL;
+      if (sink_pad != NULL)
+        {
+          caps = gst_pad_get_current_caps (sink_pad);
+          gst_object_unref (sink_pad);
+        }
+      if ((caps != NULL) && gst_audio_info_from_caps (&audio_info, caps))
+        bytes = gst_util_uint64_scale (buffer_time,
+                                       (guint64) GST_AUDIO_INFO_RATE
+                                       (&audio_info) *
+                                       GST_AUDIO_INFO_BPF (&audio_info),
+                                       G_USEC_PER_SEC);
+      if (caps != NULL)
+        gst_caps_unref (caps);
+    }
+  return (bytes);
+}
+
+/* The memory held by the pipeline's buffers, and its element count.  */
+static guint64
+memory_pipeline_bytes (GApplication *app, gint *element_count,
+                       gint *queue_count)
+{
+  GstPipeline *pipeline_element;
+  GstIterator *bin_iterator;
+  GstElement *this_element;
+  gboolean done;
+  guint64 bytes;
+  GValue item = G_VALUE_INIT;
+
+  bytes = 0;
+  *element_count = 0;
+  *queue_count = 0;
+  pipeline_element = sep_get_pipeline_from_app (app);
+  if (pipeline_element == NULL)
+    return (0);
+
+  bin_iterator = gst_bin_iterate_recurse (GST_BIN (pipeline_element));
+  done = FALSE;
+  while (!done)
+    {
+      switch (gst_iterator_next (bin_iterator, &item))
+        {
+        case GST_ITERATOR_OK:
+          this_element = GST_ELEMENT (g_value_get_object (&item));
+          *element_count = *element_count + 1;
+          bytes = bytes + memory_element_buffer_bytes (this_element,
+                                                       queue_count);
+          g_value_reset (&item);
+          break;
+        case GST_ITERATOR_RESYNC:
+          /* The pipeline changed while we were looking; start over.  */
+          bytes = 0;
+          *element_count = 0;
+          *queue_count = 0;
+          gst_iterator_resync (bin_iterator);
+          break;
+        case GST_ITERATOR_ERROR:
+        case GST_ITERATOR_DONE:
+          done = TRUE;
+          break;
+        }
+    }
+  g_value_unset (&item);
+  gst_iterator_free (bin_iterator);
+  return (bytes);
+}
+
+/* The process's resident memory, or 0 if it cannot be found.  */
+static guint64
+memory_resident_bytes (void)
+{
+  FILE *statm;
+  unsigned long size, resident;
+
+  statm = fopen ("/proc/self/statm", "r");
+  if (statm == NULL)
+    return (0);
+  if (fscanf (statm, "%lu %lu", &size, &resident) != 2)
+    resident = 0;
+  fclose (statm);
+  return ((guint64) resident * sysconf (_SC_PAGESIZE));
+}
+
+/* Print a line of the report, with an amount of memory.  */
+static void
+memory_print (const gchar *label, guint64 bytes, const gchar *detail)
+{
+  gchar *size_text;
+
+  size_text = g_format_size (bytes);
+  g_print ("  %s: %s (%" G_GUINT64_FORMAT " bytes)%s%s.\n", label,
+           size_text, bytes, (detail == NULL) ? "" : ", ",
+           (detail == NULL) ? "" : detail);
+  g_free (size_text);
+  return;
+}
+
+/* Print how much memory the sounds, the caches and the pipeline are
+ * using.  */
+void
+memory_report (GApplication *app)
+{
+  GList *l, *v;
+  struct sound_info *sound_data;
+  struct voice_info *voice_data;
+  struct memory_sound sound_entry, *largest;
+  struct memory_file *file_entry;
+  GArray *sounds;
+  GPtrArray *files;
+  GHashTable *seen, *files_by_name;
+  xmlDocPtr configuration_file;
+  const gchar *file_name;
+  gchar *detail, *label;
+  guint64 sample_bytes, cache_bytes, xml_bytes, pipeline_bytes;
+  guint64 resident_bytes, accounted_bytes;
+  gint element_count, queue_count;
+  guint index;
+
+  sounds = g_array_new (FALSE, FALSE, sizeof (struct memory_sound));
+  files = g_ptr_array_new_with_free_func (g_free);
+  files_by_name = g_hash_table_new (g_str_hash, g_str_equal);
+  seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  /* Count the samples held by each sound and its voices, and by the
+   * sounds which use each file.  */
+  sample_bytes = 0;
+  for (l = sound_get_sounds_list (app); l != NULL; l = l->next)
+    {
+      sound_data = l->data;
+      sound_entry.sound_data = sound_data;
+      sound_entry.voice_count = 1;
+      sound_entry.bytes =
+        memory_looper_bytes (sound_data->looper_element, seen);
+      for (v = sound_data->voices; v != NULL; v = v->next)
+        {
+          voice_data = v->data;
+          sound_entry.voice_count = sound_entry.voice_count + 1;
+          sound_entry.bytes = sound_entry.bytes +
+            memory_looper_bytes (voice_data->looper_element, seen);
+        }
+      g_array_append_val (sounds, sound_entry);
+      sample_bytes = sample_bytes + sound_entry.bytes;
+
+      file_name = sound_data->wav_file_name_full;
+      if (file_name == NULL)
+        file_name = sound_data->wav_file_name;
+      if (file_name == NULL)
+        continue;
+      file_entry = g_hash_table_lookup (files_by_name, file_name);
+      if (file_entry == NULL)
+        {
+          file_entry = g_malloc0 (sizeof (struct memory_file));
+          file_entry->file_name = file_name;
+          g_hash_table_insert (files_by_name, (gpointer) file_name,
+                               file_entry);
+          g_ptr_array_add (files, file_entry);
+        }
+      file_entry->bytes = file_entry->bytes + sound_entry.bytes;
+      file_entry->sound_count = file_entry->sound_count + 1;
+      if (sound_entry.bytes > 0)
+        file_entry->copy_count = file_entry->copy_count + 1;
+    }
+  g_array_sort (sounds, memory_compare_sounds);
+  g_ptr_array_sort (files, memory_compare_files);
+
+  g_print ("Memory report:\n");
+  g_print (" Samples, by sound:\n");
+  for (index = 0; index < sounds->len; index++)
+    {
+      sound_entry = g_array_index (sounds, struct memory_sound, index);
+      sound_data = sound_entry.sound_data;
+      detail = g_strdup_printf ("%d voice%s, %s samples%s",
+                                sound_entry.voice_count,
+                                (sound_entry.voice_count == 1) ? "" : "s",
+                                (sound_data->storage_format_name == NULL) ?
+                                "no" : sound_data->storage_format_name,
+                                sound_data->disabled ? ", disabled" : "");
+      memory_print (sound_data->name, sound_entry.bytes, detail);
+      g_free (detail);
+    }
+
+  g_print (" Samples, by file:\n");
+  for (index = 0; index < files->len; index++)
+    {
+      file_entry = g_ptr_array_index (files, index);
+      detail = g_strdup_printf ("used by %d sound%s%s",
+                                file_entry->sound_count,
+                                (file_entry->sound_count == 1) ? "" : "s",
+                                (file_entry->copy_count > 1) ?
+                                ", each with its own copy" : "");
+      memory_print (file_entry->file_name, file_entry->bytes, detail);
+      g_free (detail);
+    }
+
+  /* The other things we keep.  */
+  cache_bytes = project_cache_memory_size (app);
+  xml_bytes = 0;
+  configuration_file = sep_get_configuration_file (app);
+  if (configuration_file != NULL)
+    xml_bytes = sizeof (xmlDoc) +
+      memory_xml_size (xmlDocGetRootElement (configuration_file));
+  pipeline_bytes = memory_pipeline_bytes (app, &element_count, &queue_count);
+  resident_bytes = memory_resident_bytes ();
+
+  g_print (" Totals:\n");
+  detail = g_strdup_printf ("%u sounds, %u files", sounds->len, files->len);
+  memory_print ("sound samples", sample_bytes, detail);
+  g_free (detail);
+  memory_print ("project cache", cache_bytes,
+                "file list kept until the project cache is written");
+  memory_print ("configuration XML", xml_bytes, "estimated");
+  detail = g_strdup_printf ("%d elements, %d queues and the audio output's "
+                            "ring buffer", element_count, queue_count);
+  memory_print ("pipeline buffers", pipeline_bytes, detail);
+  g_free (detail);
+  if (resident_bytes > 0)
+    {
+      accounted_bytes = sample_bytes + cache_bytes + xml_bytes
+        + pipeline_bytes;
+      memory_print ("other", (resident_bytes > accounted_bytes) ?
+                    (resident_bytes - accounted_bytes) : 0,
+                    "code, libraries and everything else");
+      memory_print ("resident", resident_bytes, NULL);
+    }
+
+  /* One sound holding most of the memory is worth a closer look: it
+   * may be longer than it needs to be, or kept at a higher resolution
+   * than it needs.  */
+  if ((sounds->len > 1) && (sample_bytes > 0))
+    {
+      largest = &g_array_index (sounds, struct memory_sound, 0);
+      if (largest->bytes > MEMORY_DOMINANT_FRACTION * sample_bytes)
+        {
+          label = g_format_size (largest->bytes);
+          g_print ("Warning: sound %s holds %s, %.0f%% of the sample "
+                   "memory.\n", largest->sound_data->name, label,
+                   100.0 * largest->bytes / sample_bytes);
+          g_free (label);
+        }
+    }
+
+  g_hash_table_destroy (seen);
+  g_hash_table_destroy (files_by_name);
+  g_ptr_array_free (files, TRUE);
+  g_array_free (sounds, TRUE);
+  return;
+}
+
+/* End of file memory_subroutines.c */
@@ -29,7 +29,11 @@
 #include "display_subroutines.h"
 #include "sound_subroutines.h"
 #include "gstreamer_subroutines.h"
+#include "realtime_subroutines.h"
+#include "record_subroutines.h"
 #include "sound_effects_player.h"
+#include "telemetry_subroutines.h"
+#include "warmup_subroutines.h"
 
 /* When debugging, it is sometimes useful to have printouts of the
  * messages as they happen. */
@@ -59,6 +63,11 @@ message_handler (GstBus *bus_element, GstMessage *message,
       {
         const GstStructure *s = gst_message_get_structure (message);
 
+        /* A sound being warmed up is not playing, as far as the
+         * operator and the sequencer are concerned.  */
+        if (warmup_claim_message (message, s, G_APPLICATION (user_data)))
+          break;
+
         if (gst_structure_has_name (s, (gchar *) "level"))
           {
             /* The level message shows the sound level on each channel.  */
@@ -110,6 +119,8 @@ message_handler (GstBus *bus_element, GstMessage *message,
 		  }
                 display_update_vu_meter (user_data, i, rms, peak_dB,
                                          decay_dB);
+                telemetry_update_level (i, rms_dB, peak_dB,
+                                        G_APPLICATION (user_data));
               }
             break;
           }
@@ -136,11 +147,20 @@ message_handler (GstBus *bus_element, GstMessage *message,
           {
             /* The completed message means a sound has finished.  */
             const gchar *sound_name;
+            struct voice_info *voice_data;
 
             /* The structure in the message contains the name of the sound.  
              */
             sound_name = gst_structure_get_string (s, (gchar *) "sound_name");
-            sound_completed (sound_name, G_APPLICATION (user_data));
+            record_event ("completed", sound_name, G_APPLICATION (user_data));
+
+            /* If the sound has several voices, see which one finished.  */
+            voice_data = sound_get_voice_from_element
+              (GST_ELEMENT (GST_MESSAGE_SRC (message)));
+            if (voice_data != NULL)
+              sound_voice_completed (voice_data, G_APPLICATION (user_data));
+            else
+              sound_completed (sound_name, G_APPLICATION (user_data));
           }
 
         if (gst_structure_has_name (s, (gchar *) "release_started"))
@@ -148,11 +168,36 @@ message_handler (GstBus *bus_element, GstMessage *message,
             /* The release_started message means a sound has entered the 
              * release portion of its envelope.  */
             const gchar *sound_name;
+            struct voice_info *voice_data;
 
             /* The structure in the message contains the name of the sound.  
              */
             sound_name = gst_structure_get_string (s, (gchar *) "sound_name");
-            sound_release_started (sound_name, G_APPLICATION (user_data));
+            record_event ("release", sound_name, G_APPLICATION (user_data));
+            voice_data = sound_get_voice_from_element
+              (GST_ELEMENT (GST_MESSAGE_SRC (message)));
+            if (voice_data != NULL)
+              sound_voice_release_started (voice_data,
+                                           G_APPLICATION (user_data));
+            else
+              sound_release_started (sound_name, G_APPLICATION (user_data));
+          }
+
+        if (gst_structure_has_name (s, (gchar *) "progress"))
+          {
+            /* A looper is telling us how far its sound has got.  */
+            guint64 elapsed_time, remaining_time;
+
+            if (gst_structure_get_uint64 (s, (gchar *) "elapsed-time",
+                                          &elapsed_time)
+                && gst_structure_get_uint64 (s, (gchar *) "remaining-time",
+                                             &remaining_time))
+              {
+                sound_progress (GST_ELEMENT (GST_MESSAGE_SRC (message)),
+                                elapsed_time, remaining_time,
+                                G_APPLICATION (user_data));
+              }
+            break;
           }
 
         /* Catchall for unrecognized messages */
@@ -269,6 +314,14 @@ message_handler (GstBus *bus_element, GstMessage *message,
         break;
       }
 
+    case GST_MESSAGE_QOS:
+      {
+        /* An element was given data too late, and dropped some of it.
+         * From the audio output, that is a dropout we can hear.  */
+        realtime_note_qos (message, G_APPLICATION (user_data));
+        break;
+      }
+
     case GST_MESSAGE_ASYNC_DONE:
       {
         if (TRACE_MESSAGES)
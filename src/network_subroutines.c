@@ -17,59 +17,251 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
 #include <gtk/gtk.h>
 #include <gio/gio.h>
 #include "sound_effects_player.h"
 #include "parse_net_subroutines.h"
 #include "network_subroutines.h"
 
+#define TRACE_NETWORK FALSE
+
+/* The space for the ancillary data which carries the kernel's receive
+ * time stamp.  */
+#define network_control_size \
+  CMSG_SPACE (sizeof (struct timespec))
+
+/* A datagram waiting for the sequencer.  */
+struct network_datagram
+{
+  gint64 receive_time;
+  guint length;
+  gchar text[network_buffer_size];
+};
+
 /* The persistent data used by the network subroutines. */
 
 struct network_info
 {
-  gchar *network_buffer;
+  gchar *network_buffer;        /* network_batch_count datagrams */
+  gchar *control_buffer;        /* the ancillary data for each datagram */
+  struct mmsghdr *message_headers;
+  struct iovec *message_iovecs;
+  gint64 receive_time;          /* when the current datagram arrived,
+                                 * or zero if none is being parsed */
   gint port_number;
   gboolean bound;
   GSource *source_IPv4, *source_IPv6;
   GSocket *socket_IPv4, *socket_IPv6;
+  GApplication *app;
+
+  /* The sockets are serviced by their own thread, which runs
+   * its own main loop.  */
+  GMainContext *context;
+  GMainLoop *loop;
+  GThread *thread;
+
+  /* Received datagrams are passed from the network thread to the 
+   * main thread through this queue.  Only the network thread advances
+   * the head and only the main thread advances the tail, so no lock
+   * is needed.  */
+  struct network_datagram *queue;
+  gint queue_head;
+  gint queue_tail;
+  gint overflow_count;          /* datagrams lost because the queue 
+                                 * was full */
+  gint overflow_reported;
+  gint truncated_count;         /* datagrams dropped because they were
+                                 * too long for the buffer */
+  gint truncated_reported;
+  gint dispatch_pending;        /* non-zero if the main thread has been
+                                 * asked to empty the queue */
 };
 
 /* Subroutines to handle network messages */
 
-/* Receive incoming data. This is called from the main loop whenever
- * there is data or a disconnect on a port. */
+/* Extract the time the kernel received a datagram, in nanoseconds
+ * since the Unix epoch.  If the kernel did not supply a time stamp,
+ * use the current time.  */
+static gint64
+message_receive_time (struct msghdr *message_header)
+{
+  struct cmsghdr *control_message;
+  struct timespec kernel_time;
+
+  for (control_message = CMSG_FIRSTHDR (message_header);
+       control_message != NULL;
+       control_message = CMSG_NXTHDR (message_header, control_message))
+    {
+      if ((control_message->cmsg_level == SOL_SOCKET)
+          && (control_message->cmsg_type == SCM_TIMESTAMPNS))
+        {
+          memcpy (&kernel_time, CMSG_DATA (control_message),
+                  sizeof (kernel_time));
+          return (((gint64) kernel_time.tv_sec * G_GINT64_CONSTANT (1000000000))
+                  + kernel_time.tv_nsec);
+        }
+    }
+
+  return (g_get_real_time () * 1000);
+}
+
+/* Run the datagrams in the queue through the parser.  This runs in
+ * the main thread, at high priority so that cues are not delayed
+ * behind display updates.  */
+static gboolean
+dispatch_datagrams (gpointer user_data)
+{
+  struct network_info *network_data = user_data;
+  struct network_datagram *datagram;
+  gint head, tail;
+  gint overflow_count, truncated_count;
+
+  /* Clear the flag before looking at the queue, so that a datagram
+   * which arrives while we are working asks for another pass.  */
+  g_atomic_int_set (&network_data->dispatch_pending, 0);
+
+  tail = network_data->queue_tail;
+  head = g_atomic_int_get (&network_data->queue_head);
+  while (tail != head)
+    {
+      datagram = &network_data->queue[tail & (network_queue_size - 1)];
+      network_data->receive_time = datagram->receive_time;
+
+      /* Parse the received datagram.  */
+      parse_net_text (datagram->length, &datagram->text[0],
+                      network_data->app);
+
+      if (TRACE_NETWORK)
+        {
+          g_print ("datagram length %d, latency %" G_GINT64_FORMAT
+                   " ns.\n", datagram->length,
+                   (g_get_real_time () * 1000) - datagram->receive_time);
+        }
+
+      /* The parser may look at the receive time only while it is 
+       * parsing a datagram from the network.  */
+      network_data->receive_time = 0;
+
+      /* Let the network thread re-use the queue entry.  */
+      tail = tail + 1;
+      g_atomic_int_set (&network_data->queue_tail, tail);
+    }
+
+  overflow_count = g_atomic_int_get (&network_data->overflow_count);
+  if (overflow_count != network_data->overflow_reported)
+    {
+      g_print ("%d network messages lost because the queue was full.\n",
+               overflow_count - network_data->overflow_reported);
+      network_data->overflow_reported = overflow_count;
+    }
+
+  truncated_count = g_atomic_int_get (&network_data->truncated_count);
+  if (truncated_count != network_data->truncated_reported)
+    {
+      g_print ("%d network messages ignored because they were longer "
+               "than %d bytes.\n",
+               truncated_count - network_data->truncated_reported,
+               network_buffer_size - 1);
+      network_data->truncated_reported = truncated_count;
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Receive incoming data.  This is called from the network thread's main
+ * loop whenever there is data or a disconnect on a port.  Receive all of
+ * the datagrams that are waiting, not just the first, so a burst of 
+ * commands from a console is handled in one wakeup, and queue them for 
+ * the main thread.  */
 static gboolean
 receive_data_callback (GSocket *socket, GIOCondition condition,
                        gpointer user_data)
 {
-  struct network_info *network_data;
-  gchar *network_buffer;
-  GError *error = NULL;
-  gssize nread;
-
-  /* Find the network buffer */
-  network_data = sep_get_network_data ((GApplication *) user_data);
-  network_buffer = network_data->network_buffer;
+  struct network_info *network_data = user_data;
+  struct msghdr *message_header;
+  struct network_datagram *datagram;
+  gint message_count;
+  gint fd;
+  gint i;
+  gint head, tail;
+  guint nread;
 
   /* If we have data, process it. */
   if ((condition & G_IO_IN) != 0)
     {
-      nread =
-        g_socket_receive (socket, network_buffer, network_buffer_size, NULL,
-                          &error);
-
-      if (error != NULL)
+      fd = g_socket_get_fd (socket);
+      do
         {
-          printf ("Error in network socket receive: %s.\n", error->message);
-          g_error_free (error);
-          return G_SOURCE_REMOVE;
+          /* The kernel overwrites the ancillary data lengths, 
+           * so reset them before each receive.  */
+          for (i = 0; i < network_batch_count; i++)
+            {
+              message_header = &network_data->message_headers[i].msg_hdr;
+              message_header->msg_controllen = network_control_size;
+              message_header->msg_flags = 0;
+            }
+
+          message_count =
+            recvmmsg (fd, network_data->message_headers, network_batch_count,
+                      MSG_DONTWAIT, NULL);
+          if (message_count < 0)
+            {
+              if ((errno == EAGAIN) || (errno == EWOULDBLOCK)
+                  || (errno == EINTR))
+                break;
+              printf ("Error in network socket receive: %s.\n",
+                      g_strerror (errno));
+              return G_SOURCE_REMOVE;
+            }
+
+          for (i = 0; i < message_count; i++)
+            {
+              nread = network_data->message_headers[i].msg_len;
+              if (nread == 0)
+                continue;
+
+              /* A datagram too long for the buffer has lost its end,
+               * so do not try to parse it.  */
+              message_header = &network_data->message_headers[i].msg_hdr;
+              if ((message_header->msg_flags & MSG_TRUNC) != 0)
+                {
+                  g_atomic_int_inc (&network_data->truncated_count);
+                  continue;
+                }
+
+              /* Copy the datagram onto the queue.  If the queue is full,
+               * count the datagram as lost.  */
+              head = network_data->queue_head;
+              tail = g_atomic_int_get (&network_data->queue_tail);
+              if (head - tail >= network_queue_size)
+                {
+                  g_atomic_int_inc (&network_data->overflow_count);
+                  continue;
+                }
+              datagram = &network_data->queue[head & (network_queue_size - 1)];
+              datagram->receive_time = message_receive_time (message_header);
+              datagram->length = nread;
+              memcpy (&datagram->text[0],
+                      network_data->network_buffer +
+                      (i * network_buffer_size), nread);
+              g_atomic_int_set (&network_data->queue_head, head + 1);
+            }
         }
-      if (nread != 0)
+      while (message_count == network_batch_count);
+
+      /* Ask the main thread to empty the queue, unless it has already
+       * been asked.  */
+      if (g_atomic_int_compare_and_exchange
+          (&network_data->dispatch_pending, 0, 1))
         {
-          /* Parse the received datagram.  */
-          parse_net_text (nread, network_buffer, user_data);
+          g_idle_add_full (G_PRIORITY_HIGH, dispatch_datagrams, network_data,
+                           NULL);
         }
-
     }
 
   /* If we have received the hangup condition, stop listening for data. */
@@ -80,6 +272,32 @@ receive_data_callback (GSocket *socket, GIOCondition condition,
   return G_SOURCE_CONTINUE;
 }
 
+/* The network thread.  Service the sockets until told to stop.  */
+static gpointer
+network_thread (gpointer user_data)
+{
+  struct network_info *network_data = user_data;
+
+  g_main_context_push_thread_default (network_data->context);
+  g_main_loop_run (network_data->loop);
+  g_main_context_pop_thread_default (network_data->context);
+
+  return (NULL);
+}
+
+/* Stop the network thread's main loop.  This runs from an idle source
+ * attached to the network thread's context, so it is dispatched by that
+ * thread's loop even if the loop had not yet started when the source
+ * was attached.  */
+static gboolean
+network_quit_loop (gpointer user_data)
+{
+  struct network_info *network_data = user_data;
+
+  g_main_loop_quit (network_data->loop);
+  return G_SOURCE_REMOVE;
+}
+
 /* Initialize the network subroutines.  The return value is the 
  * persistent data.  */
 void *
@@ -87,14 +305,65 @@ network_init (GApplication *app)
 {
   gchar *network_buffer;
   struct network_info *network_data;
+  struct msghdr *message_header;
+  gint i;
 
   /* Allocate the persistent information. */
   network_data = g_malloc (sizeof (struct network_info));
 
-  /* Allocate the network buffer. */
-  network_buffer = g_malloc0 (network_buffer_size);
+  /* Allocate the network buffer, which has room for a batch
+   * of datagrams.  */
+  network_buffer = g_malloc0 (network_batch_count * network_buffer_size);
   network_data->network_buffer = network_buffer;
 
+  /* Set up the message headers used to receive a batch of datagrams.
+   * Each datagram gets its own part of the network buffer.  Leave room
+   * after each datagram so the parser can terminate it with a NUL.  */
+  network_data->control_buffer =
+    g_malloc0 (network_batch_count * network_control_size);
+  network_data->message_headers =
+    g_malloc0 (network_batch_count * sizeof (struct mmsghdr));
+  network_data->message_iovecs =
+    g_malloc0 (network_batch_count * sizeof (struct iovec));
+  for (i = 0; i < network_batch_count; i++)
+    {
+      network_data->message_iovecs[i].iov_base =
+        network_buffer + (i * network_buffer_size);
+      network_data->message_iovecs[i].iov_len = network_buffer_size - 1;
+      message_header = &network_data->message_headers[i].msg_hdr;
+      message_header->msg_name = NULL;
+      message_header->msg_namelen = 0;
+      message_header->msg_iov = &network_data->message_iovecs[i];
+      message_header->msg_iovlen = 1;
+      message_header->msg_control =
+        network_data->control_buffer + (i * network_control_size);
+      message_header->msg_controllen = network_control_size;
+    }
+  network_data->receive_time = 0;
+
+  /* Set up the queue that carries datagrams to the main thread.  */
+  network_data->queue =
+    g_malloc (network_queue_size * sizeof (struct network_datagram));
+  network_data->queue_head = 0;
+  network_data->queue_tail = 0;
+  network_data->overflow_count = 0;
+  network_data->overflow_reported = 0;
+  network_data->truncated_count = 0;
+  network_data->truncated_reported = 0;
+  network_data->dispatch_pending = 0;
+
+  /* The sockets will be serviced by a separate thread, with its own
+   * main loop, so that network commands do not wait behind display
+   * updates and Gstreamer messages.  */
+  network_data->app = app;
+  network_data->context = g_main_context_new ();
+  network_data->loop = g_main_loop_new (network_data->context, FALSE);
+  network_data->thread = NULL;
+  network_data->source_IPv4 = NULL;
+  network_data->source_IPv6 = NULL;
+  network_data->socket_IPv4 = NULL;
+  network_data->socket_IPv6 = NULL;
+
   /* Set the default port. */
   network_data->port_number = 1500;
 
@@ -140,19 +409,34 @@ network_bind_port (GApplication *app)
       g_error_free (error);
       return;
     }
+
+  /* Ask the kernel to record the time each datagram arrives.  */
+  if (!g_socket_set_option (socket_IPv6, SOL_SOCKET, SO_TIMESTAMPNS, 1,
+                            &error))
+    {
+      printf ("Cannot request network time stamps: %s.\n", error->message);
+      g_error_free (error);
+      error = NULL;
+    }
   source_IPv6 =
     g_socket_create_source (socket_IPv6, G_IO_IN | G_IO_HUP, NULL);
   g_source_set_callback (source_IPv6, (GSourceFunc) receive_data_callback,
-                         app, NULL);
-  g_source_attach (source_IPv6, NULL);
+                         network_data, NULL);
+  g_source_attach (source_IPv6, network_data->context);
   network_data->source_IPv6 = source_IPv6;
   network_data->socket_IPv6 = socket_IPv6;
 
+  /* Start serving the IPv6 socket now, so that it is served even if
+   * we cannot listen on IPv4.  A source attached later is picked up
+   * by the running loop.  */
+  network_data->bound = TRUE;
+  network_data->thread =
+    g_thread_new ("network", network_thread, network_data);
+
   if (g_socket_speaks_ipv4 (socket_IPv6))
     {
       network_data->source_IPv4 = NULL;
       network_data->socket_IPv4 = NULL;
-      network_data->bound = TRUE;
       return;
     }
 
@@ -178,14 +462,20 @@ network_bind_port (GApplication *app)
       g_error_free (error);
       return;
     }
+  if (!g_socket_set_option (socket_IPv4, SOL_SOCKET, SO_TIMESTAMPNS, 1,
+                            &error))
+    {
+      printf ("Cannot request network time stamps: %s.\n", error->message);
+      g_error_free (error);
+      error = NULL;
+    }
   source_IPv4 =
     g_socket_create_source (socket_IPv4, G_IO_IN | G_IO_HUP, NULL);
   g_source_set_callback (source_IPv4, (GSourceFunc) receive_data_callback,
-                         app, NULL);
-  g_source_attach (source_IPv4, NULL);
+                         network_data, NULL);
   network_data->source_IPv4 = source_IPv4;
   network_data->socket_IPv4 = socket_IPv4;
-  network_data->bound = TRUE;
+  g_source_attach (source_IPv4, network_data->context);
 
   return;
 }
@@ -207,10 +497,27 @@ void
 network_unbind_port (GApplication *app)
 {
   GError *error = NULL;
+  GSource *quit_source;
   struct network_info *network_data;
 
   network_data = sep_get_network_data (app);
 
+  /* Stop the network thread before closing its sockets.  Do not use
+   * g_main_context_invoke: if the network thread has not yet acquired
+   * its context, the quit would run here, before the loop is running,
+   * and be lost.  An idle source waits for the loop.  */
+  if (network_data->thread != NULL)
+    {
+      quit_source = g_idle_source_new ();
+      g_source_set_priority (quit_source, G_PRIORITY_HIGH);
+      g_source_set_callback (quit_source, network_quit_loop, network_data,
+                             NULL);
+      g_source_attach (quit_source, network_data->context);
+      g_source_unref (quit_source);
+      g_thread_join (network_data->thread);
+      network_data->thread = NULL;
+    }
+
   /* Stop network processing.  */
   if (network_data->source_IPv4 != NULL)
     {
@@ -261,4 +568,32 @@ network_get_port (GApplication *app)
   return (port_number);
 }
 
+/* Find the time the datagram currently being parsed arrived, according
+ * to the kernel, in nanoseconds since the Unix epoch.  The value is zero
+ * if the text being parsed did not come from the network, for example
+ * if it is being replayed.  */
+gint64
+network_get_receive_time (GApplication *app)
+{
+  struct network_info *network_data;
+  gint64 receive_time;
+
+  network_data = sep_get_network_data (app);
+  receive_time = network_data->receive_time;
+  return (receive_time);
+}
+
+/* Find the number of datagrams lost because the sequencer did not
+ * keep up with the network.  */
+gint
+network_get_overflow_count (GApplication *app)
+{
+  struct network_info *network_data;
+  gint overflow_count;
+
+  network_data = sep_get_network_data (app);
+  overflow_count = g_atomic_int_get (&network_data->overflow_count);
+  return (overflow_count);
+}
+
 /* End of file network_subroutines.c  */
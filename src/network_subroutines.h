@@ -22,6 +22,13 @@
 
 #define network_buffer_size 8000
 
+/* The number of datagrams received with one system call.  */
+#define network_batch_count 16
+
+/* The number of datagrams that can wait for the sequencer.  
+ * This must be a power of two.  */
+#define network_queue_size 64
+
 /* Subroutines defined in network_subroutines.c */
 
 /* Initialize. */
@@ -39,4 +46,11 @@ void network_unbind_port (GApplication *app);
 /* Get the port number. */
 gint network_get_port (GApplication *app);
 
+/* Get the time the current datagram arrived, or zero if the text
+ * being parsed did not come from the network.  */
+gint64 network_get_receive_time (GApplication *app);
+
+/* Get the number of datagrams lost because the queue was full.  */
+gint network_get_overflow_count (GApplication *app);
+
 /* End of file network_subroutines.h  */
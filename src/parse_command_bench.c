@@ -0,0 +1,90 @@
+/*
+ * parse_command_bench.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measure how many text commands per second the network command parser
+ * can split and interpret.  This program does not need the user interface
+ * or Gstreamer.  Build it with "make parse_command_bench" and run it with
+ * an optional count of passes over the sample commands.  */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "parse_command_subroutines.h"
+
+/* Commands typical of what an external sequencer sends.  */
+static const gchar *sample_commands[] = {
+  "start 3\n",
+  "stop 3\n",
+  "go 12.5\n",
+  "start 0x0f",
+  "go  intermission music  \r\n",
+  "quit",
+  "bogus 7\n",
+  "stop"
+};
+
+int
+main (int argc, char *argv[])
+{
+  struct parse_command_info command;
+  glong passes, pass;
+  glong number;
+  guint i;
+  guint lengths[G_N_ELEMENTS (sample_commands)];
+  gint64 start_time, end_time;
+  gdouble elapsed_seconds;
+  glong command_count;
+  glong checksum;
+
+  passes = 1000000;
+  if (argc > 1)
+    passes = strtol (argv[1], NULL, 0);
+
+  for (i = 0; i < G_N_ELEMENTS (sample_commands); i++)
+    lengths[i] = strlen (sample_commands[i]);
+
+  /* The checksum keeps the compiler from discarding the work.  */
+  checksum = 0;
+  start_time = g_get_monotonic_time ();
+  for (pass = 0; pass < passes; pass++)
+    {
+      for (i = 0; i < G_N_ELEMENTS (sample_commands); i++)
+        {
+          parse_command_tokenize (sample_commands[i], lengths[i], &command);
+          checksum = checksum + command.code + command.argument_length;
+          if (((command.code == parse_command_start)
+               || (command.code == parse_command_stop))
+              && parse_command_argument_number (&command, &number))
+            checksum = checksum + number;
+        }
+    }
+  end_time = g_get_monotonic_time ();
+
+  command_count = passes * G_N_ELEMENTS (sample_commands);
+  elapsed_seconds = (gdouble) (end_time - start_time) / 1e6;
+  if (elapsed_seconds <= 0.0)
+    elapsed_seconds = 1e-6;
+  g_print ("%ld commands in %.3f seconds: %.0f commands per second "
+           "(checksum %ld).\n", command_count, elapsed_seconds,
+           (gdouble) command_count / elapsed_seconds, checksum);
+
+  return (0);
+}
+
+/* End of file parse_command_bench.c */
@@ -0,0 +1,108 @@
+/*
+ * parse_command_fuzz.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A fuzzing target for the network text command parser.  It does not
+ * need the user interface or Gstreamer.
+ *
+ * For libFuzzer, build with clang and define PARSE_COMMAND_LIBFUZZER:
+ *   make parse_command_fuzz CC=clang \
+ *     CFLAGS="-g -fsanitize=fuzzer,address -DPARSE_COMMAND_LIBFUZZER"
+ * For AFL, build with afl-cc and run under afl-fuzz; without 
+ * PARSE_COMMAND_LIBFUZZER the program reads one input from each file 
+ * named on the command line, or from standard input if there are none.  */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <glib.h>
+#include "parse_command_subroutines.h"
+
+/* The largest input we pass to the parser, the same as the largest
+ * datagram the network subroutines accept.  */
+#define FUZZ_INPUT_SIZE 8000
+
+int LLVMFuzzerTestOneInput (const uint8_t * data, size_t size);
+
+/* Parse one input and check that the results stay within it.  */
+int
+LLVMFuzzerTestOneInput (const uint8_t * data, size_t size)
+{
+  struct parse_command_info command;
+  const gchar *text;
+  guint length;
+  glong number;
+
+  if (size > FUZZ_INPUT_SIZE)
+    size = FUZZ_INPUT_SIZE;
+  text = (const gchar *) data;
+  length = size;
+
+  parse_command_tokenize (text, length, &command);
+  g_assert (command.keyword == text);
+  g_assert (command.keyword_length <= length);
+  g_assert (command.argument >= text);
+  g_assert (command.argument + command.argument_length <= text + length);
+  g_assert ((command.code == parse_command_unknown)
+            || (command.keyword_length > 0));
+  parse_command_argument_number (&command, &number);
+
+  return (0);
+}
+
+#ifndef PARSE_COMMAND_LIBFUZZER
+/* Feed the parser one input from a file.  */
+static void
+fuzz_file (FILE * input_file)
+{
+  static uint8_t buffer[FUZZ_INPUT_SIZE];
+  size_t size;
+
+  size = fread (buffer, 1, sizeof (buffer), input_file);
+  LLVMFuzzerTestOneInput (buffer, size);
+  return;
+}
+
+int
+main (int argc, char *argv[])
+{
+  FILE *input_file;
+  int i;
+
+  if (argc < 2)
+    {
+      fuzz_file (stdin);
+      return (0);
+    }
+
+  for (i = 1; i < argc; i++)
+    {
+      input_file = fopen (argv[i], "rb");
+      if (input_file == NULL)
+        {
+          perror (argv[i]);
+          return (1);
+        }
+      fuzz_file (input_file);
+      fclose (input_file);
+    }
+  return (0);
+}
+#endif
+
+/* End of file parse_command_fuzz.c */
@@ -0,0 +1,189 @@
+/*
+ * parse_command_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include "parse_command_subroutines.h"
+
+/* The keyword table.  Each keyword is placed at the position given by
+ * PARSE_COMMAND_HASH, which has been chosen so that no two keywords land
+ * in the same place.  Finding a keyword therefore takes one calculation
+ * and one comparison.  If you add a keyword, make sure it does not
+ * collide with the others, enlarging the table if necessary.  The hash
+ * uses the last character of the keyword, since "start" and "reload"
+ * have the same first character plus length, and twice the length,
+ * since "start" and "status" have the same last character plus
+ * length.  */
+#define PARSE_COMMAND_TABLE_SIZE 16
+#define PARSE_COMMAND_HASH(last_char, length) \
+  ((((guint) (guchar) (last_char)) + (2 * (length))) \
+   & (PARSE_COMMAND_TABLE_SIZE - 1))
+
+struct parse_command_keyword
+{
+  const gchar *name;
+  guint length;
+  enum parse_command_code code;
+};
+
+static const struct parse_command_keyword
+  keyword_table[PARSE_COMMAND_TABLE_SIZE] = {
+  [0] = {"reload", 6, parse_command_reload},    /* 'd' + 12 = 112 */
+  [3] = {"go", 2, parse_command_go},    /* 'o' + 4 = 115 */
+  [8] = {"stop", 4, parse_command_stop},        /* 'p' + 8 = 120 */
+  [12] = {"quit", 4, parse_command_quit},       /* 't' + 8 = 124 */
+  [14] = {"start", 5, parse_command_start},     /* 't' + 10 = 126 */
+  [15] = {"status", 6, parse_command_status}    /* 's' + 12 = 127 */
+};
+
+/* Split a text command into its keyword and argument, and identify
+ * the keyword.  */
+void
+parse_command_tokenize (const gchar * text, guint length,
+                        struct parse_command_info *command)
+{
+  const struct parse_command_keyword *keyword;
+  guint keyword_length;
+  guint argument_start, argument_end;
+
+  /* Isolate the keyword that starts the command.  The keyword is
+   * terminated by white space or the end of the text.  */
+  for (keyword_length = 0; keyword_length < length; keyword_length++)
+    if (g_ascii_isspace (text[keyword_length]) || (text[keyword_length] == '\0'))
+      break;
+  command->keyword = text;
+  command->keyword_length = keyword_length;
+
+  /* Whatever follows the keyword, less surrounding white space, 
+   * is the argument.  A NUL ends the text early.  */
+  argument_end = keyword_length;
+  while ((argument_end < length) && (text[argument_end] != '\0'))
+    argument_end++;
+  argument_start = keyword_length;
+  while ((argument_start < argument_end)
+         && g_ascii_isspace (text[argument_start]))
+    argument_start++;
+  while ((argument_end > argument_start)
+         && g_ascii_isspace (text[argument_end - 1]))
+    argument_end--;
+  command->argument = text + argument_start;
+  command->argument_length = argument_end - argument_start;
+
+  /* Look up the keyword.  */
+  command->code = parse_command_unknown;
+  if (keyword_length > 0)
+    {
+      keyword =
+        &keyword_table[PARSE_COMMAND_HASH (text[keyword_length - 1],
+                                           keyword_length)];
+      if ((keyword->name != NULL) && (keyword->length == keyword_length)
+          && (memcmp (keyword->name, text, keyword_length) == 0))
+        command->code = keyword->code;
+    }
+
+  return;
+}
+
+/* Find the value of a digit in the specified base, or -1 if the
+ * character is not a digit in that base.  */
+static gint
+digit_value (gchar digit, gint base)
+{
+  gint value;
+
+  if (g_ascii_isdigit (digit))
+    value = digit - '0';
+  else if (g_ascii_isxdigit (digit))
+    value = g_ascii_xdigit_value (digit);
+  else
+    return (-1);
+
+  if (value >= base)
+    return (-1);
+  return (value);
+}
+
+/* Interpret the argument as a number.  Like strtol with base 0, a leading
+ * 0x means hexadecimal and a leading 0 means octal.  Trailing text after
+ * the number is ignored.  The number saturates rather than overflowing.  */
+gboolean
+parse_command_argument_number (struct parse_command_info *command,
+                               glong * value)
+{
+  const gchar *text;
+  guint length;
+  guint position;
+  gboolean negative;
+  gint base;
+  gint digit;
+  gulong result;
+  gboolean digit_seen;
+
+  text = command->argument;
+  length = command->argument_length;
+  position = 0;
+
+  negative = FALSE;
+  if ((position < length) && ((text[position] == '-')
+                              || (text[position] == '+')))
+    {
+      negative = (text[position] == '-');
+      position = position + 1;
+    }
+
+  base = 10;
+  digit_seen = FALSE;
+  if ((position < length) && (text[position] == '0'))
+    {
+      base = 8;
+      digit_seen = TRUE;
+      position = position + 1;
+      if ((position + 1 < length)
+          && ((text[position] == 'x') || (text[position] == 'X'))
+          && (digit_value (text[position + 1], 16) >= 0))
+        {
+          base = 16;
+          position = position + 1;
+        }
+    }
+
+  result = 0;
+  for (; position < length; position++)
+    {
+      digit = digit_value (text[position], base);
+      if (digit < 0)
+        break;
+      digit_seen = TRUE;
+      if (result > ((gulong) G_MAXLONG - digit) / base)
+        result = G_MAXLONG;
+      else
+        result = (result * base) + digit;
+    }
+
+  if (!digit_seen)
+    return (FALSE);
+
+  if (negative)
+    *value = -(glong) result;
+  else
+    *value = (glong) result;
+  return (TRUE);
+}
+
+/* End of file parse_command_subroutines.c */
@@ -0,0 +1,61 @@
+/*
+ * parse_command_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+/* Subroutines defined in parse_command_subroutines.c.  These split a
+ * text command received from the network into its parts.  They do not
+ * depend on the rest of the application, so they can be exercised
+ * by themselves.  */
+
+/* The text commands.  */
+enum parse_command_code
+{
+  parse_command_unknown = 0,
+  parse_command_start,
+  parse_command_stop,
+  parse_command_quit,
+  parse_command_go,
+  parse_command_reload,
+  parse_command_status
+};
+
+/* A text command, split into its parts.  The keyword and the argument
+ * point into the original text, which is not modified and need not be
+ * terminated by a NUL.  The argument is everything after the keyword,
+ * with leading and trailing white space removed.  */
+struct parse_command_info
+{
+  enum parse_command_code code;
+  const gchar *keyword;
+  guint keyword_length;
+  const gchar *argument;
+  guint argument_length;
+};
+
+/* Split a text command into its parts.  */
+void parse_command_tokenize (const gchar *text, guint length,
+                             struct parse_command_info *command);
+
+/* Interpret the argument of a command as a number, in the manner of
+ * strtol with base 0.  Returns FALSE if the argument is not a number.  */
+gboolean parse_command_argument_number (struct parse_command_info *command,
+                                        glong *value);
+
+/* End of file parse_command_subroutines.h  */
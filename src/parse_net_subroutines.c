@@ -20,6 +20,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include "parse_net_subroutines.h"
+#include "memory_subroutines.h"
+#include "network_subroutines.h"
+#include "parse_command_subroutines.h"
+#include "record_subroutines.h"
 #include "sound_effects_player.h"
 #include "sound_subroutines.h"
 #include "sequence_subroutines.h"
@@ -35,223 +39,702 @@
 
 struct parse_net_info
 {
-  GHashTable *hash_table;
   gchar *message_buffer;
+  GList *scheduled_bundles;     /* OSC bundles waiting for their time */
 };
 
-/* The keyword hash table. */
-enum keyword_codes
-{ keyword_start = 1, keyword_stop, keyword_quit, keyword_go };
+/* The longest operand of a Go command.  */
+#define PARSE_NET_MAX_Q_NUMBER 128
 
-static enum keyword_codes keyword_values[] =
-{ keyword_start, keyword_stop, keyword_quit, keyword_go };
+/* The most arguments we decode from an OSC message.  */
+#define OSC_MAX_ARGUMENTS 16
 
-struct keyword_value_pairs
+/* How deeply OSC bundles may be nested.  */
+#define OSC_MAX_DEPTH 8
+
+/* The OSC time tag that means "execute immediately".  */
+#define OSC_TIME_TAG_IMMEDIATE G_GUINT64_CONSTANT (1)
+
+/* How late, in nanoseconds, a bundle may be executed before we say so.  */
+#define OSC_LATE_REPORT G_GINT64_CONSTANT (10000000)
+
+/* The number of seconds from the NTP epoch, 1900, to the Unix epoch, 1970.
+ */
+#define OSC_NTP_TO_UNIX_SECONDS G_GINT64_CONSTANT (2208988800)
+
+/* An argument of an OSC message.  Strings and blobs point into the
+ * datagram.  */
+struct osc_argument
 {
-  gpointer key;
-  gpointer val;
+  gchar type;
+  union
+  {
+    gint32 i;
+    gint64 h;
+    gfloat f;
+    gdouble d;
+    const gchar *s;
+    struct
+    {
+      const guchar *data;
+      guint32 length;
+    } b;
+  } value;
 };
 
-static struct keyword_value_pairs keywords_with_values[] = {
-  {"start", &keyword_values[0]},
-  {"stop", &keyword_values[1]},
-  {"quit", &keyword_values[2]},
-  {"go", &keyword_values[3]}
+/* An OSC bundle waiting for its time tag.  It is freed when the last
+ * reference to its clock ID goes away.  */
+struct osc_scheduled_bundle
+{
+  GApplication *app;
+  GstClockID clock_id;
+  gboolean cancelled;           /* set if it is not to be executed */
+  guint length;
+  guchar packet[];
 };
 
+static void parse_osc_packet (const guchar * packet, guint length,
+                              guint depth, GApplication *app);
+
 /* Initialize the network messages parser */
 
 void *
 parse_net_init (GApplication *app)
 {
   struct parse_net_info *parse_net_data;
-  int i;
 
   /* Allocate the persistent data used by the parser. */
   parse_net_data = g_malloc (sizeof (struct parse_net_info));
 
-  /* Allocate the hash table which holds the keywords. */
-  parse_net_data->hash_table = g_hash_table_new (g_str_hash, g_str_equal);
+  /* The message buffer starts out empty. */
+  parse_net_data->message_buffer = NULL;
+
+  /* No OSC bundles are waiting.  */
+  parse_net_data->scheduled_bundles = NULL;
+
+  return parse_net_data;
+}
+
+/* Subroutines for decoding Open Sound Control (OSC) version 1.0 packets.
+ * A packet is either a message or a bundle.  A message is an address
+ * pattern, a type tag string and the arguments.  A bundle is the string
+ * "#bundle", a time tag, and a sequence of elements, each of which is
+ * a message or a bundle preceded by its size.  All numbers are big-endian
+ * and everything is padded to a multiple of four bytes.  The packet is
+ * decoded in place; nothing is allocated unless a bundle must be held 
+ * for later execution.  */
+
+/* Read an OSC string.  Returns NULL if the string does not end
+ * within the packet.  */
+static const gchar *
+osc_read_string (const guchar * packet, guint length, guint * offset)
+{
+  const guchar *string_start;
+  const guchar *string_end;
+
+  if (*offset >= length)
+    return (NULL);
+  string_start = packet + *offset;
+  string_end = memchr (string_start, '\0', length - *offset);
+  if (string_end == NULL)
+    return (NULL);
+
+  /* Skip the terminating NUL and the padding.  Tolerate missing padding
+   * at the end of the packet.  */
+  *offset = *offset + (((string_end - string_start) + 4) & ~3);
+  if (*offset > length)
+    *offset = length;
+  return ((const gchar *) string_start);
+}
+
+/* Read a 32-bit big-endian number.  */
+static gboolean
+osc_read_int32 (const guchar * packet, guint length, guint * offset,
+                guint32 * value)
+{
+  guint32 raw_value;
+
+  if ((length < 4) || (*offset > length - 4))
+    return (FALSE);
+  memcpy (&raw_value, packet + *offset, 4);
+  *value = GUINT32_FROM_BE (raw_value);
+  *offset = *offset + 4;
+  return (TRUE);
+}
+
+/* Read a 64-bit big-endian number.  */
+static gboolean
+osc_read_int64 (const guchar * packet, guint length, guint * offset,
+                guint64 * value)
+{
+  guint64 raw_value;
+
+  if ((length < 8) || (*offset > length - 8))
+    return (FALSE);
+  memcpy (&raw_value, packet + *offset, 8);
+  *value = GUINT64_FROM_BE (raw_value);
+  *offset = *offset + 8;
+  return (TRUE);
+}
+
+/* Convert an OSC time tag, which is an NTP time stamp, to nanoseconds
+ * since the Unix epoch.  */
+static gint64
+osc_time_tag_to_unix (guint64 time_tag)
+{
+  gint64 seconds;
+  gint64 nanoseconds;
 
-  /* Populate the hash table. */
-  for (i = 0;
-       i < sizeof (keywords_with_values) / sizeof (keywords_with_values[0]);
-       i++)
+  seconds = (gint64) (time_tag >> 32) - OSC_NTP_TO_UNIX_SECONDS;
+  nanoseconds = ((time_tag & G_GUINT64_CONSTANT (0xFFFFFFFF))
+                 * G_GUINT64_CONSTANT (1000000000)) >> 32;
+  return ((seconds * G_GINT64_CONSTANT (1000000000)) + nanoseconds);
+}
+
+/* Decode the arguments of an OSC message.  Returns the number of
+ * arguments, or -1 if the message is malformed.  */
+static gint
+osc_read_arguments (const guchar * packet, guint length, guint * offset,
+                    const gchar * type_tags, struct osc_argument *arguments)
+{
+  struct osc_argument *argument;
+  const gchar *tag;
+  guint32 value_32;
+  guint64 value_64;
+  gint argument_count;
+  gboolean ok;
+
+  argument_count = 0;
+  for (tag = type_tags + 1; *tag != '\0'; tag++)
     {
-      g_hash_table_insert (parse_net_data->hash_table,
-                           keywords_with_values[i].key,
-                           keywords_with_values[i].val);
+      /* Arrays are flattened.  */
+      if ((*tag == '[') || (*tag == ']'))
+        continue;
+
+      if (argument_count >= OSC_MAX_ARGUMENTS)
+        break;
+      argument = &arguments[argument_count];
+      argument->type = *tag;
+      ok = TRUE;
+      switch (*tag)
+        {
+        case 'i':
+        case 'c':
+        case 'r':
+        case 'm':
+          ok = osc_read_int32 (packet, length, offset, &value_32);
+          argument->value.i = (gint32) value_32;
+          break;
+
+        case 'f':
+          ok = osc_read_int32 (packet, length, offset, &value_32);
+          memcpy (&argument->value.f, &value_32, 4);
+          break;
+
+        case 'h':
+        case 't':
+          ok = osc_read_int64 (packet, length, offset, &value_64);
+          argument->value.h = (gint64) value_64;
+          break;
+
+        case 'd':
+          ok = osc_read_int64 (packet, length, offset, &value_64);
+          memcpy (&argument->value.d, &value_64, 8);
+          break;
+
+        case 's':
+        case 'S':
+          argument->value.s = osc_read_string (packet, length, offset);
+          ok = (argument->value.s != NULL);
+          break;
+
+        case 'b':
+          ok = osc_read_int32 (packet, length, offset, &value_32);
+          if (ok && (value_32 <= length - *offset))
+            {
+              argument->value.b.data = packet + *offset;
+              argument->value.b.length = value_32;
+              *offset = *offset + ((value_32 + 3) & ~3);
+              if (*offset > length)
+                *offset = length;
+            }
+          else
+            ok = FALSE;
+          break;
+
+        case 'T':
+        case 'F':
+        case 'N':
+        case 'I':
+          /* These carry no data.  */
+          break;
+
+        default:
+          /* We cannot find the remaining arguments after one
+           * we don't understand.  */
+          ok = FALSE;
+          break;
+        }
+
+      if (!ok)
+        return (-1);
+      argument_count = argument_count + 1;
     }
 
-  /* The message buffer starts out empty. */
-  parse_net_data->message_buffer = NULL;
+  return (argument_count);
+}
 
-  return parse_net_data;
+/* Fetch an integer from an OSC argument of any numeric type.  */
+static gboolean
+osc_argument_to_integer (struct osc_argument *argument, gint64 * value)
+{
+  switch (argument->type)
+    {
+    case 'i':
+      *value = argument->value.i;
+      return (TRUE);
+    case 'h':
+      *value = argument->value.h;
+      return (TRUE);
+    case 'f':
+      *value = argument->value.f;
+      return (TRUE);
+    case 'd':
+      *value = argument->value.d;
+      return (TRUE);
+    default:
+      return (FALSE);
+    }
 }
 
-/* Receive a datagram from the network.  Parse and execute the command.
- */
-void
-parse_net_text (guint nread, gchar *text, GApplication *app)
+/* Execute an OSC message.  The only OSC command we implement at this time
+ * is cue.  The forms we handle are "/cue/next", "/cue/quit", 
+ * "/cue/# <cue number>" and "/cue/uuid <cue string>".  */
+static void
+osc_execute_message (const gchar * address, struct osc_argument *arguments,
+                     gint argument_count, GApplication *app)
 {
-  struct parse_net_info *parse_net_data;
-  int command_length;
-  int kl;                       /* keyword length */
-  gchar *keyword_string;
-  gpointer *p;
-  enum keyword_codes keyword_value;
-  gchar *extra_text;
-  gchar *parameter_text = NULL;
-  long int cluster_no;
-  long long int cue_number;
-  int i;
-  
+  gint64 cue_number;
+
+  if (strcmp (address, "/cue/quit") == 0)
+    {
+      g_application_quit (app);
+      return;
+    }
+
+  if (strcmp (address, "/cue/next") == 0)
+    {
+      /* Treat it like pressing the Play button.  */
+      sequence_button_play (app);
+      return;
+    }
+
+  if ((strcmp (address, "/cue/#") == 0) && (argument_count >= 1)
+      && osc_argument_to_integer (&arguments[0], &cue_number))
+    {
+      /* Tell the sequencer to perform the cue.  */
+      sequence_OSC_cue_number (cue_number, app);
+      return;
+    }
+
+  if ((strcmp (address, "/cue/uuid") == 0) && (argument_count >= 1)
+      && ((arguments[0].type == 's') || (arguments[0].type == 'S')))
+    {
+      sequence_OSC_cue_string ((gchar *) arguments[0].value.s, app);
+      return;
+    }
+
+  g_print ("Unknown OSC message %s with %d arguments.\n", address,
+           argument_count);
+  return;
+}
+
+/* Decode and execute an OSC message.  */
+static void
+parse_osc_message (const guchar * packet, guint length, GApplication *app)
+{
+  struct osc_argument arguments[OSC_MAX_ARGUMENTS];
+  const gchar *address;
+  const gchar *type_tags;
+  gint argument_count;
+  guint offset;
+
+  offset = 0;
+  address = osc_read_string (packet, length, &offset);
+  if (address == NULL)
+    {
+      g_print ("Malformed OSC message.\n");
+      return;
+    }
+
+  /* Some older senders omit the type tag string; treat that as a message
+   * with no arguments.  */
+  if ((offset < length) && (packet[offset] == ','))
+    type_tags = osc_read_string (packet, length, &offset);
+  else
+    type_tags = ",";
+  if (type_tags == NULL)
+    {
+      g_print ("Malformed OSC type tags in %s.\n", address);
+      return;
+    }
+
+  /* We ignore extra data at the end of a message to make testing using
+   * nc and emacs in hexl-mode easier.  */
+  argument_count =
+    osc_read_arguments (packet, length, &offset, type_tags, &arguments[0]);
+  if (argument_count < 0)
+    {
+      g_print ("Malformed OSC arguments in %s, type tags %s.\n", address,
+               type_tags);
+      return;
+    }
+
   if (TRACE_PARSE_NET)
     {
-      printf ("network message, length %d, contents (in hexadecimal): ",
-              nread);
-      for (i = 0; i < nread; i++)
+      g_print ("OSC message %s, type tags %s, %d arguments.\n", address,
+               type_tags, argument_count);
+    }
+
+  osc_execute_message (address, &arguments[0], argument_count, app);
+  return;
+}
+
+/* Execute a bundle whose time has come.  This runs in the main thread.
+ * The bundle is no longer waiting, so drop the reference to its clock 
+ * ID held by the list of scheduled bundles; the idle source holds 
+ * another until we are done.  */
+static gboolean
+osc_execute_scheduled_bundle (gpointer user_data)
+{
+  struct osc_scheduled_bundle *scheduled_bundle = user_data;
+  struct parse_net_info *parse_net_data;
+
+  if (scheduled_bundle->cancelled)
+    return G_SOURCE_REMOVE;
+
+  parse_net_data = sep_get_parse_net_data (scheduled_bundle->app);
+  parse_net_data->scheduled_bundles =
+    g_list_remove (parse_net_data->scheduled_bundles, scheduled_bundle);
+  gst_clock_id_unref (scheduled_bundle->clock_id);
+
+  parse_osc_packet (&scheduled_bundle->packet[0], scheduled_bundle->length,
+                    0, scheduled_bundle->app);
+  return G_SOURCE_REMOVE;
+}
+
+/* The main thread is done with a bundle that was due.  */
+static void
+osc_release_scheduled_bundle (gpointer user_data)
+{
+  struct osc_scheduled_bundle *scheduled_bundle = user_data;
+
+  gst_clock_id_unref (scheduled_bundle->clock_id);
+  return;
+}
+
+/* The clock has reached the time of a bundle.  This runs in the clock's
+ * thread, so pass the bundle to the main thread for execution, keeping
+ * its clock ID, and so the bundle, until the main thread is done.  */
+static gboolean
+osc_bundle_due (GstClock * clock, GstClockTime time, GstClockID clock_id,
+                gpointer user_data)
+{
+  gst_clock_id_ref (clock_id);
+  g_idle_add_full (G_PRIORITY_HIGH, osc_execute_scheduled_bundle, user_data,
+                   osc_release_scheduled_bundle);
+  return (TRUE);
+}
+
+/* Hold a bundle until its time tag, measured on the pipeline clock.  
+ * The bundle is copied, with its time tag changed to "immediately", 
+ * since the datagram it came in will be re-used.  Returns FALSE if
+ * the bundle should be executed now.  */
+static gboolean
+osc_schedule_bundle (const guchar * packet, guint length, gint64 unix_time,
+                     GApplication *app)
+{
+  struct osc_scheduled_bundle *scheduled_bundle;
+  struct parse_net_info *parse_net_data;
+  GstPipeline *pipeline_element;
+  GstClock *clock;
+  GstClockID clock_id;
+  gint64 delay, receive_time;
+  guint64 immediate_time_tag;
+
+  /* A bundle whose time has passed is executed now.  If it is well
+   * past, say whether it was late arriving or waited too long in the
+   * queue from the network thread.  */
+  delay = unix_time - (g_get_real_time () * 1000);
+  if (delay <= 0)
+    {
+      receive_time = network_get_receive_time (app);
+      if ((delay < -OSC_LATE_REPORT) && (receive_time != 0))
         {
-          printf ("%02x", text[i]);
+          g_print ("OSC bundle is %.3f ms late, and waited %.3f ms "
+                   "to be parsed.\n", (gdouble) -delay / 1e6,
+                   (gdouble) ((g_get_real_time () * 1000) - receive_time)
+                   / 1e6);
         }
-      printf (".\n");
+      return (FALSE);
+    }
+
+  /* Use the clock the sounds are played by, if there is one.  */
+  pipeline_element = sep_get_pipeline_from_app (app);
+  clock = NULL;
+  if (pipeline_element != NULL)
+    clock = gst_pipeline_get_clock (pipeline_element);
+  if (clock == NULL)
+    clock = gst_system_clock_obtain ();
+
+  scheduled_bundle =
+    g_malloc (sizeof (struct osc_scheduled_bundle) + length);
+  scheduled_bundle->app = app;
+  scheduled_bundle->cancelled = FALSE;
+  scheduled_bundle->length = length;
+  memcpy (&scheduled_bundle->packet[0], packet, length);
+  immediate_time_tag = GUINT64_TO_BE (OSC_TIME_TAG_IMMEDIATE);
+  memcpy (&scheduled_bundle->packet[8], &immediate_time_tag, 8);
+
+  if (TRACE_PARSE_NET)
+    {
+      g_print ("OSC bundle of %d bytes scheduled in %" G_GINT64_FORMAT
+               " ns.\n", length, delay);
     }
 
+  /* Keep the clock ID, so the bundle can be cancelled by a reload
+   * or when we shut down.  Freeing the clock ID frees the bundle.  */
+  clock_id = gst_clock_new_single_shot_id (clock,
+                                           gst_clock_get_time (clock) +
+                                           delay);
+  scheduled_bundle->clock_id = clock_id;
   parse_net_data = sep_get_parse_net_data (app);
+  parse_net_data->scheduled_bundles =
+    g_list_prepend (parse_net_data->scheduled_bundles, scheduled_bundle);
+  gst_clock_id_wait_async (clock_id, osc_bundle_due, scheduled_bundle,
+                           g_free);
+  gst_object_unref (clock);
+
+  return (TRUE);
+}
 
-  /* If the datagram starts with "/" and is at least 16 bytes long,
-   * it is an OSC message.  We ignore extra data at the end of a
-   * datagram to make testing using nc and emacs in hexl-mode easier.  */
-  if ((text[0] == '/') && (nread >= 16))
+/* Decode and execute an OSC bundle.  */
+static void
+parse_osc_bundle (const guchar * packet, guint length, guint depth,
+                  GApplication *app)
+{
+  guint offset;
+  guint64 time_tag;
+  guint32 element_size;
+
+  offset = 8;
+  if (!osc_read_int64 (packet, length, &offset, &time_tag))
     {
-      /* The only OSC command we implement at this time
-       * is cue.  The four forms we handle are "/cue/next/",
-       * "/cue/quit/", "/cue/#,i <cue number>" and /cue/uuid,s <cue_string>.
-       * The first three forms are 16 bytes long, the last 56.  */
-      if (memcmp (text, (gchar *) "/cue/quit\0\0\0,\0\0\0", 16) == 0)
-        {
-          /* This is "/cue/quit".  */
-          g_application_quit (app);
-          return;
-        }
+      g_print ("Malformed OSC bundle.\n");
+      return;
+    }
 
-      if (memcmp (text, (gchar *) "/cue/next\0\0\0,\0\0\0", 16) == 0)
-        {
-          /* This is "/cue/next".  Treat it like pressing the Play
-           * button.  */
-          sequence_button_play (app);
-          return;
-        }
+  /* If the bundle is to be executed in the future, hold it until then.  */
+  if ((time_tag != OSC_TIME_TAG_IMMEDIATE)
+      && osc_schedule_bundle (packet, length,
+                              osc_time_tag_to_unix (time_tag), app))
+    return;
 
-      if (memcmp (text, (gchar *) "/cue/#\0\0,i\0\0", 12) == 0)
+  /* Execute each element of the bundle in order.  */
+  while (offset < length)
+    {
+      if (!osc_read_int32 (packet, length, &offset, &element_size)
+          || (element_size > length - offset))
         {
-          /* This is "/cue/#,i <cue number>".
-           * Bytes 12-15 are the cue number in binary,
-           * high-order byte first.  */
-          cue_number = text[12];
-          cue_number = cue_number * 256;
-          cue_number = cue_number + text[13];
-          cue_number = cue_number * 256;
-          cue_number = cue_number + text[14];
-          cue_number = cue_number * 256;
-          cue_number = cue_number + text[15];
-
-          /* Tell the sequencer to perform the cue.  */
-          sequence_OSC_cue_number (cue_number, app);
+          g_print ("Malformed OSC bundle element.\n");
           return;
         }
+      parse_osc_packet (packet + offset, element_size, depth + 1, app);
+      offset = offset + element_size;
+    }
 
-      if ((nread >= 56)
-          && (memcmp (text, (gchar *) "/cue/uuid\0\0\0,s\0\0", 16) == 0))
-        {
-          /* This is "/cue/uuid,s <cue string>".
-           * Bytes 16-51 are the cue string.  These bytes are ASCII text
-           * and are followed by 4 NULs, so we can pass the address
-           * of text [16] as the pointer to a string.  */
-          sequence_OSC_cue_string ((gchar *) & text[16], app);
-          return;
-        }
+  return;
+}
 
-      /* The datagram starts with "/" but is not recognized.  */
-      g_print ("Unknown message (in hexadecimal): ");
-      for (i = 0; i < nread; i++)
-        {
-          printf ("%02x", text[i]);
-        }
-      printf (".\n");
+/* Decode and execute an OSC packet, which is either a message 
+ * or a bundle.  Bundles can contain bundles, so limit the depth.  */
+static void
+parse_osc_packet (const guchar * packet, guint length, guint depth,
+                  GApplication *app)
+{
+  if (depth > OSC_MAX_DEPTH)
+    {
+      g_print ("OSC bundles nested too deeply.\n");
       return;
     }
 
-  /* Absent a slash, this is a simple text command.  */
-  command_length = nread;
-  text[nread] = '\0';
-  /* Isolate the keyword that starts the command. The keyword will be
-   * terminated by white space or the end of the string.  */
-  for (kl = 0; kl < command_length; kl++)
-    if (g_ascii_isspace (text[kl]))
-      break;
+  if ((length >= 16) && (memcmp (packet, "#bundle", 8) == 0))
+    {
+      parse_osc_bundle (packet, length, depth, app);
+      return;
+    }
 
-  keyword_string = g_strndup (text, kl);
-  /* If there is any text after the keyword, it is probably a parameter
-   * to the command.  Isolate it, also.  */
-  if (kl + 1 < command_length)
+  if ((length > 0) && (packet[0] == '/'))
     {
-      extra_text = g_strdup (text + kl + 1);
+      parse_osc_message (packet, length, app);
+      return;
     }
-  else
+
+  g_print ("Unknown OSC packet of %d bytes.\n", length);
+  return;
+}
+
+/* Receive a datagram from the network.  Parse and execute the command.
+ * The datagram is parsed where it lies, without copying it.  */
+void
+parse_net_text (guint nread, gchar *text, GApplication *app)
+{
+  struct parse_command_info command;
+  gchar Q_number[PARSE_NET_MAX_Q_NUMBER + 1];
+  glong cluster_no;
+  guint i;
+
+  if (TRACE_PARSE_NET)
     {
-      extra_text = NULL;
+      printf ("network message, length %d, contents (in hexadecimal): ",
+              nread);
+      for (i = 0; i < nread; i++)
+        {
+          printf ("%02x", text[i]);
+        }
+      printf (".\n");
     }
 
-  /* Find the keyword in the hash table. */
-  p = g_hash_table_lookup (parse_net_data->hash_table, keyword_string);
-  if (p == NULL)
+  record_datagram (nread, text, app);
+
+  /* If the datagram starts with "/" it is an OSC message, and if it
+   * starts with "#" it is an OSC bundle.  */
+  if ((nread > 0) && ((text[0] == '/') || (text[0] == '#')))
     {
-      g_print ("Unknown command\n");
+      parse_osc_packet ((guchar *) text, nread, 0, app);
+      return;
     }
-  else
+
+  /* Absent a slash, this is a simple text command: a keyword
+   * followed by an optional operand.  */
+  parse_command_tokenize (text, nread, &command);
+  switch (command.code)
     {
-      keyword_value = (enum keyword_codes) *p;
-      switch (keyword_value)
+    case parse_command_start:
+      /* For the Start command, the operand is the cluster number. */
+      if (!parse_command_argument_number (&command, &cluster_no))
         {
-        case keyword_start:
-          /* For the Start command, the operand is the 
-           * cluster number. */
-          cluster_no = strtol (extra_text, NULL, 0);
-          sequence_cluster_start (cluster_no, app);
+          g_print ("Start needs a cluster number.\n");
           break;
+        }
+      sequence_cluster_start (cluster_no, app);
+      break;
 
-        case keyword_stop:
-          /* Likewise for the Stop command. */
-          cluster_no = strtol (extra_text, NULL, 0);
-          sequence_cluster_stop (cluster_no, app);
+    case parse_command_stop:
+      /* Likewise for the Stop command. */
+      if (!parse_command_argument_number (&command, &cluster_no))
+        {
+          g_print ("Stop needs a cluster number.\n");
           break;
+        }
+      sequence_cluster_stop (cluster_no, app);
+      break;
 
-        case keyword_quit:
-          /* The Quit command takes no arguments. */
-          g_application_quit (app);
-          break;
+    case parse_command_quit:
+      /* The Quit command takes no arguments. */
+      g_application_quit (app);
+      break;
 
-        case keyword_go:
-          /* The go command is treated as the 
-           * MIDI Show Control command Go.
-           * We must isolate the text parameter, since
-           * extra_text may end with a line break.  */
-          g_strdelimit (extra_text, (gchar *) "\n", (gchar) ' ');
-          g_strstrip (extra_text);
-          sequence_MIDI_show_control_go (extra_text, app);
+    case parse_command_reload:
+      /* The Reload command, like SIGHUP, re-reads the project.  */
+      sep_reload_project (app);
+      break;
+
+    case parse_command_go:
+      /* The go command is treated as the MIDI Show Control command Go.
+       * The sequencer needs the operand as a string, so copy it, 
+       * changing any embedded line breaks to spaces.  */
+      if ((command.argument_length == 0)
+          || (command.argument_length > PARSE_NET_MAX_Q_NUMBER))
+        {
+          g_print ("Go needs a Q number of 1 to %d characters.\n",
+                   PARSE_NET_MAX_Q_NUMBER);
           break;
+        }
+      for (i = 0; i < command.argument_length; i++)
+        {
+          if ((command.argument[i] == '\n') || (command.argument[i] == '\r'))
+            Q_number[i] = ' ';
+          else
+            Q_number[i] = command.argument[i];
+        }
+      Q_number[command.argument_length] = '\0';
+      sequence_MIDI_show_control_go (&Q_number[0], app);
+      break;
 
-        default:
-          g_print ("unknown command\n");
+    case parse_command_status:
+      /* The Status command prints a report on standard output.  Its
+       * operand says what to report on.  */
+      if ((command.argument_length == 6)
+          && (g_ascii_strncasecmp (command.argument, "memory", 6) == 0))
+        {
+          memory_report (app);
+          break;
         }
+      g_print ("Status needs memory.\n");
+      break;
 
-      g_free (keyword_string);
-      g_free (extra_text);
-      g_free (parameter_text);
+    default:
+      g_print ("Unknown command\n");
+      break;
     }
 
   return;
 }
 
+/* Cancel the OSC bundles waiting for their time.  A bundle which is
+ * already due, but not yet executed, is marked so that it will not be.
+ * This is done before a reload, since the bundles were sent for the old
+ * project, and when we shut down.  */
+void
+parse_net_cancel_bundles (GApplication *app)
+{
+  struct parse_net_info *parse_net_data;
+  struct osc_scheduled_bundle *scheduled_bundle;
+  GList *l;
+
+  parse_net_data = sep_get_parse_net_data (app);
+  if (parse_net_data == NULL)
+    return;
+
+  for (l = parse_net_data->scheduled_bundles; l != NULL; l = l->next)
+    {
+      scheduled_bundle = l->data;
+      scheduled_bundle->cancelled = TRUE;
+      gst_clock_id_unschedule (scheduled_bundle->clock_id);
+      gst_clock_id_unref (scheduled_bundle->clock_id);
+    }
+  g_list_free (parse_net_data->scheduled_bundles);
+  parse_net_data->scheduled_bundles = NULL;
+
+  return;
+}
+
+/* Cancel any waiting OSC bundles and deallocate the persistent data
+ * used by the parser.  */
+void
+parse_net_finish (GApplication *app)
+{
+  struct parse_net_info *parse_net_data;
+
+  parse_net_data = sep_get_parse_net_data (app);
+  if (parse_net_data == NULL)
+    return;
+
+  parse_net_cancel_bundles (app);
+  g_free (parse_net_data->message_buffer);
+  g_free (parse_net_data);
+  return;
+}
+
 /* End of file parse_net_subroutines.c */
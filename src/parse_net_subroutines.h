@@ -27,4 +27,10 @@ void *parse_net_init (GApplication *app);
 /* Process a received datagram.  */
 void parse_net_text (guint nread, gchar *text, GApplication *app);
 
+/* Cancel the OSC bundles waiting for their time.  */
+void parse_net_cancel_bundles (GApplication *app);
+
+/* Cancel any waiting bundles and deallocate the parser's data.  */
+void parse_net_finish (GApplication *app);
+
 /* End of file parse_net_subroutines.h  */
@@ -0,0 +1,309 @@
+/*
+ * parse_xml_bench.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compare the time and peak memory needed to read a large sound sequence
+ * file by parsing it into a document tree, as we used to, and by reading
+ * it as a stream one sequence item at a time, as parse_xml_subroutines.c
+ * now does.  The program writes a generated sequence file, reads it both
+ * ways, visiting the text of every field of every item, and reports the
+ * results.  It does not need the user interface or Gstreamer.  Build it
+ * with "make parse_xml_bench" and run it with an optional count of
+ * sequence items, or the name of an existing sequence file.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <libxml/xmlmemory.h>
+#include <libxml/parser.h>
+#include <libxml/xmlreader.h>
+
+/* libxml2 lets us supply its memory allocator, so we can count the
+ * bytes it is using.  Each block is preceded by its size.  */
+#define HEADER_SIZE 16
+
+static gsize current_bytes;
+static gsize peak_bytes;
+
+static void *
+counting_malloc (size_t size)
+{
+  guchar *block;
+
+  block = malloc (size + HEADER_SIZE);
+  if (block == NULL)
+    return NULL;
+  *(size_t *) block = size;
+  current_bytes = current_bytes + size;
+  if (current_bytes > peak_bytes)
+    peak_bytes = current_bytes;
+  return block + HEADER_SIZE;
+}
+
+static void
+counting_free (void *memory)
+{
+  guchar *block;
+
+  if (memory == NULL)
+    return;
+  block = (guchar *) memory - HEADER_SIZE;
+  current_bytes = current_bytes - *(size_t *) block;
+  free (block);
+}
+
+static void *
+counting_realloc (void *memory, size_t size)
+{
+  guchar *block;
+  size_t old_size;
+
+  if (memory == NULL)
+    return counting_malloc (size);
+  block = (guchar *) memory - HEADER_SIZE;
+  old_size = *(size_t *) block;
+  block = realloc (block, size + HEADER_SIZE);
+  if (block == NULL)
+    return NULL;
+  *(size_t *) block = size;
+  current_bytes = current_bytes - old_size + size;
+  if (current_bytes > peak_bytes)
+    peak_bytes = current_bytes;
+  return block + HEADER_SIZE;
+}
+
+static char *
+counting_strdup (const char *string)
+{
+  char *copy;
+  size_t length;
+
+  length = strlen (string) + 1;
+  copy = counting_malloc (length);
+  if (copy != NULL)
+    memcpy (copy, string, length);
+  return copy;
+}
+
+/* Write a sequence file with the specified number of sequence items,
+ * in the form produced by the show_control tools.  */
+static gboolean
+write_sequence_file (const gchar *file_name, glong item_count)
+{
+  FILE *file_stream;
+  glong item;
+
+  file_stream = fopen (file_name, "w");
+  if (file_stream == NULL)
+    return FALSE;
+
+  fprintf (file_stream, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+           "<show_control>\n <sound_sequence>\n  <version>1.0</version>\n");
+  for (item = 0; item < item_count; item++)
+    {
+      fprintf (file_stream,
+               "  <sequence_item>\n"
+               "   <name>item %ld</name>\n"
+               "   <type>start_sound</type>\n"
+               "   <sound_name>sound %ld</sound_name>\n"
+               "   <tag>tag %ld</tag>\n"
+               "   <volume>0.75</volume>\n"
+               "   <importance>2</importance>\n"
+               "   <Q_number>%ld</Q_number>\n"
+               "   <text_to_display>Cue %ld is playing.</text_to_display>\n"
+               "   <next_completion>item %ld</next_completion>\n"
+               "  </sequence_item>\n",
+               item, item % 100, item, item, item, item + 1);
+    }
+  fprintf (file_stream, " </sound_sequence>\n</show_control>\n");
+  return (fclose (file_stream) == 0);
+}
+
+/* Visit the text of each field of a sequence item, as the parser does.  */
+static glong
+visit_item (xmlDocPtr file, xmlNodePtr item_loc)
+{
+  xmlChar *name_data;
+  glong checksum;
+
+  checksum = 0;
+  for (; item_loc != NULL; item_loc = item_loc->next)
+    {
+      name_data = xmlNodeListGetString (file, item_loc->xmlChildrenNode, 1);
+      if (name_data != NULL)
+        {
+          checksum = checksum + xmlStrlen (name_data);
+          xmlFree (name_data);
+        }
+    }
+  return checksum;
+}
+
+/* Read the file into a document tree, then walk the tree.  */
+static glong
+read_as_tree (const gchar *file_name, glong *item_count)
+{
+  xmlDocPtr file;
+  xmlNodePtr loc, item_loc;
+  glong checksum;
+
+  checksum = 0;
+  *item_count = 0;
+  file = xmlReadFile (file_name, NULL, XML_PARSE_NOBLANKS);
+  if (file == NULL)
+    return -1;
+  loc = xmlDocGetRootElement (file);
+  for (loc = loc->xmlChildrenNode; loc != NULL; loc = loc->next)
+    {
+      if (!xmlStrEqual (loc->name, (const xmlChar *) "sound_sequence"))
+        continue;
+      for (item_loc = loc->xmlChildrenNode; item_loc != NULL;
+           item_loc = item_loc->next)
+        {
+          if (!xmlStrEqual (item_loc->name,
+                            (const xmlChar *) "sequence_item"))
+            continue;
+          checksum = checksum + visit_item (file, item_loc->xmlChildrenNode);
+          *item_count = *item_count + 1;
+        }
+    }
+  xmlFreeDoc (file);
+  return checksum;
+}
+
+/* Read the file as a stream, expanding one sequence item at a time.  */
+static glong
+read_as_stream (const gchar *file_name, glong *item_count)
+{
+  xmlTextReaderPtr reader;
+  xmlNodePtr item_loc;
+  glong checksum;
+  gint status;
+
+  checksum = 0;
+  *item_count = 0;
+  reader = xmlReaderForFile (file_name, NULL, XML_PARSE_NOBLANKS);
+  if (reader == NULL)
+    return -1;
+  status = xmlTextReaderRead (reader);
+  while (status == 1)
+    {
+      if ((xmlTextReaderNodeType (reader) == XML_READER_TYPE_ELEMENT)
+          && (xmlTextReaderDepth (reader) == 2)
+          && xmlStrEqual (xmlTextReaderConstName (reader),
+                          (const xmlChar *) "sequence_item"))
+        {
+          item_loc = xmlTextReaderExpand (reader);
+          if (item_loc != NULL)
+            {
+              checksum =
+                checksum + visit_item (item_loc->doc,
+                                       item_loc->xmlChildrenNode);
+              *item_count = *item_count + 1;
+            }
+          status = xmlTextReaderNext (reader);
+          continue;
+        }
+      status = xmlTextReaderRead (reader);
+    }
+  xmlFreeTextReader (reader);
+  if (status < 0)
+    return -1;
+  return checksum;
+}
+
+/* Run one method and report its time and peak memory.  */
+static void
+measure (const gchar *method_name,
+         glong (*method) (const gchar *file_name, glong *item_count),
+         const gchar *file_name)
+{
+  gint64 start_time, end_time;
+  glong checksum, item_count;
+  gsize base_bytes;
+
+  base_bytes = current_bytes;
+  peak_bytes = current_bytes;
+  start_time = g_get_monotonic_time ();
+  checksum = method (file_name, &item_count);
+  end_time = g_get_monotonic_time ();
+
+  g_print ("%-8s %9ld items in %8.3f seconds, "
+           "peak memory %8.2f MB (checksum %ld).\n",
+           method_name, item_count,
+           (gdouble) (end_time - start_time) / 1e6,
+           (gdouble) (peak_bytes - base_bytes) / (1024.0 * 1024.0),
+           checksum);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gchar *file_name;
+  gboolean generated;
+  glong item_count;
+  FILE *file_stream;
+
+  xmlMemSetup (counting_free, counting_malloc, counting_realloc,
+               counting_strdup);
+  xmlInitParser ();
+
+  /* The parameter is either the number of sequence items to generate
+   * or the name of a sequence file to read.  */
+  item_count = 200000;
+  generated = TRUE;
+  file_name = NULL;
+  if (argc > 1)
+    {
+      file_stream = fopen (argv[1], "r");
+      if (file_stream != NULL)
+        {
+          fclose (file_stream);
+          file_name = g_strdup (argv[1]);
+          generated = FALSE;
+        }
+      else
+        item_count = strtol (argv[1], NULL, 0);
+    }
+
+  if (generated)
+    {
+      file_name =
+        g_build_filename (g_get_tmp_dir (), "parse_xml_bench.xml", NULL);
+      if (!write_sequence_file (file_name, item_count))
+        {
+          g_printerr ("Unable to write %s.\n", file_name);
+          return EXIT_FAILURE;
+        }
+    }
+
+  /* Run each method twice, so both see the file in the page cache.  */
+  measure ("tree", read_as_tree, file_name);
+  measure ("stream", read_as_stream, file_name);
+  measure ("tree", read_as_tree, file_name);
+  measure ("stream", read_as_stream, file_name);
+
+  if (generated)
+    remove (file_name);
+  g_free (file_name);
+  xmlCleanupParser ();
+  return EXIT_SUCCESS;
+}
+
+/* End of file parse_xml_bench.c */
@@ -21,8 +21,11 @@
 #include <gtk/gtk.h>
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 #include "parse_xml_subroutines.h"
+#include "loader_subroutines.h"
 #include "network_subroutines.h"
+#include "project_cache_subroutines.h"
 #include "sound_effects_player.h"
 #include "sound_structure.h"
 #include "sound_subroutines.h"
@@ -177,1166 +180,1395 @@ parse_channels_info (xmlDocPtr sounds_file, gchar *sounds_file_name,
   return;
 }
 
+/* Process one sound.  We start at the children of a "sound" section,
+ * and append the sound to the list of sounds.  */
 static void
-parse_sounds_info (xmlDocPtr sounds_file, gchar *sounds_file_name,
-                   xmlNodePtr sounds_loc, GApplication *app)
+parse_sound_info (xmlDocPtr sounds_file, gchar *sounds_file_name,
+                  xmlNodePtr sound_loc, GApplication *app)
 {
   const xmlChar *name;
   xmlChar *name_data;
   gchar *file_dirname, *absolute_file_name;
   gdouble double_data;
   gint64 long_data;
-  xmlNodePtr sound_loc;
   struct sound_info *sound_data;
-  
+
   file_dirname = NULL;
   absolute_file_name = NULL;
   name_data = NULL;
-  /* We start at the children of a "sounds" section.  Each child should
-   * be a "version" or "sound" section. */
-  while (sounds_loc != NULL)
+
+
+  /* Allocate a structure to hold sound information. */
+  sound_data = g_malloc (sizeof (struct sound_info));
+  /* Set the fields to their default values.  If a field does not
+   * appear in the XML file, it will retain its default value.
+   * This lets us add new fields without invalidating old XML files.
+   */
+  sound_data->name = NULL;
+  sound_data->disabled = FALSE;
+  sound_data->wav_file_name = NULL;
+  sound_data->wav_file_name_full = NULL;
+  sound_data->attack_duration_time = 0;
+  sound_data->attack_level = 1.0;
+  sound_data->decay_duration_time = 0;
+  sound_data->sustain_level = 1.0;
+  sound_data->release_start_time = 0;
+  sound_data->release_duration_time = 0;
+  sound_data->release_duration_infinite = FALSE;
+  sound_data->loop_from_time = 0;
+  sound_data->loop_to_time = 0;
+  sound_data->loop_limit = 0;
+  sound_data->max_duration_time = 0;
+  sound_data->start_time = 0;
+  sound_data->designer_volume_level = 1.0;
+  sound_data->designer_pan = 0.0;
+  sound_data->default_volume_level = 1.0;
+  sound_data->MIDI_program_number = 0;
+  sound_data->MIDI_program_number_specified = FALSE;
+  sound_data->MIDI_note_number = 0;
+  sound_data->MIDI_note_number_specified = FALSE;
+  sound_data->function_key = NULL;
+  sound_data->function_key_specified = FALSE;
+  sound_data->omit_panning = FALSE;
+  sound_data->compact_storage = FALSE;
+  sound_data->compact_storage_specified = FALSE;
+  sound_data->storage_format_name = NULL;
+  sound_data->channels = NULL;
+  
+  /* We will fill in this field by examining the sound's WAV file.  */
+  sound_data->channel_count = 0;
+  sound_data->sample_rate = 0;
+  sound_data->format_name = NULL;
+
+  /* The value for this field depends on other sounds.  */
+  sound_data->channel_mask = 0;
+
+  /* By default a sound cannot be started again while it is playing.  */
+  sound_data->max_voices = 1;
+  sound_data->voices = NULL;
+  sound_data->stolen = FALSE;
+  
+  /* These fields will be filled at run time.  */
+  sound_data->sound_control = NULL;
+  sound_data->looper_element = NULL;
+  sound_data->elapsed_time = 0;
+  sound_data->remaining_time = G_MAXUINT64;
+  sound_data->wav_file_time = 0;
+  sound_data->cluster_widget = NULL;
+  sound_data->cluster_number = 0;
+  sound_data->running = FALSE;
+  sound_data->release_sent = FALSE;
+  sound_data->release_has_started = FALSE;
+  sound_data->warmed = FALSE;
+
+  /* Collect information from the XML file.  */
+  while (sound_loc != NULL)
     {
-      name = sounds_loc->name;
-      if (xmlStrEqual (name, (const xmlChar *) "version"))
+      name = sound_loc->name;
+      if (xmlStrEqual (name, (const xmlChar *) "name"))
         {
+          /* This is the name of the sound.  It is mandatory.  */
           name_data =
-            xmlNodeListGetString (sounds_file, sounds_loc->xmlChildrenNode,
-                                  1);
-          if ((!g_str_has_prefix ((gchar *) name_data, (gchar *) "1.")))
-            {
-              g_printerr ("Version number of sounds is %s, "
-                          "should start with 1.\n", name_data);
-              return;
-            }
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          sound_data->name = g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
         }
-      if (xmlStrEqual (name, (const xmlChar *) "sound"))
+      if (xmlStrEqual (name, (const xmlChar *) "wav_file_name"))
         {
-          /* This is a sound.  Copy its information.  */
-          sound_loc = sounds_loc->xmlChildrenNode;
-          /* Allocate a structure to hold sound information. */
-          sound_data = g_malloc (sizeof (struct sound_info));
-          /* Set the fields to their default values.  If a field does not
-           * appear in the XML file, it will retain its default value.
-           * This lets us add new fields without invalidating old XML files.
-           */
-          sound_data->name = NULL;
-          sound_data->disabled = FALSE;
-          sound_data->wav_file_name = NULL;
-          sound_data->wav_file_name_full = NULL;
-          sound_data->attack_duration_time = 0;
-          sound_data->attack_level = 1.0;
-          sound_data->decay_duration_time = 0;
-          sound_data->sustain_level = 1.0;
-          sound_data->release_start_time = 0;
-          sound_data->release_duration_time = 0;
-          sound_data->release_duration_infinite = FALSE;
-          sound_data->loop_from_time = 0;
-          sound_data->loop_to_time = 0;
-          sound_data->loop_limit = 0;
-          sound_data->max_duration_time = 0;
-          sound_data->start_time = 0;
-          sound_data->designer_volume_level = 1.0;
-          sound_data->designer_pan = 0.0;
-	  sound_data->default_volume_level = 1.0;
-          sound_data->MIDI_program_number = 0;
-          sound_data->MIDI_program_number_specified = FALSE;
-          sound_data->MIDI_note_number = 0;
-          sound_data->MIDI_note_number_specified = FALSE;
-          sound_data->function_key = NULL;
-          sound_data->function_key_specified = FALSE;
-          sound_data->omit_panning = FALSE;
-	  sound_data->channels = NULL;
-	  
-	  /* We will fill in this field by examining the sound's WAV file.  */
-	  sound_data->channel_count = 0;
-	  sound_data->format_name = NULL;
-
-	  /* The value for this field depends on other sounds.  */
-	  sound_data->channel_mask = 0;
-	  
-          /* These fields will be filled at run time.  */
-          sound_data->sound_control = NULL;
-          sound_data->cluster_widget = NULL;
-          sound_data->cluster_number = 0;
-          sound_data->running = FALSE;
-          sound_data->release_sent = FALSE;
-          sound_data->release_has_started = FALSE;
-
-          /* Collect information from the XML file.  */
-          while (sound_loc != NULL)
+          /* The name of the WAV file from which we take the
+           * waveform.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
             {
-              name = sound_loc->name;
-              if (xmlStrEqual (name, (const xmlChar *) "name"))
-                {
-                  /* This is the name of the sound.  It is mandatory.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  sound_data->name = g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "wav_file_name"))
-                {
-                  /* The name of the WAV file from which we take the
-                   * waveform.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      sound_data->wav_file_name =
-                        g_strdup ((gchar *) name_data);
-                      xmlFree (name_data);
-                      name_data = NULL;
-
-                      /* If the file name does not have an absolute path,
-                       * prepend the path of the sounds, equipment or project 
-                       * file.  This allows wave files to be copied along with 
-                       * the files that refer to them.  */
-                      if (g_path_is_absolute (sound_data->wav_file_name))
-                        {
-                          g_free (absolute_file_name);
-                          absolute_file_name =
-                            g_strdup (sound_data->wav_file_name);
-                        }
-                      else
-                        {
-                          g_free (file_dirname);
-                          file_dirname =
-                            g_path_get_dirname (sounds_file_name);
-                          g_free (absolute_file_name);
-                          absolute_file_name =
-                            g_build_filename (file_dirname,
-                                              sound_data->wav_file_name,
-                                              NULL);
-                          g_free (file_dirname);
-                          file_dirname = NULL;
-                        }
-                      sound_data->wav_file_name_full = absolute_file_name;
-                      if (!g_file_test
-                          (absolute_file_name, G_FILE_TEST_EXISTS))
-                        {
-                          g_printerr ("File %s does not exist.\n",
-                                      absolute_file_name);
-                          sound_data->disabled = TRUE;
-                        }
-		      else
-			{
-			  /* Open the file WAV and extract the number of 
-			   * channels and file format.
-			   */
-			  sound_parse_wav_file_header (absolute_file_name,
-						       sound_data,
-						       app);
-			}
-                      absolute_file_name = NULL;
-                    }
-                }
-              if (xmlStrEqual
-                  (name, (const xmlChar *) "attack_duration_time"))
-                {
-                  /* The time required to ramp up the sound when it starts.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  double_data = g_ascii_strtod ((gchar *) name_data, NULL);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                  sound_data->attack_duration_time = double_data * 1E9;
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "attack_level"))
-                {
-                  /* The level we ramp up to.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      name_data = NULL;
-                      sound_data->attack_level = double_data;
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "decay_duration_time"))
-                {
-                  /* Following the attack, the time to decrease the volume
-                   * to the sustain level.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      name_data = NULL;
-                      sound_data->decay_duration_time = double_data * 1E9;
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "sustain_level"))
-                {
-                  /* The volume to reach at the end of the decay.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      name_data = NULL;
-                      sound_data->sustain_level = double_data;
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "release_start_time"))
-                {
-                  /* When to start the release process.  If this value is
-                   * zero, we start the release process only upon receipt
-                   * of an external signal, such as MIDI Note Off.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      name_data = NULL;
-                      sound_data->release_start_time = double_data * 1E9;
-                    }
-                }
-              if (xmlStrEqual
-                  (name, (const xmlChar *) "release_duration_time"))
-                {
-                  /* Once release has started, the time to ramp the volume
-                   * down to zero.  Note this value may be infinity, which
-                   * means that the volume does not decrease.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      if (xmlStrEqual (name_data, (const xmlChar *) "∞"))
-                        {
-                          sound_data->release_duration_infinite = TRUE;
-                          sound_data->release_duration_time = 0;
-                          xmlFree (name_data);
-                          name_data = NULL;
-                        }
-                      else
-                        {
-                          double_data =
-                            g_ascii_strtod ((gchar *) name_data, NULL);
-                          xmlFree (name_data);
-                          sound_data->release_duration_time =
-                            double_data * 1E9;
-                          sound_data->release_duration_infinite = FALSE;
-                          name_data = NULL;
-                        }
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "loop_from_time"))
-                {
-                  /* If we are looping, the end time of the loop.  
-                   * 0, the default, means do not loop.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sound_data->loop_from_time = double_data * 1E9;
-                      name_data = NULL;
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "loop_to_time"))
-                {
-                  /* If we are looping, the start time of the loop.  
-                   * Each time through the loop we play from start time
-                   * to the end time of the loop.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sound_data->loop_to_time = double_data * 1E9;
-                      name_data = NULL;
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "loop_limit"))
-                {
-                  /* The number of times to pass through the loop.  Zero
-                   * means loop until stopped by a Release message.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sound_data->loop_limit = long_data;
-                      name_data = NULL;
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "max_duration_time"))
-                {
-                  /* The maximum amount of time to absorb from the WAV file  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sound_data->max_duration_time = double_data * 1E9;
-                      name_data = NULL;
-                    }
-                }
-              if (xmlStrEqual (name, (const xmlChar *) "start_time"))
-                {
-                  /* The time within the WAV file to start this sound effect.
-                   */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sound_data->start_time = double_data * 1E9;
-                      name_data = NULL;
-                    }
-                }
+              sound_data->wav_file_name =
+                g_strdup ((gchar *) name_data);
+              xmlFree (name_data);
+              name_data = NULL;
 
-              if (xmlStrEqual
-                  (name, (const xmlChar *) "designer_volume_level"))
+              /* If the file name does not have an absolute path,
+               * prepend the path of the sounds, equipment or project 
+               * file.  This allows wave files to be copied along with 
+               * the files that refer to them.  */
+              if (g_path_is_absolute (sound_data->wav_file_name))
                 {
-                  /* For this sound effect, decrease the volume from the WAV
-                   * file by this amount.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sound_data->designer_volume_level = double_data;
-                      name_data = NULL;
-                    }
+                  g_free (absolute_file_name);
+                  absolute_file_name =
+                    g_strdup (sound_data->wav_file_name);
                 }
-
-              if (xmlStrEqual (name, (const xmlChar *) "designer_pan"))
+              else
                 {
-                  /* For monaural WAV files, the amount to send to the left and
-                   * right channels, expressed as -1 for left channel only,
-                   * 0 for both channels equally, and +1 for right channel
-                   * only.  Other values between +1 and -1 also place the sound
-                   * in the stereo field.  For stereo WAV files this operates
-                   * as a balance control.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sound_data->designer_pan = double_data;
-                      name_data = NULL;
-                    }
+                  g_free (file_dirname);
+                  file_dirname =
+                    g_path_get_dirname (sounds_file_name);
+                  g_free (absolute_file_name);
+                  absolute_file_name =
+                    g_build_filename (file_dirname,
+                                      sound_data->wav_file_name,
+                                      NULL);
+                  g_free (file_dirname);
+                  file_dirname = NULL;
                 }
-
-              if (xmlStrEqual
-                  (name, (const xmlChar *) "default_volume_level"))
+              sound_data->wav_file_name_full = absolute_file_name;
+              project_cache_note_file (absolute_file_name, app);
+              if (!g_file_test
+                  (absolute_file_name, G_FILE_TEST_EXISTS))
                 {
-                  /* For this sound effect, start with the operator volume at
-		   * this level, so he can increase it if he needs to.
-		   */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sound_data->default_volume_level = double_data;
-                      name_data = NULL;
-                    }
+                  g_printerr ("File %s does not exist.\n",
+                              absolute_file_name);
+                  sound_data->disabled = TRUE;
                 }
-
-              if (xmlStrEqual (name, (const xmlChar *) "MIDI_program_number"))
+              /* The number of channels and file format are
+               * read from the WAV file's header later, along
+               * with those of all the other sounds.  */
+              absolute_file_name = NULL;
+            }
+        }
+      if (xmlStrEqual
+          (name, (const xmlChar *) "attack_duration_time"))
+        {
+          /* The time required to ramp up the sound when it starts.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          double_data = g_ascii_strtod ((gchar *) name_data, NULL);
+          xmlFree (name_data);
+          name_data = NULL;
+          sound_data->attack_duration_time = double_data * 1E9;
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "attack_level"))
+        {
+          /* The level we ramp up to.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              name_data = NULL;
+              sound_data->attack_level = double_data;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "decay_duration_time"))
+        {
+          /* Following the attack, the time to decrease the volume
+           * to the sustain level.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              name_data = NULL;
+              sound_data->decay_duration_time = double_data * 1E9;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "sustain_level"))
+        {
+          /* The volume to reach at the end of the decay.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              name_data = NULL;
+              sound_data->sustain_level = double_data;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "release_start_time"))
+        {
+          /* When to start the release process.  If this value is
+           * zero, we start the release process only upon receipt
+           * of an external signal, such as MIDI Note Off.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              name_data = NULL;
+              sound_data->release_start_time = double_data * 1E9;
+            }
+        }
+      if (xmlStrEqual
+          (name, (const xmlChar *) "release_duration_time"))
+        {
+          /* Once release has started, the time to ramp the volume
+           * down to zero.  Note this value may be infinity, which
+           * means that the volume does not decrease.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              if (xmlStrEqual (name_data, (const xmlChar *) "∞"))
                 {
-                  /* If we aren't using the internal sequencer, the MIDI 
-                   * program number within which a MIDI Note On will activate 
-                   * this sound effect.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sound_data->MIDI_program_number = long_data;
-                      sound_data->MIDI_program_number_specified = TRUE;
-                    }
+                  sound_data->release_duration_infinite = TRUE;
+                  sound_data->release_duration_time = 0;
+                  xmlFree (name_data);
                   name_data = NULL;
                 }
-
-              if (xmlStrEqual (name, (const xmlChar *) "MIDI_note_number"))
-                {
-                  /* If we aren't using the internal sequencer, the MIDI Note
-                   * number that will activate this sound effect.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sound_data->MIDI_note_number = long_data;
-                      sound_data->MIDI_note_number_specified = TRUE;
-                      name_data = NULL;
-                    }
-                }
-
-              if (xmlStrEqual (name, (const xmlChar *) "function_key"))
-                {
-                  /* If we are not using the internal sequencer, this is the
-                   * function key the operator presses to activate this
-                   * sound effect.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (name_data != NULL)
-                    {
-                      sound_data->function_key =
-                        g_strdup ((gchar *) name_data);
-                      sound_data->function_key_specified = TRUE;
-                      xmlFree (name_data);
-                      name_data = NULL;
-                    }
-                }
-
-              if (xmlStrEqual (name, (const xmlChar *) "omit_panning"))
+              else
                 {
-                  /* Do not allow the operator to pan this sound.
-                   * Needed for sounds with one channel that are directed at a
-                   * specific speaker.  */
-                  name_data =
-                    xmlNodeListGetString (sounds_file,
-                                          sound_loc->xmlChildrenNode, 1);
-                  if (xmlStrEqual (name_data, (const xmlChar *) "True"))
-                    {
-                      sound_data->omit_panning = TRUE;
-                    }
+                  double_data =
+                    g_ascii_strtod ((gchar *) name_data, NULL);
                   xmlFree (name_data);
+                  sound_data->release_duration_time =
+                    double_data * 1E9;
+                  sound_data->release_duration_infinite = FALSE;
                   name_data = NULL;
                 }
-
-              if (xmlStrEqual (name, (const xmlChar *) "channels"))
-                {
-		  /* Process the per-channel information about this sound.
-		   */
-		  parse_channels_info (sounds_file, absolute_file_name,
-				       sound_loc->xmlChildrenNode,
-				       sound_data, app);
-		}
-
-              /* Ignore fields we don't recognize, so we can read future
-               * XML files. */
-
-              sound_loc = sound_loc->next;
             }
-          /* Append this sound to the list of sounds.  */
-          sound_append_sound (sound_data, app);
         }
-      sounds_loc = sounds_loc->next;
-    }
-
-  return;
-}
+      if (xmlStrEqual (name, (const xmlChar *) "loop_from_time"))
+        {
+          /* If we are looping, the end time of the loop.  
+           * 0, the default, means do not loop.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sound_data->loop_from_time = double_data * 1E9;
+              name_data = NULL;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "loop_to_time"))
+        {
+          /* If we are looping, the start time of the loop.  
+           * Each time through the loop we play from start time
+           * to the end time of the loop.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sound_data->loop_to_time = double_data * 1E9;
+              name_data = NULL;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "loop_limit"))
+        {
+          /* The number of times to pass through the loop.  Zero
+           * means loop until stopped by a Release message.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sound_data->loop_limit = long_data;
+              name_data = NULL;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "max_voices"))
+        {
+          /* The number of copies of this sound which can play at once.
+           * Starting the sound while all are playing takes over one of
+           * them.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sound_data->max_voices = CLAMP (long_data, 1, MAX_VOICES);
+              name_data = NULL;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "max_duration_time"))
+        {
+          /* The maximum amount of time to absorb from the WAV file  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sound_data->max_duration_time = double_data * 1E9;
+              name_data = NULL;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "start_time"))
+        {
+          /* The time within the WAV file to start this sound effect.
+           */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sound_data->start_time = double_data * 1E9;
+              name_data = NULL;
+            }
+        }
 
-/* Dig through a sequence xml file, or the sequence content of an equipment
- * or project xml file, looking for the individual sequence items.  
- * Construct the sound effect player's internal data structure for each 
- * sequence item.  */
-static void
-parse_sequence_info (xmlDocPtr sequence_file, gchar * sequence_file_name,
-                     xmlNodePtr sequence_loc, GApplication * app)
-{
-  const xmlChar *name;
-  xmlChar *name_data;
-  gchar *text_data;
-  gdouble double_data;
-  gint64 long_data;
-  xmlNodePtr sequence_item_loc;
-  struct sequence_item_info *sequence_item_data;
-  enum sequence_item_type item_type;
+      if (xmlStrEqual
+          (name, (const xmlChar *) "designer_volume_level"))
+        {
+          /* For this sound effect, decrease the volume from the WAV
+           * file by this amount.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sound_data->designer_volume_level = double_data;
+              name_data = NULL;
+            }
+        }
 
-  name_data = NULL;
-  /* We start at the children of a "sequence" section.  Each child should
-   * be a "version" or "sequence_item" section. */
-  while (sequence_loc != NULL)
-    {
-      name = sequence_loc->name;
-      if (xmlStrEqual (name, (const xmlChar *) "version"))
+      if (xmlStrEqual (name, (const xmlChar *) "designer_pan"))
         {
+          /* For monaural WAV files, the amount to send to the left and
+           * right channels, expressed as -1 for left channel only,
+           * 0 for both channels equally, and +1 for right channel
+           * only.  Other values between +1 and -1 also place the sound
+           * in the stereo field.  For stereo WAV files this operates
+           * as a balance control.  */
           name_data =
-            xmlNodeListGetString (sequence_file,
-                                  sequence_loc->xmlChildrenNode, 1);
-          if ((!g_str_has_prefix ((gchar *) name_data, (gchar *) "1.")))
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
             {
-              g_printerr ("Version number of sequence is %s, "
-                          "should start with 1.\n", name_data);
-              return;
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sound_data->designer_pan = double_data;
+              name_data = NULL;
             }
         }
-      if (xmlStrEqual (name, (const xmlChar *) "sequence_item"))
+
+      if (xmlStrEqual
+          (name, (const xmlChar *) "default_volume_level"))
         {
-          /* This is a sequence item.  Copy its information.  */
-          sequence_item_loc = sequence_loc->xmlChildrenNode;
-          /* Allocate a structure to hold sequence item information. */
-          sequence_item_data = g_malloc (sizeof (struct sequence_item_info));
-          /* Set the fields to their default values.  If a field does not
-           * appear in the XML file, it will retain its default value.
-           * This lets us add new fields without invalidating old XML files.
+          /* For this sound effect, start with the operator volume at
+           * this level, so he can increase it if he needs to.
            */
-          /* Fields used in the Start Sound sequence item.  */
-          sequence_item_data->name = NULL;
-          sequence_item_data->type = unknown;
-          sequence_item_data->sound_name = NULL;
-          sequence_item_data->tag = NULL;
-          sequence_item_data->use_external_velocity = 0;
-          sequence_item_data->volume = 1.0;
-          sequence_item_data->pan = 0.0;
-          sequence_item_data->program_number = 0;
-          sequence_item_data->bank_number = 0;
-          sequence_item_data->cluster_number = 0;
-          sequence_item_data->cluster_number_specified = FALSE;
-          sequence_item_data->next_completion = NULL;
-          sequence_item_data->next_termination = NULL;
-          sequence_item_data->next_starts = NULL;
-          sequence_item_data->next_release_started = NULL;
-	  sequence_item_data->next_sound_stopped = NULL;
-          sequence_item_data->importance = 1;
-          sequence_item_data->Q_number = NULL;
-          sequence_item_data->OSC_cue_number = 0;
-          sequence_item_data->OSC_cue_number_specified = FALSE;
-          sequence_item_data->OSC_cue_string = NULL;
-          sequence_item_data->OSC_cue_string_specified = FALSE;
-          sequence_item_data->text_to_display = NULL;
-
-          /* Fields used in the Stop Sound sequence item but not mentioned 
-           * above.  */
-          sequence_item_data->next = NULL;
-
-          /* Fields used in the Wait sequence item but not mentioned above.  */
-          sequence_item_data->time_to_wait = 0;
-
-          /* Fields used in the Offer Sound sequence item but not mentioned
-           * above.  */
-          sequence_item_data->next_to_start = NULL;
-          sequence_item_data->MIDI_program_number = 0;
-          sequence_item_data->MIDI_note_number = 0;
-          sequence_item_data->MIDI_note_number_specified = FALSE;
-          sequence_item_data->macro_number = 0;
-          sequence_item_data->function_key = NULL;
-
-          /* Fields used in the Operator Wait sequence item but not mentioned
-           * above.  */
-          sequence_item_data->next_play = NULL;
-          sequence_item_data->omit_from_display = FALSE;
-
-          /* The Cease Offering Sounds, Cancel Wait and Start Sequence
-           *  sequence items uses only fields already mentioned.  */
-
-          /* Collect information from the XML file.  */
-          while (sequence_item_loc != NULL)
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
             {
-              name = sequence_item_loc->name;
-              if (xmlStrEqual (name, (const xmlChar *) "name"))
-                {
-                  /* This is the name of the sequence item.  It is mandatory.  
-                   */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->name = g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sound_data->default_volume_level = double_data;
+              name_data = NULL;
+            }
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "type"))
-                {
-                  /* The type field specifies what this sequence item does.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-
-                  /* Convert the textual name in the XML file into an enum.  */
-                  item_type = unknown;
-                  if (xmlStrEqual
-                      (name_data, (const xmlChar *) "start_sound"))
-                    {
-                      item_type = start_sound;
-                    }
-                  if (xmlStrEqual (name_data, (const xmlChar *) "stop_sound"))
-                    {
-                      item_type = stop_sound;
-                    }
-                  if (xmlStrEqual (name_data, (const xmlChar *) "wait"))
-                    {
-                      item_type = wait;
-                    }
-                  if (xmlStrEqual
-                      (name_data, (const xmlChar *) "offer_sound"))
-                    {
-                      item_type = offer_sound;
-                    }
-                  if (xmlStrEqual
-                      (name_data, (const xmlChar *) "cease_offering_sound"))
-                    {
-                      item_type = cease_offering_sound;
-                    }
-                  if (xmlStrEqual
-                      (name_data, (const xmlChar *) "operator_wait"))
-                    {
-                      item_type = operator_wait;
-                    }
-                  if (xmlStrEqual
-                      (name_data, (const xmlChar *) "cancel_wait"))
-                    {
-                      item_type = cancel_wait;
-                    }
-                  if (xmlStrEqual
-                      (name_data, (const xmlChar *) "start_sequence"))
-                    {
-                      item_type = start_sequence;
-                    }
+      if (xmlStrEqual (name, (const xmlChar *) "MIDI_program_number"))
+        {
+          /* If we aren't using the internal sequencer, the MIDI 
+           * program number within which a MIDI Note On will activate 
+           * this sound effect.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sound_data->MIDI_program_number = long_data;
+              sound_data->MIDI_program_number_specified = TRUE;
+            }
+          name_data = NULL;
+        }
 
-                  sequence_item_data->type = item_type;
-		  if (item_type == unknown)
-		    {
-		      g_printerr ("Unknown sequence item type: %s.\n",
-				  name_data);
-		    }
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "MIDI_note_number"))
+        {
+          /* If we aren't using the internal sequencer, the MIDI Note
+           * number that will activate this sound effect.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sound_data->MIDI_note_number = long_data;
+              sound_data->MIDI_note_number_specified = TRUE;
+              name_data = NULL;
+            }
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "sound_name"))
-                {
-                  /* For the Start Sound sequence item, the name of the sound
-                   * to start.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->sound_name =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "function_key"))
+        {
+          /* If we are not using the internal sequencer, this is the
+           * function key the operator presses to activate this
+           * sound effect.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (name_data != NULL)
+            {
+              sound_data->function_key =
+                g_strdup ((gchar *) name_data);
+              sound_data->function_key_specified = TRUE;
+              xmlFree (name_data);
+              name_data = NULL;
+            }
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "tag"))
-                {
-                  /* The tag in Start Sound and Offer Sound is used by Stop
-                   * and Cease Offering Sound to name the sound or offering
-                   * to stop.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->tag = g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "omit_panning"))
+        {
+          /* Do not allow the operator to pan this sound.
+           * Needed for sounds with one channel that are directed at a
+           * specific speaker.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          if (xmlStrEqual (name_data, (const xmlChar *) "True"))
+            {
+              sound_data->omit_panning = TRUE;
+            }
+          xmlFree (name_data);
+          name_data = NULL;
+        }
 
-              if (xmlStrEqual
-                  (name, (const xmlChar *) "use_external_velocity"))
-                {
-                  /* For the Start Sound sequence item, if this is set to 1
-                   * we use the velocity of an external Note On message to
-                   * scale the volume of the sound.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->use_external_velocity = long_data;
-                      name_data = NULL;
-                    }
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "compact_storage"))
+        {
+          /* Keep samples wider than 24 bits in memory as 24-bit
+           * integers, or not, regardless of the --sample-storage
+           * option.  */
+          name_data =
+            xmlNodeListGetString (sounds_file,
+                                  sound_loc->xmlChildrenNode, 1);
+          sound_data->compact_storage =
+            xmlStrEqual (name_data, (const xmlChar *) "True");
+          sound_data->compact_storage_specified = TRUE;
+          xmlFree (name_data);
+          name_data = NULL;
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "volume"))
-                {
-                  /* For the Start Sound sequence item, scale the sound
-                   * designer's volume by this amount.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sequence_item_data->volume = double_data;
-                      name_data = NULL;
-                    }
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "channels"))
+        {
+          /* Process the per-channel information about this sound.
+           */
+          parse_channels_info (sounds_file, absolute_file_name,
+                               sound_loc->xmlChildrenNode,
+                               sound_data, app);
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "pan"))
-                {
-                  /* For the Start Sound sequence item, adjust the sound
-                   * designer's pan by this amount.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sequence_item_data->pan = double_data;
-                      name_data = NULL;
-                    }
-                }
+      /* Ignore fields we don't recognize, so we can read future
+       * XML files. */
 
-              if (xmlStrEqual (name, (const xmlChar *) "program_number"))
-                {
-                  /* For the Start Sound and Offer Sound sequence items, 
-                   * the program number of
-                   * the cluster in which we display the sound.  The program
-                   * number of the clusters being shown is controlled by
-                   * the sound effects operator.  Unless there are a large
-                   * number of clusters being used, let this value default
-                   * to zero.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->program_number = long_data;
-                      name_data = NULL;
-                    }
-                }
+      sound_loc = sound_loc->next;
+    }
+  /* Append this sound to the list of sounds.  */
+  sound_append_sound (sound_data, app);
 
-              if (xmlStrEqual (name, (const xmlChar *) "bank_number"))
-                {
-                  /* For the Start Sound and Offer Sound sequence items, 
-                   * the bank number of the cluster in which we display 
-                   * the sound.  The bank
-                   * number of the clusters being shown is controlled by
-                   * the sound effects operator.  Unless there are a large
-                   * number of clusters being used, let this value default
-                   * to zero.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->bank_number = long_data;
-                      name_data = NULL;
-                    }
-                }
+  return;
+}
 
-              if (xmlStrEqual (name, (const xmlChar *) "cluster_number"))
-                {
-                  /* For the Start Sound and Offer Sound sequence items, 
-                   * the cluster number in which we display the sound.  
-                   * If none is specified,
-                   * one will be chosen at run time.  Use this to place
-                   * a sound in the same cluster as a previous, related,
-                   * sound.  For example, you might devote a particular
-                   * cluster to ringing a telephone even though it doesn't
-                   * ring throughtout the show.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->cluster_number = long_data;
-                      sequence_item_data->cluster_number_specified = TRUE;
-                      name_data = NULL;
-                    }
-                }
+static void
+parse_sounds_info (xmlDocPtr sounds_file, gchar *sounds_file_name,
+                   xmlNodePtr sounds_loc, GApplication *app)
+{
+  const xmlChar *name;
+  xmlChar *name_data;
+  
+  name_data = NULL;
+  /* We start at the children of a "sounds" section.  Each child should
+   * be a "version" or "sound" section. */
+  while (sounds_loc != NULL)
+    {
+      name = sounds_loc->name;
+      if (xmlStrEqual (name, (const xmlChar *) "version"))
+        {
+          name_data =
+            xmlNodeListGetString (sounds_file, sounds_loc->xmlChildrenNode,
+                                  1);
+          if ((!g_str_has_prefix ((gchar *) name_data, (gchar *) "1.")))
+            {
+              g_printerr ("Version number of sounds is %s, "
+                          "should start with 1.\n", name_data);
+              return;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "sound"))
+        {
+          parse_sound_info (sounds_file, sounds_file_name,
+                            sounds_loc->xmlChildrenNode, app);
+        }
+      sounds_loc = sounds_loc->next;
+    }
+
+  return;
+}
+
+/* Process one sequence item.  We start at the children of a
+ * "sequence_item" section, and append the item to the sequence.  */
+static void
+parse_sequence_item_info (xmlDocPtr sequence_file, gchar *sequence_file_name,
+                          xmlNodePtr sequence_item_loc, GApplication *app)
+{
+  const xmlChar *name;
+  xmlChar *name_data;
+  gchar *text_data;
+  gdouble double_data;
+  gint64 long_data;
+  struct sequence_item_info *sequence_item_data;
+  enum sequence_item_type item_type;
+
+  name_data = NULL;
+
+
+  /* Allocate a structure to hold sequence item information. */
+  sequence_item_data = g_malloc (sizeof (struct sequence_item_info));
+  /* Set the fields to their default values.  If a field does not
+   * appear in the XML file, it will retain its default value.
+   * This lets us add new fields without invalidating old XML files.
+   */
+  /* Fields used in the Start Sound sequence item.  */
+  sequence_item_data->name = NULL;
+  sequence_item_data->type = unknown;
+  sequence_item_data->sound_name = NULL;
+  sequence_item_data->tag = NULL;
+  sequence_item_data->use_external_velocity = 0;
+  sequence_item_data->volume = 1.0;
+  sequence_item_data->pan = 0.0;
+  sequence_item_data->program_number = 0;
+  sequence_item_data->bank_number = 0;
+  sequence_item_data->cluster_number = 0;
+  sequence_item_data->cluster_number_specified = FALSE;
+  sequence_item_data->next_completion = NULL;
+  sequence_item_data->next_termination = NULL;
+  sequence_item_data->next_starts = NULL;
+  sequence_item_data->next_release_started = NULL;
+  sequence_item_data->next_sound_stopped = NULL;
+  sequence_item_data->importance = 1;
+  sequence_item_data->Q_number = NULL;
+  sequence_item_data->OSC_cue_number = 0;
+  sequence_item_data->OSC_cue_number_specified = FALSE;
+  sequence_item_data->OSC_cue_string = NULL;
+  sequence_item_data->OSC_cue_string_specified = FALSE;
+  sequence_item_data->text_to_display = NULL;
+
+  /* Fields used in the Stop Sound sequence item but not mentioned 
+   * above.  */
+  sequence_item_data->next = NULL;
+
+  /* Fields used in the Wait sequence item but not mentioned above.  */
+  sequence_item_data->time_to_wait = 0;
+
+  /* Fields used in the Offer Sound sequence item but not mentioned
+   * above.  */
+  sequence_item_data->next_to_start = NULL;
+  sequence_item_data->MIDI_program_number = 0;
+  sequence_item_data->MIDI_note_number = 0;
+  sequence_item_data->MIDI_note_number_specified = FALSE;
+  sequence_item_data->macro_number = 0;
+  sequence_item_data->function_key = NULL;
+
+  /* Fields used in the Operator Wait sequence item but not mentioned
+   * above.  */
+  sequence_item_data->next_play = NULL;
+  sequence_item_data->omit_from_display = FALSE;
+
+  /* The Cease Offering Sounds, Cancel Wait and Start Sequence
+   *  sequence items uses only fields already mentioned.  */
+
+  /* Collect information from the XML file.  */
+  while (sequence_item_loc != NULL)
+    {
+      name = sequence_item_loc->name;
+      if (xmlStrEqual (name, (const xmlChar *) "name"))
+        {
+          /* This is the name of the sequence item.  It is mandatory.  
+           */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->name = g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "type"))
+        {
+          /* The type field specifies what this sequence item does.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+
+          /* Convert the textual name in the XML file into an enum.  */
+          item_type = unknown;
+          if (xmlStrEqual
+              (name_data, (const xmlChar *) "start_sound"))
+            {
+              item_type = start_sound;
+            }
+          if (xmlStrEqual (name_data, (const xmlChar *) "stop_sound"))
+            {
+              item_type = stop_sound;
+            }
+          if (xmlStrEqual (name_data, (const xmlChar *) "wait"))
+            {
+              item_type = wait;
+            }
+          if (xmlStrEqual
+              (name_data, (const xmlChar *) "offer_sound"))
+            {
+              item_type = offer_sound;
+            }
+          if (xmlStrEqual
+              (name_data, (const xmlChar *) "cease_offering_sound"))
+            {
+              item_type = cease_offering_sound;
+            }
+          if (xmlStrEqual
+              (name_data, (const xmlChar *) "operator_wait"))
+            {
+              item_type = operator_wait;
+            }
+          if (xmlStrEqual
+              (name_data, (const xmlChar *) "cancel_wait"))
+            {
+              item_type = cancel_wait;
+            }
+          if (xmlStrEqual
+              (name_data, (const xmlChar *) "start_sequence"))
+            {
+              item_type = start_sequence;
+            }
+
+          sequence_item_data->type = item_type;
+          if (item_type == unknown)
+            {
+              g_printerr ("Unknown sequence item type: %s.\n",
+                          name_data);
+            }
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "sound_name"))
+        {
+          /* For the Start Sound sequence item, the name of the sound
+           * to start.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->sound_name =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "tag"))
+        {
+          /* The tag in Start Sound and Offer Sound is used by Stop
+           * and Cease Offering Sound to name the sound or offering
+           * to stop.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->tag = g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual
+          (name, (const xmlChar *) "use_external_velocity"))
+        {
+          /* For the Start Sound sequence item, if this is set to 1
+           * we use the velocity of an external Note On message to
+           * scale the volume of the sound.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->use_external_velocity = long_data;
+              name_data = NULL;
+            }
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "volume"))
+        {
+          /* For the Start Sound sequence item, scale the sound
+           * designer's volume by this amount.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sequence_item_data->volume = double_data;
+              name_data = NULL;
+            }
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "pan"))
+        {
+          /* For the Start Sound sequence item, adjust the sound
+           * designer's pan by this amount.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sequence_item_data->pan = double_data;
+              name_data = NULL;
+            }
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "program_number"))
+        {
+          /* For the Start Sound and Offer Sound sequence items, 
+           * the program number of
+           * the cluster in which we display the sound.  The program
+           * number of the clusters being shown is controlled by
+           * the sound effects operator.  Unless there are a large
+           * number of clusters being used, let this value default
+           * to zero.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->program_number = long_data;
+              name_data = NULL;
+            }
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "bank_number"))
+        {
+          /* For the Start Sound and Offer Sound sequence items, 
+           * the bank number of the cluster in which we display 
+           * the sound.  The bank
+           * number of the clusters being shown is controlled by
+           * the sound effects operator.  Unless there are a large
+           * number of clusters being used, let this value default
+           * to zero.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->bank_number = long_data;
+              name_data = NULL;
+            }
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "cluster_number"))
+        {
+          /* For the Start Sound and Offer Sound sequence items, 
+           * the cluster number in which we display the sound.  
+           * If none is specified,
+           * one will be chosen at run time.  Use this to place
+           * a sound in the same cluster as a previous, related,
+           * sound.  For example, you might devote a particular
+           * cluster to ringing a telephone even though it doesn't
+           * ring throughtout the show.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->cluster_number = long_data;
+              sequence_item_data->cluster_number_specified = TRUE;
+              name_data = NULL;
+            }
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "next_completion"))
+        {
+          /* In the Start Sound sequence item, the next sequence item 
+           * to execute, when and if this sound completes normally.
+           * In the Wait sequence item, the sequence item to execute
+           * when the wait has completed.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next_completion =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "next_termination"))
+        {
+          /* The next sequence item to execute, when and if this
+           * sound terminates due to an external event, such as
+           * a MIDI Note Off or the sound effects operator pressing
+           * his Stop key.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next_termination =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "next_starts"))
+        {
+          /* The next sequence item to execute when this sound has
+           * started.  This can be used to fork the sequencer.
+           */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next_starts =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual
+          (name, (const xmlChar *) "next_release_started"))
+        {
+          /* The next sequence item to execute when this sound has
+           * reached the release stage of its amplitude envelope
+           * without having been stopped by the operator.
+           * This can be used to fork the sequencer.
+           */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next_release_started =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual
+          (name, (const xmlChar *) "next_sound_stopped"))
+        {
+          /* The next sequence item to execute when this sound has
+           * been stopped by the operator.  
+           * This can be used to fork the sequencer.
+           */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next_sound_stopped =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "importance"))
+        {
+          /* The importance of this sound to the sound effects
+           * operator.  The most important sound being played
+           * is displayed on the console.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->importance = long_data;
+              name_data = NULL;
+            }
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "Q_number"))
+        {
+          /* The Q number of this sound, for MIDI Show Control.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->Q_number =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "OSC_cue_number"))
+        {
+          /* The cue for this sound, when expressed as a number,
+           * for Open Sound Control.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          long_data = g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+          xmlFree (name_data);
+          name_data = NULL;
+          sequence_item_data->OSC_cue_number = long_data;
+          sequence_item_data->OSC_cue_number_specified = TRUE;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "OSC_cue_string"))
+        {
+          /* The cue for this sound, when expressed as text,
+           * for Open Sound Control.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->OSC_cue_string =
+            g_strdup ((gchar *) name_data);
+          sequence_item_data->OSC_cue_string_specified = TRUE;
+          xmlFree (name_data);
+          name_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "text_to_display"))
+        {
+          /* The text to display to the sound effects operator when
+           * this sound is playing.  If this element appears more
+           * than once, concatenate the strings.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (sequence_item_data->text_to_display != NULL)
+            {
+              text_data =
+                g_strconcat (sequence_item_data->text_to_display,
+                             (gchar *) name_data, NULL);
+              g_free (sequence_item_data->text_to_display);
+              sequence_item_data->text_to_display = NULL;
+              xmlFree (name_data);
+              name_data = NULL;
+            }
+          else
+            {
+              text_data = g_strdup ((gchar *) name_data);
+              xmlFree (name_data);
+              name_data = NULL;
+            }
+          sequence_item_data->text_to_display = text_data;
+          text_data = NULL;
+        }
+
+      if (xmlStrEqual (name, (const xmlChar *) "next"))
+        {
+          /* In other than the Start Sound sequence item, the next
+           * seqeunce item to execute when this one is done.  The
+           * Start Sound sequence item has three specialized next
+           * sequence items, and so does not use this general one.
+           */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next = g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "next_completion"))
-                {
-                  /* In the Start Sound sequence item, the next sequence item 
-                   * to execute, when and if this sound completes normally.
-                   * In the Wait sequence item, the sequence item to execute
-                   * when the wait has completed.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next_completion =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "time_to_wait"))
+        {
+          /* In the Wait sequence item, the length of time to wait,
+           * in seconds.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              double_data =
+                g_ascii_strtod ((gchar *) name_data, NULL);
+              xmlFree (name_data);
+              sequence_item_data->time_to_wait = double_data * 1E9;
+              name_data = NULL;
+            }
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "next_termination"))
-                {
-                  /* The next sequence item to execute, when and if this
-                   * sound terminates due to an external event, such as
-                   * a MIDI Note Off or the sound effects operator pressing
-                   * his Stop key.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next_termination =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "next_to_start"))
+        {
+          /* In the Offer Sound sequence item, the sequence item
+           * that is to be executed when the sound effects operator
+           * presses the Start button on the specified cluster.
+           * The sequence item can also be started remotely.  
+           * This sequence item, like Start Sound, can be used
+           * to fork the sequencer.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next_to_start =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "next_starts"))
-                {
-                  /* The next sequence item to execute when this sound has
-                   * started.  This can be used to fork the sequencer.
-                   */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next_starts =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "MIDI_program_number"))
+        {
+          /* In the Offer Sound sequence item, the MIDI program number
+           * of the MIDI Note On message that will trigger the
+           * specified sequence item.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->MIDI_program_number = long_data;
+              name_data = NULL;
+            }
+        }
 
-              if (xmlStrEqual
-                  (name, (const xmlChar *) "next_release_started"))
-                {
-                  /* The next sequence item to execute when this sound has
-                   * reached the release stage of its amplitude envelope
-		   * without having been stopped by the operator.
-                   * This can be used to fork the sequencer.
-                   */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next_release_started =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "MIDI_note_number"))
+        {
+          /* In the Offer Sound sequence item, the MIDI note number
+           * of the MIDI Note On message that will trigger the
+           * specified sequence item.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->MIDI_note_number = long_data;
+              sequence_item_data->MIDI_note_number_specified = TRUE;
+              name_data = NULL;
+            }
+        }
 
-              if (xmlStrEqual
-                  (name, (const xmlChar *) "next_sound_stopped"))
-                {
-                  /* The next sequence item to execute when this sound has
-                   * been stopped by the operator.  
-                   * This can be used to fork the sequencer.
-                   */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next_sound_stopped =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "macro_number"))
+        {
+          /* In the Offer Sound sequence item, the macro number used
+           * by the Fire command of MIDI Show Control to trigger
+           * the specified sequence item remotely.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (name_data != NULL)
+            {
+              long_data =
+                g_ascii_strtoll ((gchar *) name_data, NULL, 10);
+              xmlFree (name_data);
+              sequence_item_data->macro_number = long_data;
+              name_data = NULL;
+            }
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "importance"))
-                {
-                  /* The importance of this sound to the sound effects
-                   * operator.  The most important sound being played
-                   * is displayed on the console.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->importance = long_data;
-                      name_data = NULL;
-                    }
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "function_key"))
+        {
+          /* In the Offer Sound and Operator Wait sequence items, 
+           * the function key used to trigger the specified sequence 
+           * item remotely.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->function_key =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "Q_number"))
-                {
-                  /* The Q number of this sound, for MIDI Show Control.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->Q_number =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "next_play"))
+        {
+          /* In the Operator Wait sequence item, the sequence item
+           * to execute when the operator presses the Play button.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          sequence_item_data->next_play =
+            g_strdup ((gchar *) name_data);
+          xmlFree (name_data);
+          name_data = NULL;
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "OSC_cue_number"))
-                {
-                  /* The cue for this sound, when expressed as a number,
-                   * for Open Sound Control.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  long_data = g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                  sequence_item_data->OSC_cue_number = long_data;
-                  sequence_item_data->OSC_cue_number_specified = TRUE;
-                }
+      if (xmlStrEqual (name, (const xmlChar *) "omit_from_display"))
+        {
+          /* In the Operator Wait sequence item, do not display this
+           * item to the operator.  */
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_item_loc->xmlChildrenNode,
+                                  1);
+          if (xmlStrEqual (name_data, (const xmlChar *) "True"))
+            {
+              sequence_item_data->omit_from_display = TRUE;
+            }
+          xmlFree (name_data);
+          name_data = NULL;
+        }
 
-              if (xmlStrEqual (name, (const xmlChar *) "OSC_cue_string"))
-                {
-                  /* The cue for this sound, when expressed as text,
-                   * for Open Sound Control.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->OSC_cue_string =
-                    g_strdup ((gchar *) name_data);
-                  sequence_item_data->OSC_cue_string_specified = TRUE;
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+      /* Ignore fields we don't recognize, so we can read future
+       * XML files. */
 
-              if (xmlStrEqual (name, (const xmlChar *) "text_to_display"))
-                {
-                  /* The text to display to the sound effects operator when
-                   * this sound is playing.  If this element appears more
-		   * than once, concatenate the strings.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-		  if (sequence_item_data->text_to_display != NULL)
-		    {
-		      text_data =
-			g_strconcat (sequence_item_data->text_to_display,
-				     (gchar *) name_data, NULL);
-		      g_free (sequence_item_data->text_to_display);
-		      sequence_item_data->text_to_display = NULL;
-		      xmlFree (name_data);
-		      name_data = NULL;
-		    }
-		  else
-		    {
-		      text_data = g_strdup ((gchar *) name_data);
-		      xmlFree (name_data);
-		      name_data = NULL;
-		    }
-                  sequence_item_data->text_to_display = text_data;
-                  text_data = NULL;
-                }
+      sequence_item_loc = sequence_item_loc->next;
+    }
 
-              if (xmlStrEqual (name, (const xmlChar *) "next"))
-                {
-                  /* In other than the Start Sound sequence item, the next
-                   * seqeunce item to execute when this one is done.  The
-                   * Start Sound sequence item has three specialized next
-                   * sequence items, and so does not use this general one.
-                   */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next = g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+  /* Append this sequence item to the sequence.  */
+  sequence_append_item (sequence_item_data, app);
 
-              if (xmlStrEqual (name, (const xmlChar *) "time_to_wait"))
-                {
-                  /* In the Wait sequence item, the length of time to wait,
-                   * in seconds.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      double_data =
-                        g_ascii_strtod ((gchar *) name_data, NULL);
-                      xmlFree (name_data);
-                      sequence_item_data->time_to_wait = double_data * 1E9;
-                      name_data = NULL;
-                    }
-                }
+  return;
+}
 
-              if (xmlStrEqual (name, (const xmlChar *) "next_to_start"))
-                {
-                  /* In the Offer Sound sequence item, the sequence item
-                   * that is to be executed when the sound effects operator
-                   * presses the Start button on the specified cluster.
-                   * The sequence item can also be started remotely.  
-                   * This sequence item, like Start Sound, can be used
-                   * to fork the sequencer.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next_to_start =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+/* Dig through a sequence xml file, or the sequence content of an equipment
+ * or project xml file, looking for the individual sequence items.  
+ * Construct the sound effect player's internal data structure for each 
+ * sequence item.  */
+static void
+parse_sequence_info (xmlDocPtr sequence_file, gchar * sequence_file_name,
+                     xmlNodePtr sequence_loc, GApplication * app)
+{
+  const xmlChar *name;
+  xmlChar *name_data;
 
-              if (xmlStrEqual (name, (const xmlChar *) "MIDI_program_number"))
-                {
-                  /* In the Offer Sound sequence item, the MIDI program number
-                   * of the MIDI Note On message that will trigger the
-                   * specified sequence item.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->MIDI_program_number = long_data;
-                      name_data = NULL;
-                    }
-                }
+  name_data = NULL;
+  /* We start at the children of a "sequence" section.  Each child should
+   * be a "version" or "sequence_item" section. */
+  while (sequence_loc != NULL)
+    {
+      name = sequence_loc->name;
+      if (xmlStrEqual (name, (const xmlChar *) "version"))
+        {
+          name_data =
+            xmlNodeListGetString (sequence_file,
+                                  sequence_loc->xmlChildrenNode, 1);
+          if ((!g_str_has_prefix ((gchar *) name_data, (gchar *) "1.")))
+            {
+              g_printerr ("Version number of sequence is %s, "
+                          "should start with 1.\n", name_data);
+              return;
+            }
+        }
+      if (xmlStrEqual (name, (const xmlChar *) "sequence_item"))
+        {
+          parse_sequence_item_info (sequence_file, sequence_file_name,
+                                    sequence_loc->xmlChildrenNode, app);
+        }
+      sequence_loc = sequence_loc->next;
+    }
 
-              if (xmlStrEqual (name, (const xmlChar *) "MIDI_note_number"))
-                {
-                  /* In the Offer Sound sequence item, the MIDI note number
-                   * of the MIDI Note On message that will trigger the
-                   * specified sequence item.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->MIDI_note_number = long_data;
-                      sequence_item_data->MIDI_note_number_specified = TRUE;
-                      name_data = NULL;
-                    }
-                }
+  return;
+}
 
-              if (xmlStrEqual (name, (const xmlChar *) "macro_number"))
-                {
-                  /* In the Offer Sound sequence item, the macro number used
-                   * by the Fire command of MIDI Show Control to trigger
-                   * the specified sequence item remotely.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (name_data != NULL)
-                    {
-                      long_data =
-                        g_ascii_strtoll ((gchar *) name_data, NULL, 10);
-                      xmlFree (name_data);
-                      sequence_item_data->macro_number = long_data;
-                      name_data = NULL;
-                    }
-                }
+/* A sounds or sound sequence file, which we read without building
+ * a document tree for the whole file.  */
+struct parse_xml_stream_kind
+{
+  const gchar *file_description;        /* for messages about the file */
+  const gchar *section_description;     /* for messages about its content */
+  const gchar *version_description;     /* for messages about its version */
+  const xmlChar *section_name;  /* the section within show_control */
+  const xmlChar *item_name;     /* each item within that section */
+  void (*parse_item) (xmlDocPtr file, gchar *file_name,
+                      xmlNodePtr item_loc, GApplication *app);
+};
+
+static const struct parse_xml_stream_kind sounds_file_kind = {
+  "sound", "sounds", "sounds",
+  (const xmlChar *) "sounds", (const xmlChar *) "sound",
+  parse_sound_info
+};
+
+static const struct parse_xml_stream_kind sequence_file_kind = {
+  "sound sequence", "sound sequence", "sequence",
+  (const xmlChar *) "sound_sequence", (const xmlChar *) "sequence_item",
+  parse_sequence_item_info
+};
+
+/* Read a sounds or sound sequence file.  A generated file can be very
+ * large, so rather than parsing the whole file into a document tree we
+ * read it as a stream, expanding only one sound or sequence item at a
+ * time.  The reader frees each item once we have moved past it, so the
+ * memory used does not grow with the size of the file.  Return FALSE
+ * if the file cannot be read, is not a show_control file, or has an
+ * error part way through.  */
+static gboolean
+parse_xml_stream_file (gchar *file_name,
+                       const struct parse_xml_stream_kind *kind,
+                       GApplication *app)
+{
+  xmlTextReaderPtr reader;
+  xmlNodePtr item_loc;
+  xmlChar *version_data;
+  xmlChar *section_name;
+  const xmlChar *name;
+  gboolean in_section, section_parsed;
+  gint status, depth;
 
-              if (xmlStrEqual (name, (const xmlChar *) "function_key"))
-                {
-                  /* In the Offer Sound and Operator Wait sequence items, 
-                   * the function key used to trigger the specified sequence 
-                   * item remotely.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->function_key =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+  reader = xmlReaderForFile (file_name, NULL, XML_PARSE_NOBLANKS);
+  if (reader == NULL)
+    {
+      g_printerr ("Load of %s file %s failed.\n", kind->file_description,
+                  file_name);
+      return FALSE;
+    }
 
-              if (xmlStrEqual (name, (const xmlChar *) "next_play"))
-                {
-                  /* In the Operator Wait sequence item, the sequence item
-                   * to execute when the operator presses the Play button.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  sequence_item_data->next_play =
-                    g_strdup ((gchar *) name_data);
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+  /* Find the root element.  */
+  do
+    {
+      status = xmlTextReaderRead (reader);
+    }
+  while ((status == 1)
+         && (xmlTextReaderNodeType (reader) != XML_READER_TYPE_ELEMENT));
+  if (status != 1)
+    {
+      g_printerr ("Empty %s file: %s.\n", kind->file_description,
+                  file_name);
+      xmlFreeTextReader (reader);
+      return FALSE;
+    }
+  name = xmlTextReaderConstName (reader);
+  if (!xmlStrEqual (name, (const xmlChar *) "show_control"))
+    {
+      g_printerr ("Not a show_control file: %s; is %s.\n", file_name, name);
+      xmlFreeTextReader (reader);
+      return FALSE;
+    }
 
-              if (xmlStrEqual (name, (const xmlChar *) "omit_from_display"))
-                {
-                  /* In the Operator Wait sequence item, do not display this
-                   * item to the operator.  */
-                  name_data =
-                    xmlNodeListGetString (sequence_file,
-                                          sequence_item_loc->xmlChildrenNode,
-                                          1);
-                  if (xmlStrEqual (name_data, (const xmlChar *) "True"))
-                    {
-                      sequence_item_data->omit_from_display = TRUE;
-                    }
-                  xmlFree (name_data);
-                  name_data = NULL;
-                }
+  /* Within the top-level show_control structure should be a sounds
+   * or sound sequence structure.  If there isn't, this isn't the kind
+   * of file we want.  */
+  section_name = NULL;
+  in_section = FALSE;
+  section_parsed = FALSE;
+  status = xmlTextReaderRead (reader);
+  while (status == 1)
+    {
+      if (xmlTextReaderNodeType (reader) != XML_READER_TYPE_ELEMENT)
+        {
+          status = xmlTextReaderRead (reader);
+          continue;
+        }
+      depth = xmlTextReaderDepth (reader);
+      name = xmlTextReaderConstName (reader);
 
-              /* Ignore fields we don't recognize, so we can read future
-               * XML files. */
+      if (depth == 1)
+        {
+          xmlFree (section_name);
+          section_name = xmlStrdup (name);
+          in_section = xmlStrEqual (name, kind->section_name);
+          if (in_section)
+            section_parsed = TRUE;
+          status = xmlTextReaderRead (reader);
+          continue;
+        }
 
-              sequence_item_loc = sequence_item_loc->next;
+      if ((depth == 2) && in_section
+          && xmlStrEqual (name, (const xmlChar *) "version"))
+        {
+          version_data = xmlTextReaderReadString (reader);
+          if (!g_str_has_prefix ((gchar *) version_data, (gchar *) "1."))
+            {
+              g_printerr ("Version number of %s is %s, "
+                          "should start with 1.\n",
+                          kind->version_description, version_data);
+              in_section = FALSE;
             }
+          xmlFree (version_data);
+        }
 
-          /* Append this sequence item to the sequence.  */
-          sequence_append_item (sequence_item_data, app);
+      if ((depth == 2) && in_section
+          && xmlStrEqual (name, kind->item_name))
+        {
+          /* Build a small tree for just this item, process it,
+           * then skip past it.  */
+          item_loc = xmlTextReaderExpand (reader);
+          if (item_loc != NULL)
+            {
+              kind->parse_item (item_loc->doc, file_name,
+                                item_loc->xmlChildrenNode, app);
+            }
+          status = xmlTextReaderNext (reader);
+          continue;
         }
-      sequence_loc = sequence_loc->next;
+
+      status = xmlTextReaderRead (reader);
     }
 
-  return;
+  /* If the file could not be read to the end, the items before the
+   * error have been parsed but those after it have not.  Do not let
+   * the project cache remember this partial project.  */
+  if (status < 0)
+    {
+      g_printerr ("Error reading %s file %s.\n", kind->file_description,
+                  file_name);
+      project_cache_abandon (app);
+      xmlFree (section_name);
+      xmlFreeTextReader (reader);
+      return FALSE;
+    }
+  if (!section_parsed)
+    {
+      g_printerr ("Not a %s file: %s; is %s.\n", kind->section_description,
+                  file_name, section_name);
+    }
+
+  xmlFree (section_name);
+  xmlFreeTextReader (reader);
+  return TRUE;
 }
 
 /* Dig through the sound_effects program section of an equipment file 
@@ -1350,11 +1582,6 @@ parse_program_info (xmlDocPtr equipment_file, gchar * equipment_file_name,
   gchar *file_name;
   gchar *file_dirname;
   gchar *absolute_file_name;
-  xmlNodePtr sounds_loc, sequence_loc;
-  xmlDocPtr sounds_file, sequence_file;
-  const xmlChar *root_name;
-  const xmlChar *sounds_name, *sequence_name;
-  gboolean sounds_section_parsed, sequence_section_parsed;
   gchar *old_file_name;
   xmlChar *text_data;
   gint64 port_number, old_port_number;
@@ -1387,6 +1614,7 @@ parse_program_info (xmlDocPtr equipment_file, gchar * equipment_file_name,
 	      text_data = NULL;
 	      return;
 	    }
+          project_cache_note_port (port_number, equipment_file_name, app);
           /* Tell the network module the new network port number. */
           old_port_number = network_get_port (app);
           if (port_number != old_port_number)
@@ -1426,6 +1654,8 @@ parse_program_info (xmlDocPtr equipment_file, gchar * equipment_file_name,
 	      g_print ("Speaker count = %" G_GINT64_FORMAT ".\n",
 		       speaker_count);
 	    }
+          project_cache_note_speaker_count (speaker_count,
+                                            equipment_file_name, app);
           /* Record the new speaker count. */
           old_speaker_count = sep_get_speaker_count (app);
           if (speaker_count != old_speaker_count)
@@ -1482,67 +1712,19 @@ parse_program_info (xmlDocPtr equipment_file, gchar * equipment_file_name,
               g_free (file_name);
               file_name = NULL;
 
-              /* Read the specified file as an XML file. */
-              xmlKeepBlanksDefault (0);
+              /* Read the specified file.  */
 	      if (TRACE_PARSE_XML)
 		{
 		  g_print ("Parsing %s.\n", absolute_file_name);
 		}
-              sounds_file = xmlParseFile (absolute_file_name);
-              if (sounds_file == NULL)
-                {
-                  g_printerr ("Load of sound file %s failed.\n",
-                              absolute_file_name);
-                  g_free (absolute_file_name);
-                  absolute_file_name = NULL;
-                  return;
-                }
-
-              /* Make sure the sounds file is valid, then extract
-               * data from it. */
-              sounds_loc = xmlDocGetRootElement (sounds_file);
-              if (sounds_loc == NULL)
-                {
-                  g_printerr ("Empty sound file: %s.\n", absolute_file_name);
-                  g_free (absolute_file_name);
-                  absolute_file_name = NULL;
-                  xmlFree (sounds_file);
-                  return;
-                }
-              root_name = sounds_loc->name;
-              if (!xmlStrEqual (root_name, (const xmlChar *) "show_control"))
+              project_cache_note_file (absolute_file_name, app);
+              if (!parse_xml_stream_file (absolute_file_name,
+                                          &sounds_file_kind, app))
                 {
-                  g_printerr ("Not a show_control file: %s; is %s.\n",
-                              absolute_file_name, root_name);
-                  xmlFree (sounds_file);
                   g_free (absolute_file_name);
                   absolute_file_name = NULL;
                   return;
                 }
-              /* Within the top-level show_control structure
-               * should be a sounds structure.  If there isn't,
-               * this isn't a sound file and must be rejected.  */
-              sounds_loc = sounds_loc->xmlChildrenNode;
-              sounds_name = NULL;
-              sounds_section_parsed = FALSE;
-              while (sounds_loc != NULL)
-                {
-                  sounds_name = sounds_loc->name;
-                  if (xmlStrEqual (sounds_name, (const xmlChar *) "sounds"))
-                    {
-                      parse_sounds_info (sounds_file, absolute_file_name,
-                                         sounds_loc->xmlChildrenNode, app);
-                      sounds_section_parsed = TRUE;
-                    }
-                  sounds_loc = sounds_loc->next;
-                }
-              if (!sounds_section_parsed)
-                {
-                  g_printerr ("Not a sounds file: %s; is %s.\n",
-                              absolute_file_name, sounds_name);
-                }
-              xmlFree (sounds_file);
-              sounds_file = NULL;
             }
           /* Now process the content of the sounds section. */
           parse_sounds_info (equipment_file, equipment_file_name,
@@ -1587,70 +1769,19 @@ parse_program_info (xmlDocPtr equipment_file, gchar * equipment_file_name,
               g_free (file_name);
               file_name = NULL;
 
-              /* Read the specified file as an XML file. */
-              xmlKeepBlanksDefault (0);
+              /* Read the specified file.  */
 	      if (TRACE_PARSE_XML)
 		{
 		  g_print ("Parsing %s.\n", absolute_file_name);
 		}
-              sequence_file = xmlParseFile (absolute_file_name);
-              if (sequence_file == NULL)
-                {
-                  g_printerr ("Load of sound sequence file %s failed.\n",
-                              absolute_file_name);
-                  g_free (absolute_file_name);
-                  absolute_file_name = NULL;
-                  return;
-                }
-
-              /* Make sure the sound sequence file is valid, then extract
-               * data from it. */
-              sequence_loc = xmlDocGetRootElement (sequence_file);
-              if (sequence_loc == NULL)
-                {
-                  g_printerr ("Empty sound sequence file: %s.\n",
-                              absolute_file_name);
-                  g_free (absolute_file_name);
-                  absolute_file_name = NULL;
-                  xmlFree (sequence_file);
-                  return;
-                }
-              root_name = sequence_loc->name;
-              if (!xmlStrEqual (root_name, (const xmlChar *) "show_control"))
+              project_cache_note_file (absolute_file_name, app);
+              if (!parse_xml_stream_file (absolute_file_name,
+                                          &sequence_file_kind, app))
                 {
-                  g_printerr ("Not a show_control file: %s; is %s.\n",
-                              absolute_file_name, root_name);
-                  xmlFree (sequence_file);
                   g_free (absolute_file_name);
                   absolute_file_name = NULL;
                   return;
                 }
-              /* Within the top-level show_control structure
-               * should be a sound sequence structure.  If there isn't,
-               * this isn't a sound sequence file and must be rejected.  */
-              sequence_loc = sequence_loc->xmlChildrenNode;
-              sequence_name = NULL;
-              sequence_section_parsed = FALSE;
-              while (sequence_loc != NULL)
-                {
-                  sequence_name = sequence_loc->name;
-                  if (xmlStrEqual
-                      (sequence_name, (const xmlChar *) "sound_sequence"))
-                    {
-                      parse_sequence_info (sequence_file, absolute_file_name,
-                                           sequence_loc->xmlChildrenNode,
-                                           app);
-                      sequence_section_parsed = TRUE;
-                    }
-                  sequence_loc = sequence_loc->next;
-                }
-              if (!sequence_section_parsed)
-                {
-                  g_printerr ("Not a sound sequence file: %s; is %s.\n",
-                              absolute_file_name, sequence_name);
-                }
-              xmlFree (sequence_file);
-              sequence_file = NULL;
             }
           /* Now process the content of the sound sequence section. */
           parse_sequence_info (equipment_file, equipment_file_name,
@@ -1812,6 +1943,7 @@ parse_project_info (xmlDocPtr project_file, gchar * project_file_name,
 		{
 		  g_print ("Parsing %s.\n", absolute_file_name);
 		}
+              project_cache_note_file (absolute_file_name, app);
               equipment_file = xmlParseFile (absolute_file_name);
               if (equipment_file == NULL)
                 {
@@ -2272,6 +2404,17 @@ parse_xml_read_project_file (gchar * project_folder_name,
   xmlKeepBlanksDefault (0);
   full_file_name =
     g_build_filename (project_folder_name, project_file_name, NULL);
+
+  /* If we have loaded this project before and none of its files
+   * has changed, take what we need from the cache instead.  */
+  if (project_cache_load (full_file_name, app))
+    {
+      g_free (full_file_name);
+      full_file_name = NULL;
+      return;
+    }
+  project_cache_begin (full_file_name, app);
+
   if (TRACE_PARSE_XML)
     {
       g_print ("Parsing %s.\n", full_file_name);
@@ -2325,6 +2468,14 @@ parse_xml_read_project_file (gchar * project_folder_name,
     {
       g_printerr ("Not a project file: %s.\n", name);
     }
+  else
+    {
+      /* Read the headers of the WAV files, all at once.  */
+      loader_probe_sounds (app);
+
+      /* Remember what we found, so we can start faster next time.  */
+      project_cache_save (full_file_name, app);
+    }
 
   xmlCleanupParser ();
   g_free (full_file_name);
@@ -0,0 +1,726 @@
+/*
+ * polyphony_bench.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measure how many voices can play at once.  We write a synthetic
+ * project--a number of WAV files of tones, of a chosen format, rate,
+ * channel count and length--into a temporary directory, and read them
+ * back the way the loader does, timing that.  Then we build a pipeline
+ * like the one the player builds: for each voice, a looper, which
+ * plays one of the sounds, looping if asked, followed by audioconvert,
+ * audioresample, envelope, audiopanorama for sounds of one or two
+ * channels, volume, and audioconvert with a mix matrix to the speakers,
+ * all feeding an audiomixer, and after it a level element, a volume
+ * element and either a fakesink or a WAV file.  The sink does not wait
+ * for the clock, so the pipeline runs as fast as it can, and we time
+ * how long it takes to produce a given length of sound.
+ *
+ * If it takes the computer less time than the sound lasts, with some
+ * headroom, the voices are sustainable.  Unless a number of voices is
+ * given we start at one and double it until they are not, then search
+ * between the last two counts for the most that are.  This is an upper
+ * bound: playing in real time also needs the audio threads to be
+ * scheduled in time, which is what --realtime-priority is for.
+ *
+ * Each measurement is written to standard output as one line of JSON,
+ * so that results can be collected and compared from one version to
+ * the next.  The program does not need the user interface, but does
+ * need the looper and envelope plugins, so set GST_PLUGIN_PATH to
+ * where they were built.  "make bench" does that, and runs a suite of
+ * configurations.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+/* The length of the WAV header we write, which is where the samples
+ * start.  */
+#define WAV_HEADER_SIZE 44
+
+/* Options.  */
+static gint sound_count = 8;
+static gint voice_count = 0;
+static gint max_voices = 1024;
+static gint channel_count = 2;
+static gint sample_rate = 48000;
+static gint output_rate = 48000;
+static gint speaker_count = 2;
+static gchar *format_string = NULL;
+static gdouble sound_seconds = 10.0;
+static gboolean loop = TRUE;
+static gdouble measure_seconds = 10.0;
+static gdouble headroom = 1.25;
+static gchar *output_file_name = NULL;
+static gchar *label = NULL;
+
+/* A sound of the synthetic project.  */
+struct bench_sound
+{
+  gchar *file_name;
+  GstBuffer *data;
+};
+
+/* The results of one measurement.  */
+struct bench_result
+{
+  gint voices;
+  gdouble audio_seconds;         /* the sound the mixer produced */
+  gdouble wall_seconds;
+  gdouble cpu_seconds;
+  gdouble realtime_factor;
+  gsize rss_bytes_per_voice;
+  gboolean sustainable;
+  gboolean ended_early;         /* the sounds ended before the time
+                                 * asked for */
+  gboolean failed;
+};
+
+/* Data shared with the probe that counts the mixer's output.  */
+struct bench_run
+{
+  GstElement *pipeline_element;
+  GstClockTime produced;
+  GstClockTime wanted;
+  gint done;
+};
+
+/* Return the memory the process has in RAM, in bytes.  */
+static gsize
+resident_bytes (void)
+{
+  FILE *statm;
+  unsigned long size, resident;
+
+  statm = fopen ("/proc/self/statm", "r");
+  if (statm == NULL)
+    return 0;
+  if (fscanf (statm, "%lu %lu", &size, &resident) != 2)
+    resident = 0;
+  fclose (statm);
+  return ((gsize) resident * sysconf (_SC_PAGESIZE));
+}
+
+/* Return the processor time used by all of our threads, in seconds.  */
+static gdouble
+cpu_seconds_used (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + (usage.ru_utime.tv_usec / 1e6)
+          + usage.ru_stime.tv_sec + (usage.ru_stime.tv_usec / 1e6));
+}
+
+/* Return the speaker channels a sound's channels are routed to.  */
+static guint64
+channel_mask_for (gint channels)
+{
+  if (channels == 1)
+    return 0;
+  return (gst_audio_channel_get_fallback_mask (channels));
+}
+
+/* Write a WAV file holding a tone, different for each sound, in each
+ * of its channels.  Return FALSE if it cannot be written.  */
+static gboolean
+write_sound (const gchar *file_name, gint sound_number,
+             const GstAudioFormatInfo *finfo)
+{
+  guint64 frames, samples, index;
+  gsize data_size;
+  guchar *contents, *header;
+  gdouble *unpacked_doubles;
+  gint32 *unpacked_ints;
+  gdouble frequency, value;
+  gboolean floating, success;
+  GError *error = NULL;
+
+  frames = (guint64) (sound_seconds * sample_rate);
+  samples = frames * channel_count;
+  data_size = samples * (GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8);
+  contents = g_malloc0 (WAV_HEADER_SIZE + data_size);
+
+  /* A quiet tone, a semitone higher for each sound.  */
+  floating =
+    (GST_AUDIO_FORMAT_INFO_UNPACK_FORMAT (finfo) == GST_AUDIO_FORMAT_F64);
+  unpacked_doubles = NULL;
+  unpacked_ints = NULL;
+  if (floating)
+    unpacked_doubles = g_malloc (samples * sizeof (gdouble));
+  else
+    unpacked_ints = g_malloc (samples * sizeof (gint32));
+  frequency = 220.0 * pow (2.0, sound_number / 12.0);
+  for (index = 0; index < samples; index++)
+    {
+      value = 0.1 * sin (2.0 * G_PI * frequency * (index / channel_count)
+                         / sample_rate);
+      if (floating)
+        unpacked_doubles[index] = value;
+      else
+        unpacked_ints[index] = (gint32) (value * G_MAXINT32);
+    }
+  finfo->pack_func (finfo, GST_AUDIO_PACK_FLAG_NONE,
+                    floating ? (gpointer) unpacked_doubles
+                    : (gpointer) unpacked_ints,
+                    contents + WAV_HEADER_SIZE, samples);
+  g_free (unpacked_doubles);
+  g_free (unpacked_ints);
+
+  /* The canonical 44-byte header.  */
+  header = contents;
+  memcpy (header, "RIFF", 4);
+  GST_WRITE_UINT32_LE (header + 4, WAV_HEADER_SIZE - 8 + data_size);
+  memcpy (header + 8, "WAVEfmt ", 8);
+  GST_WRITE_UINT32_LE (header + 16, 16);
+  GST_WRITE_UINT16_LE (header + 20, floating ? 3 : 1);
+  GST_WRITE_UINT16_LE (header + 22, channel_count);
+  GST_WRITE_UINT32_LE (header + 24, sample_rate);
+  GST_WRITE_UINT32_LE (header + 28, sample_rate * channel_count
+                       * (GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8));
+  GST_WRITE_UINT16_LE (header + 32, channel_count
+                       * (GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8));
+  GST_WRITE_UINT16_LE (header + 34, GST_AUDIO_FORMAT_INFO_WIDTH (finfo));
+  memcpy (header + 36, "data", 4);
+  GST_WRITE_UINT32_LE (header + 40, data_size);
+
+  success = g_file_set_contents (file_name, (gchar *) contents,
+                                 WAV_HEADER_SIZE + data_size, &error);
+  if (!success)
+    {
+      g_printerr ("Unable to write %s: %s.\n", file_name, error->message);
+      g_error_free (error);
+    }
+  g_free (contents);
+  return success;
+}
+
+/* Read a sound's samples into memory.  */
+static gboolean
+read_sound (struct bench_sound *sound)
+{
+  gchar *contents;
+  gsize length;
+  GError *error = NULL;
+
+  if (!g_file_get_contents (sound->file_name, &contents, &length, &error))
+    {
+      g_printerr ("Unable to read %s: %s.\n", sound->file_name,
+                  error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+  sound->data =
+    gst_buffer_new_wrapped_full (0, contents, length, WAV_HEADER_SIZE,
+                                 length - WAV_HEADER_SIZE, contents, g_free);
+  return TRUE;
+}
+
+/* Set an audioconvert element's mix matrix, routing each incoming
+ * channel to one outgoing channel, as a sound designer might route the
+ * channels of a sound to the speakers.  */
+static void
+set_mix_matrix (GstElement *convert_element, gint in_channels,
+                gint out_channels)
+{
+  GValue v = G_VALUE_INIT;
+  GValue v2 = G_VALUE_INIT;
+  GValue v3 = G_VALUE_INIT;
+  gint in_chan, out_chan;
+
+  g_value_init (&v, GST_TYPE_ARRAY);
+  for (out_chan = 0; out_chan < out_channels; out_chan++)
+    {
+      g_value_init (&v2, GST_TYPE_ARRAY);
+      for (in_chan = 0; in_chan < in_channels; in_chan++)
+        {
+          g_value_init (&v3, G_TYPE_FLOAT);
+          g_value_set_float (&v3,
+                             ((in_chan % out_channels) == out_chan) ? 1.0 :
+                             0.0);
+          gst_value_array_append_value (&v2, &v3);
+          g_value_unset (&v3);
+        }
+      gst_value_array_append_value (&v, &v2);
+      g_value_unset (&v2);
+    }
+  g_object_set_property (G_OBJECT (convert_element), "mix-matrix", &v);
+  g_value_unset (&v);
+}
+
+/* Add a voice playing a sound to the pipeline, and link it to a new
+ * input of the mixer.  */
+static gboolean
+add_voice (GstElement *pipeline_element, GstElement *mixer_element,
+           struct bench_sound *sound, GstCaps *output_caps)
+{
+  GstElement *looper_element, *convert2_element, *resample_element;
+  GstElement *envelope_element, *pan_element, *volume_element;
+  GstElement *convert3_element;
+  GstCaps *source_caps, *caps_filter1, *caps_filter2;
+  gint in_channels;
+  guint64 channel_mask, sound_length;
+  gboolean success;
+
+  looper_element = gst_element_factory_make ("looper", NULL);
+  convert2_element = gst_element_factory_make ("audioconvert", NULL);
+  resample_element = gst_element_factory_make ("audioresample", NULL);
+  envelope_element = gst_element_factory_make ("envelope", NULL);
+  pan_element = NULL;
+  if (channel_count <= 2)
+    pan_element = gst_element_factory_make ("audiopanorama", NULL);
+  volume_element = gst_element_factory_make ("volume", NULL);
+  convert3_element = gst_element_factory_make ("audioconvert", NULL);
+  if ((looper_element == NULL) || (envelope_element == NULL))
+    {
+      g_printerr ("Unable to create the looper and envelope elements; "
+                  "set GST_PLUGIN_PATH to where they were built.\n");
+      return FALSE;
+    }
+
+  channel_mask = channel_mask_for (channel_count);
+  source_caps =
+    gst_caps_new_simple ("audio/x-raw",
+                         "format", G_TYPE_STRING, format_string,
+                         "rate", G_TYPE_INT, sample_rate,
+                         "channels", G_TYPE_INT, channel_count,
+                         "channel-mask", GST_TYPE_BITMASK, channel_mask,
+                         "layout", G_TYPE_STRING, "interleaved", NULL);
+  g_object_set (looper_element, "caps", source_caps, "preload", TRUE,
+                "autostart", TRUE, NULL);
+  gst_caps_unref (source_caps);
+  if (loop)
+    {
+      sound_length = (guint64) (sound_seconds * GST_SECOND);
+      g_object_set (looper_element, "loop-from", sound_length, "loop-to",
+                    (guint64) 0, "loop-limit", 0, NULL);
+    }
+  g_object_set (looper_element, "preloaded-data", sound->data, NULL);
+  g_object_set (envelope_element, "autostart", TRUE, NULL);
+
+  in_channels = channel_count;
+  if ((channel_count == 1) && (pan_element != NULL))
+    in_channels = 2;
+  set_mix_matrix (convert3_element, in_channels, speaker_count);
+
+  gst_bin_add_many (GST_BIN (pipeline_element), looper_element,
+                    convert2_element, resample_element, envelope_element,
+                    volume_element, convert3_element, NULL);
+  if (pan_element != NULL)
+    gst_bin_add (GST_BIN (pipeline_element), pan_element);
+
+  caps_filter1 =
+    gst_caps_new_simple ("audio/x-raw",
+                         "format", G_TYPE_STRING, format_string,
+                         "channels", G_TYPE_INT, channel_count,
+                         "channel-mask", GST_TYPE_BITMASK, channel_mask,
+                         NULL);
+  caps_filter2 =
+    gst_caps_new_simple ("audio/x-raw",
+                         "format", G_TYPE_STRING, "F32LE",
+                         "channels", G_TYPE_INT, channel_count,
+                         "channel-mask", GST_TYPE_BITMASK, channel_mask,
+                         NULL);
+  success =
+    gst_element_link_filtered (looper_element, convert2_element,
+                               caps_filter1)
+    && gst_element_link_filtered (convert2_element, resample_element,
+                                  caps_filter2)
+    && gst_element_link (resample_element, envelope_element);
+  if (pan_element != NULL)
+    success = success
+      && gst_element_link_many (envelope_element, pan_element,
+                                volume_element, NULL);
+  else
+    success = success && gst_element_link (envelope_element, volume_element);
+  success = success
+    && gst_element_link (volume_element, convert3_element)
+    && gst_element_link_filtered (convert3_element, mixer_element,
+                                  output_caps);
+  gst_caps_unref (caps_filter1);
+  gst_caps_unref (caps_filter2);
+
+  if (!success)
+    g_printerr ("Unable to link a voice.\n");
+  return success;
+}
+
+/* Count the sound the mixer produces, and say when there is enough.
+ * This runs on the mixer's streaming thread.  */
+static GstPadProbeReturn
+count_output (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  struct bench_run *run = user_data;
+  GstBuffer *buffer;
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (GST_BUFFER_DURATION_IS_VALID (buffer))
+    run->produced = run->produced + GST_BUFFER_DURATION (buffer);
+  if ((run->produced >= run->wanted)
+      && g_atomic_int_compare_and_exchange (&run->done, 0, 1))
+    {
+      gst_element_post_message (run->pipeline_element,
+                                gst_message_new_application
+                                (GST_OBJECT (run->pipeline_element),
+                                 gst_structure_new_empty ("done")));
+    }
+  return GST_PAD_PROBE_OK;
+}
+
+/* Play some number of voices, spread over the sounds, and measure how
+ * fast the computer can mix them.  */
+static void
+measure (gint voices, struct bench_sound *sounds,
+         struct bench_result *result)
+{
+  GstElement *pipeline_element, *mixer_element, *level_element;
+  GstElement *volume_element, *wavenc_element, *sink_element;
+  GstCaps *output_caps;
+  GstPad *mixer_pad;
+  GstBus *bus;
+  GstMessage *message;
+  struct bench_run run;
+  gsize rss_before, rss_after;
+  gint64 start_time, end_time;
+  gdouble start_cpu, end_cpu;
+  gint voice;
+  gboolean success;
+
+  memset (result, 0, sizeof (*result));
+  result->voices = voices;
+  result->failed = TRUE;
+  rss_before = resident_bytes ();
+
+  pipeline_element = gst_pipeline_new ("bench");
+  mixer_element = gst_element_factory_make ("audiomixer", NULL);
+  level_element = gst_element_factory_make ("level", NULL);
+  volume_element = gst_element_factory_make ("volume", NULL);
+  wavenc_element = NULL;
+  if (output_file_name != NULL)
+    {
+      wavenc_element = gst_element_factory_make ("wavenc", NULL);
+      sink_element = gst_element_factory_make ("filesink", NULL);
+      g_object_set (sink_element, "location", output_file_name, NULL);
+    }
+  else
+    sink_element = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink_element, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline_element), mixer_element,
+                    level_element, volume_element, sink_element, NULL);
+
+  output_caps =
+    gst_caps_new_simple ("audio/x-raw",
+                         "format", G_TYPE_STRING, "F32LE",
+                         "rate", G_TYPE_INT, output_rate,
+                         "channels", G_TYPE_INT, speaker_count,
+                         "channel-mask", GST_TYPE_BITMASK,
+                         channel_mask_for (speaker_count),
+                         "layout", G_TYPE_STRING, "interleaved", NULL);
+  success =
+    gst_element_link_filtered (mixer_element, level_element, output_caps)
+    && gst_element_link (level_element, volume_element);
+  if (wavenc_element != NULL)
+    {
+      gst_bin_add (GST_BIN (pipeline_element), wavenc_element);
+      success = success
+        && gst_element_link_many (volume_element, wavenc_element,
+                                  sink_element, NULL);
+    }
+  else
+    success = success && gst_element_link (volume_element, sink_element);
+
+  for (voice = 0; success && (voice < voices); voice++)
+    success = add_voice (pipeline_element, mixer_element,
+                         &sounds[voice % sound_count], output_caps);
+  gst_caps_unref (output_caps);
+
+  run.pipeline_element = pipeline_element;
+  run.produced = 0;
+  run.wanted = (GstClockTime) (measure_seconds * GST_SECOND);
+  run.done = 0;
+  mixer_pad = gst_element_get_static_pad (mixer_element, "src");
+  gst_pad_add_probe (mixer_pad, GST_PAD_PROBE_TYPE_BUFFER, count_output,
+                     &run, NULL);
+  gst_object_unref (mixer_pad);
+
+  /* Let the pipeline build its buffers before we start the clock.  */
+  if (success)
+    {
+      gst_element_set_state (pipeline_element, GST_STATE_PAUSED);
+      success = (gst_element_get_state (pipeline_element, NULL, NULL,
+                                        GST_CLOCK_TIME_NONE)
+                 != GST_STATE_CHANGE_FAILURE);
+    }
+  rss_after = resident_bytes ();
+
+  if (success)
+    {
+      bus = gst_element_get_bus (pipeline_element);
+      start_time = g_get_monotonic_time ();
+      start_cpu = cpu_seconds_used ();
+      gst_element_set_state (pipeline_element, GST_STATE_PLAYING);
+      message =
+        gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+                                    GST_MESSAGE_APPLICATION
+                                    | GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+      end_time = g_get_monotonic_time ();
+      end_cpu = cpu_seconds_used ();
+      if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+        {
+          GError *error = NULL;
+
+          gst_message_parse_error (message, &error, NULL);
+          g_printerr ("Error from %s: %s.\n",
+                      GST_OBJECT_NAME (GST_MESSAGE_SRC (message)),
+                      error->message);
+          g_error_free (error);
+        }
+      else
+        {
+          result->failed = FALSE;
+          result->ended_early =
+            (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS);
+          result->audio_seconds = run.produced / (gdouble) GST_SECOND;
+          result->wall_seconds = (end_time - start_time) / 1e6;
+          result->cpu_seconds = end_cpu - start_cpu;
+          result->realtime_factor =
+            result->audio_seconds / result->wall_seconds;
+          result->sustainable = (result->realtime_factor >= headroom);
+          if (rss_after > rss_before)
+            result->rss_bytes_per_voice = (rss_after - rss_before) / voices;
+        }
+      gst_message_unref (message);
+      gst_object_unref (bus);
+    }
+
+  gst_element_set_state (pipeline_element, GST_STATE_NULL);
+  gst_object_unref (pipeline_element);
+}
+
+/* Write the measurement as a line of JSON.  The CPU use is per second
+ * of sound actually produced, which is less than asked for if the
+ * sounds do not loop and end early.  */
+static void
+report (const struct bench_result *result, gsize bytes_per_sound,
+        gdouble load_seconds)
+{
+  gdouble cpu_percent_per_voice;
+
+  cpu_percent_per_voice = 0.0;
+  if ((result->audio_seconds > 0.0) && (result->voices > 0))
+    cpu_percent_per_voice =
+      100.0 * result->cpu_seconds / result->audio_seconds / result->voices;
+
+  g_print ("{\"label\": \"%s\", \"sounds\": %d, \"voices\": %d, "
+           "\"format\": \"%s\", \"channels\": %d, \"rate\": %d, "
+           "\"output_rate\": %d, \"speakers\": %d, \"loop\": %s, "
+           "\"sound_seconds\": %.3f, \"audio_seconds\": %.3f, "
+           "\"load_seconds\": %.6f, \"bytes_per_sound\": %" G_GSIZE_FORMAT
+           ", \"rss_bytes_per_voice\": %" G_GSIZE_FORMAT
+           ", \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, "
+           "\"realtime_factor\": %.3f, \"cpu_percent_per_voice\": %.4f, "
+           "\"sustainable\": %s, \"ended_early\": %s, \"failed\": %s}\n",
+           label, sound_count, result->voices, format_string, channel_count,
+           sample_rate, output_rate, speaker_count, loop ? "true" : "false",
+           sound_seconds, result->audio_seconds, load_seconds, bytes_per_sound,
+           result->rss_bytes_per_voice, result->wall_seconds,
+           result->cpu_seconds, result->realtime_factor,
+           cpu_percent_per_voice, result->sustainable ? "true" : "false",
+           result->ended_early ? "true" : "false",
+           result->failed ? "true" : "false");
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  const GstAudioFormatInfo *finfo;
+  GstAudioFormat format;
+  struct bench_sound *sounds;
+  struct bench_result result;
+  gchar *directory_name, *base_name, *escaped_label;
+  gint64 start_time, end_time;
+  gdouble load_seconds;
+  gsize bytes_per_sound;
+  gint index, good, bad, middle;
+  gboolean success;
+  const GOptionEntry entries[] = {
+    {"sounds", 0, 0, G_OPTION_ARG_INT, &sound_count,
+     "the number of sounds in the project"},
+    {"voices", 0, 0, G_OPTION_ARG_INT, &voice_count,
+     "the number of voices to play; 0 means find the most"},
+    {"max-voices", 0, 0, G_OPTION_ARG_INT, &max_voices,
+     "the most voices to try when finding the most"},
+    {"channels", 0, 0, G_OPTION_ARG_INT, &channel_count,
+     "the number of channels in each sound"},
+    {"rate", 0, 0, G_OPTION_ARG_INT, &sample_rate,
+     "the sample rate of the sounds"},
+    {"output-rate", 0, 0, G_OPTION_ARG_INT, &output_rate,
+     "the sample rate of the mixer"},
+    {"speakers", 0, 0, G_OPTION_ARG_INT, &speaker_count,
+     "the number of speakers"},
+    {"format", 0, 0, G_OPTION_ARG_STRING, &format_string,
+     "the sample format of the sounds, such as S16LE or F32LE"},
+    {"sound-seconds", 0, 0, G_OPTION_ARG_DOUBLE, &sound_seconds,
+     "the length of each sound"},
+    {"no-loop", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &loop,
+     "play each sound once rather than looping it"},
+    {"seconds", 0, 0, G_OPTION_ARG_DOUBLE, &measure_seconds,
+     "the length of sound to mix for each measurement"},
+    {"headroom", 0, 0, G_OPTION_ARG_DOUBLE, &headroom,
+     "how many times faster than real time is sustainable"},
+    {"output-file", 0, 0, G_OPTION_ARG_FILENAME, &output_file_name,
+     "write the mix to this WAV file rather than discarding it"},
+    {"label", 0, 0, G_OPTION_ARG_STRING, &label,
+     "a name for this configuration in the results"},
+    {NULL,}
+  };
+
+  context = g_option_context_new ("- measure polyphony");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+  g_option_context_free (context);
+  gst_init (&argc, &argv);
+
+  if (format_string == NULL)
+    format_string = g_strdup ("S16LE");
+  format = gst_audio_format_from_string (format_string);
+  finfo = gst_audio_format_get_info (format);
+  if ((format == GST_AUDIO_FORMAT_UNKNOWN)
+      || (GST_AUDIO_FORMAT_INFO_WIDTH (finfo) % 8 != 0))
+    {
+      g_printerr ("Unknown sample format %s.\n", format_string);
+      return EXIT_FAILURE;
+    }
+  if ((sound_count < 1) || (channel_count < 1) || (channel_count > 8)
+      || (speaker_count < 1) || (speaker_count > 8) || (sample_rate < 1)
+      || (output_rate < 1) || (sound_seconds <= 0.0)
+      || (measure_seconds <= 0.0) || (max_voices < 1))
+    {
+      g_printerr ("The counts, rates and lengths must be positive, "
+                  "with no more than 8 channels or speakers.\n");
+      return EXIT_FAILURE;
+    }
+  escaped_label = g_strescape ((label == NULL) ? "" : label, NULL);
+  g_free (label);
+  label = escaped_label;
+
+  /* Write the project.  */
+  directory_name = g_dir_make_tmp ("polyphony_bench_XXXXXX", &error);
+  if (directory_name == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+  sounds = g_new0 (struct bench_sound, sound_count);
+  success = TRUE;
+  for (index = 0; success && (index < sound_count); index++)
+    {
+      base_name = g_strdup_printf ("sound_%d.wav", index);
+      sounds[index].file_name = g_build_filename (directory_name, base_name,
+                                                  NULL);
+      g_free (base_name);
+      success = write_sound (sounds[index].file_name, index, finfo);
+    }
+
+  /* Read it back, as the loader would.  */
+  start_time = g_get_monotonic_time ();
+  for (index = 0; success && (index < sound_count); index++)
+    success = read_sound (&sounds[index]);
+  end_time = g_get_monotonic_time ();
+  load_seconds = (end_time - start_time) / 1e6;
+  bytes_per_sound = 0;
+  if (success)
+    bytes_per_sound = gst_buffer_get_size (sounds[0].data);
+
+  if (success && (voice_count > 0))
+    {
+      measure (voice_count, sounds, &result);
+      report (&result, bytes_per_sound, load_seconds);
+      success = !result.failed;
+    }
+  else if (success)
+    {
+      /* Double the voices until they are too many, then search between
+       * the last count that was sustainable and the first that was not.
+       */
+      good = 0;
+      bad = max_voices + 1;
+      for (index = 1; index <= max_voices; index = index * 2)
+        {
+          measure (index, sounds, &result);
+          report (&result, bytes_per_sound, load_seconds);
+          if (result.failed || !result.sustainable)
+            {
+              bad = index;
+              break;
+            }
+          good = index;
+        }
+      if ((good > 0) && (good < max_voices) && (bad > max_voices))
+        {
+          measure (max_voices, sounds, &result);
+          report (&result, bytes_per_sound, load_seconds);
+          if (!result.failed && result.sustainable)
+            good = max_voices;
+          else
+            bad = max_voices;
+        }
+      while (bad - good > 1)
+        {
+          middle = (good + bad) / 2;
+          measure (middle, sounds, &result);
+          report (&result, bytes_per_sound, load_seconds);
+          if (!result.failed && result.sustainable)
+            good = middle;
+          else
+            bad = middle;
+        }
+      g_print ("{\"label\": \"%s\", \"max_polyphony\": %d}\n", label, good);
+    }
+
+  for (index = 0; index < sound_count; index++)
+    {
+      if (sounds[index].data != NULL)
+        gst_buffer_unref (sounds[index].data);
+      if (sounds[index].file_name != NULL)
+        g_unlink (sounds[index].file_name);
+      g_free (sounds[index].file_name);
+    }
+  g_free (sounds);
+  g_rmdir (directory_name);
+  g_free (directory_name);
+  g_free (label);
+  g_free (format_string);
+  g_free (output_file_name);
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/* End of file polyphony_bench.c */
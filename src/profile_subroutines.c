@@ -0,0 +1,578 @@
+/*
+ * profile_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include "profile_subroutines.h"
+#include "sound_effects_player.h"
+#include "trace_subroutines.h"
+#include "main.h"
+
+/* When the sound stutters, we need to know which element is taking
+ * the time: the looper, the envelope, the resampler, the mixer or the
+ * audio output.  Gstreamer calls tracer hooks before and after each
+ * buffer is pushed from one pad to the next.  A push runs the chain
+ * function of the element which receives the buffer, and within that
+ * any pushes that element makes downstream, so the time the receiving
+ * element spent on the buffer itself is the time of the push less the
+ * time of the pushes nested inside it.  That time includes any time
+ * the element waits, such as the sink waiting for the audio device,
+ * or the mixer waiting for room in its input.  We also record the
+ * longest push made by each element, which is the latency its output
+ * sees, and count the buffers each element receives.
+ *
+ * Every few seconds the main thread adds up the times, by element and
+ * by voice, and writes the greatest, along with the level of each
+ * queue, into the trace file.
+ *
+ * Tracer hooks cannot be removed once they are installed, so they are
+ * installed only if profiling is requested.  Otherwise Gstreamer does
+ * not call them at all and profiling costs nothing.  */
+
+#define TRACE_PROFILE FALSE
+
+/* How many elements and voices are listed in each summary.  */
+#define PROFILE_TOP_COUNT 8
+
+/* How deeply pushes may be nested on one streaming thread.  Pushes
+ * nested more deeply than this are counted in the push that holds
+ * them.  */
+#define PROFILE_STACK_DEPTH 32
+
+/* The persistent data used by the profile subroutines.  These are
+ * used only on the main thread.  */
+struct profile_info
+{
+  gint interval;                /* seconds between summaries */
+  guint summary_source;
+  gint64 last_summary_time;     /* monotonic microseconds */
+};
+
+/* The counts kept for each element, attached to the element.  Any
+ * streaming thread may update them, and the main thread takes them
+ * when it summarizes, so they are protected by a lock.  */
+struct profile_stats
+{
+  GMutex lock;
+  GstClockTime busy_time;       /* in this element's chain function */
+  guint64 buffer_count;         /* buffers received */
+  GstClockTime longest_push;    /* longest push from this element */
+};
+
+/* A push in progress on a streaming thread.  */
+struct profile_frame
+{
+  GstPad *pad;
+  GstClockTime start_time;
+  GstClockTime nested_time;     /* in pushes made during this one */
+};
+
+/* The pushes in progress on a streaming thread, innermost last.  */
+struct profile_stack
+{
+  gint depth;
+  struct profile_frame frames[PROFILE_STACK_DEPTH];
+};
+
+/* One line of a summary.  */
+struct profile_entry
+{
+  gchar *name;
+  GstClockTime busy_time;
+  guint64 buffer_count;
+  GstClockTime longest_push;
+};
+
+/* The tracer which receives the hooks.  It needs no state of its own.  */
+typedef struct
+{
+  GstTracer parent;
+} ProfileTracer;
+
+typedef struct
+{
+  GstTracerClass parent_class;
+} ProfileTracerClass;
+
+G_DEFINE_TYPE (ProfileTracer, profile_tracer, GST_TYPE_TRACER);
+
+static GQuark profile_stats_quark;
+static GPrivate profile_stack_key = G_PRIVATE_INIT (g_free);
+
+/* The hooks cannot be removed, so the tracer is kept until we exit.  */
+static GstTracer *installed_tracer = NULL;
+
+/* Set while profiling, so the hooks do nothing once we have finished.  */
+static gint profile_active = 0;
+
+static void
+profile_free_stats (gpointer data)
+{
+  struct profile_stats *stats = data;
+
+  g_mutex_clear (&stats->lock);
+  g_free (stats);
+  return;
+}
+
+/* Find the counts for an element, attaching them if it has none.  */
+static struct profile_stats *
+profile_get_stats (GstObject *object)
+{
+  struct profile_stats *stats, *new_stats;
+
+  stats = g_object_get_qdata (G_OBJECT (object), profile_stats_quark);
+  if (stats != NULL)
+    return (stats);
+
+  new_stats = g_malloc0 (sizeof (struct profile_stats));
+  g_mutex_init (&new_stats->lock);
+
+  /* Another streaming thread may be attaching counts to the same
+   * element, such as the mixer, which has an input from each voice.  */
+  if (g_object_replace_qdata (G_OBJECT (object), profile_stats_quark, NULL,
+                              new_stats, profile_free_stats, NULL))
+    return (new_stats);
+
+  profile_free_stats (new_stats);
+  stats = g_object_get_qdata (G_OBJECT (object), profile_stats_quark);
+  return (stats);
+}
+
+/* The element which owns a pad, or NULL if the pad belongs to a bin
+ * or to a ghost pad.  Bins do no processing of their own.  */
+static GstObject *
+profile_pad_element (GstPad *pad)
+{
+  GstObject *parent;
+
+  if (pad == NULL)
+    return (NULL);
+  parent = GST_OBJECT_PARENT (pad);
+  if ((parent == NULL) || !GST_IS_ELEMENT (parent) || GST_IS_BIN (parent))
+    return (NULL);
+  return (parent);
+}
+
+/* A buffer, or a list of buffers, is about to be pushed from a pad.
+ * This runs on the streaming thread.  */
+static void
+profile_push_pre (GObject *tracer, GstClockTime ts, GstPad *pad,
+                  gpointer buffer)
+{
+  struct profile_stack *stack;
+  struct profile_frame *frame;
+
+  if (g_atomic_int_get (&profile_active) == 0)
+    return;
+
+  stack = g_private_get (&profile_stack_key);
+  if (stack == NULL)
+    {
+      stack = g_malloc0 (sizeof (struct profile_stack));
+      g_private_set (&profile_stack_key, stack);
+    }
+
+  if (stack->depth < PROFILE_STACK_DEPTH)
+    {
+      frame = &stack->frames[stack->depth];
+      frame->pad = pad;
+      frame->start_time = ts;
+      frame->nested_time = 0;
+    }
+  stack->depth = stack->depth + 1;
+  return;
+}
+
+/* The push has returned.  Charge its time, less the time of the pushes
+ * made within it, to the element which received the buffer.  */
+static void
+profile_push_post (GObject *tracer, GstClockTime ts, GstPad *pad,
+                   GstFlowReturn result)
+{
+  struct profile_stack *stack;
+  struct profile_frame *frame;
+  struct profile_stats *stats;
+  GstObject *element;
+  GstClockTime elapsed_time;
+
+  stack = g_private_get (&profile_stack_key);
+  if ((stack == NULL) || (stack->depth == 0))
+    return;
+  stack->depth = stack->depth - 1;
+  if (stack->depth >= PROFILE_STACK_DEPTH)
+    return;
+
+  frame = &stack->frames[stack->depth];
+  if ((frame->pad != pad) || (g_atomic_int_get (&profile_active) == 0))
+    return;
+
+  elapsed_time = 0;
+  if (ts > frame->start_time)
+    elapsed_time = ts - frame->start_time;
+  if (stack->depth > 0)
+    {
+      stack->frames[stack->depth - 1].nested_time =
+        stack->frames[stack->depth - 1].nested_time + elapsed_time;
+    }
+
+  element = profile_pad_element (GST_PAD_PEER (pad));
+  if (element != NULL)
+    {
+      stats = profile_get_stats (element);
+      g_mutex_lock (&stats->lock);
+      if (elapsed_time > frame->nested_time)
+        stats->busy_time =
+          stats->busy_time + (elapsed_time - frame->nested_time);
+      stats->buffer_count = stats->buffer_count + 1;
+      g_mutex_unlock (&stats->lock);
+    }
+
+  element = profile_pad_element (pad);
+  if (element != NULL)
+    {
+      stats = profile_get_stats (element);
+      g_mutex_lock (&stats->lock);
+      if (elapsed_time > stats->longest_push)
+        stats->longest_push = elapsed_time;
+      g_mutex_unlock (&stats->lock);
+    }
+
+  return;
+}
+
+static void
+profile_tracer_class_init (ProfileTracerClass *klass)
+{
+  return;
+}
+
+static void
+profile_tracer_init (ProfileTracer *self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  gst_tracing_register_hook (tracer, "pad-push-pre",
+                             G_CALLBACK (profile_push_pre));
+  gst_tracing_register_hook (tracer, "pad-push-post",
+                             G_CALLBACK (profile_push_post));
+  gst_tracing_register_hook (tracer, "pad-push-list-pre",
+                             G_CALLBACK (profile_push_pre));
+  gst_tracing_register_hook (tracer, "pad-push-list-post",
+                             G_CALLBACK (profile_push_post));
+  return;
+}
+
+/* Sort summary lines so the busiest comes first.  */
+static gint
+profile_compare_entries (gconstpointer a, gconstpointer b)
+{
+  const struct profile_entry *entry_a = a;
+  const struct profile_entry *entry_b = b;
+
+  if (entry_a->busy_time > entry_b->busy_time)
+    return (-1);
+  if (entry_a->busy_time < entry_b->busy_time)
+    return (1);
+  return (0);
+}
+
+static void
+profile_free_entry (gpointer data)
+{
+  struct profile_entry *entry = data;
+
+  g_free (entry->name);
+  return;
+}
+
+static void
+profile_free_voice (gpointer data)
+{
+  profile_free_entry (data);
+  g_free (data);
+  return;
+}
+
+/* Write a line of the summary into the trace file.  */
+static void
+profile_write (GApplication *app, const gchar *format, ...)
+{
+  va_list args;
+  gchar *line;
+
+  va_start (args, format);
+  line = g_strdup_vprintf (format, args);
+  va_end (args);
+  if (TRACE_PROFILE)
+    {
+      g_print ("%s\n", line);
+    }
+  trace_sequencer_write (line, app);
+  g_free (line);
+  return;
+}
+
+/* Take an element's counts, clearing them for the next summary, and
+ * add them to the element and voice lists.  */
+static void
+profile_take_element (GstElement *element, GArray *elements,
+                      GHashTable *voices)
+{
+  struct profile_stats *stats;
+  struct profile_entry entry, *voice_entry;
+  GstObject *parent;
+
+  stats = g_object_get_qdata (G_OBJECT (element), profile_stats_quark);
+  if (stats == NULL)
+    return;
+
+  g_mutex_lock (&stats->lock);
+  entry.busy_time = stats->busy_time;
+  entry.buffer_count = stats->buffer_count;
+  entry.longest_push = stats->longest_push;
+  stats->busy_time = 0;
+  stats->buffer_count = 0;
+  stats->longest_push = 0;
+  g_mutex_unlock (&stats->lock);
+
+  if ((entry.buffer_count == 0) && (entry.longest_push == 0))
+    return;
+  entry.name = gst_object_get_name (GST_OBJECT (element));
+  g_array_append_val (elements, entry);
+
+  /* Each voice of each sound has its own bin.  */
+  parent = GST_OBJECT_PARENT (element);
+  if ((parent == NULL) || !GST_IS_BIN (parent) || GST_IS_PIPELINE (parent))
+    return;
+  voice_entry = g_hash_table_lookup (voices, GST_OBJECT_NAME (parent));
+  if (voice_entry == NULL)
+    {
+      voice_entry = g_malloc0 (sizeof (struct profile_entry));
+      voice_entry->name = gst_object_get_name (parent);
+      g_hash_table_insert (voices, voice_entry->name, voice_entry);
+    }
+  voice_entry->busy_time = voice_entry->busy_time + entry.busy_time;
+  voice_entry->buffer_count = voice_entry->buffer_count + entry.buffer_count;
+  if (entry.longest_push > voice_entry->longest_push)
+    voice_entry->longest_push = entry.longest_push;
+  return;
+}
+
+/* Report how full a queue is.  */
+static void
+profile_report_queue (GstElement *element, GApplication *app)
+{
+  GstElementFactory *factory;
+  guint level_buffers;
+  guint64 level_time;
+
+  factory = gst_element_get_factory (element);
+  if ((factory == NULL)
+      || (g_strcmp0 (GST_OBJECT_NAME (factory), "queue") != 0))
+    return;
+
+  g_object_get (element, "current-level-buffers", &level_buffers,
+                "current-level-time", &level_time, NULL);
+  profile_write (app, "profile queue %s: %u buffers, %.3f ms.",
+                 GST_OBJECT_NAME (element), level_buffers,
+                 (gdouble) level_time / GST_MSECOND);
+  return;
+}
+
+/* Summarize the time spent since the last summary into the trace
+ * file.  */
+static gboolean
+profile_summarize (gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct profile_info *profile_data;
+  GstPipeline *pipeline_element;
+  GstIterator *bin_iterator;
+  GstElement *this_element;
+  GArray *elements, *voice_entries;
+  GHashTable *voices;
+  GHashTableIter voice_iter;
+  gpointer voice_value;
+  struct profile_entry *entry;
+  GstClockTime total_time;
+  gint64 now;
+  gdouble interval_ms;
+  gboolean done;
+  guint index;
+  GValue item = G_VALUE_INIT;
+
+  profile_data = sep_get_profile_data (app);
+  pipeline_element = sep_get_pipeline_from_app (app);
+  if ((profile_data == NULL) || (pipeline_element == NULL))
+    return G_SOURCE_CONTINUE;
+
+  now = g_get_monotonic_time ();
+  interval_ms = (gdouble) (now - profile_data->last_summary_time) / 1000.0;
+  profile_data->last_summary_time = now;
+
+  elements = g_array_new (FALSE, FALSE, sizeof (struct profile_entry));
+  g_array_set_clear_func (elements, profile_free_entry);
+  voices = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                  profile_free_voice);
+
+  bin_iterator = gst_bin_iterate_recurse (GST_BIN (pipeline_element));
+  done = FALSE;
+  while (!done)
+    {
+      switch (gst_iterator_next (bin_iterator, &item))
+        {
+        case GST_ITERATOR_OK:
+          this_element = GST_ELEMENT (g_value_get_object (&item));
+          if (!GST_IS_BIN (this_element))
+            {
+              profile_take_element (this_element, elements, voices);
+              profile_report_queue (this_element, app);
+            }
+          g_value_reset (&item);
+          break;
+        case GST_ITERATOR_RESYNC:
+          /* Counts already taken were cleared, so taking them again
+           * does not count them twice.  */
+          gst_iterator_resync (bin_iterator);
+          break;
+        case GST_ITERATOR_ERROR:
+        case GST_ITERATOR_DONE:
+          done = TRUE;
+          break;
+        }
+    }
+  g_value_unset (&item);
+  gst_iterator_free (bin_iterator);
+
+  total_time = 0;
+  for (index = 0; index < elements->len; index++)
+    {
+      entry = &g_array_index (elements, struct profile_entry, index);
+      total_time = total_time + entry->busy_time;
+    }
+  profile_write (app, "profile: %.3f ms in %u elements over %.0f ms, "
+                 "%.1f%% of one processor.",
+                 (gdouble) total_time / GST_MSECOND, elements->len,
+                 interval_ms,
+                 (interval_ms > 0) ?
+                 (100.0 * total_time / GST_MSECOND / interval_ms) : 0.0);
+
+  g_array_sort (elements, profile_compare_entries);
+  for (index = 0; (index < elements->len) && (index < PROFILE_TOP_COUNT);
+       index++)
+    {
+      entry = &g_array_index (elements, struct profile_entry, index);
+      profile_write (app, "profile element %s: %.3f ms, %" G_GUINT64_FORMAT
+                     " buffers, longest push %.3f ms.", entry->name,
+                     (gdouble) entry->busy_time / GST_MSECOND,
+                     entry->buffer_count,
+                     (gdouble) entry->longest_push / GST_MSECOND);
+    }
+
+  voice_entries = g_array_new (FALSE, FALSE, sizeof (struct profile_entry));
+  g_hash_table_iter_init (&voice_iter, voices);
+  while (g_hash_table_iter_next (&voice_iter, NULL, &voice_value))
+    {
+      entry = voice_value;
+      g_array_append_val (voice_entries, *entry);
+    }
+  g_array_sort (voice_entries, profile_compare_entries);
+  for (index = 0;
+       (index < voice_entries->len) && (index < PROFILE_TOP_COUNT); index++)
+    {
+      entry = &g_array_index (voice_entries, struct profile_entry, index);
+      profile_write (app, "profile voice %s: %.3f ms, %" G_GUINT64_FORMAT
+                     " buffers, longest push %.3f ms.", entry->name,
+                     (gdouble) entry->busy_time / GST_MSECOND,
+                     entry->buffer_count,
+                     (gdouble) entry->longest_push / GST_MSECOND);
+    }
+
+  /* The voice entries share their names with the hash table.  */
+  g_array_free (voice_entries, TRUE);
+  g_hash_table_destroy (voices);
+  g_array_free (elements, TRUE);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Start profiling the pipeline, if requested.  */
+void *
+profile_init (GApplication *app)
+{
+  struct profile_info *profile_data;
+
+  profile_data = g_malloc0 (sizeof (struct profile_info));
+  profile_data->interval = main_get_trace_profile_interval ();
+  if (profile_data->interval <= 0)
+    return (profile_data);
+
+  /* The summaries go into the trace file, so without one there is no
+   * point in profiling.  */
+  if (!trace_file_open (app))
+    {
+      g_printerr ("Profiling requires a trace file.\n");
+      profile_data->interval = 0;
+      return (profile_data);
+    }
+
+  /* Creating the tracer installs its hooks.  */
+  if (installed_tracer == NULL)
+    {
+      profile_stats_quark = g_quark_from_static_string ("profile-stats");
+      installed_tracer =
+        gst_object_ref_sink (g_object_new (profile_tracer_get_type (), NULL));
+    }
+  g_atomic_int_set (&profile_active, 1);
+
+  profile_data->last_summary_time = g_get_monotonic_time ();
+  profile_data->summary_source =
+    g_timeout_add_seconds (profile_data->interval, profile_summarize, app);
+  if (TRACE_PROFILE)
+    {
+      g_print ("Profiling every %d seconds.\n", profile_data->interval);
+    }
+  return (profile_data);
+}
+
+/* Stop profiling and deallocate the profile subroutines' persistent
+ * data.  */
+void
+profile_finish (GApplication *app)
+{
+  struct profile_info *profile_data;
+
+  profile_data = sep_get_profile_data (app);
+  if (profile_data == NULL)
+    return;
+
+  g_atomic_int_set (&profile_active, 0);
+  if (profile_data->summary_source != 0)
+    {
+      g_source_remove (profile_data->summary_source);
+      profile_data->summary_source = 0;
+    }
+  g_free (profile_data);
+  return;
+}
+
+/* End of file profile_subroutines.c */
@@ -0,0 +1,31 @@
+/*
+ * profile_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+/* Subroutines defined in profile_subroutines.c */
+
+/* Start profiling the pipeline into the trace file, if requested.  */
+void *profile_init (GApplication *app);
+
+/* Stop summarizing the profile and deallocate its persistent data.  */
+void profile_finish (GApplication *app);
+
+/* End of file profile_subroutines.h */
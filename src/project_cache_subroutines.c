@@ -0,0 +1,985 @@
+/*
+ * project_cache_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <sys/stat.h>
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include "project_cache_subroutines.h"
+#include "main.h"
+#include "network_subroutines.h"
+#include "sequence_structure.h"
+#include "sequence_subroutines.h"
+#include "sound_effects_player.h"
+#include "sound_structure.h"
+#include "sound_subroutines.h"
+
+/* Reading a large project means parsing several XML files and opening
+ * every WAV file to read its header.  To start quickly, we save what
+ * we learned in a binary file in the user's cache directory, and read
+ * that instead the next time the same project is loaded.  The cache
+ * records the size and modification time of every file we read,
+ * including the WAV files and any files which were missing, so a
+ * change to any of them causes the project to be parsed again and
+ * the cache to be rewritten.
+ *
+ * The cache file is used only on the computer that wrote it, so
+ * numbers are stored in the computer's native byte order.  Its header
+ * includes a byte order mark and the program version, and a cache
+ * written by any other version of the program is ignored.  */
+
+#define TRACE_PROJECT_CACHE FALSE
+
+/* Increment this whenever the layout of the cache file changes.  */
+#define PROJECT_CACHE_FORMAT 4
+
+#define PROJECT_CACHE_MAGIC "SEPCACHE"
+#define PROJECT_CACHE_BYTE_ORDER 0x01020304
+#define PROJECT_CACHE_TRAILER 0x454e4421
+
+/* A string length which means the string pointer was NULL.  */
+#define PROJECT_CACHE_NULL_STRING G_MAXUINT32
+
+/* A file we read while parsing the project.  */
+struct project_cache_dependency
+{
+  gchar *file_name;
+  gint64 size;                  /* -1 if the file did not exist */
+  gint64 modification_time;     /* nanoseconds since the epoch */
+};
+
+/* The persistent data used by the project cache subroutines.  */
+struct project_cache_info
+{
+  gboolean enabled;
+  gboolean recording;           /* the XML parser is reading a project */
+  GList *dependencies;          /* the files it has read */
+  gint64 port_number;           /* 0 if the project did not specify */
+  gchar *port_file_name;
+  gint64 speaker_count;         /* 0 if the project did not specify */
+  gchar *speaker_count_file_name;
+};
+
+/* Used to read the mapped cache file.  Reading past the end of the
+ * file sets the error flag and returns zeros, so the caller can check
+ * for errors once, after reading a whole record.  */
+struct project_cache_reader
+{
+  const guchar *data;
+  gsize length;
+  gsize offset;
+  gboolean error;
+};
+
+/* The names of the sample formats.  sound_parse_wav_file_header
+ * points the format name of a sound at one of these constant strings,
+ * so we do the same when reading a sound from the cache.  */
+static const gchar *const format_names[] = {
+  "U8", "S16LE", "S24LE", "S32LE", "F32LE", "F64LE", NULL
+};
+
+/* Initialize the project cache subroutines.  */
+void *
+project_cache_init (GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+
+  project_cache_data = g_malloc (sizeof (struct project_cache_info));
+  project_cache_data->enabled = !main_get_no_project_cache ();
+  project_cache_data->recording = FALSE;
+  project_cache_data->dependencies = NULL;
+  project_cache_data->port_number = 0;
+  project_cache_data->port_file_name = NULL;
+  project_cache_data->speaker_count = 0;
+  project_cache_data->speaker_count_file_name = NULL;
+
+  return (project_cache_data);
+}
+
+/* Free a dependency.  */
+static void
+free_dependency (gpointer data)
+{
+  struct project_cache_dependency *dependency = data;
+
+  g_free (dependency->file_name);
+  g_free (dependency);
+  return;
+}
+
+/* Forget what was recorded about the last project.  */
+static void
+forget_project (struct project_cache_info *project_cache_data)
+{
+  g_list_free_full (project_cache_data->dependencies, free_dependency);
+  project_cache_data->dependencies = NULL;
+  project_cache_data->port_number = 0;
+  g_free (project_cache_data->port_file_name);
+  project_cache_data->port_file_name = NULL;
+  project_cache_data->speaker_count = 0;
+  g_free (project_cache_data->speaker_count_file_name);
+  project_cache_data->speaker_count_file_name = NULL;
+  project_cache_data->recording = FALSE;
+  return;
+}
+
+/* Deallocate the project cache subroutines' persistent data.  */
+void
+project_cache_finish (GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  if (project_cache_data == NULL)
+    return;
+
+  forget_project (project_cache_data);
+  g_free (project_cache_data);
+  return;
+}
+
+/* Construct the name of the cache file for a project.  Projects are
+ * distinguished by a hash of the project file name.  */
+static gchar *
+cache_file_name (gchar *project_file_name)
+{
+  gchar *checksum;
+  gchar *base_name;
+  gchar *file_name;
+
+  checksum =
+    g_compute_checksum_for_string (G_CHECKSUM_SHA1, project_file_name, -1);
+  base_name = g_strconcat (checksum, ".cache", NULL);
+  file_name = g_build_filename (g_get_user_cache_dir (),
+                                (gchar *) "sound_effects_player",
+                                base_name, NULL);
+  g_free (base_name);
+  g_free (checksum);
+  return (file_name);
+}
+
+/* Find the size and modification time of a file.  A file which does
+ * not exist has size -1.  */
+static void
+stat_file (const gchar *file_name, gint64 *size, gint64 *modification_time)
+{
+  GStatBuf stat_buf;
+
+  if (g_stat (file_name, &stat_buf) != 0)
+    {
+      *size = -1;
+      *modification_time = 0;
+      return;
+    }
+  *size = stat_buf.st_size;
+  *modification_time =
+    ((gint64) stat_buf.st_mtim.tv_sec * G_GINT64_CONSTANT (1000000000)) +
+    stat_buf.st_mtim.tv_nsec;
+  return;
+}
+
+/* Subroutines to write the cache file.  */
+
+static void
+write_uint32 (GByteArray *buffer, guint32 value)
+{
+  g_byte_array_append (buffer, (guint8 *) &value, sizeof (value));
+  return;
+}
+
+static void
+write_int32 (GByteArray *buffer, gint32 value)
+{
+  g_byte_array_append (buffer, (guint8 *) &value, sizeof (value));
+  return;
+}
+
+static void
+write_int64 (GByteArray *buffer, gint64 value)
+{
+  g_byte_array_append (buffer, (guint8 *) &value, sizeof (value));
+  return;
+}
+
+static void
+write_uint64 (GByteArray *buffer, guint64 value)
+{
+  g_byte_array_append (buffer, (guint8 *) &value, sizeof (value));
+  return;
+}
+
+static void
+write_double (GByteArray *buffer, gdouble value)
+{
+  g_byte_array_append (buffer, (guint8 *) &value, sizeof (value));
+  return;
+}
+
+static void
+write_string (GByteArray *buffer, const gchar *value)
+{
+  guint32 length;
+
+  if (value == NULL)
+    {
+      write_uint32 (buffer, PROJECT_CACHE_NULL_STRING);
+      return;
+    }
+  length = strlen (value);
+  write_uint32 (buffer, length);
+  g_byte_array_append (buffer, (const guint8 *) value, length);
+  return;
+}
+
+/* Write a sound, including its channels and speakers.  */
+static void
+write_sound (GByteArray *buffer, struct sound_info *sound_data)
+{
+  GList *channel_list, *speaker_list;
+  struct channel_info *channel_data;
+  struct speaker_info *speaker_data;
+
+  write_string (buffer, sound_data->name);
+  write_int32 (buffer, sound_data->disabled);
+  write_string (buffer, sound_data->wav_file_name);
+  write_string (buffer, sound_data->wav_file_name_full);
+  write_uint64 (buffer, sound_data->attack_duration_time);
+  write_double (buffer, sound_data->attack_level);
+  write_uint64 (buffer, sound_data->decay_duration_time);
+  write_double (buffer, sound_data->sustain_level);
+  write_uint64 (buffer, sound_data->release_start_time);
+  write_uint64 (buffer, sound_data->release_duration_time);
+  write_int32 (buffer, sound_data->release_duration_infinite);
+  write_int64 (buffer, sound_data->loop_from_time);
+  write_int64 (buffer, sound_data->loop_to_time);
+  write_int32 (buffer, sound_data->loop_limit);
+  write_uint64 (buffer, sound_data->max_duration_time);
+  write_uint64 (buffer, sound_data->start_time);
+  write_double (buffer, sound_data->designer_volume_level);
+  write_double (buffer, sound_data->designer_pan);
+  write_double (buffer, sound_data->default_volume_level);
+  write_int32 (buffer, sound_data->MIDI_program_number);
+  write_int32 (buffer, sound_data->MIDI_program_number_specified);
+  write_int32 (buffer, sound_data->MIDI_note_number);
+  write_int32 (buffer, sound_data->MIDI_note_number_specified);
+  write_string (buffer, sound_data->function_key);
+  write_int32 (buffer, sound_data->function_key_specified);
+  write_int32 (buffer, sound_data->omit_panning);
+  write_int32 (buffer, sound_data->compact_storage);
+  write_int32 (buffer, sound_data->compact_storage_specified);
+  write_string (buffer, sound_data->format_name);
+  write_int32 (buffer, sound_data->channel_count);
+  write_int32 (buffer, sound_data->sample_rate);
+  write_int32 (buffer, sound_data->max_voices);
+
+  write_uint32 (buffer, g_list_length (sound_data->channels));
+  for (channel_list = sound_data->channels; channel_list != NULL;
+       channel_list = channel_list->next)
+    {
+      channel_data = channel_list->data;
+      write_int32 (buffer, channel_data->number);
+      write_uint32 (buffer, g_list_length (channel_data->speakers));
+      for (speaker_list = channel_data->speakers; speaker_list != NULL;
+           speaker_list = speaker_list->next)
+        {
+          speaker_data = speaker_list->data;
+          write_string (buffer, speaker_data->name);
+          write_int32 (buffer, speaker_data->speaker_code);
+          write_int32 (buffer, speaker_data->output_channel);
+          write_double (buffer, speaker_data->volume_level);
+        }
+    }
+  return;
+}
+
+/* Write a sequence item.  */
+static void
+write_sequence_item (GByteArray *buffer, struct sequence_item_info *item)
+{
+  write_string (buffer, item->name);
+  write_uint32 (buffer, item->type);
+  write_string (buffer, item->sound_name);
+  write_string (buffer, item->tag);
+  write_uint32 (buffer, item->use_external_velocity);
+  write_double (buffer, item->volume);
+  write_double (buffer, item->pan);
+  write_uint32 (buffer, item->program_number);
+  write_uint32 (buffer, item->bank_number);
+  write_uint32 (buffer, item->cluster_number);
+  write_int32 (buffer, item->cluster_number_specified);
+  write_string (buffer, item->next_completion);
+  write_string (buffer, item->next_termination);
+  write_string (buffer, item->next_starts);
+  write_string (buffer, item->next_sound_stopped);
+  write_string (buffer, item->next_release_started);
+  write_uint32 (buffer, item->importance);
+  write_string (buffer, item->Q_number);
+  write_string (buffer, item->text_to_display);
+  write_string (buffer, item->next);
+  write_uint64 (buffer, item->time_to_wait);
+  write_string (buffer, item->next_to_start);
+  write_string (buffer, item->next_play);
+  write_int32 (buffer, item->MIDI_program_number);
+  write_int32 (buffer, item->MIDI_note_number);
+  write_int32 (buffer, item->MIDI_note_number_specified);
+  write_uint32 (buffer, item->OSC_cue_number);
+  write_int32 (buffer, item->OSC_cue_number_specified);
+  write_string (buffer, item->OSC_cue_string);
+  write_int32 (buffer, item->OSC_cue_string_specified);
+  write_uint32 (buffer, item->macro_number);
+  write_string (buffer, item->function_key);
+  write_int32 (buffer, item->omit_from_display);
+  return;
+}
+
+/* Subroutines to read the cache file.  */
+
+static const guchar *
+read_bytes (struct project_cache_reader *reader, gsize length)
+{
+  const guchar *bytes;
+
+  if (reader->error || (length > reader->length - reader->offset))
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+  bytes = reader->data + reader->offset;
+  reader->offset = reader->offset + length;
+  return (bytes);
+}
+
+static guint32
+read_uint32 (struct project_cache_reader *reader)
+{
+  const guchar *bytes;
+  guint32 value;
+
+  bytes = read_bytes (reader, sizeof (value));
+  if (bytes == NULL)
+    return 0;
+  memcpy (&value, bytes, sizeof (value));
+  return (value);
+}
+
+static gint32
+read_int32 (struct project_cache_reader *reader)
+{
+  const guchar *bytes;
+  gint32 value;
+
+  bytes = read_bytes (reader, sizeof (value));
+  if (bytes == NULL)
+    return 0;
+  memcpy (&value, bytes, sizeof (value));
+  return (value);
+}
+
+static gint64
+read_int64 (struct project_cache_reader *reader)
+{
+  const guchar *bytes;
+  gint64 value;
+
+  bytes = read_bytes (reader, sizeof (value));
+  if (bytes == NULL)
+    return 0;
+  memcpy (&value, bytes, sizeof (value));
+  return (value);
+}
+
+static guint64
+read_uint64 (struct project_cache_reader *reader)
+{
+  const guchar *bytes;
+  guint64 value;
+
+  bytes = read_bytes (reader, sizeof (value));
+  if (bytes == NULL)
+    return 0;
+  memcpy (&value, bytes, sizeof (value));
+  return (value);
+}
+
+static gdouble
+read_double (struct project_cache_reader *reader)
+{
+  const guchar *bytes;
+  gdouble value;
+
+  bytes = read_bytes (reader, sizeof (value));
+  if (bytes == NULL)
+    return 0.0;
+  memcpy (&value, bytes, sizeof (value));
+  return (value);
+}
+
+/* Read a string into newly allocated storage.  */
+static gchar *
+read_string (struct project_cache_reader *reader)
+{
+  guint32 length;
+  const guchar *bytes;
+
+  length = read_uint32 (reader);
+  if (reader->error || (length == PROJECT_CACHE_NULL_STRING))
+    return NULL;
+  bytes = read_bytes (reader, length);
+  if (bytes == NULL)
+    return NULL;
+  return (g_strndup ((const gchar *) bytes, length));
+}
+
+/* Read a count of records.  A count larger than the rest of the file
+ * could hold means the file is damaged.  */
+static guint32
+read_count (struct project_cache_reader *reader)
+{
+  guint32 count;
+
+  count = read_uint32 (reader);
+  if (count > reader->length - reader->offset)
+    {
+      reader->error = TRUE;
+      return 0;
+    }
+  return (count);
+}
+
+/* Read a sound, including its channels and speakers.  */
+static struct sound_info *
+read_sound (struct project_cache_reader *reader)
+{
+  struct sound_info *sound_data;
+  struct channel_info *channel_data;
+  struct speaker_info *speaker_data;
+  guint32 channel_count, speaker_count;
+  guint32 channel_index, speaker_index;
+  gchar *format_name;
+  gint format_index;
+
+  /* Fields which are filled in at run time start as zero or NULL.  */
+  sound_data = g_malloc0 (sizeof (struct sound_info));
+
+  sound_data->name = read_string (reader);
+  sound_data->disabled = read_int32 (reader);
+  sound_data->wav_file_name = read_string (reader);
+  sound_data->wav_file_name_full = read_string (reader);
+  sound_data->attack_duration_time = read_uint64 (reader);
+  sound_data->attack_level = read_double (reader);
+  sound_data->decay_duration_time = read_uint64 (reader);
+  sound_data->sustain_level = read_double (reader);
+  sound_data->release_start_time = read_uint64 (reader);
+  sound_data->release_duration_time = read_uint64 (reader);
+  sound_data->release_duration_infinite = read_int32 (reader);
+  sound_data->loop_from_time = read_int64 (reader);
+  sound_data->loop_to_time = read_int64 (reader);
+  sound_data->loop_limit = read_int32 (reader);
+  sound_data->max_duration_time = read_uint64 (reader);
+  sound_data->start_time = read_uint64 (reader);
+  sound_data->designer_volume_level = read_double (reader);
+  sound_data->designer_pan = read_double (reader);
+  sound_data->default_volume_level = read_double (reader);
+  sound_data->MIDI_program_number = read_int32 (reader);
+  sound_data->MIDI_program_number_specified = read_int32 (reader);
+  sound_data->MIDI_note_number = read_int32 (reader);
+  sound_data->MIDI_note_number_specified = read_int32 (reader);
+  sound_data->function_key = read_string (reader);
+  sound_data->function_key_specified = read_int32 (reader);
+  sound_data->omit_panning = read_int32 (reader);
+  sound_data->compact_storage = read_int32 (reader);
+  sound_data->compact_storage_specified = read_int32 (reader);
+  sound_data->storage_format_name = NULL;
+
+  format_name = read_string (reader);
+  sound_data->format_name = NULL;
+  for (format_index = 0; format_names[format_index] != NULL; format_index++)
+    {
+      if (g_strcmp0 (format_name, format_names[format_index]) == 0)
+        {
+          sound_data->format_name = (gchar *) format_names[format_index];
+          break;
+        }
+    }
+  g_free (format_name);
+  format_name = NULL;
+  sound_data->channel_count = read_int32 (reader);
+  sound_data->sample_rate = read_int32 (reader);
+  sound_data->max_voices = read_int32 (reader);
+
+  /* The channel and speaker lists are written in list order, so
+   * building them with append preserves that order.  */
+  channel_count = read_count (reader);
+  for (channel_index = 0; channel_index < channel_count; channel_index++)
+    {
+      channel_data = g_malloc (sizeof (struct channel_info));
+      channel_data->number = read_int32 (reader);
+      channel_data->speakers = NULL;
+      sound_data->channels =
+        g_list_append (sound_data->channels, channel_data);
+      speaker_count = read_count (reader);
+      for (speaker_index = 0; speaker_index < speaker_count; speaker_index++)
+        {
+          speaker_data = g_malloc (sizeof (struct speaker_info));
+          speaker_data->name = read_string (reader);
+          speaker_data->speaker_code = read_int32 (reader);
+          speaker_data->output_channel = read_int32 (reader);
+          speaker_data->volume_level = read_double (reader);
+          channel_data->speakers =
+            g_list_append (channel_data->speakers, speaker_data);
+        }
+    }
+
+  /* These fields are set at run time.  */
+  sound_data->sound_control = NULL;
+  sound_data->looper_element = NULL;
+  sound_data->elapsed_time = 0;
+  sound_data->remaining_time = G_MAXUINT64;
+  sound_data->wav_file_time = 0;
+  sound_data->cluster_widget = NULL;
+  sound_data->cluster_number = 0;
+  sound_data->running = FALSE;
+  sound_data->release_sent = FALSE;
+  sound_data->release_has_started = FALSE;
+  sound_data->channel_mask = 0;
+  sound_data->voices = NULL;
+  sound_data->stolen = FALSE;
+
+  return (sound_data);
+}
+
+/* Read a sequence item.  */
+static struct sequence_item_info *
+read_sequence_item (struct project_cache_reader *reader)
+{
+  struct sequence_item_info *item;
+
+  item = g_malloc0 (sizeof (struct sequence_item_info));
+  item->name = read_string (reader);
+  item->type = read_uint32 (reader);
+  item->sound_name = read_string (reader);
+  item->tag = read_string (reader);
+  item->use_external_velocity = read_uint32 (reader);
+  item->volume = read_double (reader);
+  item->pan = read_double (reader);
+  item->program_number = read_uint32 (reader);
+  item->bank_number = read_uint32 (reader);
+  item->cluster_number = read_uint32 (reader);
+  item->cluster_number_specified = read_int32 (reader);
+  item->next_completion = read_string (reader);
+  item->next_termination = read_string (reader);
+  item->next_starts = read_string (reader);
+  item->next_sound_stopped = read_string (reader);
+  item->next_release_started = read_string (reader);
+  item->importance = read_uint32 (reader);
+  item->Q_number = read_string (reader);
+  item->text_to_display = read_string (reader);
+  item->next = read_string (reader);
+  item->time_to_wait = read_uint64 (reader);
+  item->next_to_start = read_string (reader);
+  item->next_play = read_string (reader);
+  item->MIDI_program_number = read_int32 (reader);
+  item->MIDI_note_number = read_int32 (reader);
+  item->MIDI_note_number_specified = read_int32 (reader);
+  item->OSC_cue_number = read_uint32 (reader);
+  item->OSC_cue_number_specified = read_int32 (reader);
+  item->OSC_cue_string = read_string (reader);
+  item->OSC_cue_string_specified = read_int32 (reader);
+  item->macro_number = read_uint32 (reader);
+  item->function_key = read_string (reader);
+  item->omit_from_display = read_int32 (reader);
+
+  return (item);
+}
+
+/* Load a project from its cache, if the cache is still valid.
+ * Returns TRUE if the project was loaded.  If it returns FALSE,
+ * nothing has been changed and the project must be parsed.  */
+gboolean
+project_cache_load (gchar *project_file_name, GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+  gchar *file_name;
+  GMappedFile *mapped_file;
+  GError *error = NULL;
+  struct project_cache_reader reader;
+  const guchar *magic;
+  gchar *string_value;
+  guint32 count, index;
+  gint64 size, modification_time, current_size, current_modification_time;
+  gint64 port_number, speaker_count;
+  gchar *port_file_name, *speaker_count_file_name;
+  GList *sounds, *items, *list_element;
+  gboolean valid;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  if (!project_cache_data->enabled)
+    return FALSE;
+
+  file_name = cache_file_name (project_file_name);
+  mapped_file = g_mapped_file_new (file_name, FALSE, &error);
+  if (mapped_file == NULL)
+    {
+      /* The usual reason is that the project has not been cached.  */
+      if (TRACE_PROJECT_CACHE)
+        {
+          g_print ("No project cache %s: %s.\n", file_name, error->message);
+        }
+      g_error_free (error);
+      error = NULL;
+      g_free (file_name);
+      return FALSE;
+    }
+
+  reader.data = (const guchar *) g_mapped_file_get_contents (mapped_file);
+  reader.length = g_mapped_file_get_length (mapped_file);
+  reader.offset = 0;
+  reader.error = FALSE;
+  sounds = NULL;
+  items = NULL;
+  port_file_name = NULL;
+  speaker_count_file_name = NULL;
+  valid = FALSE;
+
+  /* Check the header.  */
+  magic = read_bytes (&reader, strlen (PROJECT_CACHE_MAGIC));
+  if ((magic == NULL)
+      || (memcmp (magic, PROJECT_CACHE_MAGIC,
+                  strlen (PROJECT_CACHE_MAGIC)) != 0)
+      || (read_uint32 (&reader) != PROJECT_CACHE_FORMAT)
+      || (read_uint32 (&reader) != PROJECT_CACHE_BYTE_ORDER))
+    goto common_exit;
+  string_value = read_string (&reader);
+  if (g_strcmp0 (string_value, PACKAGE_VERSION) != 0)
+    {
+      g_free (string_value);
+      goto common_exit;
+    }
+  g_free (string_value);
+  string_value = read_string (&reader);
+  if (g_strcmp0 (string_value, project_file_name) != 0)
+    {
+      g_free (string_value);
+      goto common_exit;
+    }
+  g_free (string_value);
+  string_value = NULL;
+
+  /* Check that none of the files we read when the cache was written
+   * has changed.  */
+  count = read_count (&reader);
+  for (index = 0; index < count; index++)
+    {
+      string_value = read_string (&reader);
+      size = read_int64 (&reader);
+      modification_time = read_int64 (&reader);
+      if (reader.error)
+        {
+          g_free (string_value);
+          goto common_exit;
+        }
+      stat_file (string_value, &current_size, &current_modification_time);
+      if ((current_size != size)
+          || (current_modification_time != modification_time))
+        {
+          if (TRACE_PROJECT_CACHE)
+            {
+              g_print ("File %s has changed since the project "
+                       "was cached.\n", string_value);
+            }
+          g_free (string_value);
+          goto common_exit;
+        }
+      g_free (string_value);
+    }
+  string_value = NULL;
+
+  /* The cache is current.  Read the settings, the sounds and the
+   * sequence, but do not use any of them until we know the whole
+   * file is readable.  */
+  port_number = read_int64 (&reader);
+  port_file_name = read_string (&reader);
+  speaker_count = read_int64 (&reader);
+  speaker_count_file_name = read_string (&reader);
+
+  count = read_count (&reader);
+  for (index = 0; (index < count) && !reader.error; index++)
+    {
+      sounds = g_list_prepend (sounds, read_sound (&reader));
+    }
+  sounds = g_list_reverse (sounds);
+
+  count = read_count (&reader);
+  for (index = 0; (index < count) && !reader.error; index++)
+    {
+      items = g_list_prepend (items, read_sequence_item (&reader));
+    }
+  items = g_list_reverse (items);
+
+  if ((read_uint32 (&reader) != PROJECT_CACHE_TRAILER) || reader.error)
+    {
+      g_printerr ("Project cache %s is damaged; ignoring it.\n", file_name);
+      goto common_exit;
+    }
+  valid = TRUE;
+
+  /* Apply the settings the same way the XML parser would.  */
+  if ((port_number != 0) && (port_number != network_get_port (app)))
+    {
+      network_set_port (port_number, app);
+      sep_set_network_port_filename (port_file_name, app);
+    }
+  if ((speaker_count != 0) && (speaker_count != sep_get_speaker_count (app)))
+    {
+      sep_set_speaker_count (speaker_count, app);
+      sep_set_speaker_count_filename (speaker_count_file_name, app);
+    }
+
+  /* Give the sounds and sequence items to their owners.  */
+  for (list_element = sounds; list_element != NULL;
+       list_element = list_element->next)
+    {
+      sound_append_sound (list_element->data, app);
+    }
+  g_list_free (sounds);
+  sounds = NULL;
+  for (list_element = items; list_element != NULL;
+       list_element = list_element->next)
+    {
+      sequence_append_item (list_element->data, app);
+    }
+  g_list_free (items);
+  items = NULL;
+
+  if (TRACE_PROJECT_CACHE)
+    {
+      g_print ("Loaded project %s from cache %s.\n", project_file_name,
+               file_name);
+    }
+
+common_exit:
+  g_list_free_full (sounds, (GDestroyNotify) sound_free_sound);
+  g_list_free_full (items, (GDestroyNotify) sequence_free_item);
+  g_free (port_file_name);
+  g_free (speaker_count_file_name);
+  g_mapped_file_unref (mapped_file);
+  g_free (file_name);
+  return (valid);
+}
+
+/* Start recording what the XML parser reads from a project.  */
+void
+project_cache_begin (gchar *project_file_name, GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  forget_project (project_cache_data);
+  if (!project_cache_data->enabled)
+    return;
+
+  project_cache_data->recording = TRUE;
+  project_cache_note_file (project_file_name, app);
+  return;
+}
+
+/* A file of the project could be read only in part, so what the parser
+ * has found is not the whole project.  Stop recording, so that it is
+ * not saved in the cache.  */
+void
+project_cache_abandon (GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  forget_project (project_cache_data);
+  return;
+}
+
+/* Record that the project depends on a file.  The file is noted
+ * before it is read, so a file which is missing or unreadable is also
+ * recorded, and creating or fixing it invalidates the cache.  */
+void
+project_cache_note_file (gchar *file_name, GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+  struct project_cache_dependency *dependency;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  if (!project_cache_data->recording)
+    return;
+
+  dependency = g_malloc (sizeof (struct project_cache_dependency));
+  dependency->file_name = g_strdup (file_name);
+  stat_file (file_name, &dependency->size, &dependency->modification_time);
+  project_cache_data->dependencies =
+    g_list_prepend (project_cache_data->dependencies, dependency);
+  return;
+}
+
+/* Record the network port specified by the project.  */
+void
+project_cache_note_port (gint64 port_number, gchar *file_name,
+                         GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  if (!project_cache_data->recording)
+    return;
+
+  project_cache_data->port_number = port_number;
+  g_free (project_cache_data->port_file_name);
+  project_cache_data->port_file_name = g_strdup (file_name);
+  return;
+}
+
+/* Record the speaker count specified by the project.  */
+void
+project_cache_note_speaker_count (gint64 speaker_count, gchar *file_name,
+                                  GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  if (!project_cache_data->recording)
+    return;
+
+  project_cache_data->speaker_count = speaker_count;
+  g_free (project_cache_data->speaker_count_file_name);
+  project_cache_data->speaker_count_file_name = g_strdup (file_name);
+  return;
+}
+
+/* Write the cache for a project which has just been parsed.  */
+void
+project_cache_save (gchar *project_file_name, GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+  struct project_cache_dependency *dependency;
+  GByteArray *buffer;
+  GList *list_element, *sounds, *items;
+  gchar *file_name, *directory_name;
+  GError *error = NULL;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  if (!project_cache_data->recording)
+    return;
+  project_cache_data->recording = FALSE;
+
+  buffer = g_byte_array_new ();
+
+  /* The header.  */
+  g_byte_array_append (buffer, (const guint8 *) PROJECT_CACHE_MAGIC,
+                       strlen (PROJECT_CACHE_MAGIC));
+  write_uint32 (buffer, PROJECT_CACHE_FORMAT);
+  write_uint32 (buffer, PROJECT_CACHE_BYTE_ORDER);
+  write_string (buffer, PACKAGE_VERSION);
+  write_string (buffer, project_file_name);
+
+  /* The files we read.  */
+  write_uint32 (buffer, g_list_length (project_cache_data->dependencies));
+  for (list_element = project_cache_data->dependencies; list_element != NULL;
+       list_element = list_element->next)
+    {
+      dependency = list_element->data;
+      write_string (buffer, dependency->file_name);
+      write_int64 (buffer, dependency->size);
+      write_int64 (buffer, dependency->modification_time);
+    }
+
+  /* The settings.  */
+  write_int64 (buffer, project_cache_data->port_number);
+  write_string (buffer, project_cache_data->port_file_name);
+  write_int64 (buffer, project_cache_data->speaker_count);
+  write_string (buffer, project_cache_data->speaker_count_file_name);
+
+  /* The sounds and the sequence.  */
+  sounds = sound_get_sounds_list (app);
+  write_uint32 (buffer, g_list_length (sounds));
+  for (list_element = sounds; list_element != NULL;
+       list_element = list_element->next)
+    {
+      write_sound (buffer, list_element->data);
+    }
+  items = sequence_get_item_list (app);
+  write_uint32 (buffer, g_list_length (items));
+  for (list_element = items; list_element != NULL;
+       list_element = list_element->next)
+    {
+      write_sequence_item (buffer, list_element->data);
+    }
+  write_uint32 (buffer, PROJECT_CACHE_TRAILER);
+
+  /* g_file_set_contents writes a temporary file and renames it,
+   * so a reader never sees a partly written cache.  */
+  file_name = cache_file_name (project_file_name);
+  directory_name = g_path_get_dirname (file_name);
+  g_mkdir_with_parents (directory_name, 0700);
+  if (!g_file_set_contents (file_name, (const gchar *) buffer->data,
+                            buffer->len, &error))
+    {
+      g_printerr ("Unable to write project cache %s: %s.\n", file_name,
+                  error->message);
+      g_error_free (error);
+      error = NULL;
+    }
+  else if (TRACE_PROJECT_CACHE)
+    {
+      g_print ("Wrote %u bytes to project cache %s.\n", buffer->len,
+               file_name);
+    }
+
+  g_free (directory_name);
+  g_free (file_name);
+  g_byte_array_unref (buffer);
+  forget_project (project_cache_data);
+  return;
+}
+
+/* Count the bytes of memory used to remember the project's files
+ * until its cache is written.  */
+gsize
+project_cache_memory_size (GApplication *app)
+{
+  struct project_cache_info *project_cache_data;
+  struct project_cache_dependency *dependency;
+  GList *l;
+  gsize size;
+
+  project_cache_data = sep_get_project_cache_data (app);
+  if (project_cache_data == NULL)
+    return (0);
+
+  size = sizeof (struct project_cache_info);
+  for (l = project_cache_data->dependencies; l != NULL; l = l->next)
+    {
+      dependency = l->data;
+      size = size + sizeof (GList) + sizeof (struct project_cache_dependency)
+        + strlen (dependency->file_name) + 1;
+    }
+  if (project_cache_data->port_file_name != NULL)
+    size = size + strlen (project_cache_data->port_file_name) + 1;
+  if (project_cache_data->speaker_count_file_name != NULL)
+    size = size + strlen (project_cache_data->speaker_count_file_name) + 1;
+  return (size);
+}
+
+/* End of file project_cache_subroutines.c */
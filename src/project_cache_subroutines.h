@@ -0,0 +1,57 @@
+/*
+ * project_cache_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+/* Subroutines defined in project_cache_subroutines.c */
+
+/* Initialize the project cache subroutines.  */
+void *project_cache_init (GApplication *app);
+
+/* Deallocate the project cache subroutines' persistent data.  */
+void project_cache_finish (GApplication *app);
+
+/* Load a project from its cache, if the cache is still valid.
+ * Returns TRUE if the project was loaded.  */
+gboolean project_cache_load (gchar *project_file_name, GApplication *app);
+
+/* Start recording what the XML parser reads from a project.  */
+void project_cache_begin (gchar *project_file_name, GApplication *app);
+
+/* Record that the project depends on a file.  */
+void project_cache_note_file (gchar *file_name, GApplication *app);
+
+/* Record the network port specified by the project.  */
+void project_cache_note_port (gint64 port_number, gchar *file_name,
+                              GApplication *app);
+
+/* Record the speaker count specified by the project.  */
+void project_cache_note_speaker_count (gint64 speaker_count,
+                                       gchar *file_name, GApplication *app);
+
+/* The project could not be read completely, so do not cache it.  */
+void project_cache_abandon (GApplication *app);
+
+/* Write the cache for a project which has just been parsed.  */
+void project_cache_save (gchar *project_file_name, GApplication *app);
+
+/* Count the bytes of memory the project cache subroutines are using.  */
+gsize project_cache_memory_size (GApplication *app);
+
+/* End of file project_cache_subroutines.h */
@@ -0,0 +1,337 @@
+/*
+ * realtime_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include "realtime_subroutines.h"
+#include "display_subroutines.h"
+#include "sound_effects_player.h"
+#include "telemetry_subroutines.h"
+#include "main.h"
+
+/* The sound must reach the audio output on time, however busy the
+ * computer is redrawing the display, loading a project or writing a
+ * trace.  The Gstreamer streaming threads--the loopers, which feed the
+ * mixer, the mixer, and the thread which feeds the audio output--can
+ * be given a real-time scheduling policy, so that they run ahead of
+ * everything else, and kept to chosen processors.  Each streaming
+ * thread announces itself with a stream-status message when it starts,
+ * which is delivered on that thread to our bus sync handler, so that
+ * is where we change it.  Once the sounds are loaded, they can be
+ * locked into memory, so that playing them never waits for a page
+ * to be read back in.
+ *
+ * An element which falls behind posts a quality-of-service message.
+ * We count those, and show the count to the operator and to any
+ * listening show control console, so that dropouts can be measured
+ * and not just heard.  */
+
+#define TRACE_REALTIME FALSE
+
+/* How often, in seconds, we update the operator's count of dropouts.  */
+#define REALTIME_MESSAGE_INTERVAL 1
+
+/* The persistent data used by the real-time subroutines.  */
+struct realtime_info
+{
+  /* These are set at initialization and only read afterwards, so the
+   * streaming threads may use them.  */
+  gint policy;                  /* SCHED_FIFO or SCHED_RR */
+  gint priority;                /* 0 means leave the threads alone */
+  gboolean pin;                 /* keep the threads on these processors */
+  cpu_set_t cpus;
+  gboolean lock_memory;
+
+  /* Used by the streaming threads.  */
+  gint thread_count;            /* threads changed, for tracing */
+  gint warned;                  /* we have said we could not */
+
+  /* The following are used only on the main thread.  */
+  gboolean memory_locked;
+  gint xrun_count;              /* late buffers reported */
+  gint message_count;           /* the count the message shows */
+  guint message_id;
+  guint message_source;
+};
+
+/* Parse a list of processor numbers, such as 2,3 or 0-3,6.
+ * Return FALSE if it cannot be parsed.  */
+static gboolean
+realtime_parse_cpus (const gchar *cpu_list, cpu_set_t *cpus)
+{
+  const gchar *cursor;
+  gchar *end;
+  glong first, last, cpu;
+
+  CPU_ZERO (cpus);
+  cursor = cpu_list;
+  while (*cursor != '\0')
+    {
+      first = strtol (cursor, &end, 10);
+      if ((end == cursor) || (first < 0) || (first >= CPU_SETSIZE))
+        return FALSE;
+      last = first;
+      cursor = end;
+      if (*cursor == '-')
+        {
+          cursor = cursor + 1;
+          last = strtol (cursor, &end, 10);
+          if ((end == cursor) || (last < first) || (last >= CPU_SETSIZE))
+            return FALSE;
+          cursor = end;
+        }
+      for (cpu = first; cpu <= last; cpu++)
+        CPU_SET (cpu, cpus);
+      if (*cursor == ',')
+        cursor = cursor + 1;
+      else if (*cursor != '\0')
+        return FALSE;
+    }
+  return (CPU_COUNT (cpus) > 0);
+}
+
+/* Initialize the real-time subroutines.  */
+void *
+realtime_init (GApplication *app)
+{
+  struct realtime_info *realtime_data;
+  gchar *policy_string, *cpu_list;
+  gint min_priority, max_priority;
+
+  realtime_data = g_malloc0 (sizeof (struct realtime_info));
+
+  /* A render runs as fast as it can, and is never late.  */
+  if (main_get_render_file_name () != NULL)
+    return (realtime_data);
+
+  realtime_data->policy = SCHED_FIFO;
+  policy_string = main_get_realtime_policy_string ();
+  if (g_strcmp0 (policy_string, "rr") == 0)
+    realtime_data->policy = SCHED_RR;
+  else if ((policy_string != NULL) && (g_strcmp0 (policy_string, "fifo") != 0))
+    g_printerr ("Unknown real-time policy %s; using fifo.\n", policy_string);
+
+  realtime_data->priority = main_get_realtime_priority ();
+  if (realtime_data->priority != 0)
+    {
+      min_priority = sched_get_priority_min (realtime_data->policy);
+      max_priority = sched_get_priority_max (realtime_data->policy);
+      if ((realtime_data->priority < min_priority)
+          || (realtime_data->priority > max_priority))
+        {
+          g_printerr ("The real-time priority must be from %d to %d.\n",
+                      min_priority, max_priority);
+          realtime_data->priority = CLAMP (realtime_data->priority,
+                                           min_priority, max_priority);
+        }
+    }
+
+  cpu_list = main_get_realtime_cpus_string ();
+  if (cpu_list != NULL)
+    {
+      realtime_data->pin = realtime_parse_cpus (cpu_list,
+                                                &realtime_data->cpus);
+      if (!realtime_data->pin)
+        g_printerr ("Unable to parse the processor list %s.\n", cpu_list);
+    }
+
+  realtime_data->lock_memory = main_get_lock_memory ();
+  return (realtime_data);
+}
+
+/* Deallocate the real-time subroutines' persistent data.  */
+void
+realtime_finish (GApplication *app)
+{
+  struct realtime_info *realtime_data;
+
+  realtime_data = sep_get_realtime_data (app);
+  if (realtime_data == NULL)
+    return;
+
+  if (realtime_data->message_source != 0)
+    {
+      g_source_remove (realtime_data->message_source);
+      realtime_data->message_source = 0;
+    }
+  if (realtime_data->memory_locked)
+    munlockall ();
+  g_free (realtime_data);
+  return;
+}
+
+/* A streaming thread is starting.  Change its scheduling and the
+ * processors it may run on.  This runs on that thread.  */
+static void
+realtime_enter_thread (struct realtime_info *realtime_data,
+                       GstElement *owner)
+{
+  struct sched_param param;
+  gint result;
+
+  if (realtime_data->priority != 0)
+    {
+      memset (&param, 0, sizeof (param));
+      param.sched_priority = realtime_data->priority;
+      result = pthread_setschedparam (pthread_self (), realtime_data->policy,
+                                      &param);
+      if ((result != 0) && g_atomic_int_compare_and_exchange
+          (&realtime_data->warned, 0, 1))
+        {
+          /* Usually this means we lack permission: see the rtprio
+           * limit in /etc/security/limits.conf.  */
+          g_printerr ("Unable to give the audio threads real-time "
+                      "priority: %s.\n", strerror (result));
+        }
+    }
+
+  if (realtime_data->pin)
+    {
+      result = pthread_setaffinity_np (pthread_self (), sizeof (cpu_set_t),
+                                       &realtime_data->cpus);
+      if (result != 0)
+        {
+          g_printerr ("Unable to keep thread of %s on the processors "
+                      "requested: %s.\n", GST_OBJECT_NAME (owner),
+                      strerror (result));
+        }
+    }
+
+  g_atomic_int_inc (&realtime_data->thread_count);
+  if (TRACE_REALTIME)
+    {
+      g_print ("Streaming thread %d of %s entered.\n",
+               g_atomic_int_get (&realtime_data->thread_count),
+               GST_OBJECT_NAME (owner));
+    }
+  return;
+}
+
+/* Look at a message on the thread that posted it.  Every message is
+ * passed on to the main thread's bus watch.  */
+GstBusSyncReply
+realtime_bus_sync_handler (GstBus *bus, GstMessage *message,
+                           gpointer user_data)
+{
+  struct realtime_info *realtime_data;
+  GstStreamStatusType status_type;
+  GstElement *owner;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_STREAM_STATUS)
+    return GST_BUS_PASS;
+
+  realtime_data = sep_get_realtime_data (user_data);
+  if ((realtime_data == NULL)
+      || ((realtime_data->priority == 0) && !realtime_data->pin))
+    return GST_BUS_PASS;
+
+  gst_message_parse_stream_status (message, &status_type, &owner);
+  if (status_type == GST_STREAM_STATUS_TYPE_ENTER)
+    realtime_enter_thread (realtime_data, owner);
+
+  return GST_BUS_PASS;
+}
+
+/* Lock all of our memory, including the sounds' samples, into RAM.
+ * This is done each time the sounds have finished loading, since a
+ * reload allocates more.  */
+void
+realtime_lock_memory (GApplication *app)
+{
+  struct realtime_info *realtime_data;
+
+  realtime_data = sep_get_realtime_data (app);
+  if ((realtime_data == NULL) || !realtime_data->lock_memory)
+    return;
+
+  if (mlockall (MCL_CURRENT) != 0)
+    {
+      /* Usually this means the memlock limit is too small.  */
+      g_printerr ("Unable to lock the sounds into memory: %s.\n",
+                  strerror (errno));
+      return;
+    }
+  realtime_data->memory_locked = TRUE;
+  if (TRACE_REALTIME)
+    {
+      g_print ("Memory locked.\n");
+    }
+  return;
+}
+
+/* Show the operator how many times the sound has been late.  */
+static gboolean
+realtime_show_xruns (gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct realtime_info *realtime_data;
+  gchar *message_text;
+
+  realtime_data = sep_get_realtime_data (app);
+  realtime_data->message_source = 0;
+  if (realtime_data->message_count == realtime_data->xrun_count)
+    return G_SOURCE_REMOVE;
+
+  if (realtime_data->message_id != 0)
+    display_remove_message (realtime_data->message_id, app);
+  message_text =
+    g_strdup_printf ("Audio dropouts: %d.", realtime_data->xrun_count);
+  realtime_data->message_id = display_show_message (message_text, app);
+  g_free (message_text);
+  realtime_data->message_count = realtime_data->xrun_count;
+  return G_SOURCE_REMOVE;
+}
+
+/* An element of the pipeline reported that it was late, and dropped
+ * or will drop data.  Count it.  */
+void
+realtime_note_qos (GstMessage *message, GApplication *app)
+{
+  struct realtime_info *realtime_data;
+
+  realtime_data = sep_get_realtime_data (app);
+  if (realtime_data == NULL)
+    return;
+
+  realtime_data->xrun_count = realtime_data->xrun_count + 1;
+  if (TRACE_REALTIME)
+    {
+      g_print ("Late buffer %d from %s.\n", realtime_data->xrun_count,
+               GST_OBJECT_NAME (GST_MESSAGE_SRC (message)));
+    }
+  telemetry_set_xrun_count (realtime_data->xrun_count, app);
+
+  /* A burst of dropouts updates the status bar only once.  */
+  if (realtime_data->message_source == 0)
+    {
+      realtime_data->message_source =
+        g_timeout_add_seconds (REALTIME_MESSAGE_INTERVAL,
+                               realtime_show_xruns, app);
+    }
+  return;
+}
+
+/* End of file realtime_subroutines.c */
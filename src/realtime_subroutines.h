@@ -0,0 +1,43 @@
+/*
+ * realtime_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+/* Subroutines defined in realtime_subroutines.c */
+
+/* Initialize the real-time subroutines from the command-line options.  */
+void *realtime_init (GApplication *app);
+
+/* Deallocate the real-time subroutines' persistent data.  */
+void realtime_finish (GApplication *app);
+
+/* Called on the thread that posted a message on the pipeline's bus,
+ * before the message is queued for the main thread.  Gives each
+ * streaming thread the scheduling and processors requested.  */
+GstBusSyncReply realtime_bus_sync_handler (GstBus *bus, GstMessage *message,
+                                           gpointer user_data);
+
+/* The sounds have been loaded: lock them into memory, if requested.  */
+void realtime_lock_memory (GApplication *app);
+
+/* An element of the pipeline reported that it was late.  */
+void realtime_note_qos (GstMessage *message, GApplication *app);
+
+/* End of file realtime_subroutines.h */
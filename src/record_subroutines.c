@@ -0,0 +1,507 @@
+/*
+ * record_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <gtk/gtk.h>
+#include "record_subroutines.h"
+#include "gstreamer_subroutines.h"
+#include "parse_net_subroutines.h"
+#include "render_subroutines.h"
+#include "sequence_subroutines.h"
+#include "sound_effects_player.h"
+#include "sound_subroutines.h"
+#include "main.h"
+
+/* These subroutines record everything that happens to the player from
+ * outside, so that a performance can be played back later, perhaps on
+ * another computer, to reproduce a problem.  Each event is one line of
+ * the record file: its time in seconds, its kind and its argument.
+ * The kinds are:
+ *
+ *   start      the sequencer started; replay times are relative to this
+ *   net        a text datagram, with C escapes for unusual characters
+ *   osc        a binary (OSC) datagram, in hexadecimal
+ *   button     an operator button: go, pause, continue, start N, stop N
+ *   signal     TERM or HUP
+ *   completed  a sound finished, as reported by the pipeline
+ *   release    a sound entered its release stage
+ *
+ * The time is from the monotonic clock, or the position in the mix
+ * when rendering.  On replay, the datagrams, buttons and signals are
+ * acted on at the same times after the start of the sequencer.  The
+ * completions are not replayed, since the pipeline produces them
+ * again; recording the replay and comparing the two files shows how
+ * their timing has changed.  */
+
+#define TRACE_RECORD FALSE
+
+/* The persistent data used by the record subroutines.  */
+struct record_info
+{
+  FILE *record_file;            /* NULL if we are not recording */
+  gboolean rendering;           /* time is the position in the mix */
+  GList *replay;                /* the events not yet replayed */
+  gboolean replay_started;
+  gint64 replay_start_time;     /* monotonic time replay started */
+  guint replay_source;          /* the timeout for the next event */
+};
+
+/* An event to be replayed.  */
+struct record_event
+{
+  gdouble time;                 /* seconds after the sequencer starts */
+  gchar *kind;
+  gchar *argument;
+  gsize length;                 /* the length of the argument */
+};
+
+/* Return the time to record an event at.  */
+static gdouble
+record_current_time (struct record_info *record_data, GApplication *app)
+{
+  if (record_data->rendering)
+    return (render_get_time (app));
+
+  return ((gdouble) g_get_monotonic_time () / 1e6);
+}
+
+static void
+record_free_event (gpointer data)
+{
+  struct record_event *event = data;
+
+  g_free (event->kind);
+  g_free (event->argument);
+  g_free (event);
+  return;
+}
+
+/* Convert an OSC datagram from hexadecimal.  Return NULL if the text
+ * is not valid.  */
+static gchar *
+record_decode_hex (const gchar *text, gsize *length)
+{
+  gsize text_length, i;
+  gchar *data;
+  gint high, low;
+
+  text_length = strlen (text);
+  if ((text_length % 2) != 0)
+    return NULL;
+
+  data = g_malloc (text_length / 2 + 1);
+  for (i = 0; i < text_length / 2; i++)
+    {
+      high = g_ascii_xdigit_value (text[i * 2]);
+      low = g_ascii_xdigit_value (text[i * 2 + 1]);
+      if ((high < 0) || (low < 0))
+        {
+          g_free (data);
+          return NULL;
+        }
+      data[i] = (high << 4) | low;
+    }
+  data[text_length / 2] = '\0';
+  *length = text_length / 2;
+  return (data);
+}
+
+/* Keep the events in time order.  The sort is stable, so events with
+ * the same time are replayed in the order they were recorded.  */
+static gint
+record_compare_events (gconstpointer a, gconstpointer b)
+{
+  const struct record_event *event_a = a;
+  const struct record_event *event_b = b;
+
+  if (event_a->time < event_b->time)
+    return -1;
+  if (event_a->time > event_b->time)
+    return 1;
+  return 0;
+}
+
+/* Read the file of events to replay.  */
+static GList *
+record_read_replay (const gchar *replay_name)
+{
+  gchar *contents;
+  gchar **lines;
+  gchar *line, *end, *kind, *argument;
+  gdouble time, start_time;
+  gboolean start_seen;
+  GList *replay, *event_list;
+  struct record_event *event;
+  GError *error = NULL;
+  gint i;
+
+  if (!g_file_get_contents (replay_name, &contents, NULL, &error))
+    {
+      g_printerr ("Cannot read replay file %s: %s.\n", replay_name,
+                  error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  replay = NULL;
+  start_time = 0.0;
+  start_seen = FALSE;
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      line = lines[i];
+      if ((line[0] == '\0') || (line[0] == '#'))
+        continue;
+
+      /* The time, the kind, and the rest of the line.  */
+      time = g_ascii_strtod (line, &end);
+      while (*end == ' ')
+        end++;
+      kind = end;
+      while ((*end != ' ') && (*end != '\0'))
+        end++;
+      argument = end;
+      if (*argument == ' ')
+        {
+          *argument = '\0';
+          argument++;
+        }
+      if ((kind == line) || (kind[0] == '\0'))
+        {
+          g_printerr ("%s line %d: expected a time and an event.\n",
+                      replay_name, i + 1);
+          continue;
+        }
+
+      /* Replay times are relative to the first start of the sequencer.  */
+      if (strcmp (kind, "start") == 0)
+        {
+          if (!start_seen)
+            start_time = time;
+          start_seen = TRUE;
+          continue;
+        }
+
+      /* The pipeline makes its own completions.  */
+      if ((strcmp (kind, "completed") == 0)
+          || (strcmp (kind, "release") == 0))
+        continue;
+
+      event = g_malloc0 (sizeof (struct record_event));
+      event->time = time;
+      event->kind = g_strdup (kind);
+      if (strcmp (kind, "osc") == 0)
+        event->argument = record_decode_hex (argument, &event->length);
+      else if ((strcmp (kind, "net") == 0) || (strcmp (kind, "button") == 0)
+               || (strcmp (kind, "signal") == 0))
+        {
+          event->argument = g_strcompress (argument);
+          event->length = strlen (event->argument);
+        }
+      if (event->argument == NULL)
+        {
+          g_printerr ("%s line %d: cannot replay event %s.\n", replay_name,
+                      i + 1, kind);
+          record_free_event (event);
+          continue;
+        }
+      replay = g_list_prepend (replay, event);
+    }
+  g_strfreev (lines);
+
+  for (event_list = replay; event_list != NULL; event_list = event_list->next)
+    {
+      event = event_list->data;
+      event->time = event->time - start_time;
+    }
+
+  replay = g_list_reverse (replay);
+  return (g_list_sort (replay, record_compare_events));
+}
+
+/* Initialize the record subroutines.  */
+void *
+record_init (GApplication *app)
+{
+  struct record_info *record_data;
+  gchar *record_name, *replay_name;
+
+  record_data = g_malloc0 (sizeof (struct record_info));
+  record_data->rendering = (main_get_render_file_name () != NULL);
+
+  record_name = main_get_record_file_name ();
+  if (record_name != NULL)
+    {
+      record_data->record_file = fopen (record_name, "w");
+      if (record_data->record_file == NULL)
+        {
+          g_printerr ("Cannot create record file %s: %s.\n", record_name,
+                      g_strerror (errno));
+        }
+      else
+        {
+          /* Write each event as it happens, so we have the events
+           * leading up to a crash.  */
+          setvbuf (record_data->record_file, NULL, _IOLBF, 0);
+          fprintf (record_data->record_file,
+                   "# sound_effects_player events: "
+                   "time (seconds), kind, argument\n");
+        }
+    }
+
+  replay_name = main_get_replay_file_name ();
+  if (replay_name != NULL)
+    record_data->replay = record_read_replay (replay_name);
+
+  return (record_data);
+}
+
+/* Close the record file and deallocate the persistent data.  */
+void
+record_finish (GApplication *app)
+{
+  struct record_info *record_data;
+
+  record_data = sep_get_record_data (app);
+  if (record_data == NULL)
+    return;
+
+  if (record_data->replay_source != 0)
+    g_source_remove (record_data->replay_source);
+  g_list_free_full (record_data->replay, record_free_event);
+  if (record_data->record_file != NULL)
+    fclose (record_data->record_file);
+  g_free (record_data);
+  return;
+}
+
+/* Write an event to the record file.  */
+static void
+record_write (struct record_info *record_data, const gchar *kind,
+              const gchar *argument, GApplication *app)
+{
+  fprintf (record_data->record_file, "%.6f %s %s\n",
+           record_current_time (record_data, app), kind, argument);
+  return;
+}
+
+/* Record a datagram.  Text commands are written as text; OSC packets,
+ * which contain null bytes, are written in hexadecimal.  */
+void
+record_datagram (guint length, const gchar *text, GApplication *app)
+{
+  struct record_info *record_data;
+  gchar *argument;
+  GString *hex_string;
+  guint i;
+
+  record_data = sep_get_record_data (app);
+  if ((record_data == NULL) || (record_data->record_file == NULL))
+    return;
+
+  if (memchr (text, '\0', length) == NULL)
+    {
+      argument = g_strndup (text, length);
+      record_event ("net", argument, app);
+      g_free (argument);
+      return;
+    }
+
+  hex_string = g_string_sized_new (length * 2);
+  for (i = 0; i < length; i++)
+    g_string_append_printf (hex_string, "%02x", (guchar) text[i]);
+  record_write (record_data, "osc", hex_string->str, app);
+  g_string_free (hex_string, TRUE);
+  return;
+}
+
+/* Record some other event.  The argument is escaped so that it fits
+ * on one line.  */
+void
+record_event (const gchar *kind, const gchar *argument, GApplication *app)
+{
+  struct record_info *record_data;
+  gchar *escaped_argument;
+
+  record_data = sep_get_record_data (app);
+  if ((record_data == NULL) || (record_data->record_file == NULL))
+    return;
+
+  escaped_argument = g_strescape (argument, NULL);
+  record_write (record_data, kind, escaped_argument, app);
+  g_free (escaped_argument);
+  return;
+}
+
+/* Act on a replayed event, and record it if we are recording.  */
+static void
+record_replay_event (struct record_event *event, GApplication *app)
+{
+  guint cluster_number;
+
+  if (TRACE_RECORD)
+    {
+      g_print ("replay %.6f %s.\n", event->time, event->kind);
+    }
+
+  /* Datagrams are recorded by the network parser.  */
+  if ((strcmp (event->kind, "net") == 0) || (strcmp (event->kind, "osc") == 0))
+    {
+      parse_net_text (event->length, event->argument, app);
+      return;
+    }
+
+  record_event (event->kind, event->argument, app);
+  if (strcmp (event->kind, "button") == 0)
+    {
+      if (strcmp (event->argument, "go") == 0)
+        sequence_button_play (app);
+      else if (strcmp (event->argument, "pause") == 0)
+        sound_button_pause (app);
+      else if (strcmp (event->argument, "continue") == 0)
+        sound_button_continue (app);
+      else if (sscanf (event->argument, "start %u", &cluster_number) == 1)
+        sequence_cluster_start (cluster_number, app);
+      else if (sscanf (event->argument, "stop %u", &cluster_number) == 1)
+        sequence_cluster_stop (cluster_number, app);
+      else
+        g_printerr ("Unknown button %s in replay.\n", event->argument);
+      return;
+    }
+
+  if (strcmp (event->kind, "signal") == 0)
+    {
+      if (strcmp (event->argument, "TERM") == 0)
+        gstreamer_shutdown (app);
+      else if (strcmp (event->argument, "HUP") == 0)
+        sep_reload_project (app);
+      else
+        g_printerr ("Unknown signal %s in replay.\n", event->argument);
+      return;
+    }
+
+  return;
+}
+
+/* Replay the events that are due.  */
+void
+record_replay_due (GApplication *app)
+{
+  struct record_info *record_data;
+  struct record_event *event;
+  gdouble current_time;
+
+  record_data = sep_get_record_data (app);
+  if ((record_data == NULL) || !record_data->replay_started)
+    return;
+
+  if (record_data->rendering)
+    current_time = render_get_time (app);
+  else
+    current_time =
+      (gdouble) (g_get_monotonic_time () -
+                 record_data->replay_start_time) / 1e6;
+
+  while (record_data->replay != NULL)
+    {
+      event = record_data->replay->data;
+      if (event->time > current_time)
+        break;
+      record_data->replay =
+        g_list_delete_link (record_data->replay, record_data->replay);
+      record_replay_event (event, app);
+      record_free_event (event);
+    }
+
+  return;
+}
+
+static void record_schedule_replay (struct record_info *record_data,
+                                    GApplication *app);
+
+/* The time of the next event has come.  */
+static gboolean
+record_replay_tick (gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct record_info *record_data;
+
+  record_data = sep_get_record_data (app);
+  record_data->replay_source = 0;
+  record_replay_due (app);
+  record_schedule_replay (record_data, app);
+  return G_SOURCE_REMOVE;
+}
+
+/* In real time, wait for the next event to be due.  When rendering,
+ * the renderer calls us as the mix advances.  */
+static void
+record_schedule_replay (struct record_info *record_data, GApplication *app)
+{
+  struct record_event *event;
+  gdouble delay;
+
+  if ((record_data->replay == NULL) || record_data->rendering)
+    return;
+
+  event = record_data->replay->data;
+  delay =
+    event->time - ((gdouble) (g_get_monotonic_time () -
+                              record_data->replay_start_time) / 1e6);
+  if (delay < 0.0)
+    delay = 0.0;
+  record_data->replay_source =
+    g_timeout_add_full (G_PRIORITY_HIGH, (guint) ceil (delay * 1000.0),
+                        record_replay_tick, app, NULL);
+  return;
+}
+
+/* The sequencer has started.  */
+void
+record_start (GApplication *app)
+{
+  struct record_info *record_data;
+
+  record_data = sep_get_record_data (app);
+  if (record_data->record_file != NULL)
+    record_write (record_data, "start", "", app);
+
+  if (record_data->replay_started)
+    return;
+  record_data->replay_started = TRUE;
+  record_data->replay_start_time = g_get_monotonic_time ();
+  record_schedule_replay (record_data, app);
+  return;
+}
+
+/* Return TRUE if some events have not yet been replayed.  */
+gboolean
+record_replay_pending (GApplication *app)
+{
+  struct record_info *record_data;
+
+  record_data = sep_get_record_data (app);
+  return (record_data->replay != NULL);
+}
+
+/* End of file record_subroutines.c */
@@ -0,0 +1,48 @@
+/*
+ * record_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+/* Subroutines defined in record_subroutines.c */
+
+/* Initialize the event recorder, opening the record file and reading
+ * the replay file if they were specified.  */
+void *record_init (GApplication *app);
+
+/* Close the record file and deallocate the recorder's persistent data.  */
+void record_finish (GApplication *app);
+
+/* The sequencer has started: note the time, and start replaying.  */
+void record_start (GApplication *app);
+
+/* Record a datagram received from the network.  */
+void record_datagram (guint length, const gchar *text, GApplication *app);
+
+/* Record some other event, such as a button being pushed.  */
+void record_event (const gchar *kind, const gchar *argument,
+                   GApplication *app);
+
+/* Replay the events that are due.  This is called by the renderer as
+ * the mix advances.  */
+void record_replay_due (GApplication *app);
+
+/* Return TRUE if there are events still to be replayed.  */
+gboolean record_replay_pending (GApplication *app);
+
+/* End of file record_subroutines.h */
@@ -0,0 +1,462 @@
+/*
+ * render_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include "render_subroutines.h"
+#include "gstreamer_subroutines.h"
+#include "parse_net_subroutines.h"
+#include "record_subroutines.h"
+#include "sound_effects_player.h"
+#include "sound_structure.h"
+#include "sound_subroutines.h"
+#include "timer_subroutines.h"
+#include "main.h"
+
+/* These subroutines render a sequence into a WAV file as fast as the
+ * processor allows, rather than in real time.  The file sink does not
+ * synchronize to the clock, so the pipeline runs freely, and the time
+ * used by the sequencer's timers and by the render script is the
+ * position in the mix rather than the time of day.
+ *
+ * To keep the sequencer in step with the mix, each buffer leaving the
+ * final audio mixer waits for the main thread to act on everything
+ * that is due by the end of the previous buffer: commands from the
+ * render script, expired timers, and messages from the pipeline such
+ * as sound completions.  A command therefore takes effect at the same
+ * place in the mix on every run, at most one buffer late.
+ *
+ * The render script is a text file.  Each line holds a time in seconds
+ * from the start of the sequence, followed by a network text command,
+ * for example "12.5 start 3".  Blank lines and lines starting with "#"
+ * are ignored.  The command "end" ends the render at that time;
+ * otherwise it ends when the script is finished, no events remain to be
+ * replayed, no timers are pending and no sounds are playing.  */
+
+#define TRACE_RENDER FALSE
+
+/* The persistent data used by the render subroutines.  */
+struct render_info
+{
+  gboolean enabled;
+  GList *script;                /* the commands not yet sent */
+  gboolean end_requested;       /* the script said "end" */
+  GstPad *mixer_pad;            /* the source pad of the final mixer */
+  gulong probe_id;
+  gint64 start_wall_time;       /* when rendering started */
+  gdouble current_time;         /* the position in the mix, in seconds */
+  GApplication *app;
+
+  /* The fields below are shared with the streaming thread, and are
+   * protected by the lock.  */
+  GMutex lock;
+  GCond step_done;
+  gboolean started;             /* the sequencer has started */
+  gboolean finished;            /* no more of the mix is wanted */
+  gboolean step_pending;        /* the streaming thread is waiting */
+  gboolean step_deferred;       /* ... for rendering to start */
+  GstClockTime origin;          /* the time stamp of the first buffer */
+  GstClockTime position;        /* the end of the latest buffer */
+};
+
+/* A command from the render script.  */
+struct render_event
+{
+  gdouble time;                 /* seconds from the start of the mix */
+  gchar *text;                  /* NULL means end the render */
+};
+
+static gboolean render_step (gpointer user_data);
+
+/* Sort the render script by time.  The sort is stable, so commands
+ * with the same time are sent in the order they appear.  */
+static gint
+render_compare_events (gconstpointer a, gconstpointer b)
+{
+  const struct render_event *event_a = a;
+  const struct render_event *event_b = b;
+
+  if (event_a->time < event_b->time)
+    return -1;
+  if (event_a->time > event_b->time)
+    return 1;
+  return 0;
+}
+
+static void
+render_free_event (gpointer data)
+{
+  struct render_event *event = data;
+
+  g_free (event->text);
+  g_free (event);
+  return;
+}
+
+/* Read the render script.  */
+static GList *
+render_read_script (const gchar *script_name)
+{
+  gchar *contents;
+  gchar **lines;
+  gchar *line, *text, *end;
+  gdouble time;
+  GList *script;
+  struct render_event *event;
+  GError *error = NULL;
+  gint i;
+
+  if (!g_file_get_contents (script_name, &contents, NULL, &error))
+    {
+      g_printerr ("Cannot read render script %s: %s.\n", script_name,
+                  error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  script = NULL;
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      line = g_strstrip (lines[i]);
+      if ((line[0] == '\0') || (line[0] == '#'))
+        continue;
+
+      time = g_ascii_strtod (line, &end);
+      text = g_strstrip (end);
+      if ((end == line) || (time < 0.0) || (text[0] == '\0'))
+        {
+          g_printerr ("%s line %d: expected a time in seconds "
+                      "and a command.\n", script_name, i + 1);
+          continue;
+        }
+
+      event = g_malloc (sizeof (struct render_event));
+      event->time = time;
+      if (g_ascii_strcasecmp (text, "end") == 0)
+        event->text = NULL;
+      else
+        event->text = g_strdup (text);
+      script = g_list_prepend (script, event);
+    }
+  g_strfreev (lines);
+
+  script = g_list_reverse (script);
+  return (g_list_sort (script, render_compare_events));
+}
+
+/* Initialize the render subroutines.  We render only if a render file
+ * was specified on the command line.  */
+void *
+render_init (GApplication *app)
+{
+  struct render_info *render_data;
+  gchar *script_name;
+
+  render_data = g_malloc0 (sizeof (struct render_info));
+  render_data->app = app;
+  render_data->enabled = (main_get_render_file_name () != NULL);
+  render_data->origin = GST_CLOCK_TIME_NONE;
+  render_data->position = 0;
+  g_mutex_init (&render_data->lock);
+  g_cond_init (&render_data->step_done);
+
+  script_name = main_get_render_script_name ();
+  if (script_name != NULL)
+    {
+      if (render_data->enabled)
+        render_data->script = render_read_script (script_name);
+      else
+        g_printerr ("The render script %s is used only with --render.\n",
+                    script_name);
+    }
+
+  return (render_data);
+}
+
+/* Deallocate the persistent data.  */
+static void
+render_free (gpointer data)
+{
+  struct render_info *render_data = data;
+
+  g_list_free_full (render_data->script, render_free_event);
+  render_data->script = NULL;
+  g_mutex_clear (&render_data->lock);
+  g_cond_clear (&render_data->step_done);
+  g_free (render_data);
+  return;
+}
+
+/* Stop rendering.  This is called before the pipeline is shut down,
+ * so release the streaming thread if it is waiting for us.  */
+void
+render_finish (GApplication *app)
+{
+  struct render_info *render_data;
+  GstPad *mixer_pad;
+
+  render_data = sep_get_render_data (app);
+  if (render_data == NULL)
+    return;
+
+  g_mutex_lock (&render_data->lock);
+  render_data->finished = TRUE;
+  g_cond_broadcast (&render_data->step_done);
+  g_mutex_unlock (&render_data->lock);
+
+  /* If the streaming thread is in the probe, the persistent data is
+   * deallocated when it leaves.  */
+  if (render_data->probe_id != 0)
+    {
+      mixer_pad = render_data->mixer_pad;
+      gst_pad_remove_probe (mixer_pad, render_data->probe_id);
+      gst_object_unref (mixer_pad);
+    }
+  else
+    {
+      render_free (render_data);
+    }
+
+  return;
+}
+
+/* Each buffer leaving the final mixer comes here, on the mixer's
+ * streaming thread.  */
+static GstPadProbeReturn
+render_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  struct render_info *render_data = user_data;
+  GstBuffer *buffer;
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  g_mutex_lock (&render_data->lock);
+  if (render_data->finished)
+    {
+      g_mutex_unlock (&render_data->lock);
+      return GST_PAD_PROBE_DROP;
+    }
+
+  if (render_data->origin == GST_CLOCK_TIME_NONE)
+    {
+      /* The first buffer prerolls the file sink, which lets the
+       * pipeline reach the playing state and the sequencer start.  */
+      render_data->origin = 0;
+      if (GST_BUFFER_PTS_IS_VALID (buffer))
+        render_data->origin = GST_BUFFER_PTS (buffer);
+    }
+  else
+    {
+      /* Wait for the main thread to catch up with the mix.  */
+      render_data->step_pending = TRUE;
+      g_idle_add (render_step, render_data->app);
+      while (render_data->step_pending && !render_data->finished)
+        g_cond_wait (&render_data->step_done, &render_data->lock);
+      if (render_data->finished)
+        {
+          g_mutex_unlock (&render_data->lock);
+          return GST_PAD_PROBE_DROP;
+        }
+    }
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer)
+      && GST_BUFFER_DURATION_IS_VALID (buffer))
+    {
+      render_data->position =
+        GST_BUFFER_PTS (buffer) + GST_BUFFER_DURATION (buffer) -
+        render_data->origin;
+    }
+  g_mutex_unlock (&render_data->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Pace the output of the final mixer.  */
+void
+render_watch_mixer (GstElement *mixer_element, GApplication *app)
+{
+  struct render_info *render_data;
+
+  render_data = sep_get_render_data (app);
+  if (!render_data->enabled)
+    return;
+
+  render_data->mixer_pad = gst_element_get_static_pad (mixer_element, "src");
+  render_data->probe_id =
+    gst_pad_add_probe (render_data->mixer_pad, GST_PAD_PROBE_TYPE_BUFFER,
+                       render_probe, render_data, render_free);
+  return;
+}
+
+/* The sequencer has started.  Let the mix proceed.  */
+void
+render_start (GApplication *app)
+{
+  struct render_info *render_data;
+  gboolean deferred;
+
+  render_data = sep_get_render_data (app);
+  if (!render_data->enabled)
+    return;
+
+  g_mutex_lock (&render_data->lock);
+  if (render_data->started)
+    {
+      g_mutex_unlock (&render_data->lock);
+      return;
+    }
+  render_data->started = TRUE;
+  deferred = render_data->step_deferred;
+  render_data->step_deferred = FALSE;
+  g_mutex_unlock (&render_data->lock);
+
+  render_data->start_wall_time = g_get_monotonic_time ();
+  g_print ("Rendering to %s.\n", main_get_render_file_name ());
+  if (deferred)
+    g_idle_add (render_step, app);
+
+  return;
+}
+
+/* Return how much of the mix has been rendered.  */
+gdouble
+render_get_time (GApplication *app)
+{
+  struct render_info *render_data;
+
+  render_data = sep_get_render_data (app);
+  if (render_data == NULL)
+    return 0.0;
+  return (render_data->current_time);
+}
+
+/* Return TRUE if any sound is playing.  */
+static gboolean
+render_sounds_running (GApplication *app)
+{
+  GList *sound_effect_list;
+  struct sound_info *sound_effect;
+
+  for (sound_effect_list = sound_get_sounds_list (app);
+       sound_effect_list != NULL; sound_effect_list = sound_effect_list->next)
+    {
+      sound_effect = sound_effect_list->data;
+      if (sound_effect->running)
+        return TRUE;
+    }
+  return FALSE;
+}
+
+/* The render is complete.  Report how fast it was and shut down the
+ * pipeline.  The end of stream closes the WAV file, and then we exit.  */
+static void
+render_complete (struct render_info *render_data, GApplication *app)
+{
+  gdouble wall_time;
+
+  g_mutex_lock (&render_data->lock);
+  render_data->finished = TRUE;
+  g_mutex_unlock (&render_data->lock);
+
+  wall_time =
+    (gdouble) (g_get_monotonic_time () - render_data->start_wall_time) / 1e6;
+  g_print ("Rendered %.3f seconds of sound in %.3f seconds",
+           render_data->current_time, wall_time);
+  if (wall_time > 0.0)
+    g_print (", %.1f times real time", render_data->current_time / wall_time);
+  g_print (".\n");
+
+  gstreamer_shutdown (app);
+  return;
+}
+
+/* On the main thread, act on everything that is due by the end of the
+ * latest buffer, then let the next buffer go.  */
+static gboolean
+render_step (gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct render_info *render_data;
+  struct render_event *event;
+  gboolean finished;
+
+  render_data = sep_get_render_data (app);
+  if (render_data == NULL)
+    return G_SOURCE_REMOVE;
+
+  g_mutex_lock (&render_data->lock);
+  finished = render_data->finished;
+  if (!render_data->started)
+    {
+      /* We are still starting up.  Render_start will call us again.  */
+      render_data->step_deferred = TRUE;
+      g_mutex_unlock (&render_data->lock);
+      return G_SOURCE_REMOVE;
+    }
+  render_data->current_time =
+    (gdouble) render_data->position / (gdouble) GST_SECOND;
+  g_mutex_unlock (&render_data->lock);
+
+  if (!finished)
+    {
+      /* Send the commands that are now due.  */
+      while ((render_data->script != NULL) && !render_data->end_requested)
+        {
+          event = render_data->script->data;
+          if (event->time > render_data->current_time)
+            break;
+          if (TRACE_RENDER)
+            {
+              g_print ("%.3f: %s\n", render_data->current_time,
+                       (event->text != NULL) ? event->text : "end");
+            }
+          if (event->text == NULL)
+            render_data->end_requested = TRUE;
+          else
+            parse_net_text (strlen (event->text), event->text, app);
+          render_free_event (event);
+          render_data->script =
+            g_list_delete_link (render_data->script, render_data->script);
+        }
+
+      /* Replay the recorded events that are now due.  */
+      record_replay_due (app);
+
+      /* Run the sequencer's timers that have expired.  */
+      timer_dispatch (app);
+
+      /* When nothing more can happen, we are done.  */
+      if (render_data->end_requested
+          || ((render_data->script == NULL) && !record_replay_pending (app)
+              && !timer_pending (app) && !render_sounds_running (app)))
+        render_complete (render_data, app);
+    }
+
+  g_mutex_lock (&render_data->lock);
+  render_data->step_pending = FALSE;
+  g_cond_signal (&render_data->step_done);
+  g_mutex_unlock (&render_data->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* End of file render_subroutines.c */
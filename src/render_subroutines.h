@@ -0,0 +1,42 @@
+/*
+ * render_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+/* Subroutines defined in render_subroutines.c */
+
+/* Initialize the render subroutines, reading the render script if
+ * one was specified.  */
+void *render_init (GApplication *app);
+
+/* Stop rendering and deallocate the renderer's persistent data.  */
+void render_finish (GApplication *app);
+
+/* Pace the mix produced by the final audio mixer, so that commands
+ * and timers take effect at their proper places in it.  */
+void render_watch_mixer (GstElement *mixer_element, GApplication *app);
+
+/* The sequencer has started: begin rendering.  */
+void render_start (GApplication *app);
+
+/* Return how much of the mix has been rendered, in seconds.  */
+gdouble render_get_time (GApplication *app);
+
+/* End of file render_subroutines.h */
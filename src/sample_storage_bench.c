@@ -0,0 +1,144 @@
+/*
+ * sample_storage_bench.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compare the two ways of keeping a sound's samples in memory chosen by
+ * --sample-storage: in the format of its file, here 32-bit floating
+ * point, or compactly as packed 24-bit integers.  For each we report
+ * the memory the samples take and the time to convert them, one buffer
+ * at a time, into the 32-bit floating point the mixer uses, which is
+ * what the audioconvert element after each looper does as the sound
+ * plays.  The conversion is done by the same Gstreamer audio converter
+ * that audioconvert uses.  The program does not need the user
+ * interface.  Build it with "make sample_storage_bench" and run it with
+ * an optional number of channels, sample rate and length in seconds.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+/* The number of frames the looper sends at a time.  */
+#define PERIOD_FRAMES 1024
+
+/* Convert the samples a period at a time, and return the elapsed time
+ * in seconds.  */
+static gdouble
+measure (GstAudioFormat format, gint channels, gint rate, guint64 frames,
+         guchar *samples, gfloat *output)
+{
+  GstAudioInfo in_info, out_info;
+  GstAudioConverter *converter;
+  gpointer in[1], out[1];
+  gint sample_size;
+  guint64 frame;
+  gsize period;
+  gint64 start_time, end_time;
+
+  gst_audio_info_set_format (&in_info, format, rate, channels, NULL);
+  gst_audio_info_set_format (&out_info, GST_AUDIO_FORMAT_F32LE, rate,
+                             channels, NULL);
+  converter =
+    gst_audio_converter_new (GST_AUDIO_CONVERTER_FLAG_NONE, &in_info,
+                             &out_info, NULL);
+  sample_size = GST_AUDIO_INFO_BPF (&in_info);
+
+  start_time = g_get_monotonic_time ();
+  for (frame = 0; frame < frames; frame = frame + period)
+    {
+      period = MIN (PERIOD_FRAMES, frames - frame);
+      in[0] = samples + (frame * sample_size);
+      out[0] = output;
+      gst_audio_converter_samples (converter, GST_AUDIO_CONVERTER_FLAG_NONE,
+                                   in, period, out, period);
+    }
+  end_time = g_get_monotonic_time ();
+
+  gst_audio_converter_free (converter);
+  return ((gdouble) (end_time - start_time) / 1e6);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gint channels, rate, seconds;
+  guint64 frames, index, sample_count;
+  gfloat *float_samples, *output;
+  guchar *packed_samples;
+  gint32 value;
+  gdouble float_time, packed_time;
+
+  gst_init (&argc, &argv);
+
+  /* By default, a minute of 8-channel ambience at 96 kHz.  */
+  channels = 8;
+  rate = 96000;
+  seconds = 60;
+  if (argc > 1)
+    channels = strtol (argv[1], NULL, 0);
+  if (argc > 2)
+    rate = strtol (argv[2], NULL, 0);
+  if (argc > 3)
+    seconds = strtol (argv[3], NULL, 0);
+  if ((channels < 1) || (rate < 1) || (seconds < 1))
+    {
+      g_printerr ("The channels, rate and length must be positive.\n");
+      return EXIT_FAILURE;
+    }
+
+  frames = (guint64) rate * seconds;
+  sample_count = frames * channels;
+  float_samples = g_malloc (sample_count * 4);
+  packed_samples = g_malloc (sample_count * 3);
+  output = g_malloc (PERIOD_FRAMES * channels * sizeof (gfloat));
+
+  /* A quiet sine wave, the same in both formats.  */
+  for (index = 0; index < sample_count; index++)
+    {
+      float_samples[index] = 0.25 * sin (index * 0.001);
+      value = float_samples[index] * 8388607.0;
+      packed_samples[(index * 3)] = value;
+      packed_samples[(index * 3) + 1] = value >> 8;
+      packed_samples[(index * 3) + 2] = value >> 16;
+    }
+
+  float_time =
+    measure (GST_AUDIO_FORMAT_F32LE, channels, rate, frames,
+             (guchar *) float_samples, output);
+  packed_time =
+    measure (GST_AUDIO_FORMAT_S24LE, channels, rate, frames,
+             packed_samples, output);
+
+  g_print ("%d channels at %d Hz for %d seconds.\n", channels, rate, seconds);
+  g_print ("source  (F32LE): %8.1f MB, %7.3f seconds to play out, "
+           "%6.0f times real time.\n", sample_count * 4 / 1e6, float_time,
+           seconds / float_time);
+  g_print ("compact (S24LE): %8.1f MB, %7.3f seconds to play out, "
+           "%6.0f times real time.\n", sample_count * 3 / 1e6, packed_time,
+           seconds / packed_time);
+
+  g_free (float_samples);
+  g_free (packed_samples);
+  g_free (output);
+  return EXIT_SUCCESS;
+}
+
+/* End of file sample_storage_bench.c */
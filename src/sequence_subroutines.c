@@ -23,6 +23,7 @@
 #include "sequence_structure.h"
 #include "button_subroutines.h"
 #include "display_subroutines.h"
+#include "main.h"
 #include "sound_effects_player.h"
 #include "sound_structure.h"
 #include "sound_subroutines.h"
@@ -33,6 +34,8 @@
 struct sequence_info
 {
   GList *item_list;             /* The sequence  */
+  GList *retired_items;         /* Items dropped by a reload which are
+                                 * still in progress.  */
   gchar *next_item_name;        /* The name of the next sequence item
                                  * to be executed.  */
   GList *running;               /* The list of Start Sound items
@@ -51,6 +54,10 @@ struct sequence_info
                                  * message to the operator.  */
   guint message_id;             /* The ID of the message being displayed by the
                                  * sequencer.  */
+  gboolean headless;            /* TRUE if there is no operator display
+                                 * to keep up to date.  */
+  gchar *activity_text;         /* The activity being shown to the
+                                 * operator.  */
 };
 
 /* an entry on the running, offering or operator waiting lists */
@@ -114,7 +121,6 @@ static void execute_cancel_wait (struct sequence_item_info *the_item,
 
 static void update_operator_display (struct sequence_info *sequence_data,
                                      GApplication *app);
-static void clock_tick (void *sequence_data, GApplication *app);
 
 /* Subroutines for handling sequence items.  */
 
@@ -126,6 +132,8 @@ sequence_init (GApplication *app)
 
   sequence_data = g_malloc (sizeof (struct sequence_info));
   sequence_data->item_list = NULL;
+  sequence_data->retired_items = NULL;
+  sequence_data->next_item_name = NULL;
   sequence_data->offering = NULL;
   sequence_data->running = NULL;
   sequence_data->current_operator_wait = NULL;
@@ -133,6 +141,8 @@ sequence_init (GApplication *app)
   sequence_data->waiting = NULL;
   sequence_data->message_displaying = FALSE;
   sequence_data->message_id = 0;
+  sequence_data->headless = main_get_headless ();
+  sequence_data->activity_text = NULL;
   return (sequence_data);
 }
 
@@ -147,6 +157,153 @@ sequence_append_item (struct sequence_item_info *item, GApplication *app)
   return;
 }
 
+/* Fetch the list of sequence items.  */
+GList *
+sequence_get_item_list (GApplication *app)
+{
+  struct sequence_info *sequence_data;
+
+  sequence_data = sep_get_sequence_data (app);
+  return (sequence_data->item_list);
+}
+
+/* Replace the list of sequence items, returning the old one.  */
+GList *
+sequence_set_item_list (GList *item_list, GApplication *app)
+{
+  struct sequence_info *sequence_data;
+  GList *old_item_list;
+
+  sequence_data = sep_get_sequence_data (app);
+  old_item_list = sequence_data->item_list;
+  sequence_data->item_list = item_list;
+  return (old_item_list);
+}
+
+/* Deallocate a sequence item.  */
+void
+sequence_free_item (struct sequence_item_info *item)
+{
+  g_free (item->name);
+  g_free (item->sound_name);
+  g_free (item->tag);
+  g_free (item->next_completion);
+  g_free (item->next_termination);
+  g_free (item->next_starts);
+  g_free (item->next_sound_stopped);
+  g_free (item->next_release_started);
+  g_free (item->Q_number);
+  g_free (item->text_to_display);
+  g_free (item->next);
+  g_free (item->next_to_start);
+  g_free (item->next_play);
+  g_free (item->OSC_cue_string);
+  g_free (item->function_key);
+  g_free (item);
+  return;
+}
+
+/* Point a remembered sequence item at the item of the same name in
+ * the new sequence.  If there is none, note that the old item is
+ * still needed.  */
+static void
+reload_remembered_item (struct remember_info *remember_data,
+                        GList *new_item_list, GHashTable *needed_items)
+{
+  struct sequence_item_info *item;
+  GList *item_list;
+
+  for (item_list = new_item_list; item_list != NULL;
+       item_list = item_list->next)
+    {
+      item = item_list->data;
+      if (g_strcmp0 (item->name, remember_data->sequence_item->name) == 0)
+        {
+          remember_data->sequence_item = item;
+          return;
+        }
+    }
+  g_hash_table_add (needed_items, remember_data->sequence_item);
+  return;
+}
+
+/* Replace the sequence with one just read from the project.  Like all
+ * of the sequencer, this runs on the main thread, so it happens between
+ * cues.  Sounds, waits, offers and operator waits that are in progress
+ * continue, but refer from now on to the new items of the same names,
+ * so that when they finish the sequencer continues in the new sequence.
+ * An item in progress that is not in the new sequence is kept until
+ * a later reload finds it no longer in use.  */
+void
+sequence_reload (GList *new_item_list, GApplication *app)
+{
+  struct sequence_info *sequence_data;
+  struct remember_info *remember_data;
+  struct sequence_item_info *item;
+  GHashTable *needed_items;
+  GList *old_items, *retired_items, *item_list;
+  GList *remember_lists[4];
+  gint i;
+  gchar *trace_text;
+
+  sequence_data = sep_get_sequence_data (app);
+  needed_items = g_hash_table_new (NULL, NULL);
+
+  remember_lists[0] = sequence_data->running;
+  remember_lists[1] = sequence_data->offering;
+  remember_lists[2] = sequence_data->operator_waiting;
+  remember_lists[3] = sequence_data->waiting;
+  for (i = 0; i < 4; i++)
+    {
+      for (item_list = remember_lists[i]; item_list != NULL;
+           item_list = item_list->next)
+        {
+          remember_data = item_list->data;
+          reload_remembered_item (remember_data, new_item_list,
+                                  needed_items);
+        }
+    }
+  if (sequence_data->current_operator_wait != NULL)
+    {
+      reload_remembered_item (sequence_data->current_operator_wait,
+                              new_item_list, needed_items);
+    }
+
+  /* Free the old items, except those still in progress.  */
+  old_items = g_list_concat (sequence_data->item_list,
+                             sequence_data->retired_items);
+  retired_items = NULL;
+  for (item_list = old_items; item_list != NULL; item_list = item_list->next)
+    {
+      item = item_list->data;
+      if (g_hash_table_contains (needed_items, item))
+        retired_items = g_list_prepend (retired_items, item);
+      else
+        sequence_free_item (item);
+    }
+  g_list_free (old_items);
+  g_hash_table_destroy (needed_items);
+
+  sequence_data->item_list = new_item_list;
+  sequence_data->retired_items = retired_items;
+
+  /* Any leftover name of a next item belonged to an old item.  */
+  sequence_data->next_item_name = NULL;
+
+  if (trace_sequencer_level (app) > 0)
+    {
+      trace_text =
+        g_strdup_printf ("sequence reloaded, %d items, %d retired.",
+                         g_list_length (new_item_list),
+                         g_list_length (retired_items));
+      trace_sequencer_write (trace_text, app);
+      g_free (trace_text);
+      trace_text = NULL;
+    }
+
+  return;
+}
+
 /* Start running the sequencer.  */
 void
 sequence_start (GApplication *app)
@@ -958,6 +1115,19 @@ execute_cancel_wait (struct sequence_item_info *the_item,
   return;
 }
 
+/* Show the activity to the operator, unless it is already showing.  */
+static void
+show_activity (struct sequence_info *sequence_data, gchar *activity_text,
+               GApplication *app)
+{
+  if (g_strcmp0 (activity_text, sequence_data->activity_text) == 0)
+    return;
+  display_current_activity (activity_text, app);
+  g_free (sequence_data->activity_text);
+  sequence_data->activity_text = g_strdup (activity_text);
+  return;
+}
+
 /* Update the operator display.  Show the most important item, preferring
  * the current item in case of a tie.  */
 static void
@@ -975,6 +1145,10 @@ update_operator_display (struct sequence_info *sequence_data,
   guint64 elapsed_time, remaining_time;
   gchar *display_text;
 
+  /* With no display there is nothing to update.  */
+  if (sequence_data->headless)
+    return;
+
   found_item = FALSE;
   most_importance = 0;
   most_important = NULL;
@@ -1044,36 +1218,48 @@ update_operator_display (struct sequence_info *sequence_data,
                              (gdouble) remaining_time / 1e9);
         }
 
-      /* Display the most important activity.  */
-      display_current_activity (display_text, app);
+      /* Display the most important activity, if it has changed.  */
+      show_activity (sequence_data, display_text, app);
       g_free (display_text);
       display_text = NULL;
 
-      /* Mark the most important item as the one currently being displayed.  */
+      /* Mark the most important item as the one currently being displayed.  
+       * Its looper will tell us as its times change.  */
       if (current_display != NULL)
         {
           current_display->being_displayed = FALSE;
         }
       most_important->being_displayed = TRUE;
-
-      /* Keep updating the display every 0.1 second until there is nothing
-       * to show.  */
-      timer_create_entry (clock_tick, 0.1, sequence_data, app);
     }
   else
     {
       /* There is nothing happening.  */
-      display_current_activity ((gchar *) "", app);
+      show_activity (sequence_data, (gchar *) "", app);
     }
   return;
 }
 
-/* Come here when the 0.1-second clock ticks to update the activity display.  */
-static void
-clock_tick (void *user_data, GApplication *app)
+/* A sound's looper has told us its elapsed and remaining time.  If that
+ * sound is the one being shown to the operator, update the display.  */
+void
+sequence_sound_progress (struct sound_info *sound_effect, GApplication *app)
 {
-  struct sequence_info *sequence_data = user_data;
-  update_operator_display (sequence_data, app);
+  struct sequence_info *sequence_data;
+  struct remember_info *remember_data;
+  GList *item_list;
+
+  sequence_data = sep_get_sequence_data (app);
+  for (item_list = sequence_data->running; item_list != NULL;
+       item_list = item_list->next)
+    {
+      remember_data = item_list->data;
+      if ((remember_data->being_displayed)
+          && (remember_data->sound_effect == sound_effect))
+        {
+          update_operator_display (sequence_data, app);
+          break;
+        }
+    }
   return;
 }
 
@@ -31,6 +31,18 @@ void *sequence_init (GApplication *app);
 void sequence_append_item (struct sequence_item_info *sequence_item_data,
                            GApplication *app);
 
+/* Fetch the list of sequence items.  */
+GList *sequence_get_item_list (GApplication *app);
+
+/* Replace the list of sequence items, returning the old one.  */
+GList *sequence_set_item_list (GList *item_list, GApplication *app);
+
+/* Replace the sequence with a newly read one, between cues.  */
+void sequence_reload (GList *new_item_list, GApplication *app);
+
+/* Deallocate a sequence item.  */
+void sequence_free_item (struct sequence_item_info *item);
+
 /* Start the internal sequencer.  */
 void sequence_start (GApplication *app);
 
@@ -63,4 +75,8 @@ void sequence_sound_completion (struct sound_info *sound_effect,
 void sequence_sound_release_started (struct sound_info *sound_effect,
                                      GApplication *app);
 
+/* A sound has reported its elapsed and remaining time.  */
+void sequence_sound_progress (struct sound_info *sound_effect,
+                              GApplication *app);
+
 /* End of file sequence_subroutines.h */
@@ -24,14 +24,14 @@
 #include "signal_subroutines.h"
 #include "sound_effects_player.h"
 #include "gstreamer_subroutines.h"
+#include "record_subroutines.h"
 
 /* When debugging it can be useful to trace what is happening in the
  * signal handler.  */
 #define TRACE_SIGNALS FALSE
 
 /* the persistent data used by the signal handler */
-/* none used at the moment, but we will probably need something
- * to implement sighup.  */
+/* none used at the moment.  */
 
 struct signal_info
 {
@@ -70,6 +70,8 @@ signal_term (gpointer user_data)
       g_print ("signal term.\n");
     }
 
+  record_event ("signal", "TERM", app);
+
   /* Initiate the shutdown of the gstreamer pipeline.  When it is complete
    * the application will terminate.  */
   gstreamer_shutdown (app);
@@ -81,13 +83,18 @@ signal_term (gpointer user_data)
 static gboolean
 signal_hup (gpointer user_data)
 {
+  GApplication *app = user_data;
+
   if (TRACE_SIGNALS)
     {
       g_print ("signal hup.\n");
     }
 
-  /* TODO: shutdown the gstreamer pipeline, re-read the current project,
-   * and rebuild the gstreamer pipeline based on it.  */
+  record_event ("signal", "HUP", app);
+
+  /* Re-read the current project.  Only the sounds that have changed
+   * are rebuilt; the others keep playing.  */
+  sep_reload_project (app);
 
   return TRUE;
 }
@@ -20,19 +20,28 @@
 #include <libxml/xmlmemory.h>
 #include "display_subroutines.h"
 #include "gstreamer_subroutines.h"
+#include "loader_subroutines.h"
 #include "main.h"
+#include "memory_subroutines.h"
 #include "menu_subroutines.h"
 #include "network_subroutines.h"
 #include "parse_net_subroutines.h"
 #include "parse_xml_subroutines.h"
+#include "project_cache_subroutines.h"
+#include "profile_subroutines.h"
+#include "realtime_subroutines.h"
+#include "record_subroutines.h"
+#include "render_subroutines.h"
 #include "sequence_subroutines.h"
 #include "signal_subroutines.h"
+#include "telemetry_subroutines.h"
 #include "sound_effects_player.h"
 #include "sound_structure.h"
 #include "sound_subroutines.h"
 #include "timer_subroutines.h"
 #include "time_subroutines.h"
 #include "trace_subroutines.h"
+#include "warmup_subroutines.h"
 
 /* The private data associated with the top-level window. */
 struct _Sound_Effects_PlayerPrivate
@@ -85,6 +94,30 @@ struct _Sound_Effects_PlayerPrivate
   /* The persistent information for the network commands parser. */
   void *parse_net_data;
 
+  /* The persistent information for the telemetry subroutines.  */
+  void *telemetry_data;
+
+  /* The persistent information for the project cache subroutines.  */
+  void *project_cache_data;
+
+  /* The persistent information for the loader subroutines.  */
+  void *loader_data;
+
+  /* The persistent information for the render subroutines.  */
+  void *render_data;
+
+  /* The persistent information for the event recorder.  */
+  void *record_data;
+
+  /* The persistent information for the real-time subroutines.  */
+  void *realtime_data;
+
+  /* The persistent information for the warm-up subroutines.  */
+  void *warmup_data;
+
+  /* The persistent information for the profile subroutines.  */
+  void *profile_data;
+
   /* The XML file that holds parameters for the program. */
   xmlDocPtr configuration_file;
 
@@ -120,9 +153,10 @@ struct _Sound_Effects_PlayerPrivate
 G_DEFINE_TYPE_WITH_PRIVATE (Sound_Effects_Player, sound_effects_player,
                             GTK_TYPE_APPLICATION);
 
-/* Create a new window loading a file. */
+/* Build the top-level window from the user interface file, and find
+ * the widgets we update while running.  */
 static void
-sound_effects_player_new_window (GApplication *app, GFile *file)
+sound_effects_player_build_window (GApplication *app)
 {
   GtkWindow *top_window;
   GtkWidget *common_area;
@@ -135,24 +169,10 @@ sound_effects_player_new_window (GApplication *app, GFile *file)
   gchar *cluster_name;
   GtkWidget *cluster_widget;
   gchar *filename;
-  guint message_code;
-  GFile *parent_file;
 
   Sound_Effects_PlayerPrivate *priv =
     SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
 
-  /* Initialize the trace subroutines.  */
-  priv->trace_data = trace_init (app);
-
-  /* Initialize the signal handler.  */
-  priv->signal_data = signal_init (app);
-
-  /* Initialize the timer.  */
-  priv->timer_data = timer_init (app);
-
-  /* Remember the path to the user interface files. */
-  priv->ui_path = g_strdup (PACKAGE_DATA_DIR "/ui/");
-
   /* Load the main user interface definition from its file. */
   builder = gtk_builder_new ();
   filename =
@@ -210,7 +230,8 @@ sound_effects_player_new_window (GApplication *app, GFile *file)
 
   /* Remember where the clusters are. Each cluster has a name identifying it. */
   priv->clusters = NULL;
-  for (cluster_number = 0; cluster_number < 16; ++cluster_number)
+  for (cluster_number = 0; cluster_number < DISPLAY_CLUSTER_COUNT;
+       ++cluster_number)
     {
       cluster_name = g_strdup_printf ("cluster_%2.2d", cluster_number);
       cluster_widget =
@@ -234,6 +255,44 @@ sound_effects_player_new_window (GApplication *app, GFile *file)
   menu_init (app, filename);
   g_free (filename);
 
+  return;
+}
+
+/* Create a new window loading a file. */
+static void
+sound_effects_player_new_window (GApplication *app, GFile *file)
+{
+  guint message_code;
+  GFile *parent_file;
+
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+
+  /* Initialize the trace subroutines.  */
+  priv->trace_data = trace_init (app);
+
+  /* Initialize the signal handler.  */
+  priv->signal_data = signal_init (app);
+
+  /* Initialize the timer.  */
+  priv->timer_data = timer_init (app);
+
+  /* Remember the path to the user interface files. */
+  priv->ui_path = g_strdup (PACKAGE_DATA_DIR "/ui/");
+
+  /* When running headless there is no window, so none of the widgets
+   * exist.  The display and button subroutines know to do nothing,
+   * and the clusters are known only by number.  */
+  priv->top_window = NULL;
+  priv->common_area = NULL;
+  priv->operator_text = NULL;
+  priv->status_bar = NULL;
+  priv->context_id = 0;
+  priv->clusters = NULL;
+  priv->windows_showing = FALSE;
+  if (!main_get_headless ())
+    sound_effects_player_build_window (app);
+
   /* Set up the remainder of the private data. */
   priv->gstreamer_pipeline = NULL;
   priv->gstreamer_ready = FALSE;
@@ -254,9 +313,50 @@ sound_effects_player_new_window (GApplication *app, GFile *file)
   /* Initialize the network handler so we can set the network port number. */
   priv->network_data = network_init (app);
 
-  /* The display is initialized; time to show it. */
-  gtk_widget_show_all (GTK_WIDGET (top_window));
-  priv->windows_showing = TRUE;
+  /* Initialize the telemetry subroutines, which report our status
+   * to show control consoles.  */
+  priv->telemetry_data = telemetry_init (app);
+
+  /* Initialize the project cache, which lets us skip parsing
+   * a project that has not changed since it was last loaded.  */
+  priv->project_cache_data = project_cache_init (app);
+
+  /* Initialize the loader, which reads the sound files on
+   * background threads.  */
+  priv->loader_data = loader_init (app);
+
+  /* Initialize the renderer, which is used only when writing the mix
+   * to a file faster than real time.  */
+  priv->render_data = render_init (app);
+
+  /* Initialize the event recorder, which can record what happens to us
+   * and play it back.  */
+  priv->record_data = record_init (app);
+
+  /* Initialize the real-time subroutines, which give the audio threads
+   * priority and count dropouts.  The pipeline uses them.  */
+  priv->realtime_data = realtime_init (app);
+
+  /* Initialize the warm-up subroutines, which play each sound silently
+   * once it is loaded, if asked.  */
+  priv->warmup_data = warmup_init (app);
+
+  /* Initialize the profile subroutines, which measure the time each
+   * element of the pipeline takes, if asked.  */
+  priv->profile_data = profile_init (app);
+
+  /* The display is initialized; time to show it.  Without a window,
+   * nothing keeps the application running, so hold it until we are
+   * told to quit.  */
+  if (priv->top_window != NULL)
+    {
+      gtk_widget_show_all (GTK_WIDGET (priv->top_window));
+      priv->windows_showing = TRUE;
+    }
+  else
+    {
+      g_application_hold (app);
+    }
 
   /* Read the configuration file, which will contain the preferences
    * and the default project file.  If the configuration file has not
@@ -315,6 +415,18 @@ sound_effects_player_new_window (GApplication *app, GFile *file)
       message_code = display_show_message ("No sounds.", app);
     }
 
+  /* When rendering, the render script takes the place of the network,
+   * and if there is nothing to render we are done.  */
+  if (main_get_render_file_name () != NULL)
+    {
+      if (priv->gstreamer_pipeline == NULL)
+        {
+          g_printerr ("There is nothing to render.\n");
+          g_application_quit (app);
+        }
+      return;
+    }
+
   /* Listen for network messages, since the network port is
    * now determined.  */
   network_bind_port (app);
@@ -367,6 +479,35 @@ sound_effects_player_open (GApplication *application, GFile **files,
     sound_effects_player_new_window (application, files[i]);
 }
 
+/* When running headless, skip GtkApplication's startup and shutdown,
+ * which initialize GTK and need a display, and go straight to
+ * GApplication's.  */
+static void
+sound_effects_player_startup (GApplication *application)
+{
+  GApplicationClass *app_class;
+
+  if (main_get_headless ())
+    app_class = g_type_class_peek (G_TYPE_APPLICATION);
+  else
+    app_class = G_APPLICATION_CLASS (sound_effects_player_parent_class);
+  app_class->startup (application);
+  return;
+}
+
+static void
+sound_effects_player_shutdown (GApplication *application)
+{
+  GApplicationClass *app_class;
+
+  if (main_get_headless ())
+    app_class = g_type_class_peek (G_TYPE_APPLICATION);
+  else
+    app_class = G_APPLICATION_CLASS (sound_effects_player_parent_class);
+  app_class->shutdown (application);
+  return;
+}
+
 static void
 sound_effects_player_init (Sound_Effects_Player *object)
 {
@@ -379,12 +520,45 @@ sound_effects_player_dispose (GObject *object)
   GApplication *app = (GApplication *) object;
   Sound_Effects_Player *self = (Sound_Effects_Player *) object;
 
+  /* Report the memory used, if asked, while the sounds are still here.  */
+  if ((self->priv->gstreamer_pipeline != NULL) && main_get_memory_report ())
+    memory_report (app);
+
+  /* Stop loading sounds before the loopers go away.  */
+  loader_finish (app);
+  self->priv->loader_data = NULL;
+
+  /* Stop warming up sounds, and let them be heard.  */
+  warmup_finish (app);
+  self->priv->warmup_data = NULL;
+
+  /* Stop rendering, so the pipeline is not waiting for us.  */
+  render_finish (app);
+  self->priv->render_data = NULL;
+
+  /* Stop recording and replaying events.  */
+  record_finish (app);
+  self->priv->record_data = NULL;
+
+  /* Cancel the OSC bundles waiting on the pipeline's clock.  */
+  parse_net_finish (app);
+  self->priv->parse_net_data = NULL;
+
   /* Deallocate the gstreamer pipeline.  */
   if (self->priv->gstreamer_pipeline != NULL)
     {
       self->priv->gstreamer_pipeline = gstreamer_dispose (app);
     }
 
+  /* The streaming threads are gone, so they no longer need the
+   * real-time subroutines.  */
+  realtime_finish (app);
+  self->priv->realtime_data = NULL;
+
+  /* Stop summarizing the profile.  */
+  profile_finish (app);
+  self->priv->profile_data = NULL;
+
   /* Deallocate the persistent data used by the display subroutines.  */
   display_finish (app);
   
@@ -421,6 +595,14 @@ sound_effects_player_dispose (GObject *object)
       self->priv->configuration_filename = NULL;
     }
 
+  /* Stop sending status reports.  */
+  telemetry_finish (app);
+  self->priv->telemetry_data = NULL;
+
+  /* Deallocate the project cache information.  */
+  project_cache_finish (app);
+  self->priv->project_cache_data = NULL;
+
   /* Shut down the trace subroutines.  */
   trace_finalize (app);
   self->priv->trace_data = NULL;
@@ -441,6 +623,8 @@ sound_effects_player_class_init (Sound_Effects_PlayerClass *klass)
 {
   G_APPLICATION_CLASS (klass)->activate = sound_effects_player_activate;
   G_APPLICATION_CLASS (klass)->open = sound_effects_player_open;
+  G_APPLICATION_CLASS (klass)->startup = sound_effects_player_startup;
+  G_APPLICATION_CLASS (klass)->shutdown = sound_effects_player_shutdown;
   G_OBJECT_CLASS (klass)->dispose = sound_effects_player_dispose;
   G_OBJECT_CLASS (klass)->finalize = sound_effects_player_finalize;
 }
@@ -466,7 +650,7 @@ sep_gstreamer_ready (GApplication *app)
   priv->gstreamer_ready = TRUE;
 
   /* If we aren't yet showing the top-level window, show it now.  */
-  if (!priv->windows_showing)
+  if ((!priv->windows_showing) && (priv->top_window != NULL))
     {
       gtk_widget_show_all (GTK_WIDGET (priv->top_window));
       priv->windows_showing = TRUE;
@@ -477,6 +661,12 @@ sep_gstreamer_ready (GApplication *app)
 
   /* Start the internal sequencer.  */
   sequence_start (app);
+
+  /* Note the start in the event record, and start any replay.  */
+  record_start (app);
+
+  /* If we are rendering, the mix can now proceed.  */
+  render_start (app);
   return;
 }
 
@@ -496,6 +686,81 @@ sep_create_pipeline (gchar * filename, GApplication *app)
   return;
 }
 
+/* Re-read the project file and bring the sounds and the sequence up to
+ * date without stopping the pipeline, so the sounds that are playing
+ * carry on.  This is done on SIGHUP and by the network Reload command.  */
+void
+sep_reload_project (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  GList *old_sounds_list, *new_sounds_list;
+  GList *old_item_list, *new_item_list;
+  gint old_port;
+  gint64 old_speaker_count;
+  guint message_code;
+
+  if ((priv->project_file_name == NULL)
+      || (priv->gstreamer_pipeline == NULL) || (!priv->gstreamer_ready))
+    {
+      display_show_message ("Cannot reload until the sounds are running.",
+                            app);
+      return;
+    }
+
+  /* OSC bundles held for later were sent for the old project.  */
+  parse_net_cancel_bundles (app);
+
+  message_code = display_show_message ("Reloading...", app);
+
+  /* Read the project into empty lists, leaving the running sounds and
+   * sequence where they are.  The project cache is used as usual;
+   * it knows whether any of the files have changed.  The speaker count
+   * starts from nothing, as it did when the project was first read,
+   * since sound_start may have raised it to cover all the speakers.  */
+  old_port = network_get_port (app);
+  old_speaker_count = sep_get_speaker_count (app);
+  sep_set_speaker_count (0, app);
+  sep_set_speaker_count_filename (NULL, app);
+  old_sounds_list = sound_set_sounds_list (NULL, app);
+  old_item_list = sequence_set_item_list (NULL, app);
+  parse_xml_read_project_file (priv->project_folder_name,
+                               priv->project_file_name, app);
+  new_sounds_list = sound_set_sounds_list (old_sounds_list, app);
+  new_item_list = sequence_set_item_list (old_item_list, app);
+  display_remove_message (message_code, app);
+
+  /* We are already listening on the network port, and the final bin
+   * was built for the speakers we have.  */
+  if (network_get_port (app) != old_port)
+    {
+      g_printerr ("The network port has changed; "
+                  "restart the program to use it.\n");
+      network_set_port (old_port, app);
+    }
+  if (sep_get_speaker_count (app) > old_speaker_count)
+    {
+      g_printerr ("The speaker count has increased; "
+                  "restart the program to use it.\n");
+      sep_set_speaker_count (old_speaker_count, app);
+      g_list_free_full (new_sounds_list, (GDestroyNotify) sound_free_sound);
+      g_list_free_full (new_item_list, (GDestroyNotify) sequence_free_item);
+      display_show_message ("Reload failed.", app);
+      return;
+    }
+  sep_set_speaker_count (old_speaker_count, app);
+
+  if (!sound_reload (new_sounds_list, app))
+    {
+      g_list_free_full (new_item_list, (GDestroyNotify) sequence_free_item);
+      display_show_message ("Reload failed.", app);
+      return;
+    }
+  sequence_reload (new_item_list, app);
+
+  return;
+}
+
 /* Find the gstreamer pipeline.  */
 GstPipeline *
 sep_get_pipeline_from_app (GApplication *app)
@@ -690,6 +955,102 @@ sep_get_trace_data (GApplication *app)
   return (trace_data);
 }
 
+/* Find the telemetry subroutines' persistent data.  */
+void *
+sep_get_telemetry_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *telemetry_data;
+
+  telemetry_data = priv->telemetry_data;
+  return (telemetry_data);
+}
+
+/* Find the project cache subroutines' persistent data.  */
+void *
+sep_get_project_cache_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *project_cache_data;
+
+  project_cache_data = priv->project_cache_data;
+  return (project_cache_data);
+}
+
+/* Find the loader subroutines' persistent data.  */
+void *
+sep_get_loader_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *loader_data;
+
+  loader_data = priv->loader_data;
+  return (loader_data);
+}
+
+/* Find the render subroutines' persistent data.  */
+void *
+sep_get_render_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *render_data;
+
+  render_data = priv->render_data;
+  return (render_data);
+}
+
+/* Find the event recorder's persistent data.  */
+void *
+sep_get_record_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *record_data;
+
+  record_data = priv->record_data;
+  return (record_data);
+}
+
+/* Find the real-time subroutines' persistent data.  */
+void *
+sep_get_realtime_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *realtime_data;
+
+  realtime_data = priv->realtime_data;
+  return (realtime_data);
+}
+
+/* Find the warm-up subroutines' persistent data.  */
+void *
+sep_get_warmup_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *warmup_data;
+
+  warmup_data = priv->warmup_data;
+  return (warmup_data);
+}
+
+/* Find the profile subroutines' persistent data.  */
+void *
+sep_get_profile_data (GApplication *app)
+{
+  Sound_Effects_PlayerPrivate *priv =
+    SOUND_EFFECTS_PLAYER_APPLICATION (app)->priv;
+  void *profile_data;
+
+  profile_data = priv->profile_data;
+  return (profile_data);
+}
+
 /* Find the network commands parser information.  
  * The parameter passed is the application.  */
 void *
@@ -63,6 +63,9 @@ void sep_gstreamer_ready (GApplication *app);
 /* Create the gstreamer pipeline by reading an XML file.  */
 void sep_create_pipeline (gchar *filename, GApplication *app);
 
+/* Re-read the project, keeping the sounds that have not changed.  */
+void sep_reload_project (GApplication *app);
+
 /* Find the gstreamer pipeline.  */
 GstPipeline *sep_get_pipeline_from_app (GApplication *app);
 
@@ -91,6 +94,30 @@ void *sep_get_network_data (GApplication *app);
 /* Find the trace information.  */
 void *sep_get_trace_data (GApplication *app);
 
+/* Find the telemetry information.  */
+void *sep_get_telemetry_data (GApplication *app);
+
+/* Find the project cache information.  */
+void *sep_get_project_cache_data (GApplication *app);
+
+/* Find the loader information.  */
+void *sep_get_loader_data (GApplication *app);
+
+/* Find the render information.  */
+void *sep_get_render_data (GApplication *app);
+
+/* Find the event recorder information.  */
+void *sep_get_record_data (GApplication *app);
+
+/* Find the real-time information.  */
+void *sep_get_realtime_data (GApplication *app);
+
+/* Find the warm-up information.  */
+void *sep_get_warmup_data (GApplication *app);
+
+/* Find the profile information.  */
+void *sep_get_profile_data (GApplication *app);
+
 /* Find the network messages parser information. */
 void *sep_get_parse_net_data (GApplication *app);
 
@@ -29,6 +29,9 @@
 #include <gtk/gtk.h>
 #include <gst/gst.h>
 
+/* The most copies of one sound that can play at once.  */
+#define MAX_VOICES 64
+
 struct sound_info
 {
   gchar *name;                  /* name of the sound */
@@ -60,21 +63,59 @@ struct sound_info
   gchar *function_key;          /* name of function key */
   gboolean function_key_specified;      /* TRUE if not empty */
   gboolean omit_panning;        /* Do not let the operator pan this sound.  */
+  gboolean compact_storage;     /* Keep wide samples as packed 24-bit.  */
+  gboolean compact_storage_specified;   /* TRUE if not the default */
 
   guint64 starting_time;        /* the time that the sound started playing.  */
   guint64 releasing_time;       /* the time that the sound entered the
                                  * release segment of its envelope.  */
   GtkWidget *cluster_widget;    /* The cluster this sound is in.  */
   GstBin *sound_control;        /* The Gstreamer bin for this sound effect */
+  GstElement *looper_element;   /* The looper in that bin.  */
+  guint64 elapsed_time;         /* How long the sound has been playing and */
+  guint64 remaining_time;       /* how much longer it will play, as last
+                                 * reported by the looper.  */
+  gint64 wav_file_time;         /* When the WAV file was last modified,
+                                 * as of when the bin was built.  */
   gint cluster_number;          /* The number of the cluster the sound is in */
   gboolean running;             /* The sound is playing.  */
   gboolean release_sent;        /* A Release command was given.  */
   gboolean release_has_started; /* The sound has started its release stage.  */
   gchar *format_name;           /* The format of the WAV file.  */
+  const gchar *storage_format_name;     /* The format the samples are kept
+                                         * in, as of when the bin was
+                                         * built.  */
   gint channel_count;           /* The number of channels in this sound's wav
 				 * file.  Momo = 1, stereo = 2, etc.  */
+  gint sample_rate;             /* Frames per second in the WAV file.  */
   guint64 channel_mask;         /* A bit set for each speaker.  */
   GList *channels;              /* Information about each channel.  */
+  gint max_voices;              /* How many copies of this sound can play
+                                 * at once.  */
+  GList *voices;                /* The extra copies: one voice_info for
+                                 * each beyond the first, which uses the
+                                 * fields above.  */
+  gboolean stolen;              /* The sound was released to make room for
+                                 * another, and no longer counts against
+                                 * the voice limit.  */
+  gboolean warmed;              /* The sound has been given to the warm-up
+                                 * subroutines.  */
+};
+
+/* An extra voice of a sound, which lets the sound be started again
+ * while it is already playing.  Each voice has its own Gstreamer bin,
+ * but all the voices of a sound share its samples.  */
+struct voice_info
+{
+  struct sound_info *sound;     /* The sound this is a voice of.  */
+  gint number;                  /* 1, 2, ...; the sound itself is 0.  */
+  GstBin *sound_control;        /* The Gstreamer bin for this voice.  */
+  GstElement *looper_element;   /* The looper in that bin.  */
+  guint64 starting_time;        /* When the voice started playing.  */
+  gboolean running;             /* The voice is playing.  */
+  gboolean release_sent;        /* A Release command was given.  */
+  gboolean release_has_started; /* The voice is in its release stage.  */
+  gboolean stolen;              /* Released to make room for another.  */
 };
 
 struct channel_info
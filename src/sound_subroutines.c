@@ -19,6 +19,7 @@
 
 #include <stdlib.h>
 #include <inttypes.h>
+#include <glib/gstdio.h>
 #include <gst/gst.h>
 #include "sound_subroutines.h"
 #include "sound_structure.h"
@@ -26,18 +27,50 @@
 #include "gstreamer_subroutines.h"
 #include "button_subroutines.h"
 #include "display_subroutines.h"
+#include "loader_subroutines.h"
 #include "sequence_subroutines.h"
+#include "telemetry_subroutines.h"
+#include "decoder_subroutines.h"
+#include "warmup_subroutines.h"
+#include "main.h"
 
 #define TRACE_SOUND FALSE
 
+/* How to choose a sound to release when the voice limit is reached.  */
+enum voice_stealing
+{
+  steal_oldest,                 /* the one that started first */
+  steal_quietest,               /* the one with the lowest volume */
+  steal_releasing               /* one that is already releasing, or
+                                 * else the oldest */
+};
+
+/* A voice which might be released to make room for another.  */
+struct voice_victim
+{
+  struct sound_info *sound;
+  struct voice_info *voice;     /* NULL for the sound's first voice */
+  guint64 starting_time;
+  gboolean releasing;
+  gfloat volume;
+};
+
 /* The persistent data used by the sound subroutines.  */
 struct sounds_info
 {
   GList *sounds_list;              /* The list of sounds.  */
+  GList *retired_list;             /* Sounds dropped by a reload, which
+                                    * the loader might still refer to.  */
   guint64 channel_mask;            /* a bit set for each speaker */
   gpointer *speaker_abbreviations; /* A speaker name for each output channel.
                                     */
   gint speaker_count;              /* The number of speakers.  */
+  gint voice_limit;                /* The most voices that may play at
+                                    * once, or 0 for no limit.  */
+  enum voice_stealing voice_stealing;   /* which voice to release at
+                                         * that limit */
+  gboolean compact_storage;        /* Keep wide samples as 24-bit unless
+                                    * a sound says otherwise.  */
 };
   
 /* Subroutines for processing sounds.  */
@@ -50,60 +83,86 @@ sound_init (GApplication *app)
 
   sounds_data = g_malloc (sizeof (struct sounds_info));
   sounds_data->sounds_list = NULL;
+  sounds_data->retired_list = NULL;
   sounds_data->channel_mask = 0;
   sounds_data->speaker_abbreviations = NULL;
+
+  sounds_data->voice_limit = MAX (main_get_voice_limit (), 0);
+  sounds_data->voice_stealing = steal_releasing;
+  if (g_strcmp0 (main_get_voice_stealing_string (), "oldest") == 0)
+    sounds_data->voice_stealing = steal_oldest;
+  else if (g_strcmp0 (main_get_voice_stealing_string (), "quietest") == 0)
+    sounds_data->voice_stealing = steal_quietest;
+  else if ((main_get_voice_stealing_string () != NULL)
+           && (g_strcmp0 (main_get_voice_stealing_string (), "releasing")
+               != 0))
+    g_printerr ("Unknown voice stealing policy %s; using releasing.\n",
+                main_get_voice_stealing_string ());
+
+  sounds_data->compact_storage =
+    (g_strcmp0 (main_get_sample_storage_string (), "compact") == 0);
+  if ((main_get_sample_storage_string () != NULL)
+      && !sounds_data->compact_storage
+      && (g_strcmp0 (main_get_sample_storage_string (), "source") != 0))
+    g_printerr ("Unknown sample storage %s; using source.\n",
+                main_get_sample_storage_string ());
   return (sounds_data);
 }
 
-/* Terminate the sound system.  */
+/* Deallocate a sound, including its channels and speakers.  */
 void
-sound_finish (GApplication *app)
+sound_free_sound (struct sound_info *sound_effect)
 {
-  struct sounds_info *sounds_data;
-  struct sound_info *sound_effect;
   struct channel_info *this_channel;
   struct speaker_info *this_speaker;
-  GList *sound_effect_list, *channel_list, *speaker_list;
-  GList *next_sound_effect, *next_channel, *next_speaker;
-  
-  /* Free all the heap storage allocated by the sound subroutines.  */
-  sounds_data = sep_get_sounds_data (app);
-  sound_effect_list = sounds_data->sounds_list;
-  
-  while (sound_effect_list != NULL)
+  GList *channel_list, *speaker_list;
+  GList *next_channel, *next_speaker;
+
+  g_free (sound_effect->name);
+  g_free (sound_effect->wav_file_name);
+  g_free (sound_effect->wav_file_name_full);
+  g_free (sound_effect->function_key);
+  channel_list = sound_effect->channels;
+  while (channel_list != NULL)
     {
-      sound_effect = sound_effect_list->data;
-      next_sound_effect = sound_effect_list->next;
-      g_free (sound_effect->name);
-      g_free (sound_effect->wav_file_name);
-      g_free (sound_effect->wav_file_name_full);
-      g_free (sound_effect->function_key);
-      channel_list = sound_effect->channels;
-      while (channel_list != NULL)
+      next_channel = channel_list->next;
+      this_channel = channel_list->data;
+      speaker_list = this_channel->speakers;
+      while (speaker_list != NULL)
 	{
-	  next_channel = channel_list->next;
-	  this_channel = channel_list->data;
-	  speaker_list = this_channel->speakers;
-	  while (speaker_list != NULL)
-	    {
-	      next_speaker = speaker_list->next;
-	      this_speaker = speaker_list->data;
-	      g_free (this_speaker->name);
-	      g_free (this_speaker);
-	      this_channel->speakers =
-		g_list_delete_link (this_channel->speakers, speaker_list);
-	      speaker_list = next_speaker;
-	    }
-	  g_free (this_channel);
-	  sound_effect->channels =
-	    g_list_delete_link (sound_effect->channels, channel_list);
-	  channel_list = next_channel;
+	  next_speaker = speaker_list->next;
+	  this_speaker = speaker_list->data;
+	  g_free (this_speaker->name);
+	  g_free (this_speaker);
+	  this_channel->speakers =
+	    g_list_delete_link (this_channel->speakers, speaker_list);
+	  speaker_list = next_speaker;
 	}
-      g_free (sound_effect);
-      sounds_data->sounds_list =
-        g_list_delete_link (sounds_data->sounds_list, sound_effect_list);
-      sound_effect_list = next_sound_effect;
+      g_free (this_channel);
+      sound_effect->channels =
+	g_list_delete_link (sound_effect->channels, channel_list);
+      channel_list = next_channel;
     }
+  g_list_free_full (sound_effect->voices, g_free);
+  sound_effect->voices = NULL;
+  g_free (sound_effect);
+  return;
+}
+
+/* Terminate the sound system.  */
+void
+sound_finish (GApplication *app)
+{
+  struct sounds_info *sounds_data;
+  
+  /* Free all the heap storage allocated by the sound subroutines.  */
+  sounds_data = sep_get_sounds_data (app);
+  g_list_free_full (sounds_data->sounds_list,
+                    (GDestroyNotify) sound_free_sound);
+  sounds_data->sounds_list = NULL;
+  g_list_free_full (sounds_data->retired_list,
+                    (GDestroyNotify) sound_free_sound);
+  sounds_data->retired_list = NULL;
 
   g_free (sounds_data->speaker_abbreviations);
   sounds_data->speaker_abbreviations = NULL;
@@ -1210,6 +1269,7 @@ sound_process_speakers (struct sounds_info *sounds_data,
 	}
     }
 
+  g_free (sounds_data->speaker_abbreviations);
   sounds_data->speaker_abbreviations = speaker_abbreviations;
   sounds_data->speaker_count = speaker_count;
   
@@ -1276,6 +1336,114 @@ sound_process_speakers (struct sounds_info *sounds_data,
   return;
 }
 
+/* Find when a file was last modified, so that a reload can tell
+ * whether a sound's samples have changed.  Returns 0 if the file
+ * cannot be examined.  */
+static gint64
+sound_file_time (const gchar *file_name)
+{
+  GStatBuf stat_buf;
+
+  if ((file_name == NULL) || (g_stat (file_name, &stat_buf) != 0))
+    return 0;
+  return ((gint64) stat_buf.st_mtime);
+}
+
+/* Build the Gstreamer bins for the extra voices of a sound.  While the
+ * pipeline is being built, pipeline_element is not NULL and the voices
+ * use the final bin's inputs starting at *sound_number.  Once it is
+ * running, pipeline_element is NULL and each voice gets a new input.  */
+static void
+sound_build_voices (struct sound_info *sound_data, gint *sound_number,
+                    GstPipeline *pipeline_element, GApplication *app)
+{
+  struct voice_info *voice_data;
+  GstBin *bin_element;
+  gint voice_number;
+
+  for (voice_number = 1; voice_number < sound_data->max_voices;
+       voice_number++)
+    {
+      voice_data = g_malloc0 (sizeof (struct voice_info));
+      voice_data->sound = sound_data;
+      voice_data->number = voice_number;
+      if (pipeline_element != NULL)
+        {
+          bin_element =
+            gstreamer_create_bin (sound_data, voice_data, *sound_number,
+                                  pipeline_element, app);
+          if (bin_element != NULL)
+            *sound_number = *sound_number + 1;
+        }
+      else
+        {
+          bin_element = gstreamer_add_bin (sound_data, voice_data, app);
+        }
+      if (bin_element == NULL)
+        {
+          g_printerr ("Unable to create voice %d of sound %s.\n",
+                      voice_number, sound_data->name);
+          g_free (voice_data);
+          break;
+        }
+      voice_data->sound_control = bin_element;
+      sound_data->voices = g_list_append (sound_data->voices, voice_data);
+    }
+  return;
+}
+
+/* Choose the format in which a sound's samples are kept in memory.
+ * Normally that is the format of its file, but samples wider than 24
+ * bits may be kept as packed 24-bit integers instead, which is more
+ * than the precision of the output and takes less memory.  The looper
+ * plays them in that format, and they are converted to floating point
+ * for the mixer a buffer at a time, as any other format is.  */
+static void
+sound_choose_storage (struct sound_info *sound_data, GApplication *app)
+{
+  struct sounds_info *sounds_data;
+  gboolean compact;
+
+  sounds_data = sep_get_sounds_data (app);
+  compact = sounds_data->compact_storage;
+  if (sound_data->compact_storage_specified)
+    compact = sound_data->compact_storage;
+
+  sound_data->storage_format_name = sound_data->format_name;
+  if (compact
+      && ((g_strcmp0 (sound_data->format_name, "S32LE") == 0)
+          || (g_strcmp0 (sound_data->format_name, "F32LE") == 0)
+          || (g_strcmp0 (sound_data->format_name, "F64LE") == 0)))
+    sound_data->storage_format_name = "S24LE";
+
+  if (TRACE_SOUND)
+    {
+      g_print ("Sound %s is kept as %s.\n", sound_data->name,
+               sound_data->storage_format_name);
+    }
+  return;
+}
+
+/* Take the bins of a sound's extra voices out of the running pipeline.  */
+static void
+sound_remove_voices (struct sound_info *sound_data, GApplication *app)
+{
+  struct voice_info *voice_data;
+  GList *l;
+
+  for (l = sound_data->voices; l != NULL; l = l->next)
+    {
+      voice_data = l->data;
+      if (voice_data->sound_control != NULL)
+        {
+          gstreamer_remove_bin (voice_data->sound_control, app);
+          voice_data->sound_control = NULL;
+          voice_data->looper_element = NULL;
+        }
+    }
+  return;
+}
+
 /* Start the sound system.  We have already read an XML file
  * containing sound definitions and put the results in the sound list.  */
 GstPipeline *
@@ -1284,7 +1452,7 @@ sound_start (GApplication *app)
   GstPipeline *pipeline_element;
   GstBin *bin_element;
   GList *sound_list;
-  gint sound_number, sound_count;
+  gint sound_number, sound_count, bin_count;
   GList *l;
   struct sound_info *sound_data;
   struct sounds_info *sounds_data;
@@ -1296,14 +1464,17 @@ sound_start (GApplication *app)
   /* Handle the speakers.  */
   sound_process_speakers (sounds_data, app);
 
-  /* Count the non-disabled sounds.  */
+  /* Count the non-disabled sounds, and the bins they need: one for
+   * each voice.  */
   sound_count = 0;
+  bin_count = 0;
   for (l = sound_list; l != NULL; l = l->next)
     {
       sound_data = l->data;
       if (!sound_data->disabled)
 	{
 	  sound_count = sound_count + 1;
+	  bin_count = bin_count + sound_data->max_voices;
 	}
     }
 
@@ -1314,7 +1485,7 @@ sound_start (GApplication *app)
       return NULL;
     }
 
-  pipeline_element = gstreamer_init (sound_count, app);
+  pipeline_element = gstreamer_init (bin_count, app);
   if (pipeline_element == NULL)
     {
       /* We are unable to create the gstreamer pipeline.  */
@@ -1329,9 +1500,10 @@ sound_start (GApplication *app)
       sound_data = l->data;
       if (!sound_data->disabled)
         {
+          sound_choose_storage (sound_data, app);
           bin_element =
-            gstreamer_create_bin (sound_data, sound_number, pipeline_element,
-                                  app);
+            gstreamer_create_bin (sound_data, NULL, sound_number,
+                                  pipeline_element, app);
 
           if (bin_element == NULL)
             {
@@ -1343,7 +1515,15 @@ sound_start (GApplication *app)
             }
 
           sound_data->sound_control = bin_element;
+          sound_data->wav_file_time =
+            sound_file_time (sound_data->wav_file_name_full);
           sound_number = sound_number + 1;
+          sound_build_voices (sound_data, &sound_number, pipeline_element,
+                              app);
+
+          /* Read the sound's samples on a background thread.  All of
+           * its voices will share them.  */
+          loader_preload_sound (sound_data, app);
         }
     }
 
@@ -1371,48 +1551,348 @@ void
 sound_cluster_set_name (gchar *sound_name, guint cluster_number,
                         GApplication *app)
 {
-  GList *children_list;
-  const char *child_name;
-  GtkLabel *title_label;
-  GtkWidget *cluster;
+  struct display_cluster_info *cluster_info;
 
   /* find the cluster */
-  cluster = sep_get_cluster_from_number (cluster_number, app);
-
-  if (cluster == NULL)
+  cluster_info = display_get_cluster (cluster_number, app);
+  if ((cluster_info == NULL) || (cluster_info->title_label == NULL))
     return;
 
   /* Set the name in the cluster.  */
-  title_label = NULL;
-  children_list = gtk_container_get_children (GTK_CONTAINER (cluster));
-  while (children_list != NULL)
+  gtk_label_set_label (cluster_info->title_label, sound_name);
+}
+
+/* Append a sound to the list of sounds. */
+void
+sound_append_sound (struct sound_info *sound_effect, GApplication *app)
+{
+  struct sounds_info *sounds_data;
+
+  sounds_data = sep_get_sounds_data (app);
+  sounds_data->sounds_list = g_list_append (sounds_data->sounds_list,
+					    sound_effect);
+  return;
+}
+
+/* Fetch the list of sounds.  */
+GList *
+sound_get_sounds_list (GApplication *app)
+{
+  struct sounds_info *sounds_data;
+
+  sounds_data = sep_get_sounds_data (app);
+  return (sounds_data->sounds_list);
+}
+
+/* Replace the list of sounds, returning the old one.  */
+GList *
+sound_set_sounds_list (GList *sounds_list, GApplication *app)
+{
+  struct sounds_info *sounds_data;
+  GList *old_sounds_list;
+
+  sounds_data = sep_get_sounds_data (app);
+  old_sounds_list = sounds_data->sounds_list;
+  sounds_data->sounds_list = sounds_list;
+  return (old_sounds_list);
+}
+
+/* Find a sound in a list, given its name.  */
+static struct sound_info *
+find_sound_by_name (gchar *sound_name, GList *sounds_list)
+{
+  struct sound_info *sound_effect;
+
+  for (; sounds_list != NULL; sounds_list = sounds_list->next)
+    {
+      sound_effect = sounds_list->data;
+      if (g_strcmp0 (sound_name, sound_effect->name) == 0)
+        return (sound_effect);
+    }
+  return (NULL);
+}
+
+/* Compare the speakers of two sounds.  */
+static gboolean
+sound_speakers_equal (struct sound_info *old_sound,
+                      struct sound_info *new_sound)
+{
+  GList *old_channels, *new_channels, *old_speakers, *new_speakers;
+  struct channel_info *old_channel, *new_channel;
+  struct speaker_info *old_speaker, *new_speaker;
+
+  old_channels = old_sound->channels;
+  new_channels = new_sound->channels;
+  while ((old_channels != NULL) && (new_channels != NULL))
     {
-      child_name = gtk_widget_get_name (children_list->data);
-      if (g_strcmp0 (child_name, "title") == 0)
+      old_channel = old_channels->data;
+      new_channel = new_channels->data;
+      if (old_channel->number != new_channel->number)
+        return (FALSE);
+      old_speakers = old_channel->speakers;
+      new_speakers = new_channel->speakers;
+      while ((old_speakers != NULL) && (new_speakers != NULL))
         {
-          title_label = children_list->data;
-          break;
+          old_speaker = old_speakers->data;
+          new_speaker = new_speakers->data;
+          if ((g_strcmp0 (old_speaker->name, new_speaker->name) != 0)
+              || (old_speaker->volume_level != new_speaker->volume_level))
+            return (FALSE);
+          old_speakers = old_speakers->next;
+          new_speakers = new_speakers->next;
         }
-      children_list = children_list->next;
+      if ((old_speakers != NULL) || (new_speakers != NULL))
+        return (FALSE);
+      old_channels = old_channels->next;
+      new_channels = new_channels->next;
     }
-  g_list_free (children_list);
+  return ((old_channels == NULL) && (new_channels == NULL));
+}
+
+/* Determine whether a sound that was just read is the same as the one
+ * we are using, and its WAV file has not been changed since we read it.
+ * If so, the sound's bin does not need to be rebuilt.  */
+static gboolean
+sound_unchanged (struct sound_info *old_sound, struct sound_info *new_sound)
+{
+  if ((old_sound->disabled != new_sound->disabled)
+      || (g_strcmp0 (old_sound->wav_file_name_full,
+                     new_sound->wav_file_name_full) != 0)
+      || (old_sound->attack_duration_time != new_sound->attack_duration_time)
+      || (old_sound->attack_level != new_sound->attack_level)
+      || (old_sound->decay_duration_time != new_sound->decay_duration_time)
+      || (old_sound->sustain_level != new_sound->sustain_level)
+      || (old_sound->release_start_time != new_sound->release_start_time)
+      || (old_sound->release_duration_time
+          != new_sound->release_duration_time)
+      || (old_sound->release_duration_infinite
+          != new_sound->release_duration_infinite)
+      || (old_sound->loop_from_time != new_sound->loop_from_time)
+      || (old_sound->loop_to_time != new_sound->loop_to_time)
+      || (old_sound->loop_limit != new_sound->loop_limit)
+      || (old_sound->max_duration_time != new_sound->max_duration_time)
+      || (old_sound->start_time != new_sound->start_time)
+      || (old_sound->designer_volume_level
+          != new_sound->designer_volume_level)
+      || (old_sound->designer_pan != new_sound->designer_pan)
+      || (old_sound->default_volume_level != new_sound->default_volume_level)
+      || (old_sound->MIDI_program_number_specified
+          != new_sound->MIDI_program_number_specified)
+      || (old_sound->MIDI_program_number != new_sound->MIDI_program_number)
+      || (old_sound->MIDI_note_number_specified
+          != new_sound->MIDI_note_number_specified)
+      || (old_sound->MIDI_note_number != new_sound->MIDI_note_number)
+      || (g_strcmp0 (old_sound->function_key, new_sound->function_key) != 0)
+      || (old_sound->omit_panning != new_sound->omit_panning)
+      || (old_sound->compact_storage != new_sound->compact_storage)
+      || (old_sound->compact_storage_specified
+          != new_sound->compact_storage_specified)
+      || (old_sound->channel_count != new_sound->channel_count)
+      || (g_strcmp0 (old_sound->format_name, new_sound->format_name) != 0)
+      || (old_sound->sample_rate != new_sound->sample_rate)
+      || (old_sound->max_voices != new_sound->max_voices)
+      || !sound_speakers_equal (old_sound, new_sound))
+    return (FALSE);
+
+  if ((!old_sound->disabled)
+      && (old_sound->wav_file_time
+          != sound_file_time (old_sound->wav_file_name_full)))
+    return (FALSE);
+
+  return (TRUE);
+}
+
+/* A sound is busy if it, or one of its voices, is playing, or if it is
+ * still shown on a cluster.  The sequencer refers to a busy sound, so we
+ * must not replace it.  */
+static gboolean
+sound_busy (struct sound_info *sound_effect)
+{
+  GList *l;
+  struct voice_info *voice_data;
 
-  if (title_label != NULL)
+  for (l = sound_effect->voices; l != NULL; l = l->next)
     {
-      gtk_label_set_label (title_label, sound_name);
+      voice_data = l->data;
+      if (voice_data->running)
+        return (TRUE);
     }
+  return (sound_effect->running || (sound_effect->cluster_widget != NULL));
 }
 
-/* Append a sound to the list of sounds. */
-void
-sound_append_sound (struct sound_info *sound_effect, GApplication *app)
+/* Replace the sounds with a list that was just read from the project.
+ * Sounds which have not changed keep their bins, so if they are playing
+ * they continue undisturbed.  Changed sounds get new bins, new sounds
+ * are added to the pipeline and sounds no longer in the project are
+ * removed from it.  A busy sound is left as it is; a later reload will
+ * pick up its changes.  The new sounds must not use a speaker that the
+ * running pipeline does not have, since the final bin cannot be changed
+ * while it is running; if they do, nothing is changed and we return
+ * FALSE.  In either case the sounds in the new list become ours.  */
+gboolean
+sound_reload (GList *new_sounds_list, GApplication *app)
 {
   struct sounds_info *sounds_data;
+  struct sound_info *old_sound, *new_sound;
+  GList *old_sounds_list, *remaining_list, *merged_list, *build_list;
+  GList *discard_list, *l;
+  guint64 old_channel_mask;
+  gint64 old_speaker_count;
+  gint added_count, changed_count, removed_count, busy_count;
+  GstBin *bin_element;
+  gchar *message_text;
 
   sounds_data = sep_get_sounds_data (app);
-  sounds_data->sounds_list = g_list_append (sounds_data->sounds_list,
-					    sound_effect);
-  return;
+  old_sounds_list = sounds_data->sounds_list;
+  old_channel_mask = sounds_data->channel_mask;
+  old_speaker_count = sep_get_speaker_count (app);
+
+  /* Give the new sounds their default speakers, so they can be compared
+   * with the old ones.  */
+  sounds_data->sounds_list = new_sounds_list;
+  sound_process_speakers (sounds_data, app);
+
+  /* Match each new sound with the old sound of the same name.  */
+  remaining_list = g_list_copy (old_sounds_list);
+  merged_list = NULL;
+  build_list = NULL;
+  discard_list = NULL;
+  added_count = 0;
+  changed_count = 0;
+  removed_count = 0;
+  busy_count = 0;
+  for (l = new_sounds_list; l != NULL; l = l->next)
+    {
+      new_sound = l->data;
+      old_sound = find_sound_by_name (new_sound->name, remaining_list);
+      if (old_sound == NULL)
+        {
+          merged_list = g_list_append (merged_list, new_sound);
+          if (!new_sound->disabled)
+            build_list = g_list_append (build_list, new_sound);
+          added_count = added_count + 1;
+          continue;
+        }
+
+      remaining_list = g_list_remove (remaining_list, old_sound);
+      if (sound_unchanged (old_sound, new_sound))
+        {
+          merged_list = g_list_append (merged_list, old_sound);
+          discard_list = g_list_prepend (discard_list, new_sound);
+          continue;
+        }
+      if (sound_busy (old_sound))
+        {
+          g_printerr ("Sound %s is in use, so it has not been reloaded.\n",
+                      old_sound->name);
+          merged_list = g_list_append (merged_list, old_sound);
+          discard_list = g_list_prepend (discard_list, new_sound);
+          busy_count = busy_count + 1;
+          continue;
+        }
+      merged_list = g_list_append (merged_list, new_sound);
+      if (!new_sound->disabled)
+        build_list = g_list_append (build_list, new_sound);
+      discard_list = g_list_prepend (discard_list, old_sound);
+      changed_count = changed_count + 1;
+    }
+
+  /* The old sounds which are left have been removed from the project.  */
+  for (l = remaining_list; l != NULL; l = l->next)
+    {
+      old_sound = l->data;
+      if (sound_busy (old_sound))
+        {
+          g_printerr ("Sound %s is in use, so it has not been removed.\n",
+                      old_sound->name);
+          merged_list = g_list_append (merged_list, old_sound);
+          busy_count = busy_count + 1;
+          continue;
+        }
+      discard_list = g_list_prepend (discard_list, old_sound);
+      removed_count = removed_count + 1;
+    }
+  g_list_free (remaining_list);
+  remaining_list = NULL;
+
+  /* Work out the speakers for the combined sounds.  If the result is
+   * not what the pipeline was built for, put everything back.  */
+  sounds_data->sounds_list = merged_list;
+  sound_process_speakers (sounds_data, app);
+  if ((sounds_data->channel_mask != old_channel_mask)
+      || (sep_get_speaker_count (app) != old_speaker_count))
+    {
+      g_printerr ("The reloaded sounds need different speakers; "
+                  "restart the program to use them.\n");
+      sounds_data->sounds_list = old_sounds_list;
+      sep_set_speaker_count (old_speaker_count, app);
+      sound_process_speakers (sounds_data, app);
+      g_list_free (merged_list);
+      g_list_free (build_list);
+      g_list_free (discard_list);
+      g_list_free_full (new_sounds_list, (GDestroyNotify) sound_free_sound);
+      return (FALSE);
+    }
+
+  /* Take the bins of the discarded sounds out of the pipeline.  The loader
+   * may still be reading one of those sounds, so we keep them until
+   * we terminate.  The sounds we read but did not use are freed now.  */
+  for (l = discard_list; l != NULL; l = l->next)
+    {
+      old_sound = l->data;
+      if (g_list_find (old_sounds_list, old_sound) == NULL)
+        {
+          sound_free_sound (old_sound);
+          continue;
+        }
+      if (old_sound->sound_control != NULL)
+        {
+          gstreamer_remove_bin (old_sound->sound_control, app);
+          old_sound->sound_control = NULL;
+          old_sound->looper_element = NULL;
+        }
+      sound_remove_voices (old_sound, app);
+      sounds_data->retired_list =
+        g_list_prepend (sounds_data->retired_list, old_sound);
+    }
+  g_list_free (discard_list);
+  discard_list = NULL;
+
+  /* Build bins for the new and changed sounds, and read their samples.  */
+  for (l = build_list; l != NULL; l = l->next)
+    {
+      new_sound = l->data;
+      sound_choose_storage (new_sound, app);
+      bin_element = gstreamer_add_bin (new_sound, NULL, app);
+      if (bin_element == NULL)
+        {
+          new_sound->disabled = TRUE;
+          continue;
+        }
+      new_sound->sound_control = bin_element;
+      new_sound->wav_file_time =
+        sound_file_time (new_sound->wav_file_name_full);
+      sound_build_voices (new_sound, NULL, NULL, app);
+      loader_preload_sound (new_sound, app);
+    }
+  g_list_free (build_list);
+  build_list = NULL;
+
+  g_list_free (old_sounds_list);
+  g_list_free (new_sounds_list);
+
+  message_text =
+    g_strdup_printf ("Reloaded sounds: %d added, %d changed, %d removed, "
+                     "%d in use.", added_count, changed_count,
+                     removed_count, busy_count);
+  if (TRACE_SOUND)
+    {
+      g_print ("%s\n", message_text);
+    }
+  display_show_message (message_text, app);
+  g_free (message_text);
+
+  return (TRUE);
 }
 
 /* Associate a sound with a specified cluster.  */
@@ -1422,6 +1902,7 @@ sound_bind_to_cluster (gchar *sound_name, guint cluster_number,
 {
   struct sounds_info *sounds_data;
   GList *sound_effect_list;
+  struct display_cluster_info *cluster_info;
   GtkWidget *cluster_widget;
   struct sound_info *sound_effect;
   gboolean sound_effect_found;
@@ -1444,7 +1925,10 @@ sound_bind_to_cluster (gchar *sound_name, guint cluster_number,
   if (!sound_effect_found)
     return NULL;
 
-  cluster_widget = sep_get_cluster_from_number (cluster_number, app);
+  cluster_info = display_get_cluster (cluster_number, app);
+  cluster_widget = NULL;
+  if (cluster_info != NULL)
+    cluster_widget = cluster_info->cluster_widget;
   sound_effect->cluster_number = cluster_number;
   sound_effect->cluster_widget = cluster_widget;
 
@@ -1494,6 +1978,270 @@ sound_get_sound_effect_from_widget (GtkWidget *cluster_widget,
   return NULL;
 }
 
+/* Tell any listening consoles how many voices of a sound are playing.
+ * Sounds with only one voice are reported by their starts and
+ * completions.  */
+static void
+sound_report_voices (struct sound_info *sound_data, GApplication *app)
+{
+  struct voice_info *voice_data;
+  GList *l;
+  gint voice_count;
+
+  if (sound_data->voices == NULL)
+    return;
+
+  voice_count = sound_data->running ? 1 : 0;
+  for (l = sound_data->voices; l != NULL; l = l->next)
+    {
+      voice_data = l->data;
+      if (voice_data->running)
+        voice_count = voice_count + 1;
+    }
+  telemetry_sound_voices (sound_data, voice_count, app);
+  return;
+}
+
+/* Send a custom event to the bin of one of a sound's extra voices.  */
+static void
+sound_voice_send (struct voice_info *voice_data, const gchar *event_name)
+{
+  GstEvent *event;
+  GstStructure *structure;
+
+  if (voice_data->sound_control == NULL)
+    return;
+  structure = gst_structure_new_empty (event_name);
+  event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, structure);
+  gst_element_send_event (GST_ELEMENT (voice_data->sound_control), event);
+  return;
+}
+
+/* Find how loud a playing voice is now: the level the sound designer
+ * gave its envelope times the current setting of its volume control,
+ * which the operator may have changed or muted since it started.  */
+static gfloat
+sound_current_volume (struct sound_info *sound_data, GstBin *bin_element)
+{
+  GstElement *volume_element;
+  gdouble volume_level;
+  gboolean muted;
+
+  volume_level = sound_data->default_volume_level;
+  muted = FALSE;
+  if (bin_element != NULL)
+    {
+      volume_element = gstreamer_get_volume (bin_element);
+      if (volume_element != NULL)
+        {
+          g_object_get (volume_element, "volume", &volume_level, "mute",
+                        &muted, NULL);
+          gst_object_unref (volume_element);
+        }
+    }
+  if (muted)
+    return (0.0);
+  return (sound_data->designer_volume_level * volume_level);
+}
+
+/* Consider a playing voice as the one to release to make room for
+ * another, replacing the best candidate so far if it is better.  */
+static void
+sound_consider_victim (struct voice_victim *best,
+                       struct voice_victim *candidate,
+                       enum voice_stealing voice_stealing)
+{
+  gboolean better;
+
+  if (best->sound == NULL)
+    {
+      *best = *candidate;
+      return;
+    }
+
+  /* Prefer a voice that is releasing if the policy says so, then
+   * the quietest if the policy says so, then the oldest.  */
+  better = (candidate->starting_time < best->starting_time);
+  if ((voice_stealing == steal_quietest)
+      && (candidate->volume != best->volume))
+    better = (candidate->volume < best->volume);
+  if ((voice_stealing == steal_releasing)
+      && (candidate->releasing != best->releasing))
+    better = candidate->releasing;
+
+  if (better)
+    *best = *candidate;
+  return;
+}
+
+/* If as many voices are playing as the voice limit allows, release one
+ * of them, chosen by the voice stealing policy.  A released voice plays
+ * out its release, but no longer counts against the limit.  */
+static void
+sound_make_room (GApplication *app)
+{
+  struct sounds_info *sounds_data;
+  struct sound_info *sound_data;
+  struct voice_info *voice_data;
+  struct voice_victim best, candidate;
+  GList *l, *v;
+  gint voice_count;
+
+  sounds_data = sep_get_sounds_data (app);
+  if (sounds_data->voice_limit == 0)
+    return;
+
+  voice_count = 0;
+  best.sound = NULL;
+  best.voice = NULL;
+  for (l = sounds_data->sounds_list; l != NULL; l = l->next)
+    {
+      sound_data = l->data;
+      candidate.sound = sound_data;
+      if (sound_data->running && !sound_data->stolen)
+        {
+          voice_count = voice_count + 1;
+          candidate.voice = NULL;
+          candidate.volume =
+            sound_current_volume (sound_data, sound_data->sound_control);
+          candidate.starting_time = sound_data->starting_time;
+          candidate.releasing = (sound_data->release_sent
+                                 || sound_data->release_has_started);
+          sound_consider_victim (&best, &candidate,
+                                 sounds_data->voice_stealing);
+        }
+      for (v = sound_data->voices; v != NULL; v = v->next)
+        {
+          voice_data = v->data;
+          if (!voice_data->running || voice_data->stolen)
+            continue;
+          voice_count = voice_count + 1;
+          candidate.voice = voice_data;
+          candidate.volume =
+            sound_current_volume (sound_data, voice_data->sound_control);
+          candidate.starting_time = voice_data->starting_time;
+          candidate.releasing = (voice_data->release_sent
+                                 || voice_data->release_has_started);
+          sound_consider_victim (&best, &candidate,
+                                 sounds_data->voice_stealing);
+        }
+    }
+
+  if ((voice_count < sounds_data->voice_limit) || (best.sound == NULL))
+    return;
+
+  if (TRACE_SOUND)
+    {
+      g_print ("%d voices playing; releasing voice %d of %s.\n",
+               voice_count, (best.voice == NULL) ? 0 : best.voice->number,
+               best.sound->name);
+    }
+  if (best.voice == NULL)
+    {
+      if (!best.sound->release_sent)
+        sound_stop_playing (best.sound, app);
+      best.sound->stolen = TRUE;
+    }
+  else
+    {
+      if (!best.voice->release_sent)
+        {
+          sound_voice_send (best.voice, "release");
+          best.voice->release_sent = TRUE;
+        }
+      best.voice->stolen = TRUE;
+    }
+  return;
+}
+
+/* Start another voice of a sound that is already playing.  If all of
+ * its voices are playing, start again the one the voice stealing policy
+ * chooses.  The voices all play the same sound, but their volume
+ * controls may have been set differently since they started.  */
+static void
+sound_start_voice (struct sound_info *sound_data, GApplication *app)
+{
+  struct sounds_info *sounds_data;
+  struct voice_info *voice_data;
+  struct voice_victim best, candidate;
+  GList *l;
+
+  sounds_data = sep_get_sounds_data (app);
+  best.sound = NULL;
+  best.voice = NULL;
+  for (l = sound_data->voices; l != NULL; l = l->next)
+    {
+      voice_data = l->data;
+      if (voice_data->sound_control == NULL)
+        continue;
+      if (!voice_data->running)
+        {
+          best.sound = sound_data;
+          best.voice = voice_data;
+          break;
+        }
+      candidate.sound = sound_data;
+      candidate.voice = voice_data;
+      candidate.starting_time = voice_data->starting_time;
+      candidate.releasing = (voice_data->release_sent
+                             || voice_data->release_has_started);
+      candidate.volume =
+        sound_current_volume (sound_data, voice_data->sound_control);
+      sound_consider_victim (&best, &candidate, sounds_data->voice_stealing);
+    }
+  if (best.voice == NULL)
+    return;
+
+  voice_data = best.voice;
+  if (!voice_data->running || voice_data->stolen)
+    sound_make_room (app);
+
+  voice_data->running = TRUE;
+  voice_data->release_sent = FALSE;
+  voice_data->release_has_started = FALSE;
+  voice_data->stolen = FALSE;
+  voice_data->starting_time = g_get_monotonic_time () * 1e3;
+  sound_voice_send (voice_data, "start");
+
+  if (TRACE_SOUND)
+    {
+      g_print ("Started voice %d of %s.\n", voice_data->number,
+               sound_data->name);
+    }
+  sound_report_voices (sound_data, app);
+  return;
+}
+
+/* Find the extra voice whose envelope posted a message, or return NULL
+ * if the message came from a sound's first voice.  */
+struct voice_info *
+sound_get_voice_from_element (GstElement *element)
+{
+  return (g_object_get_data (G_OBJECT (element), (gchar *) "voice_info"));
+}
+
+/* One of a sound's extra voices has finished.  Only the sound's first
+ * voice is followed by the sequencer and the operator, so there is
+ * nothing to tell them.  */
+void
+sound_voice_completed (struct voice_info *voice_data, GApplication *app)
+{
+  voice_data->running = FALSE;
+  voice_data->release_sent = FALSE;
+  voice_data->stolen = FALSE;
+  sound_report_voices (voice_data->sound, app);
+  return;
+}
+
+/* One of a sound's extra voices has entered its release stage.  */
+void
+sound_voice_release_started (struct voice_info *voice_data,
+                             GApplication *app)
+{
+  voice_data->release_has_started = TRUE;
+  return;
+}
+
 /* Start playing a sound effect.  */
 void
 sound_start_playing (struct sound_info *sound_data, GApplication *app)
@@ -1506,27 +2254,44 @@ sound_start_playing (struct sound_info *sound_data, GApplication *app)
   if (bin_element == NULL)
     return;
 
+  /* If the sound is being warmed up, it is the operator's now.  */
+  warmup_cancel_sound (sound_data, app);
+
   /* If the sound has already been started, and is not yet releasing, 
-   * don't try to start it again.  A sound is releasing if we have sent
-   * a release message or if it has entered its release stage on its own.  */
+   * start another of its voices, or if it has only one, don't try to
+   * start it again.  A sound is releasing if we have sent a release
+   * message or if it has entered its release stage on its own.  */
   if (sound_data->running && !sound_data->release_sent
       && !sound_data->release_has_started)
     {
+      if (sound_data->voices != NULL)
+        sound_start_voice (sound_data, app);
       return;
     }
 
+  /* If as many voices are playing as we allow, release one.  */
+  if (!sound_data->running || sound_data->stolen)
+    sound_make_room (app);
+
   /* Send a start message to the bin.  It will be routed to the source, and
    * flow from there downstream through the looper and envelope.  
    * The looper element will start sending its local buffer
    * and the envelope element will start to shape the volume.  */
   sound_data->running = TRUE;
+  sound_data->elapsed_time = 0;
+  sound_data->remaining_time = G_MAXUINT64;
   sound_data->starting_time = g_get_monotonic_time () * 1e3;
   sound_data->release_sent = FALSE;
   sound_data->release_has_started = FALSE;
+  sound_data->stolen = FALSE;
   structure = gst_structure_new_empty ((gchar *) "start");
   event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, structure);
   gst_element_send_event (GST_ELEMENT (bin_element), event);
 
+  /* Tell any listening consoles.  */
+  telemetry_sound_started (sound_data, app);
+  sound_report_voices (sound_data, app);
+
   return;
 }
 
@@ -1558,13 +2323,8 @@ sound_stop_playing (struct sound_info *sound_data, GApplication *app)
 guint64
 sound_get_elapsed_time (struct sound_info * sound_data, GApplication *app)
 {
-  GstElement *looper_element;
-  guint64 elapsed_time;
-
-  looper_element = gstreamer_get_looper (sound_data->sound_control);
-  g_object_get (looper_element, (gchar *) "elapsed-time", &elapsed_time,
-                NULL);
-  return elapsed_time;
+  /* The looper tells us as the sound plays.  */
+  return sound_data->elapsed_time;
 }
 
 /* Calculate the amount of time allowed by the envelope.
@@ -1609,14 +2369,11 @@ calculate_envelope_duration_time (struct sound_info *sound_data,
 guint64
 sound_get_remaining_time (struct sound_info * sound_data, GApplication *app)
 {
-  GstElement *looper_element;
   guint64 looper_remaining_time;
   guint64 envelope_duration_time, envelope_remaining_time, elapsed_time;
 
-  /* Calculate the amount of time left in the looper element.  */
-  looper_element = gstreamer_get_looper (sound_data->sound_control);
-  g_object_get (looper_element, (gchar *) "remaining-time",
-                &looper_remaining_time, NULL);
+  /* The amount of time left in the looper element, as it last told us.  */
+  looper_remaining_time = sound_data->remaining_time;
 
   /* Calculate how long the envelope will allow the sound to run.  */
   envelope_duration_time = calculate_envelope_duration_time (sound_data, app);
@@ -1630,8 +2387,7 @@ sound_get_remaining_time (struct sound_info * sound_data, GApplication *app)
     }
 
   /* Calculate how long until the envelope ends the sound.  */
-  g_object_get (looper_element, (gchar *) "elapsed-time", &elapsed_time,
-                NULL);
+  elapsed_time = sound_data->elapsed_time;
   envelope_remaining_time = envelope_duration_time - elapsed_time;
 
   /* Return the limit that will end the sound sooner.  */
@@ -1676,6 +2432,9 @@ sound_completed (const gchar * sound_name, GApplication *app)
    * normally from one that has been stopped.  */
   terminated = sound_effect->release_sent;
   sound_effect->release_sent = FALSE;
+  sound_effect->stolen = FALSE;
+  telemetry_sound_completed (sound_effect, terminated, app);
+  sound_report_voices (sound_effect, app);
   sequence_sound_completion (sound_effect, terminated, app);
   return;
 }
@@ -1712,6 +2471,7 @@ sound_release_started (const gchar * sound_name, GApplication *app)
   /* Remember that the sound is in its release stage.  */
   sound_effect->releasing_time = g_get_monotonic_time () * 1e3;
   sound_effect->release_has_started = TRUE;
+  telemetry_sound_release_started (sound_effect, app);
 
   /* Let the internal sequencer handle it.  */
   sequence_sound_release_started (sound_effect, app);
@@ -1719,13 +2479,39 @@ sound_release_started (const gchar * sound_name, GApplication *app)
   return;
 }
 
+/* Receive a progress message from a sound's looper, which tells us how
+ * long the sound has been playing and how much longer it will play.  */
+void
+sound_progress (GstElement *looper_element, guint64 elapsed_time,
+                guint64 remaining_time, GApplication *app)
+{
+  struct sound_info *sound_effect;
+
+  /* The looper knows its sound.  Ignore a looper whose bin has been
+   * replaced by a reload.  */
+  sound_effect =
+    g_object_get_data (G_OBJECT (looper_element), (gchar *) "sound_info");
+  if ((sound_effect == NULL)
+      || (sound_effect->looper_element != looper_element))
+    return;
+
+  sound_effect->elapsed_time = elapsed_time;
+  sound_effect->remaining_time = remaining_time;
+
+  /* Let the internal sequencer show it.  */
+  if (sound_effect->running)
+    sequence_sound_progress (sound_effect, app);
+
+  return;
+}
+
 /* The Pause button was pushed.  */
 void
 sound_button_pause (GApplication *app)
 {
   struct sounds_info *sounds_data;
   GList *sound_list;
-  GList *l;
+  GList *l, *v;
   struct sound_info *sound_data;
   GstBin *bin_element;
   GstEvent *event;
@@ -1748,6 +2534,10 @@ sound_button_pause (GApplication *app)
           structure = gst_structure_new_empty ((gchar *) "pause");
           event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, structure);
           gst_element_send_event (GST_ELEMENT (bin_element), event);
+
+          /* Do the same for the sound's other voices.  */
+          for (v = sound_data->voices; v != NULL; v = v->next)
+            sound_voice_send (v->data, "pause");
         }
 
     }
@@ -1760,7 +2550,7 @@ sound_button_continue (GApplication *app)
 {
   struct sounds_info *sounds_data;
   GList *sound_list;
-  GList *l;
+  GList *l, *v;
   struct sound_info *sound_data;
   GstBin *bin_element;
   GstEvent *event;
@@ -1783,6 +2573,10 @@ sound_button_continue (GApplication *app)
           structure = gst_structure_new_empty ((gchar *) "continue");
           event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, structure);
           gst_element_send_event (GST_ELEMENT (bin_element), event);
+
+          /* Do the same for the sound's other voices.  */
+          for (v = sound_data->voices; v != NULL; v = v->next)
+            sound_voice_send (v->data, "continue");
         }
 
     }
@@ -1790,8 +2584,8 @@ sound_button_continue (GApplication *app)
   return;
 }
 
-/* Count the bit depth and number of sound channels in a WAV file.
- * Return 1 on success, 0 on failure.  */
+/* Count the bit depth, number of sound channels and sample rate in a
+ * WAV file.  Return 1 on success, 0 on failure.  */
 gint
 sound_parse_wav_file_header (const gchar *wav_file_name,
 			     struct sound_info *sound_effect,
@@ -1805,6 +2599,7 @@ sound_parse_wav_file_header (const gchar *wav_file_name,
   gint format_code;
   gchar *format_name;
   gint bits_per_sample;
+  guint32 sample_rate;
   gint return_value = 0;
   gchar header [36];
   
@@ -1827,6 +2622,14 @@ sound_parse_wav_file_header (const gchar *wav_file_name,
       goto common_exit;
     }
 
+  /* A compressed file will be decoded by the loader, into a format
+   * the decoder chooses.  */
+  if (decoder_is_compressed (&header[0]))
+    {
+      return_value = decoder_parse_header (wav_file_name, sound_effect);
+      goto common_exit;
+    }
+
   if (memcmp (&header[0], "RIFF", 4) != 0)
     {
       g_printerr ("File \"%s\" is not a RIFF file.",
@@ -1849,6 +2652,10 @@ sound_parse_wav_file_header (const gchar *wav_file_name,
   bits_per_sample = header[34] + (header[35] * 256);
   format_code = header[20] + (header[21] * 256);
 
+  /* The sample rate is a 4-byte little-endian integer at offset 24.  */
+  memcpy (&sample_rate, &header[24], 4);
+  sample_rate = GUINT32_FROM_LE (sample_rate);
+
   /* Note that whether a sample is signed or unsigned is not indicated
    * in the WAV file format, so the convention is that 8-bit samples
    * are unsigned and all the rest are signed.  */
@@ -1893,11 +2700,12 @@ sound_parse_wav_file_header (const gchar *wav_file_name,
 
   sound_effect->format_name = format_name;
   sound_effect->channel_count = channel_count;
+  sound_effect->sample_rate = sample_rate;
   
   if (TRACE_SOUND)
     {
-      g_print ("File %s is %s with %d channels.\n",
-	       wav_file_name, format_name, channel_count);
+      g_print ("File %s is %s with %d channels at %u frames per second.\n",
+	       wav_file_name, format_name, channel_count, sample_rate);
       g_print ("Byte 20: %d, 21: %d, 22: %d, 23: %d, 34: %d, 35: %d.\n",
 	       header[20], header[21], header[22], header[23],
 	       header[34], header[35]);
@@ -1930,18 +2738,35 @@ sound_append_channel (struct channel_info *channel_data,
       g_print ("Channel %d in sound %s.\n",
 	       channel_data->number, sound_data->name);
     }
-  if (channel_data->number >= sound_data->channel_count)
-    {
-      g_printerr ("Sound %s has %d channels but specifies more.\n",
-		  sound_data->wav_file_name, sound_data->channel_count);
-      sound_data->disabled = TRUE;
-    }
   sound_data->channels = g_list_prepend (sound_data->channels,
 					 channel_data);
   
   return;
 }
 
+/* Make sure a sound does not specify more channels than its WAV file has.
+ * This is done after the WAV file's header has been read.  */
+void
+sound_check_channels (struct sound_info *sound_data, GApplication *app)
+{
+  GList *l;
+  struct channel_info *channel_data;
+
+  for (l = sound_data->channels; l != NULL; l = l->next)
+    {
+      channel_data = l->data;
+      if (channel_data->number >= sound_data->channel_count)
+	{
+	  g_printerr ("Sound %s has %d channels but specifies more.\n",
+		      sound_data->wav_file_name, sound_data->channel_count);
+	  sound_data->disabled = TRUE;
+	  break;
+	}
+    }
+
+  return;
+}
+
 /* Add a speaker description to a channel.  */
 void
 sound_append_speaker (struct speaker_info *speaker_data,
@@ -39,6 +39,19 @@ void sound_cluster_set_name (gchar *sound_name, guint cluster_number,
 /* Append a sound to the list of sounds.  */
 void sound_append_sound (struct sound_info *sound_data, GApplication *app);
 
+/* Fetch the list of sounds.  */
+GList *sound_get_sounds_list (GApplication *app);
+
+/* Replace the list of sounds, returning the old one.  */
+GList *sound_set_sounds_list (GList *sounds_list, GApplication *app);
+
+/* Bring the sounds up to date with a list just read from the project,
+ * without disturbing the sounds that have not changed.  */
+gboolean sound_reload (GList *new_sounds_list, GApplication *app);
+
+/* Deallocate a sound.  */
+void sound_free_sound (struct sound_info *sound_data);
+
 /* Associate a sound with a cluster.  */
 struct sound_info *sound_bind_to_cluster (gchar *sound_name,
                                           guint cluster_number,
@@ -74,14 +87,29 @@ void sound_completed (const gchar *sound_name, GApplication *app);
  */
 void sound_release_started (const gchar *sound_name, GApplication *app);
 
+/* Find the extra voice of a sound to which an element belongs, or
+ * return NULL if it belongs to the sound's first voice.  */
+struct voice_info *sound_get_voice_from_element (GstElement *element);
+
+/* Note that one of a sound's extra voices has completed.  */
+void sound_voice_completed (struct voice_info *voice_data, GApplication *app);
+
+/* Note that one of a sound's extra voices has entered its release stage.  */
+void sound_voice_release_started (struct voice_info *voice_data,
+                                  GApplication *app);
+
+/* Note how far a sound has progressed, as reported by its looper.  */
+void sound_progress (GstElement *looper_element, guint64 elapsed_time,
+                     guint64 remaining_time, GApplication *app);
+
 /* The Pause button has been pushed.  */
 void sound_button_pause (GApplication *app);
 
 /* The Continue button has been pushed.  */
 void sound_button_continue (GApplication *app);
 
-/* Count the bit depth and number of sound channels in a WAV file.
- * Return 1 on success, 0 on failure.  */
+/* Count the bit depth, number of sound channels and sample rate in a
+ * WAV file.  Return 1 on success, 0 on failure.  */
 gint
 sound_parse_wav_file_header (const gchar *wav_file_name,
 			     struct sound_info *sound_effect,
@@ -92,6 +120,9 @@ void sound_append_channel (struct channel_info *channel_data,
 			   struct sound_info *sound_data,
 			   GApplication *app);
 
+/* Make sure a sound does not specify more channels than its file has.  */
+void sound_check_channels (struct sound_info *sound_data, GApplication *app);
+
 /* Add a speaker description to a channel.  */
 void sound_append_speaker (struct speaker_info *speaker_data,
 			   struct channel_info *channel_data,
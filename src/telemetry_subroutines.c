@@ -0,0 +1,500 @@
+/*
+ * telemetry_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+#include "telemetry_subroutines.h"
+#include "sound_effects_player.h"
+#include "sound_structure.h"
+#include "sound_subroutines.h"
+#include "main.h"
+
+/* These subroutines send the state of the sound effects player to
+ * show control consoles as Open Sound Control (OSC) bundles over UDP.
+ * Events and periodic values are collected into one bundle, which is
+ * sent at most once per telemetry interval, so a burst of activity 
+ * costs at most one datagram per interval.  Level messages replace
+ * earlier ones, so only the latest levels are sent.  */
+
+#define TRACE_TELEMETRY FALSE
+
+/* The largest bundle we send.  This fits in an Ethernet frame.  */
+#define TELEMETRY_BUNDLE_SIZE 1400
+
+/* The largest single message.  */
+#define TELEMETRY_MESSAGE_SIZE 512
+
+/* The most output channels whose levels we report.  */
+#define TELEMETRY_MAX_CHANNELS 64
+
+/* The persistent data used by the telemetry subroutines.  */
+struct telemetry_info
+{
+  gboolean enabled;
+  GSocket *socket;
+  GSocketAddress *destination;
+  guint tick_source;
+  GList *running_sounds;        /* sounds we report the times of */
+  gint level_count;             /* the number of channels with levels */
+  gdouble rms_dB[TELEMETRY_MAX_CHANNELS];
+  gdouble peak_dB[TELEMETRY_MAX_CHANNELS];
+  gboolean levels_changed;
+  gint xrun_count;
+  gint xrun_count_sent;
+  gint dropped_count;           /* datagrams the kernel would not take */
+  guint bundle_length;
+  guchar bundle[TELEMETRY_BUNDLE_SIZE];
+};
+
+/* An OSC message being built.  */
+struct telemetry_message
+{
+  guint length;
+  gboolean overflow;
+  guchar data[TELEMETRY_MESSAGE_SIZE];
+};
+
+static gboolean telemetry_tick (gpointer user_data);
+
+/* Initialize the telemetry subroutines.  Telemetry is sent only if
+ * a destination was specified on the command line.  */
+void *
+telemetry_init (GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+  gchar *address_string;
+  GSocketConnectable *connectable;
+  GSocketAddressEnumerator *enumerator;
+  GSocketAddress *destination;
+  GInetAddress *inet_address;
+  GError *error = NULL;
+  gint interval;
+
+  telemetry_data = g_malloc0 (sizeof (struct telemetry_info));
+  telemetry_data->enabled = FALSE;
+
+  address_string = main_get_telemetry_address_string ();
+  if (address_string == NULL)
+    return (telemetry_data);
+
+  /* The destination is host:port; the host may be a multicast group.  */
+  connectable = g_network_address_parse (address_string, 0, &error);
+  if (connectable == NULL)
+    {
+      g_printerr ("Telemetry address %s is not valid: %s.\n",
+                  address_string, error->message);
+      g_error_free (error);
+      return (telemetry_data);
+    }
+  enumerator = g_socket_connectable_enumerate (connectable);
+  destination = g_socket_address_enumerator_next (enumerator, NULL, &error);
+  g_object_unref (enumerator);
+  g_object_unref (connectable);
+  if (destination == NULL)
+    {
+      g_printerr ("Cannot find telemetry destination %s: %s.\n",
+                  address_string,
+                  (error != NULL) ? error->message : "no address");
+      if (error != NULL)
+        g_error_free (error);
+      return (telemetry_data);
+    }
+
+  telemetry_data->socket =
+    g_socket_new (g_socket_address_get_family (destination),
+                  G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, &error);
+  if (telemetry_data->socket == NULL)
+    {
+      g_printerr ("Failed to create telemetry socket: %s.\n",
+                  error->message);
+      g_error_free (error);
+      g_object_unref (destination);
+      return (telemetry_data);
+    }
+
+  /* Never let a slow network hold up the player.  */
+  g_socket_set_blocking (telemetry_data->socket, FALSE);
+
+  /* If the destination is a multicast group, let consoles on this
+   * computer hear it too.  */
+  inet_address =
+    g_inet_socket_address_get_address (G_INET_SOCKET_ADDRESS (destination));
+  if (g_inet_address_get_is_multicast (inet_address))
+    {
+      g_socket_set_multicast_loopback (telemetry_data->socket, TRUE);
+      g_socket_set_multicast_ttl (telemetry_data->socket, 1);
+    }
+
+  telemetry_data->destination = destination;
+  telemetry_data->enabled = TRUE;
+
+  interval = main_get_telemetry_interval ();
+  if (interval < 10)
+    interval = 10;
+  telemetry_data->tick_source = g_timeout_add (interval, telemetry_tick, app);
+
+  return (telemetry_data);
+}
+
+/* Shut down the telemetry subroutines.  */
+void
+telemetry_finish (GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+
+  telemetry_data = sep_get_telemetry_data (app);
+  if (telemetry_data == NULL)
+    return;
+
+  if (telemetry_data->tick_source != 0)
+    g_source_remove (telemetry_data->tick_source);
+  if (telemetry_data->dropped_count > 0)
+    {
+      g_print ("%d telemetry datagrams were dropped.\n",
+               telemetry_data->dropped_count);
+    }
+  g_list_free (telemetry_data->running_sounds);
+  if (telemetry_data->socket != NULL)
+    g_object_unref (telemetry_data->socket);
+  if (telemetry_data->destination != NULL)
+    g_object_unref (telemetry_data->destination);
+  g_free (telemetry_data);
+  return;
+}
+
+/* Subroutines for building OSC messages.  Each item is padded to a
+ * multiple of four bytes, and numbers are big-endian.  */
+
+static void
+message_add_bytes (struct telemetry_message *message, const void *bytes,
+                   guint length)
+{
+  guint padded_length;
+
+  padded_length = (length + 3) & ~3;
+  if (message->length + padded_length > TELEMETRY_MESSAGE_SIZE)
+    {
+      message->overflow = TRUE;
+      return;
+    }
+  memcpy (&message->data[message->length], bytes, length);
+  memset (&message->data[message->length + length], 0,
+          padded_length - length);
+  message->length = message->length + padded_length;
+  return;
+}
+
+static void
+message_add_string (struct telemetry_message *message, const gchar * text)
+{
+  /* Include the terminating NUL.  */
+  message_add_bytes (message, text, strlen (text) + 1);
+  return;
+}
+
+static void
+message_add_int32 (struct telemetry_message *message, gint32 value)
+{
+  guint32 big_endian_value;
+
+  big_endian_value = GUINT32_TO_BE ((guint32) value);
+  message_add_bytes (message, &big_endian_value, 4);
+  return;
+}
+
+static void
+message_add_int64 (struct telemetry_message *message, gint64 value)
+{
+  guint64 big_endian_value;
+
+  big_endian_value = GUINT64_TO_BE ((guint64) value);
+  message_add_bytes (message, &big_endian_value, 8);
+  return;
+}
+
+static void
+message_add_float (struct telemetry_message *message, gfloat value)
+{
+  guint32 bits;
+
+  memcpy (&bits, &value, 4);
+  message_add_int32 (message, bits);
+  return;
+}
+
+/* Start a message with its address and type tags.  */
+static void
+message_start (struct telemetry_message *message, const gchar * address,
+               const gchar * type_tags)
+{
+  message->length = 0;
+  message->overflow = FALSE;
+  message_add_string (message, address);
+  message_add_string (message, type_tags);
+  return;
+}
+
+/* Send the bundle we have been building, if it has anything in it.  */
+static void
+telemetry_flush (struct telemetry_info *telemetry_data)
+{
+  GError *error = NULL;
+  gssize bytes_sent;
+
+  /* The bundle header is 16 bytes.  */
+  if (telemetry_data->bundle_length <= 16)
+    return;
+
+  bytes_sent =
+    g_socket_send_to (telemetry_data->socket, telemetry_data->destination,
+                      (gchar *) & telemetry_data->bundle[0],
+                      telemetry_data->bundle_length, NULL, &error);
+  if (bytes_sent < 0)
+    {
+      if (TRACE_TELEMETRY)
+        {
+          g_print ("Telemetry send failed: %s.\n", error->message);
+        }
+      g_error_free (error);
+      telemetry_data->dropped_count = telemetry_data->dropped_count + 1;
+    }
+  telemetry_data->bundle_length = 0;
+  return;
+}
+
+/* Add a message to the bundle.  If it will not fit, send the bundle
+ * first.  */
+static void
+telemetry_queue_message (struct telemetry_info *telemetry_data,
+                         struct telemetry_message *message)
+{
+  guint32 big_endian_length;
+  guint64 immediate_time_tag;
+
+  if (message->overflow)
+    return;
+
+  if (telemetry_data->bundle_length + 4 + message->length >
+      TELEMETRY_BUNDLE_SIZE)
+    telemetry_flush (telemetry_data);
+
+  /* Start a new bundle, to be acted on immediately.  */
+  if (telemetry_data->bundle_length == 0)
+    {
+      memcpy (&telemetry_data->bundle[0], "#bundle", 8);
+      immediate_time_tag = GUINT64_TO_BE (G_GUINT64_CONSTANT (1));
+      memcpy (&telemetry_data->bundle[8], &immediate_time_tag, 8);
+      telemetry_data->bundle_length = 16;
+    }
+
+  big_endian_length = GUINT32_TO_BE (message->length);
+  memcpy (&telemetry_data->bundle[telemetry_data->bundle_length],
+          &big_endian_length, 4);
+  memcpy (&telemetry_data->bundle[telemetry_data->bundle_length + 4],
+          &message->data[0], message->length);
+  telemetry_data->bundle_length =
+    telemetry_data->bundle_length + 4 + message->length;
+  return;
+}
+
+/* Report an event concerning a sound.  */
+static void
+telemetry_sound_event (const gchar * address, struct sound_info *sound_effect,
+                       GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+  struct telemetry_message message;
+
+  telemetry_data = sep_get_telemetry_data (app);
+  if ((telemetry_data == NULL) || !telemetry_data->enabled)
+    return;
+
+  message_start (&message, address, ",si");
+  message_add_string (&message, sound_effect->name);
+  message_add_int32 (&message, sound_effect->cluster_number);
+  telemetry_queue_message (telemetry_data, &message);
+  return;
+}
+
+/* A sound has started.  */
+void
+telemetry_sound_started (struct sound_info *sound_effect, GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+
+  telemetry_data = sep_get_telemetry_data (app);
+  if ((telemetry_data == NULL) || !telemetry_data->enabled)
+    return;
+
+  if (g_list_find (telemetry_data->running_sounds, sound_effect) == NULL)
+    telemetry_data->running_sounds =
+      g_list_prepend (telemetry_data->running_sounds, sound_effect);
+  telemetry_sound_event ("/sound/started", sound_effect, app);
+  return;
+}
+
+/* A sound has entered its release stage.  */
+void
+telemetry_sound_release_started (struct sound_info *sound_effect,
+                                 GApplication *app)
+{
+  telemetry_sound_event ("/sound/release_started", sound_effect, app);
+  return;
+}
+
+/* A sound has completed, or has been terminated.  */
+void
+telemetry_sound_completed (struct sound_info *sound_effect,
+                           gboolean terminated, GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+
+  telemetry_data = sep_get_telemetry_data (app);
+  if ((telemetry_data == NULL) || !telemetry_data->enabled)
+    return;
+
+  telemetry_data->running_sounds =
+    g_list_remove (telemetry_data->running_sounds, sound_effect);
+  if (terminated)
+    telemetry_sound_event ("/sound/terminated", sound_effect, app);
+  else
+    telemetry_sound_event ("/sound/completed", sound_effect, app);
+  return;
+}
+
+/* Report how many voices of a sound are playing, and how many it has.  */
+void
+telemetry_sound_voices (struct sound_info *sound_effect, gint voice_count,
+                        GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+  struct telemetry_message message;
+
+  telemetry_data = sep_get_telemetry_data (app);
+  if ((telemetry_data == NULL) || !telemetry_data->enabled)
+    return;
+
+  message_start (&message, "/sound/voices", ",sii");
+  message_add_string (&message, sound_effect->name);
+  message_add_int32 (&message, voice_count);
+  message_add_int32 (&message, sound_effect->max_voices);
+  telemetry_queue_message (telemetry_data, &message);
+  return;
+}
+
+/* Remember the latest level on an output channel.  Only the latest 
+ * level is sent.  */
+void
+telemetry_update_level (gint channel, gdouble rms_dB, gdouble peak_dB,
+                        GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+
+  telemetry_data = sep_get_telemetry_data (app);
+  if ((telemetry_data == NULL) || !telemetry_data->enabled)
+    return;
+  if ((channel < 0) || (channel >= TELEMETRY_MAX_CHANNELS))
+    return;
+
+  telemetry_data->rms_dB[channel] = rms_dB;
+  telemetry_data->peak_dB[channel] = peak_dB;
+  if (channel >= telemetry_data->level_count)
+    telemetry_data->level_count = channel + 1;
+  telemetry_data->levels_changed = TRUE;
+  return;
+}
+
+/* Remember the number of times the audio output has run short.  */
+void
+telemetry_set_xrun_count (gint xrun_count, GApplication *app)
+{
+  struct telemetry_info *telemetry_data;
+
+  telemetry_data = sep_get_telemetry_data (app);
+  if ((telemetry_data == NULL) || !telemetry_data->enabled)
+    return;
+
+  telemetry_data->xrun_count = xrun_count;
+  return;
+}
+
+/* Once per telemetry interval, add the periodic values to the bundle
+ * and send it.  */
+static gboolean
+telemetry_tick (gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct telemetry_info *telemetry_data;
+  struct telemetry_message message;
+  struct sound_info *sound_effect;
+  GList *sound_list;
+  guint64 remaining_time;
+  gint channel;
+
+  telemetry_data = sep_get_telemetry_data (app);
+
+  /* Report the master levels, one message per channel.  */
+  if (telemetry_data->levels_changed)
+    {
+      for (channel = 0; channel < telemetry_data->level_count; channel++)
+        {
+          message_start (&message, "/master/level", ",iff");
+          message_add_int32 (&message, channel);
+          message_add_float (&message, telemetry_data->rms_dB[channel]);
+          message_add_float (&message, telemetry_data->peak_dB[channel]);
+          telemetry_queue_message (telemetry_data, &message);
+        }
+      telemetry_data->levels_changed = FALSE;
+    }
+
+  /* Report the elapsed and remaining time of each running sound,
+   * in nanoseconds.  A remaining time of -1 means the sound will run
+   * until it is stopped.  */
+  for (sound_list = telemetry_data->running_sounds; sound_list != NULL;
+       sound_list = sound_list->next)
+    {
+      sound_effect = sound_list->data;
+      if (sound_effect->sound_control == NULL)
+        continue;
+      remaining_time = sound_get_remaining_time (sound_effect, app);
+      message_start (&message, "/sound/time", ",shh");
+      message_add_string (&message, sound_effect->name);
+      message_add_int64 (&message,
+                         sound_get_elapsed_time (sound_effect, app));
+      message_add_int64 (&message, (remaining_time == G_MAXUINT64) ?
+                         -1 : (gint64) remaining_time);
+      telemetry_queue_message (telemetry_data, &message);
+    }
+
+  /* Report the count of audio output underruns when it changes.  */
+  if (telemetry_data->xrun_count != telemetry_data->xrun_count_sent)
+    {
+      message_start (&message, "/master/xruns", ",i");
+      message_add_int32 (&message, telemetry_data->xrun_count);
+      telemetry_queue_message (telemetry_data, &message);
+      telemetry_data->xrun_count_sent = telemetry_data->xrun_count;
+    }
+
+  telemetry_flush (telemetry_data);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* End of file telemetry_subroutines.c */
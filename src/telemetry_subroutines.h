@@ -0,0 +1,54 @@
+/*
+ * telemetry_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include "sound_structure.h"
+
+/* Subroutines defined in telemetry_subroutines.c */
+
+/* Initialize the telemetry subroutines.  */
+void *telemetry_init (GApplication *app);
+
+/* Shut down the telemetry subroutines.  */
+void telemetry_finish (GApplication *app);
+
+/* Report that a sound has started.  */
+void telemetry_sound_started (struct sound_info *sound_effect,
+                              GApplication *app);
+
+/* Report that a sound has entered its release stage.  */
+void telemetry_sound_release_started (struct sound_info *sound_effect,
+                                      GApplication *app);
+
+/* Report that a sound has completed or been terminated.  */
+void telemetry_sound_completed (struct sound_info *sound_effect,
+                                gboolean terminated, GApplication *app);
+
+/* Report how many voices of a sound are playing.  */
+void telemetry_sound_voices (struct sound_info *sound_effect,
+                             gint voice_count, GApplication *app);
+
+/* Report the level on an output channel.  */
+void telemetry_update_level (gint channel, gdouble rms_dB, gdouble peak_dB,
+                             GApplication *app);
+
+/* Report the number of audio output underruns.  */
+void telemetry_set_xrun_count (gint xrun_count, GApplication *app);
+
+/* End of file telemetry_subroutines.h */
@@ -24,6 +24,8 @@
 #include <gst/gst.h>
 #include "timer_subroutines.h"
 #include "sound_effects_player.h"
+#include "render_subroutines.h"
+#include "main.h"
 
 /* When debugging it can be useful to trace what is happening in the
  * timer.  */
@@ -35,6 +37,7 @@ struct timer_info
   gdouble last_trace_time;
   GList *timer_entry_list;      /* The list of timer items  */
   guint tick_source;
+  gboolean rendering;           /* time is the position in the mix */
 };
 
 /* an entry on the timer list */
@@ -50,6 +53,18 @@ struct timer_entry_info
  */
 static gboolean timer_tick (gpointer user_data);
 
+/* Return the current time in seconds.  Normally this is the time since
+ * the last reboot, but when we are rendering the mix faster than real
+ * time it is how much of the mix has been rendered.  */
+static gdouble
+timer_current_time (struct timer_info *timer_data, GApplication *app)
+{
+  if (timer_data->rendering)
+    return (render_get_time (app));
+
+  return ((gdouble) g_get_monotonic_time () / 1e6);
+}
+
 /* Initialize the timer.  */
 void *
 timer_init (GApplication *app)
@@ -67,8 +82,12 @@ timer_init (GApplication *app)
   /* The list of timer entries is empty.  */
   timer_data->timer_entry_list = NULL;
 
-  /* Specify where to go on each tick.  */
-  timer_data->tick_source = g_timeout_add (100, timer_tick, app);
+  /* Specify where to go on each tick.  When rendering, the renderer
+   * dispatches the timers as the mix advances.  */
+  timer_data->rendering = (main_get_render_file_name () != NULL);
+  timer_data->tick_source = 0;
+  if (!timer_data->rendering)
+    timer_data->tick_source = g_timeout_add (100, timer_tick, app);
 
   return (timer_data);
 }
@@ -96,7 +115,8 @@ timer_finalize (GApplication *app)
     }
 
   /* Cancel the ticking source.  */
-  g_source_remove (timer_data->tick_source);
+  if (timer_data->tick_source != 0)
+    g_source_remove (timer_data->tick_source);
 
   g_free (timer_data);
   timer_data = NULL;
@@ -118,7 +138,7 @@ timer_create_entry (void (*subroutine) (void *, GApplication *),
       g_print ("create timer entry at %p for %4.1f seconds from now.\n",
                subroutine, interval);
     }
-  current_time = (gdouble) g_get_monotonic_time () / 1e6;
+  current_time = timer_current_time (timer_data, app);
 
   /* Construct the timer entry.  */
   timer_entry_data = g_malloc (sizeof (struct timer_entry_info));
@@ -137,6 +157,15 @@ static gboolean
 timer_tick (gpointer user_data)
 {
   GApplication *app = user_data;
+
+  timer_dispatch (app);
+  return G_SOURCE_CONTINUE;
+}
+
+/* Call the subroutines of the timer entries that have expired.  */
+void
+timer_dispatch (GApplication *app)
+{
   gdouble current_time;
   GList *timer_entry_list;
   struct timer_entry_info *timer_entry_data;
@@ -145,8 +174,8 @@ timer_tick (gpointer user_data)
   /* Get our persistent data.  */
   timer_data = sep_get_timer_data (app);
 
-  /* Calculate the current time in seconds since the last reboot.  */
-  current_time = (gdouble) g_get_monotonic_time () / 1e6;
+  /* Calculate the current time in seconds.  */
+  current_time = timer_current_time (timer_data, app);
 
   /* Don't print the trace message oftener than once a second.  */
   if (TRACE_TIMER && ((current_time - timer_data->last_trace_time) >= 1.0))
@@ -185,7 +214,17 @@ timer_tick (gpointer user_data)
       timer_entry_list = timer_entry_next;
     }
 
-  return G_SOURCE_CONTINUE;
+  return;
+}
+
+/* Return TRUE if there are timer entries that have not yet expired.  */
+gboolean
+timer_pending (GApplication *app)
+{
+  struct timer_info *timer_data;
+
+  timer_data = sep_get_timer_data (app);
+  return (timer_data->timer_entry_list != NULL);
 }
 
 /* End of file timer_subroutines.c  */
@@ -33,4 +33,10 @@ void timer_create_entry (void (*subroutine) (void *, GApplication *),
                          gdouble interval, gpointer user_data,
                          GApplication *app);
 
+/* Call the subroutines of the entries that have expired.  */
+void timer_dispatch (GApplication *app);
+
+/* Return TRUE if any entries have not yet expired.  */
+gboolean timer_pending (GApplication *app);
+
 /* End of file timer_subroutines.h */
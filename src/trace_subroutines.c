@@ -17,9 +17,11 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gst/gst.h>
@@ -28,6 +30,42 @@
 #include "sound_effects_player.h"
 #include "main.h"
 
+/* The number of trace records the ring buffer can hold.  This must be
+ * a power of two.  */
+#define TRACE_RING_SIZE 1024
+
+/* The longest line we keep in a trace record.  A longer line is
+ * copied to the heap instead.  */
+#define TRACE_LINE_SIZE 240
+
+/* The size of the buffer the writer thread assembles lines into before
+ * writing them to the file.  */
+#define TRACE_BATCH_SIZE 65536
+
+/* How often, in microseconds, the writer thread looks for new records
+ * if nobody wakes it.  */
+#define TRACE_WRITER_INTERVAL 50000
+
+/* When to force the trace file out to the disk.  */
+enum trace_sync_policy
+{
+  trace_sync_none,              /* leave it to the kernel */
+  trace_sync_batch,             /* after each batch of records is written */
+  trace_sync_each               /* after each record, using O_DSYNC */
+};
+
+/* One line of trace output.  The time is captured when the record is
+ * made, but it is not converted to text until the writer thread
+ * gets to it.  */
+struct trace_record
+{
+  struct tm time_tm;
+  gint nanoseconds;
+  gint line_length;
+  gchar *long_line;             /* the line, if it does not fit below */
+  gchar line[TRACE_LINE_SIZE];
+};
+
 /* the persistent data used by the trace subroutines */
 struct trace_info
 {
@@ -35,27 +73,81 @@ struct trace_info
   gint sequencer_level;
   gint fid;
   gint file_open;
+  enum trace_sync_policy sync_policy;
+  struct trace_record *ring;    /* records waiting to be written */
+  gint ring_head;               /* next record to fill, main thread only */
+  gint ring_tail;               /* next record to write, writer only */
+  gint dropped_count;           /* records lost because the ring was full */
+  gint dropped_reported;        /* how many of those we have written about */
+  gint stopping;                /* non-zero tells the writer to finish */
+  gint write_failed;            /* non-zero once a write has failed */
+  GThread *writer_thread;
+  GMutex writer_mutex;          /* only used to sleep on writer_cond */
+  GCond writer_cond;
+  gchar *batch_buffer;          /* the writer's output buffer */
+  const gchar *failed_operation;        /* "write" or "sync" */
+  gint failed_errno;            /* why it failed */
 };
 
 /* Subroutines for tracing.  */
 
+static gpointer trace_writer (gpointer user_data);
+
 /* Initialize the trace subroutines.  */
 void *
 trace_init (GApplication * app)
 {
   struct trace_info *trace_data;
+  gchar *sync_string;
+  gint open_flags;
 
   trace_data = g_malloc (sizeof (struct trace_info));
   trace_data->sequencer_level = main_get_trace_sequencer_level ();
   trace_data->file_name = main_get_trace_file_name ();
   trace_data->file_open = 0;
-  
-  if ((trace_data->file_name != NULL) && (trace_data->sequencer_level > 0))
+  trace_data->ring = NULL;
+  trace_data->ring_head = 0;
+  trace_data->ring_tail = 0;
+  trace_data->dropped_count = 0;
+  trace_data->dropped_reported = 0;
+  trace_data->stopping = 0;
+  trace_data->write_failed = 0;
+  trace_data->writer_thread = NULL;
+  trace_data->batch_buffer = NULL;
+  trace_data->failed_operation = NULL;
+  trace_data->failed_errno = 0;
+  g_mutex_init (&trace_data->writer_mutex);
+  g_cond_init (&trace_data->writer_cond);
+
+  /* Decide when the trace file is to be synchronized with the disk.  
+   * The default is after each batch of records.  */
+  trace_data->sync_policy = trace_sync_batch;
+  sync_string = main_get_trace_sync_string ();
+  if (sync_string != NULL)
+    {
+      if (g_ascii_strcasecmp (sync_string, "none") == 0)
+        trace_data->sync_policy = trace_sync_none;
+      else if (g_ascii_strcasecmp (sync_string, "batch") == 0)
+        trace_data->sync_policy = trace_sync_batch;
+      else if (g_ascii_strcasecmp (sync_string, "each") == 0)
+        trace_data->sync_policy = trace_sync_each;
+      else
+        g_printf ("Unknown trace sync policy %s, using batch.\n",
+                  sync_string);
+    }
+
+  /* The file is opened if the sequencer is to be traced or the
+   * pipeline is to be profiled.  */
+  if ((trace_data->file_name != NULL)
+      && ((trace_data->sequencer_level > 0)
+          || (main_get_trace_profile_interval () > 0)))
     {
       /* Open the trace file for append.  */
+      open_flags = O_WRONLY | O_APPEND | O_CREAT;
+      if (trace_data->sync_policy == trace_sync_each)
+        open_flags = open_flags | O_DSYNC;
       trace_data->fid =
-        g_open (trace_data->file_name,
-                O_WRONLY | O_APPEND | O_CREAT | O_DSYNC,
+        g_open (trace_data->file_name, open_flags,
                 S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
       if (trace_data->fid == -1)
         {
@@ -64,9 +156,19 @@ trace_init (GApplication * app)
           trace_data->sequencer_level = 0;
         }
       else
-	trace_data->file_open = 1;
+        {
+          trace_data->file_open = 1;
+
+          /* The file is written by a separate thread, so that the
+           * sequencer does not wait for the disk.  */
+          trace_data->ring =
+            g_malloc (TRACE_RING_SIZE * sizeof (struct trace_record));
+          trace_data->batch_buffer = g_malloc (TRACE_BATCH_SIZE);
+          trace_data->writer_thread =
+            g_thread_new ("trace writer", trace_writer, trace_data);
+        }
     }
-  
+
   return (trace_data);
 }
 
@@ -75,11 +177,37 @@ void
 trace_finalize (GApplication * app)
 {
   struct trace_info *trace_data;
+  gint dropped_count;
 
   trace_data = sep_get_trace_data (app);
+
+  /* Let the writer thread empty the ring buffer, then wait for it 
+   * to exit.  */
+  if (trace_data->writer_thread != NULL)
+    {
+      g_mutex_lock (&trace_data->writer_mutex);
+      g_atomic_int_set (&trace_data->stopping, 1);
+      g_cond_signal (&trace_data->writer_cond);
+      g_mutex_unlock (&trace_data->writer_mutex);
+      g_thread_join (trace_data->writer_thread);
+      trace_data->writer_thread = NULL;
+    }
+
+  dropped_count = g_atomic_int_get (&trace_data->dropped_count);
+  if (dropped_count > 0)
+    {
+      g_printf ("%d trace records were dropped.\n", dropped_count);
+    }
+
   if (trace_data->file_open == 1)
     g_close (trace_data->fid, NULL);
   trace_data->file_open = 0;
+  g_free (trace_data->ring);
+  trace_data->ring = NULL;
+  g_free (trace_data->batch_buffer);
+  trace_data->batch_buffer = NULL;
+  g_mutex_clear (&trace_data->writer_mutex);
+  g_cond_clear (&trace_data->writer_cond);
   g_free (trace_data);
   return;
 }
@@ -91,61 +219,270 @@ trace_sequencer_level (GApplication * app)
   struct trace_info *trace_data;
 
   trace_data = sep_get_trace_data (app);
-  if (trace_data->file_open == 0)
+  if ((trace_data->file_open == 0)
+      || (g_atomic_int_get (&trace_data->write_failed) != 0))
     return (0);
-  
+
   return (trace_data->sequencer_level);
 }
 
-/* Subroutine to return the current time as a string.  */
-static gchar *
-trace_current_time (GApplication * app)
+/* See if the trace file is open, so lines written to it are kept.  */
+gboolean
+trace_file_open (GApplication * app)
 {
-  struct tm current_time_tm, local_time_tm;
-  gint nanoseconds;
-  gchar string_buffer[64];
-  gchar *result;
-
-  /* Get the current time into a tm structure.  */
-  time_current_tm_nano (&current_time_tm, &nanoseconds);
-
-  /* Convert to local time.  */
-  time_UTC_to_local (&current_time_tm, &local_time_tm, INT_MIN);
+  struct trace_info *trace_data;
 
-  /* Express the local time as a string.  */
-  time_tm_nano_to_string (&local_time_tm, nanoseconds,
-			  &string_buffer[0], sizeof (string_buffer));
-  result = g_strdup (&string_buffer[0]);
-  return (result);
+  trace_data = sep_get_trace_data (app);
+  return ((trace_data->file_open != 0)
+          && (g_atomic_int_get (&trace_data->write_failed) == 0));
 }
 
-/* Write a line into the trace file from the sequencer.  */
+/* Write a line into the trace file from the sequencer.  The line is
+ * placed in the ring buffer along with the current time, and is written
+ * to the file later by the writer thread.  If the ring buffer is full 
+ * the line is dropped and counted.  Only the main thread calls this
+ * subroutine, so only the writer thread and this subroutine touch 
+ * the ring buffer, and no lock is needed.  */
 void
 trace_sequencer_write (gchar * line, GApplication * app)
 {
   struct trace_info *trace_data;
-  size_t bytes_to_write;
-  gchar *current_time;
-  gchar *output_string;
-  ssize_t bytes_written;
+  struct trace_record *record;
+  gint head, tail;
+  gsize line_length;
 
   trace_data = sep_get_trace_data (app);
+  if ((trace_data->ring == NULL)
+      || (g_atomic_int_get (&trace_data->write_failed) != 0))
+    return;
 
-  /* Prepend the current time onto the string.  */
-  current_time = trace_current_time (app);
-  output_string = g_strdup_printf ("%s %s\n", current_time, line);
-  g_free (current_time);
-  current_time = NULL;
-  bytes_to_write = strlen (output_string);
-  bytes_written = write (trace_data->fid, output_string, bytes_to_write);
-  if (bytes_written < 0)
+  head = trace_data->ring_head;
+  tail = g_atomic_int_get (&trace_data->ring_tail);
+  if (head - tail >= TRACE_RING_SIZE)
     {
-      g_printf ("Trace file write failure on %s: %s.\n",
-                trace_data->file_name, g_strerror (errno));
-      trace_data->sequencer_level = 0;
+      g_atomic_int_inc (&trace_data->dropped_count);
+      return;
     }
-  g_free (output_string);
-  output_string = NULL;
+
+  record = &trace_data->ring[head & (TRACE_RING_SIZE - 1)];
+  time_current_tm_nano (&record->time_tm, &record->nanoseconds);
+  line_length = strlen (line);
+  if (line_length < TRACE_LINE_SIZE)
+    {
+      memcpy (&record->line[0], line, line_length + 1);
+      record->long_line = NULL;
+    }
+  else
+    {
+      /* Sound names and operator text can make a line long.  Rather
+       * than cut it, let the writer thread free a copy.  */
+      record->long_line = g_strdup (line);
+    }
+  record->line_length = line_length;
+
+  /* Publish the record to the writer thread.  */
+  g_atomic_int_set (&trace_data->ring_head, head + 1);
 
   return;
 }
+
+/* Write the writer's batch buffer, or a line too long for it, to the
+ * file.  The kernel may write less than we asked, for example if
+ * interrupted by a signal, so keep writing until it is all out.
+ * Returns FALSE, remembering why, if the write failed.  */
+static gboolean
+trace_write_buffer (struct trace_info *trace_data, const gchar *buffer,
+                    gsize batch_length)
+{
+  gsize offset;
+  ssize_t bytes_written;
+
+  offset = 0;
+  while (offset < batch_length)
+    {
+      bytes_written =
+        write (trace_data->fid, buffer + offset, batch_length - offset);
+      if (bytes_written < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          trace_data->failed_errno = errno;
+          trace_data->failed_operation = "write";
+          return (FALSE);
+        }
+      if (bytes_written == 0)
+        {
+          /* No progress and no error: give up rather than spin.  */
+          trace_data->failed_errno = EIO;
+          trace_data->failed_operation = "write";
+          return (FALSE);
+        }
+      offset = offset + bytes_written;
+    }
+  return (TRUE);
+}
+
+/* Append text to the writer's batch buffer, writing the buffer to the
+ * file first if there is not enough room.  Returns FALSE if the write
+ * to the file failed.  */
+static gboolean
+trace_batch_append (struct trace_info *trace_data, gsize *batch_length,
+                    gchar * text, gsize text_length)
+{
+  gboolean write_ok;
+
+  if (*batch_length + text_length > TRACE_BATCH_SIZE)
+    {
+      write_ok =
+        trace_write_buffer (trace_data, trace_data->batch_buffer,
+                            *batch_length);
+      *batch_length = 0;
+      if (!write_ok)
+        return (FALSE);
+    }
+  if (text_length > TRACE_BATCH_SIZE)
+    return (trace_write_buffer (trace_data, text, text_length));
+  memcpy (trace_data->batch_buffer + *batch_length, text, text_length);
+  *batch_length = *batch_length + text_length;
+  return (TRUE);
+}
+
+/* Write the records in the ring buffer to the trace file.  Returns FALSE
+ * if the file could not be written.  */
+static gboolean
+trace_write_batch (struct trace_info *trace_data)
+{
+  struct trace_record *record;
+  struct tm local_time_tm;
+  gchar string_buffer[64];
+  gchar *dropped_text;
+  gchar *line;
+  gint head, tail;
+  gint dropped_count;
+  gsize batch_length;
+  gboolean write_ok;
+
+  head = g_atomic_int_get (&trace_data->ring_head);
+  tail = trace_data->ring_tail;
+  dropped_count = g_atomic_int_get (&trace_data->dropped_count);
+  if ((head == tail) && (dropped_count == trace_data->dropped_reported))
+    return (TRUE);
+
+  batch_length = 0;
+  write_ok = TRUE;
+  while ((tail != head) && write_ok)
+    {
+      record = &trace_data->ring[tail & (TRACE_RING_SIZE - 1)];
+
+      /* Prepend the local time onto the line.  */
+      time_UTC_to_local (&record->time_tm, &local_time_tm, INT_MIN);
+      time_tm_nano_to_string (&local_time_tm, record->nanoseconds,
+                              &string_buffer[0], sizeof (string_buffer));
+      line = record->long_line;
+      if (line == NULL)
+        line = &record->line[0];
+      write_ok =
+        trace_batch_append (trace_data, &batch_length, &string_buffer[0],
+                            strlen (&string_buffer[0]))
+        && trace_batch_append (trace_data, &batch_length, (gchar *) " ", 1)
+        && trace_batch_append (trace_data, &batch_length, line,
+                               record->line_length)
+        && trace_batch_append (trace_data, &batch_length, (gchar *) "\n",
+                               1);
+      g_free (record->long_line);
+      record->long_line = NULL;
+      tail = tail + 1;
+
+      /* Let the sequencer re-use the record.  */
+      g_atomic_int_set (&trace_data->ring_tail, tail);
+    }
+
+  /* If records were lost since the last batch, say so in the file.  */
+  if (write_ok && (dropped_count != trace_data->dropped_reported))
+    {
+      dropped_text =
+        g_strdup_printf ("%d trace records dropped.\n",
+                         dropped_count - trace_data->dropped_reported);
+      write_ok =
+        trace_batch_append (trace_data, &batch_length, dropped_text,
+                            strlen (dropped_text));
+      g_free (dropped_text);
+      dropped_text = NULL;
+      trace_data->dropped_reported = dropped_count;
+    }
+
+  if (write_ok && (batch_length > 0))
+    write_ok =
+      trace_write_buffer (trace_data, trace_data->batch_buffer,
+                          batch_length);
+
+  if (write_ok && (trace_data->sync_policy == trace_sync_batch)
+      && (fdatasync (trace_data->fid) != 0))
+    {
+      trace_data->failed_errno = errno;
+      trace_data->failed_operation = "sync";
+      write_ok = FALSE;
+    }
+
+  return (write_ok);
+}
+
+/* Discard the records in the ring buffer without writing them.  */
+static void
+trace_discard_records (struct trace_info *trace_data)
+{
+  struct trace_record *record;
+  gint head, tail;
+
+  head = g_atomic_int_get (&trace_data->ring_head);
+  for (tail = trace_data->ring_tail; tail != head; tail++)
+    {
+      record = &trace_data->ring[tail & (TRACE_RING_SIZE - 1)];
+      g_free (record->long_line);
+      record->long_line = NULL;
+    }
+  g_atomic_int_set (&trace_data->ring_tail, head);
+  return;
+}
+
+/* The writer thread.  Wake up periodically, or when asked to finish,
+ * and write whatever the sequencer has placed in the ring buffer.  */
+static gpointer
+trace_writer (gpointer user_data)
+{
+  struct trace_info *trace_data = user_data;
+  gint64 end_time;
+  gboolean stopping;
+
+  stopping = FALSE;
+  while (!stopping)
+    {
+      g_mutex_lock (&trace_data->writer_mutex);
+      if (g_atomic_int_get (&trace_data->stopping) == 0)
+        {
+          end_time = g_get_monotonic_time () + TRACE_WRITER_INTERVAL;
+          g_cond_wait_until (&trace_data->writer_cond,
+                             &trace_data->writer_mutex, end_time);
+        }
+      stopping = (g_atomic_int_get (&trace_data->stopping) != 0);
+      g_mutex_unlock (&trace_data->writer_mutex);
+
+      if (g_atomic_int_get (&trace_data->write_failed) != 0)
+        {
+          /* A previous write failed; discard what has accumulated.  */
+          trace_discard_records (trace_data);
+          continue;
+        }
+
+      /* Report a failure once, then stop tracing.  */
+      if (!trace_write_batch (trace_data))
+        {
+          g_printf ("Trace file %s failure on %s: %s.\n",
+                    trace_data->failed_operation, trace_data->file_name,
+                    g_strerror (trace_data->failed_errno));
+          g_atomic_int_set (&trace_data->write_failed, 1);
+        }
+    }
+
+  return (NULL);
+}
@@ -29,6 +29,8 @@ void trace_finalize (GApplication *app);
 
 gint trace_sequencer_level (GApplication *app);
 
+gboolean trace_file_open (GApplication *app);
+
 void trace_sequencer_write (gchar *line, GApplication *app);
 
 /* End of file trace_subroutines.h */
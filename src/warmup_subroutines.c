@@ -0,0 +1,629 @@
+/*
+ * warmup_subroutines.c
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include "warmup_subroutines.h"
+#include "gstreamer_subroutines.h"
+#include "main.h"
+#include "sound_effects_player.h"
+#include "sound_structure.h"
+#include "sound_subroutines.h"
+
+/* The first time a sound is started after it is loaded it is slower to
+ * reach the mixer than it will be afterwards: the pages holding its
+ * samples may not be in memory, and the envelope and the elements after
+ * it have only ever seen silence.  If asked, once the sounds are loaded
+ * and the pipeline is playing, we warm each of them up.  We touch every
+ * page of its samples, then, with its volume element muted, start each
+ * of its voices, wait for the first of its samples to leave the voice's
+ * bin, and release it, twice.  The time from start to sound is reported
+ * for both, so the cold start can be compared with the warm one.
+ *
+ * One voice is warmed at a time, on the main thread, paced by a timer.
+ * Pad probes on the looper's source pad and on the bin's source pad,
+ * which run on the voice's streaming thread, note when the sound
+ * arrives.  Messages from the voice's elements while it is being warmed
+ * are not passed on, so the operator and the sequencer never see a
+ * sound start or stop.  */
+
+#define TRACE_WARMUP FALSE
+
+/* How often, in milliseconds, we look at the voice being warmed.  */
+#define WARMUP_INTERVAL 10
+
+/* How long, in seconds, we wait for a voice to sound and then to finish,
+ * besides its release time, before giving up on it.  */
+#define WARMUP_TIMEOUT 5
+
+/* How many times each voice is started: the first is cold.  */
+#define WARMUP_RUNS 2
+
+/* What a voice being warmed is doing.  The stage is advanced by the
+ * streaming thread from starting to sounding, so it is atomic.  */
+enum warmup_stage
+{ warmup_starting, warmup_entered, warmup_sounding, warmup_releasing };
+
+/* The voice being warmed.  */
+struct warmup_chain
+{
+  GstBin *bin_element;
+  GstElement *looper_element;
+  GstElement *volume_element;
+  GstPad *looper_pad;           /* where the samples enter */
+  GstPad *output_pad;           /* where they leave for the mixer */
+  gulong looper_probe;
+  gulong output_probe;
+  gint stage;
+  gint64 onset_time;            /* set by the streaming thread */
+  gint64 start_time;
+  gint64 timeout;               /* microseconds allowed for a run */
+  gint64 deadline;
+  gint run;
+  gint64 latency[WARMUP_RUNS];
+};
+
+/* A voice we are done with, but whose release has not yet completed.
+ * Its messages are not passed on until it has.  */
+struct warmup_absorbed
+{
+  GstBin *bin_element;
+  GstElement *volume_element;   /* if it is to stay muted until the
+                                 * release completes */
+  struct sound_info *sound_data;        /* the sound it belongs to */
+};
+
+/* The persistent data used by the warm-up subroutines.  */
+struct warmup_info
+{
+  gboolean enabled;
+  GList *pending_sounds;        /* sounds waiting to be warmed */
+  struct sound_info *sound_data;        /* the sound being warmed */
+  gint voice_number;            /* its voice being warmed */
+  struct warmup_chain *chain;
+  GList *absorbed;              /* voices still releasing */
+  guint timer_source;
+  gint warmed_count;
+};
+
+/* Initialize the warm-up subroutines.  */
+void *
+warmup_init (GApplication *app)
+{
+  struct warmup_info *warmup_data;
+
+  warmup_data = g_malloc0 (sizeof (struct warmup_info));
+
+  /* A render is not played in real time, so has nothing to gain.  */
+  warmup_data->enabled = (main_get_warm_up ()
+                          && (main_get_render_file_name () == NULL));
+  return (warmup_data);
+}
+
+/* Note the arrival at the looper's source pad of the first buffer of
+ * samples after the start.  The looper sends silence until then.  This
+ * runs on the voice's streaming thread.  */
+static GstPadProbeReturn
+warmup_looper_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  struct warmup_chain *chain = user_data;
+  GstBuffer *buffer;
+  guint64 elapsed_time;
+
+  if (g_atomic_int_get (&chain->stage) != warmup_starting)
+    return GST_PAD_PROBE_OK;
+
+  /* The start sets the looper's elapsed time to zero, and each buffer
+   * of samples, but not of silence, adds its duration.  */
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  g_object_get (chain->looper_element, "elapsed-time", &elapsed_time, NULL);
+  if (elapsed_time == GST_BUFFER_DURATION (buffer))
+    g_atomic_int_set (&chain->stage, warmup_entered);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Note when the first samples leave the bin.  The elements of the bin
+ * process a buffer on the thread that pushed it, so the next buffer to
+ * leave after the samples entered is made from them.  */
+static GstPadProbeReturn
+warmup_output_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+  struct warmup_chain *chain = user_data;
+
+  if (g_atomic_int_get (&chain->stage) != warmup_entered)
+    return GST_PAD_PROBE_OK;
+
+  chain->onset_time = g_get_monotonic_time ();
+  g_atomic_int_set (&chain->stage, warmup_sounding);
+  return GST_PAD_PROBE_OK;
+}
+
+/* Send a start or release to the voice being warmed.  */
+static void
+warmup_send (struct warmup_chain *chain, const gchar *event_name)
+{
+  GstStructure *structure;
+  GstEvent *event;
+
+  structure = gst_structure_new_empty (event_name);
+  event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM, structure);
+  gst_element_send_event (GST_ELEMENT (chain->bin_element), event);
+  return;
+}
+
+/* Start the voice being warmed.  */
+static void
+warmup_start_run (struct warmup_chain *chain)
+{
+  g_atomic_int_set (&chain->stage, warmup_starting);
+  chain->start_time = g_get_monotonic_time ();
+  chain->deadline = chain->start_time + chain->timeout;
+  warmup_send (chain, "start");
+  return;
+}
+
+/* Bring every page of a sound's samples into memory.  */
+static void
+warmup_touch_samples (GstElement *looper_element)
+{
+  GstBuffer *buffer = NULL;
+  GstMapInfo info;
+  gsize offset, page_size;
+  volatile guchar *data;
+
+  g_object_get (looper_element, "preloaded-data", &buffer, NULL);
+  if (buffer == NULL)
+    return;
+
+  if (gst_buffer_map (buffer, &info, GST_MAP_READ))
+    {
+      page_size = sysconf (_SC_PAGESIZE);
+      data = info.data;
+      for (offset = 0; offset < info.size; offset = offset + page_size)
+        (void) data[offset];
+      gst_buffer_unmap (buffer, &info);
+    }
+  gst_buffer_unref (buffer);
+  return;
+}
+
+/* Prepare the next voice to be warmed.  Returns FALSE if there are
+ * none left.  */
+static gboolean
+warmup_next_chain (struct warmup_info *warmup_data)
+{
+  struct sound_info *sound_data;
+  struct voice_info *voice_data;
+  struct warmup_chain *chain;
+  GstBin *bin_element;
+  GstElement *looper_element, *volume_element;
+
+  for (;;)
+    {
+      if (warmup_data->sound_data == NULL)
+        {
+          if (warmup_data->pending_sounds == NULL)
+            return FALSE;
+          warmup_data->sound_data = warmup_data->pending_sounds->data;
+          warmup_data->pending_sounds =
+            g_list_delete_link (warmup_data->pending_sounds,
+                                warmup_data->pending_sounds);
+          warmup_data->voice_number = 0;
+
+          /* The sound might have been removed by a reload, or started
+           * by the operator.  A sound whose release never ends could
+           * not be stopped once started.  */
+          sound_data = warmup_data->sound_data;
+          if ((sound_data->sound_control == NULL)
+              || (sound_data->looper_element == NULL)
+              || sound_data->running
+              || sound_data->release_duration_infinite)
+            {
+              warmup_data->sound_data = NULL;
+              continue;
+            }
+          warmup_touch_samples (sound_data->looper_element);
+          bin_element = sound_data->sound_control;
+          looper_element = sound_data->looper_element;
+        }
+      else
+        {
+          sound_data = warmup_data->sound_data;
+          warmup_data->voice_number = warmup_data->voice_number + 1;
+          voice_data =
+            g_list_nth_data (sound_data->voices,
+                             warmup_data->voice_number - 1);
+          if (voice_data == NULL)
+            {
+              warmup_data->sound_data = NULL;
+              continue;
+            }
+          if ((voice_data->sound_control == NULL)
+              || (voice_data->looper_element == NULL)
+              || voice_data->running)
+            continue;
+          bin_element = voice_data->sound_control;
+          looper_element = voice_data->looper_element;
+        }
+
+      volume_element = gstreamer_get_volume (bin_element);
+      if (volume_element == NULL)
+        continue;
+      break;
+    }
+
+  /* Silence the voice, and watch its samples go through it.  */
+  chain = g_malloc0 (sizeof (struct warmup_chain));
+  chain->bin_element = gst_object_ref (bin_element);
+  chain->looper_element = gst_object_ref (looper_element);
+  chain->volume_element = volume_element;
+  g_object_set (volume_element, "mute", TRUE, NULL);
+  chain->timeout =
+    (WARMUP_TIMEOUT * G_USEC_PER_SEC)
+    + (sound_data->release_duration_time / 1000);
+  chain->looper_pad = gst_element_get_static_pad (looper_element, "src");
+  chain->output_pad =
+    gst_element_get_static_pad (GST_ELEMENT (bin_element), "src");
+  chain->looper_probe =
+    gst_pad_add_probe (chain->looper_pad, GST_PAD_PROBE_TYPE_BUFFER,
+                       warmup_looper_probe, chain, NULL);
+  chain->output_probe =
+    gst_pad_add_probe (chain->output_pad, GST_PAD_PROBE_TYPE_BUFFER,
+                       warmup_output_probe, chain, NULL);
+  warmup_data->chain = chain;
+
+  if (TRACE_WARMUP)
+    {
+      g_print ("Warming up %s.\n", GST_OBJECT_NAME (bin_element));
+    }
+  return TRUE;
+}
+
+/* Let a voice whose release we are absorbing be heard.  */
+static void
+warmup_unmute_absorbed (struct warmup_absorbed *absorbed)
+{
+  if (absorbed->volume_element == NULL)
+    return;
+
+  g_object_set (absorbed->volume_element, "mute", FALSE, NULL);
+  gst_object_unref (absorbed->volume_element);
+  absorbed->volume_element = NULL;
+  return;
+}
+
+/* Stop absorbing the messages of a voice.  */
+static void
+warmup_free_absorbed (struct warmup_absorbed *absorbed)
+{
+  warmup_unmute_absorbed (absorbed);
+  gst_object_unref (absorbed->bin_element);
+  g_free (absorbed);
+  return;
+}
+
+/* Find the absorbed voice an element belongs to, if any.  */
+static GList *
+warmup_find_absorbed (struct warmup_info *warmup_data, GstObject *element)
+{
+  struct warmup_absorbed *absorbed;
+  GList *l;
+
+  for (l = warmup_data->absorbed; l != NULL; l = l->next)
+    {
+      absorbed = l->data;
+      if ((element == GST_OBJECT (absorbed->bin_element))
+          || gst_object_has_as_ancestor (element,
+                                         GST_OBJECT (absorbed->bin_element)))
+        return l;
+    }
+  return NULL;
+}
+
+/* Swallow the messages of the voice being warmed until its release
+ * completes.  If the voice is to stay muted until then, so say.  */
+static void
+warmup_absorb_chain (struct warmup_info *warmup_data, gboolean muted)
+{
+  struct warmup_chain *chain;
+  struct warmup_absorbed *absorbed;
+
+  chain = warmup_data->chain;
+  absorbed = g_malloc0 (sizeof (struct warmup_absorbed));
+  absorbed->bin_element = gst_object_ref (chain->bin_element);
+  absorbed->sound_data = warmup_data->sound_data;
+  if (muted)
+    absorbed->volume_element = gst_object_ref (chain->volume_element);
+  warmup_data->absorbed = g_list_prepend (warmup_data->absorbed, absorbed);
+  return;
+}
+
+/* We are done with the voice being warmed.  If it finished, report
+ * how long it took to start.  The voice is unmuted unless it is
+ * being absorbed muted.  */
+static void
+warmup_end_chain (struct warmup_info *warmup_data, gboolean finished)
+{
+  struct warmup_chain *chain;
+  GList *absorbed_link;
+
+  chain = warmup_data->chain;
+  warmup_data->chain = NULL;
+
+  gst_pad_remove_probe (chain->looper_pad, chain->looper_probe);
+  gst_pad_remove_probe (chain->output_pad, chain->output_probe);
+  absorbed_link =
+    warmup_find_absorbed (warmup_data, GST_OBJECT (chain->bin_element));
+  if ((absorbed_link == NULL)
+      || (((struct warmup_absorbed *) absorbed_link->data)->volume_element
+          == NULL))
+    g_object_set (chain->volume_element, "mute", FALSE, NULL);
+
+  if (finished)
+    {
+      g_print ("Warm-up of %s: first start %.3f ms, second start %.3f ms.\n",
+               GST_OBJECT_NAME (chain->bin_element),
+               (gdouble) chain->latency[0] / 1000.0,
+               (gdouble) chain->latency[WARMUP_RUNS - 1] / 1000.0);
+      warmup_data->warmed_count = warmup_data->warmed_count + 1;
+    }
+
+  gst_object_unref (chain->looper_pad);
+  gst_object_unref (chain->output_pad);
+  gst_object_unref (chain->volume_element);
+  gst_object_unref (chain->looper_element);
+  gst_object_unref (chain->bin_element);
+  g_free (chain);
+  return;
+}
+
+/* Return TRUE if the pipeline has finished going to playing.  */
+static gboolean
+warmup_pipeline_playing (GApplication *app)
+{
+  GstPipeline *pipeline_element;
+  GstState state, pending;
+
+  pipeline_element = sep_get_pipeline_from_app (app);
+  if (pipeline_element == NULL)
+    return FALSE;
+  gst_element_get_state (GST_ELEMENT (pipeline_element), &state, &pending,
+                         0);
+  return ((state == GST_STATE_PLAYING) && (pending == GST_STATE_VOID_PENDING));
+}
+
+/* Called periodically on the main thread while there are sounds
+ * to warm up.  */
+static gboolean
+warmup_tick (gpointer user_data)
+{
+  GApplication *app = user_data;
+  struct warmup_info *warmup_data;
+  struct warmup_chain *chain;
+
+  warmup_data = sep_get_warmup_data (app);
+  chain = warmup_data->chain;
+
+  if (chain == NULL)
+    {
+      if (!warmup_pipeline_playing (app))
+        return G_SOURCE_CONTINUE;
+      if (!warmup_next_chain (warmup_data))
+        {
+          if (TRACE_WARMUP)
+            {
+              g_print ("Warm-up done: %d voices.\n",
+                       warmup_data->warmed_count);
+            }
+          warmup_data->timer_source = 0;
+          return G_SOURCE_REMOVE;
+        }
+      warmup_start_run (warmup_data->chain);
+      return G_SOURCE_CONTINUE;
+    }
+
+  /* Once the voice has sounded, release it.  We will start it again,
+   * or go on to the next, when it has completed.  */
+  if (g_atomic_int_get (&chain->stage) == warmup_sounding)
+    {
+      chain->latency[chain->run] = chain->onset_time - chain->start_time;
+      g_atomic_int_set (&chain->stage, warmup_releasing);
+      warmup_send (chain, "release");
+      return G_SOURCE_CONTINUE;
+    }
+
+  /* If the voice has not sounded or completed in time, give up on it.
+   * It may still be playing or releasing, so release it, if we have
+   * not, and keep it muted until it says it has completed.  */
+  if (g_get_monotonic_time () > chain->deadline)
+    {
+      g_printerr ("Unable to warm up %s.\n",
+                  GST_OBJECT_NAME (chain->bin_element));
+      if (g_atomic_int_get (&chain->stage) != warmup_releasing)
+        {
+          g_atomic_int_set (&chain->stage, warmup_releasing);
+          warmup_send (chain, "release");
+        }
+      warmup_absorb_chain (warmup_data, TRUE);
+      warmup_end_chain (warmup_data, FALSE);
+    }
+  return G_SOURCE_CONTINUE;
+}
+
+/* Warm up the sounds which have not yet been warmed.  */
+void
+warmup_start (GApplication *app)
+{
+  struct warmup_info *warmup_data;
+  struct sounds_info *sounds_data;
+  struct sound_info *sound_data;
+  GList *l;
+
+  warmup_data = sep_get_warmup_data (app);
+  if ((warmup_data == NULL) || !warmup_data->enabled)
+    return;
+
+  sounds_data = sep_get_sounds_data (app);
+  for (l = sounds_data->sounds_list; l != NULL; l = l->next)
+    {
+      sound_data = l->data;
+      if (sound_data->disabled || sound_data->warmed)
+        continue;
+      sound_data->warmed = TRUE;
+      warmup_data->pending_sounds =
+        g_list_append (warmup_data->pending_sounds, sound_data);
+    }
+
+  if ((warmup_data->pending_sounds != NULL)
+      && (warmup_data->timer_source == 0))
+    {
+      warmup_data->timer_source =
+        g_timeout_add (WARMUP_INTERVAL, warmup_tick, app);
+    }
+  return;
+}
+
+/* The operator is starting a sound.  If we are warming it, stop, and
+ * let its volume be heard.  */
+void
+warmup_cancel_sound (struct sound_info *sound_data, GApplication *app)
+{
+  struct warmup_info *warmup_data;
+  struct warmup_chain *chain;
+  struct warmup_absorbed *absorbed;
+  GList *l;
+
+  warmup_data = sep_get_warmup_data (app);
+  if (warmup_data == NULL)
+    return;
+
+  /* If we gave up on any of its voices and are waiting for them to
+   * complete, they need not stay muted now.  */
+  for (l = warmup_data->absorbed; l != NULL; l = l->next)
+    {
+      absorbed = l->data;
+      if (absorbed->sound_data == sound_data)
+        warmup_unmute_absorbed (absorbed);
+    }
+
+  if (warmup_data->sound_data != sound_data)
+    return;
+
+  chain = warmup_data->chain;
+  if (chain != NULL)
+    {
+      /* If we have released the voice, its envelope will finish the
+       * release before it starts again, and will say it has completed.
+       * That is ours, not the operator's.  */
+      if (g_atomic_int_get (&chain->stage) == warmup_releasing)
+        warmup_absorb_chain (warmup_data, FALSE);
+      warmup_end_chain (warmup_data, FALSE);
+    }
+  warmup_data->sound_data = NULL;
+
+  if (TRACE_WARMUP)
+    {
+      g_print ("Warm-up of %s cancelled.\n", sound_data->name);
+    }
+  return;
+}
+
+/* Look at an element message.  If it is from the voice we are warming,
+ * act on it and return TRUE.  */
+gboolean
+warmup_claim_message (GstMessage *message, const GstStructure *structure,
+                      GApplication *app)
+{
+  struct warmup_info *warmup_data;
+  struct warmup_chain *chain;
+  GstObject *source;
+  GList *absorbed_link;
+
+  warmup_data = sep_get_warmup_data (app);
+  if (warmup_data == NULL)
+    return FALSE;
+  source = GST_MESSAGE_SRC (message);
+
+  /* Swallow the messages of a released voice until its release
+   * completes.  */
+  absorbed_link = warmup_find_absorbed (warmup_data, source);
+  if (absorbed_link != NULL)
+    {
+      if (gst_structure_has_name (structure, (gchar *) "completed"))
+        {
+          warmup_free_absorbed (absorbed_link->data);
+          warmup_data->absorbed =
+            g_list_delete_link (warmup_data->absorbed, absorbed_link);
+        }
+      return TRUE;
+    }
+
+  chain = warmup_data->chain;
+  if ((chain == NULL)
+      || !gst_object_has_as_ancestor (source,
+                                      GST_OBJECT (chain->bin_element)))
+    return FALSE;
+
+  if (!gst_structure_has_name (structure, (gchar *) "completed"))
+    return TRUE;
+
+  /* A short sound can complete before we release it.  */
+  if (g_atomic_int_get (&chain->stage) == warmup_sounding)
+    {
+      chain->latency[chain->run] = chain->onset_time - chain->start_time;
+      g_atomic_int_set (&chain->stage, warmup_releasing);
+    }
+  if (g_atomic_int_get (&chain->stage) != warmup_releasing)
+    return TRUE;
+
+  chain->run = chain->run + 1;
+  if (chain->run < WARMUP_RUNS)
+    warmup_start_run (chain);
+  else
+    warmup_end_chain (warmup_data, TRUE);
+  return TRUE;
+}
+
+/* Stop any warm-up and deallocate the persistent data.  */
+void
+warmup_finish (GApplication *app)
+{
+  struct warmup_info *warmup_data;
+
+  warmup_data = sep_get_warmup_data (app);
+  if (warmup_data == NULL)
+    return;
+
+  if (warmup_data->timer_source != 0)
+    {
+      g_source_remove (warmup_data->timer_source);
+      warmup_data->timer_source = 0;
+    }
+  if (warmup_data->chain != NULL)
+    warmup_end_chain (warmup_data, FALSE);
+  g_list_free_full (warmup_data->absorbed,
+                    (GDestroyNotify) warmup_free_absorbed);
+  g_list_free (warmup_data->pending_sounds);
+  g_free (warmup_data);
+  return;
+}
+
+/* End of file warmup_subroutines.c */
@@ -0,0 +1,44 @@
+/*
+ * warmup_subroutines.h
+ *
+ * Copyright © 2025 by John Sauter <John_Sauter@systemeyescomputerstore.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include "sound_structure.h"
+
+/* Subroutines defined in warmup_subroutines.c */
+
+/* Initialize the warm-up subroutines from the command-line options.  */
+void *warmup_init (GApplication *app);
+
+/* Stop any warm-up and deallocate its persistent data.  */
+void warmup_finish (GApplication *app);
+
+/* The sounds have been loaded: warm up those not yet warmed.  */
+void warmup_start (GApplication *app);
+
+/* The operator is starting a sound: stop warming it up.  */
+void warmup_cancel_sound (struct sound_info *sound_data, GApplication *app);
+
+/* Called for each element message.  Returns TRUE if the message came
+ * from a sound being warmed up, in which case it has been dealt with.  */
+gboolean warmup_claim_message (GstMessage *message,
+                               const GstStructure *structure,
+                               GApplication *app);
+
+/* End of file warmup_subroutines.h */